@@ -1,52 +1,15 @@
-//g++ ChemicalMasterEquation.cpp -O3 -std=c++11 `pkg-config opencv --cflags --libs` -o CME
+//g++ ChemicalMasterEquation.cpp ../src/chemical_master_equation.cpp ../src/checkpoint.cpp -O3 -std=c++11 -pthread -I../include -o CME
+//g++ ChemicalMasterEquation.cpp ../src/chemical_master_equation.cpp ../src/checkpoint.cpp -O3 -std=c++11 -pthread -I../include -DOPENCV `pkg-config opencv --cflags --libs` -o CME
 #include <iostream>
-#include <random>
+#include <string>
+#ifdef OPENCV
 #include <opencv2/opencv.hpp>
 #include <opencv2/plot.hpp>
+#endif
 
+#include <chemical_master_equation.h>
+#include <profiler.hpp>
 
-void BrusselatorCME (std :: vector < double > & x, std :: vector < double > & y,
-                     std :: vector < double > & t,
-                     const double & A, const double & B,
-                     const double & omega, double max_time = 30.,
-                     std :: size_t seed = 123)
-{
-  double ti = t[0];
-  double xi = x[0];
-  double yi = y[0];
-
-  std :: mt19937 mt(seed);
-  std :: uniform_real_distribution < double > uniform(0., 1.);
-
-  while (ti <= max_time)
-  {
-    std :: cout << "\rTime " << ti << std :: flush;
-
-    std :: array < double, 4 > c{ {A * omega,
-                                   A * omega + B * xi,
-                                   A * omega + B * xi + xi,
-                                   A * omega + B * xi + xi + xi * (xi - 1.) * yi / (omega * omega)
-                                   }
-                                 };
-
-    const double rng1 = uniform(mt);
-    const double rng2 = uniform(mt);
-    const double tau = -std :: log(rng1) / c[3];
-    const double uct = rng2 * c.back();
-
-    ti += tau;
-
-    if     (uct < c[0]) ++xi;
-    else if(uct < c[1]) {--xi; ++yi;}
-    else if(uct < c[2]) --xi;
-    else if(uct < c[3]) {++xi; --yi;}
-
-    x.push_back(xi);
-    y.push_back(yi);
-    t.push_back(ti);
-  }
-
-}
 
 int main (int argc, char ** argv)
 {
@@ -62,8 +25,22 @@ int main (int argc, char ** argv)
   std :: vector < double > y = {y0};
   std :: vector < double > t = {0.};
 
-  BrusselatorCME (x, y, t, A, B, omega, 30., 42);
+  // optional checkpoint file: an interrupted run restarts from its last snapshot
+  if (argc > 1)
+  {
+    const bool restarted = BrusselatorCME (x, y, t, A, B, omega, 30., 42, std :: string(argv[1]), 100000);
+
+    if (restarted)
+      std :: cout << "Restarted from " << argv[1] << std :: endl;
+  }
+  else
+    BrusselatorCME (x, y, t, A, B, omega, 30., 42);
+
+  std :: cout << "Simulated " << t.size() - 1 << " events up to time " << t.back()
+              << " (x = " << x.back() << ", y = " << y.back() << ")"
+              << std :: endl;
 
+#ifdef OPENCV
   cv :: Mat plot_x;
   cv :: Mat plot_y;
 
@@ -96,6 +73,9 @@ int main (int argc, char ** argv)
   cv :: imshow("Brusselator CME", plot_res);
 
   cv :: waitKey(0);
+#endif
+
+  PROFILE_REPORT(std :: cerr, "text");
 
   return 0;
 }
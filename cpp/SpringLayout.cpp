@@ -1,46 +1,37 @@
 #include <iostream>
-#include <unordered_set>
-#include <numeric>
 #include <random>
+#include <string>
+#include <cstdio>
+#include <cmath>
+#include <cassert>
+#ifdef OPENCV
 #include <opencv2/opencv.hpp>
+#endif
 
-static const int32_t DIM = 2;
-static const int32_t SEED = 42;
-
-std :: mt19937 eng(SEED);
-std :: uniform_real_distribution < float > distr(0.1f, .2f);
+#include <spring_layout.h>
+#include <profiler.hpp>
 
-struct node
-{
-  std :: array < float, DIM > force;
-  std :: array < float, DIM > pos;
+static const int32_t SEED = 42;
 
-  node ()
-  {
-    std :: fill_n(this->force.begin(), DIM, 0.f);
-    std :: fill_n(this->pos.begin(), DIM, 0.f);
-  };
 
-  ~node() = default;
-};
+#ifdef OPENCV
 
-void view (const std :: string & name, const cv :: Mat & edges, node * nodes, const int32_t & Nnodes, int32_t ms=1)
+void view (const std :: string & name, const graph & g, const nodes & nd, int32_t ms=1)
 {
-  cv :: Mat pos(Nnodes, 2, CV_32FC1);
-  for (int32_t n = 0; n < Nnodes; ++n)
-    pos.at < cv :: Point2f >(n) = cv :: Point2f(nodes[n].pos[0], nodes[n].pos[1]);
+  cv :: Mat pos(g.Nnodes, 2, CV_32FC1);
+  for (int32_t n = 0; n < g.Nnodes; ++n)
+    pos.at < cv :: Point2f >(n) = cv :: Point2f(nd.pos[0][n], nd.pos[1][n]);
 
   cv :: normalize(pos, pos, 6.f, 506.f, cv :: NORM_MINMAX);
 
   cv :: Mat canvas = cv :: Mat :: zeros(cv :: Size(512, 512), CV_8UC1);
-  for (int32_t i = 0; i < Nnodes; ++i)
+  for (int32_t i = 0; i < g.Nnodes; ++i)
     cv :: circle(canvas, pos.at< cv :: Point2f >(i), 5, cv :: Scalar :: all(255), cv :: FILLED);
 
-  for (int32_t i = 0; i < edges.rows; ++i)
+  for (int32_t i = 0; i < g.Nedges; ++i)
   {
-    cv :: Point2i edge = edges.at< cv :: Point2i >(i);
-    cv :: Point2f start = pos.at < cv :: Point2f >(edge.x);
-    cv :: Point2f end = pos.at < cv :: Point2f >(edge.y);
+    cv :: Point2f start = pos.at < cv :: Point2f >(g.src[i]);
+    cv :: Point2f end = pos.at < cv :: Point2f >(g.dst[i]);
     cv :: line(canvas, start, end, cv :: Scalar :: all(128), 1);
   }
 
@@ -60,193 +51,198 @@ void view (const std :: string & name, const cv :: Mat & edges, node * nodes, co
 }
 
 
+#endif // OPENCV
 
 
-struct
+/**
+* @brief Bandwidth of the dense labelling (max |u - v| over the edges)
+*
+*/
+int32_t bandwidth (const graph & g)
 {
-  void operator()(node & n1,
-                  node & n2,
-                  const float & k,
-                  const float & r)
-  {
-    std :: array < float, DIM > delta;
+  int32_t b = 0;
+  for (int32_t e = 0; e < g.Nedges; ++e)
+    b = std :: max(b, g.dst[e] - g.src[e]);
+  return b;
+}
 
-    std :: transform(n1.pos.begin(), n1.pos.end(),
-                    n2.pos.begin(), delta.begin(),
-                    [](const float & x1, const float & x2)
-                    {
-                     return x2 - x1;
-                    });
-    float distance = std :: accumulate(delta.begin(), delta.end(),
-                                       0.f, [](const float & r, const float & d)
-                                       {
-                                         return r + d * d;
-                                       });
-
-    // If the deltas are too small, use random values to keep things moving
-    if (distance < .1f)
+/**
+* @brief Edge list of a (rows x cols) grid with shuffled node IDs
+*
+*/
+std :: vector < int32_t > grid_edges (const int32_t & rows, const int32_t & cols, std :: mt19937 & eng)
+{
+  std :: vector < int32_t > id(rows * cols);
+  for (int32_t n = 0; n < rows * cols; ++n)
+    id[n] = 1000 + 7 * n;
+  std :: shuffle(id.begin(), id.end(), eng);
+
+  std :: vector < int32_t > edges;
+  for (int32_t r = 0; r < rows; ++r)
+    for (int32_t c = 0; c < cols; ++c)
     {
-      std :: generate_n(delta.begin(), DIM, [](){return distr(eng);});
-      distance = std::accumulate(delta.begin(), delta.end(),
-                                 0.f, [](const float & r, const float & d)
-                                 {
-                                   return r + d * d;
-                                 });
+      if (c + 1 < cols)
+        edges.insert(edges.end(), {id[r * cols + c], id[r * cols + c + 1]});
+      if (r + 1 < rows)
+        edges.insert(edges.end(), {id[r * cols + c], id[(r + 1) * cols + c]});
     }
 
-    if (distance < r*r)
-    {
-      float force = (k * k) / distance;
-      std :: transform(n1.force.begin(), n1.force.end(),
-                       delta.begin(), n1.force.begin(),
-                       [&](const float & f, const float & d)
-                       {
-                          return f - force * d;
-                       });
-      std :: transform(n2.force.begin(), n2.force.end(),
-                       delta.begin(), n2.force.begin(),
-                       [&](const float & f, const float & d)
-                       {
-                          return f + force*d;
-                       });
-    }
-    return;
-  }
+  return edges;
+}
 
-} Coulomb;
 
-struct
+int main (int argc, char ** argv)
 {
-  void operator()(node & n1,
-                  node & n2,
-                  const float & k,
-                  const float & r)
+  int32_t Nnodes = 50, Nedges = 100;
+  bool multilevel = true;
+  std :: string checkpoint;
+
+  if (argc > 1)
+    Nnodes = std :: stoi(argv[1]);
+  if (argc > 2)
+    Nedges = std :: stoi(argv[2]);
+  if (argc > 3)
+    multilevel = std :: stoi(argv[3]);
+  // optional checkpoint file: an interrupted multilevel layout restarts from its last snapshot
+  if (argc > 4)
+    checkpoint = argv[4];
+
+  std :: mt19937 eng(SEED);
+
+  // CSR ingestion: a path with arbitrary IDs, a duplicated (reversed) edge and a self-loop
   {
-    std :: array < float, DIM > delta;
-    std :: transform(n1.pos.begin(), n1.pos.end(),
-                     n2.pos.begin(), delta.begin(),
-                     [](const float & x1, const float & x2)
-                     {
-                      return x2 - x1;
-                     });
-    float distance = std :: accumulate(delta.begin(), delta.end(),
-                                       0.f, [](const float & r, const float & d)
-                                       {
-                                         return r + d * d;
-                                       });
-
-    // If the deltas are too small, use random values to keep things moving
-    if (distance < .1f)
+    const std :: vector < int32_t > edges = {50, 30, 30, 90, 90, 10, 10, 70, 70, 20, 20, 80, 80, 40, 10, 90, 70, 70};
+    const graph path = make_graph(edges.data(), static_cast < int32_t >(edges.size() / 2));
+
+    assert (path.Nnodes == 8 && path.Nedges == 7);
+    assert (path.offsets.back() == 2 * path.Nedges && static_cast < int32_t >(path.adjacency.size()) == 2 * path.Nedges);
+
+    int32_t ends = 0;
+    for (int32_t n = 0; n < path.Nnodes; ++n)
     {
-      std :: generate_n(delta.begin(), DIM, [](){return distr(eng);});
-      distance = std::accumulate(delta.begin(), delta.end(),
-                                 0.f, [](const float & r, const float & d)
-                                 {
-                                   return r + d * d;
-                                 });
+      const int32_t degree = path.offsets[n + 1] - path.offsets[n];
+      assert (degree == 1 || degree == 2);
+      ends += degree == 1;
+
+      // the adjacency follows the input edges (with the original IDs)
+      for (int32_t j = path.offsets[n]; j < path.offsets[n + 1]; ++j)
+      {
+        const int32_t u = path.labels[n];
+        const int32_t v = path.labels[path.adjacency[j]];
+        bool found = false;
+        for (std :: size_t e = 0; e < edges.size(); e += 2)
+          found = found || (edges[e] == u && edges[e + 1] == v) || (edges[e] == v && edges[e + 1] == u);
+        assert (found);
+      }
     }
+    assert (ends == 2);
 
-    // Truncate distance so as to not have crazy springiness
-    distance = std :: min(distance, r);
-
-    // Calculate Hooke force and update nodes
-    float force = (distance - k * k) / (distance * distance * k);
-    std :: transform(n1.force.begin(), n1.force.end(),
-                     delta.begin(), n1.force.begin(),
-                     [&](const float & f, const float & d)
-                     {
-                        return f + force * d;
-                     });
-    std :: transform(n2.force.begin(), n2.force.end(),
-                     delta.begin(), n2.force.begin(),
-                     [&](const float & f, const float & d)
-                     {
-                        return f - force * d;
-                     });
-    return;
+    // the RCM ordering of a path is a path
+    std :: cout << "Path bandwidth : " << bandwidth(path) << " (expected 1)" << std :: endl;
+    assert (bandwidth(path) == 1);
   }
 
-} Hooke;
+  // RCM ordering of a grid: the BFS levels are the anti-diagonals, so the bandwidth is about the short side
+  {
+    const std :: vector < int32_t > edges = grid_edges(12, 20, eng);
+    const int32_t Ngrid = static_cast < int32_t >(edges.size() / 2);
+
+    const graph unordered = make_graph(edges.data(), Ngrid, false);
+    const graph ordered = make_graph(edges.data(), Ngrid);
 
+    std :: cout << "Grid 12 x 20 bandwidth : " << bandwidth(unordered) << " (input order), "
+                << bandwidth(ordered) << " (RCM)" << std :: endl;
 
-struct
-{
-  auto operator()(const cv :: Mat & edges,
-                  int iterations = 1000,
-                  float force_strength = 5.f,
-                  float damping = .01f,
-                  float max_velocity = 2.f,
-                  float max_distance = 50.f
-                  )
+    assert (ordered.Nnodes == 240 && ordered.Nedges == 12 * 19 + 11 * 20);
+    assert (bandwidth(ordered) <= 12 + 1 && bandwidth(ordered) < bandwidth(unordered));
+  }
+
+  // multilevel convergence and restart of a grid layout
   {
-    std :: unordered_set < int32_t > n;
+    const std :: vector < int32_t > edges = grid_edges(16, 16, eng);
+    const graph grid = make_graph(edges.data(), static_cast < int32_t >(edges.size() / 2));
 
-    for (int32_t i = 0; i < edges.rows; ++i)
-    {
-      cv :: Point2i edge = edges.at< cv :: Point2i >(i);
-      n.insert(edge.x);
-      n.insert(edge.y);
-    }
+    int32_t finest = 0;
+    layout_callback count = [&](const graph & level, const nodes &, const int32_t & iter)
+                            {
+                              if (level.Nnodes == grid.Nnodes)
+                                finest = iter;
+                            };
 
-    int32_t i = 0;
-    int32_t Nnodes = static_cast < int32_t >(n.size());
+    const std :: vector < float > pos = multilevel_layout(grid, 16, 1000, 5.f, .01f, 2.f, 50.f, 5e-2f, count);
 
-    std :: unique_ptr < node[] > nodes(new node[Nnodes]);
+    // mean length of the edges against the mean distance of the nodes
+    auto distance = [&](const int32_t & u, const int32_t & v)
+                    {
+                      return std :: hypot(pos[u * LAYOUT_DIM] - pos[v * LAYOUT_DIM], pos[u * LAYOUT_DIM + 1] - pos[v * LAYOUT_DIM + 1]);
+                    };
 
-    const std :: string name = "Spring Layout";
+    double edge_length = 0., node_distance = 0.;
+    for (int32_t e = 0; e < grid.Nedges; ++e)
+      edge_length += distance(grid.src[e], grid.dst[e]) / grid.Nedges;
+    for (int32_t u = 0; u < grid.Nnodes; ++u)
+      for (int32_t v = 0; v < u; ++v)
+        node_distance += distance(u, v) / (.5 * grid.Nnodes * (grid.Nnodes - 1));
 
-    while ( i < iterations )
-    {
+    std :: cout << "Grid 16 x 16 multilevel : " << finest << " iterations on the input graph, edge length / node distance "
+                << edge_length / node_distance << std :: endl;
 
-      // Add in Coulomb-esque node-node repulsive forces
-      for (int32_t n1 = 0; n1 < Nnodes; ++n1)
-        for (int32_t n2 = 0; n2 < n1; ++n2)
-          Coulomb(nodes[n1], nodes[n2], force_strength, max_distance);
+    assert (finest < 1000);
+    assert (edge_length < .5 * node_distance);
 
-      // And Hooke-esque edge spring forces
-      for (int32_t e = 0; e < edges.rows; ++e)
-      {
-        cv :: Point2i edge = edges.at< cv :: Point2i >(e);
-        Hooke(nodes[edge.x], nodes[edge.y], force_strength, max_distance);
-      }
+    // a finished checkpoint restarts at its end, the one of another graph is ignored
+    const std :: string ckpt = "SpringLayout.ckpt";
+    std :: remove(ckpt.c_str());
 
-      // Move by resultant force
-      for (int32_t n = 0; n < Nnodes; ++n)
-      {
-        std :: transform(nodes[n].force.begin(), nodes[n].force.end(),
-                         nodes[n].pos.begin(), nodes[n].pos.begin(),
-                         [&](const float & f, const float & p)
-                         {
-                           return p + std :: max(-max_velocity, std :: min(damping*f, max_velocity));
-                         });
-
-        std :: fill_n(nodes[n].force.begin(), DIM, 0.f);
-      }
-      ++i;
+    assert (multilevel_layout(grid, ckpt, 10) == pos);
+    assert (multilevel_layout(grid, ckpt, 10) == pos);
 
+    // same nodes with a diagonal edge
+    std :: vector < int32_t > diagonal(edges);
+    diagonal.insert(diagonal.end(), {edges[1], edges[3]});
+    const graph other = make_graph(diagonal.data(), static_cast < int32_t >(diagonal.size() / 2));
 
-      view (name, edges, nodes.get(), Nnodes, 1);
-      cv :: setWindowTitle(name, name + " (Iter: " + std :: to_string(i) + ")");
-    }
+    const std :: vector < float > other_pos = multilevel_layout(other);
 
-    // Clean and return
-    cv :: Mat pos(Nnodes, 2, CV_32FC1);
-    for (int32_t n = 0; n < Nnodes; ++n)
-      pos.at < cv :: Point2f >(n) = cv :: Point2f(nodes[n].pos[0], nodes[n].pos[1]);
+    assert (multilevel_layout(grid, ckpt, 10) == pos);
+    assert (multilevel_layout(other, ckpt, 10) == other_pos);
 
-    return pos;
+    std :: remove(ckpt.c_str());
   }
 
-} spring_layout;
+  std :: uniform_int_distribution < int32_t > node_id(0, Nnodes - 1);
 
-int main (int argc, char ** argv)
-{
-  const int Nnodes = 50, Nedges = 100;
+  std :: vector < int32_t > edges(2 * Nedges);
+  std :: generate(edges.begin(), edges.end(), [&](){return node_id(eng);});
+
+  graph g = make_graph(edges.data(), Nedges);
+
+#ifdef OPENCV
+  const std :: string name = "Spring Layout";
+
+  layout_callback display = [&](const graph & level, const nodes & nd, const int32_t & iter)
+                            {
+                              view(name, level, nd, 1);
+                              cv :: setWindowTitle(name, name + " (Nodes: " + std :: to_string(level.Nnodes) + " Iter: " + std :: to_string(iter) + ")");
+                            };
+#else
+  layout_callback display = nullptr;
+#endif
+
+  std :: vector < float > pos = !multilevel         ? spring_layout(g, 1000, 5.f, .01f, 2.f, 50.f, 5e-2f, display)
+                              : checkpoint.empty() ? multilevel_layout(g, 16, 1000, 5.f, .01f, 2.f, 50.f, 5e-2f, display)
+                              : multilevel_layout(g, checkpoint, 50, 16, 1000, 5.f, .01f, 2.f, 50.f, 5e-2f, display);
+
+#ifdef OPENCV
+  nodes nd(g.Nnodes);
+  for (int32_t n = 0; n < g.Nnodes; ++n)
+    for (int32_t d = 0; d < LAYOUT_DIM; ++d)
+      nd.pos[d][n] = pos[n * LAYOUT_DIM + d];
 
-  cv :: Mat edges(Nedges, 2, CV_32SC1);
-  cv :: randu(edges, cv :: Scalar(0.), cv :: Scalar(Nnodes));
+  view(name, g, nd, 0);
+#endif
 
-  cv :: Mat pos = spring_layout(edges);
+  PROFILE_REPORT(std :: cerr, "text");
 
   return 0;
 }
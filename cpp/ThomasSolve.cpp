@@ -1,41 +1,12 @@
 #include <iostream>
 #include <iterator>
-#include <memory>
 #include <algorithm>
+#include <array>
 
-std :: unique_ptr < float[] > Thomas (const float * b, const float * a,
-                                      float * c, float * d,
-                                      const int32_t & nb)
-{
-  int32_t i = 0;
-  std :: unique_ptr < float[] > x(new float[nb]);
-
-  float tmp = c[i];
-
-  c[i] /= b[i];
-  d[i] /= b[i];
-
-  for (i = 1; i < nb - 1; ++i)
-  {
-    const float scale = a ? a[i - 1] : tmp;
-    const float id = 1.f / (b[i] - scale * c[i-1]);
-    d[i] = (d[i] - a[i-1] * d[i-1]) * id;
-    tmp = c[i];
-    c[i] *= id;
-  }
-
-  tmp = a ? a[i - 1] : tmp;
-  d[i] = (d[i] - tmp * d[i-1]) / (b[i] - tmp * c[i-1]);
-  x[nb - 1] = d[i];
-
-  for (i = nb-2; i != -1; --i)
-    x[i] = d[i] - c[i] * x[i+1];
-
-  return x;
-}
+#include <thomas.h>
 
 
-int main (int argc, char ** argv)
+int main ()
 {
   std :: array < float, 2 > a = {4.f, 3.f};
   std :: array < float, 3 > b = {9.f, -7.f, 8.f};
@@ -0,0 +1,892 @@
+// g++ benchmark.cpp ../src/*.cpp -std=c++14 -O3 -march=native -fopenmp -I../include -o benchmark
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <string>
+#include <functional>
+#include <algorithm>
+#include <cstdint>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/resource.h>
+#endif
+
+#include <sysdyn.h>
+#include <profiler.hpp>
+
+
+/**
+* @brief Result of a benchmark run
+*
+* @details The cost is measured per operation, where the
+* operation is the natural work item of the kernel (unit),
+* e.g. a grid site update, an integration step or an SSA event.
+*
+*/
+struct bench_result
+{
+  std :: string name;
+  std :: string unit;
+
+  int64_t size;
+  int32_t threads;
+  int32_t reps;
+
+  double ns_per_op;     // median over the repetitions
+  double min_ns_per_op; // best repetition
+  double throughput;    // units per second (median)
+  int64_t peak_rss_kb;  // memory high-water mark during the run
+};
+
+/**
+* @brief Benchmark definition
+*
+* @details The setup function prepares the inputs for a given
+* problem size and returns the kernel to time; the kernel returns
+* the number of operations performed by a single call (it could
+* depend on the run, e.g. the number of stochastic events).
+* The setup is not timed.
+*
+*/
+struct benchmark
+{
+  std :: string name;
+  std :: string unit;
+  std :: vector < int64_t > sizes;
+  bool parallel; // run the kernel for each thread count
+
+  std :: function < std :: function < int64_t () > (const int64_t &) > setup;
+};
+
+
+/**
+* @brief Reset the memory high-water mark of the process
+*
+* @details On Linux the peak RSS can be reset writing 5 in
+* /proc/self/clear_refs, so the next reading refers only to the
+* current benchmark. Elsewhere the peak is the one of the process.
+*
+*/
+void reset_peak_memory ()
+{
+#ifdef __linux__
+  std :: ofstream os("/proc/self/clear_refs");
+  if (os)
+    os << "5";
+#endif
+}
+
+/**
+* @brief Memory high-water mark of the process in kB
+*
+*/
+int64_t peak_memory ()
+{
+#ifdef __linux__
+  std :: ifstream is("/proc/self/status");
+  std :: string line;
+
+  while (std :: getline(is, line))
+    if (line.compare(0, 6, "VmHWM:") == 0)
+      return std :: stoll(line.substr(6));
+#endif
+
+#if defined(__linux__) || defined(__APPLE__)
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return static_cast < int64_t >(usage.ru_maxrss / 1024); // bytes on MacOS
+#else
+  return static_cast < int64_t >(usage.ru_maxrss);
+#endif
+#else
+  return 0;
+#endif
+}
+
+/**
+* @brief Time a kernel
+*
+* @details The kernel is called once as warm-up and then repeated
+* at least min_reps times and until min_time seconds are spent.
+*
+*/
+bench_result run (const benchmark & b, const int64_t & size, const int32_t & threads,
+                  const double & min_time, const int32_t & min_reps)
+{
+#ifdef _OPENMP
+  omp_set_num_threads(threads);
+#endif
+
+  reset_peak_memory();
+
+  std :: function < int64_t () > kernel = b.setup(size);
+  kernel();
+
+  std :: vector < double > cost;
+  double elapsed = 0.;
+
+  while ( static_cast < int32_t >(cost.size()) < min_reps || elapsed < min_time )
+  {
+    const auto start_time = std :: chrono :: high_resolution_clock :: now();
+    const int64_t n = kernel();
+    const double run_time = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+    elapsed += run_time;
+    cost.push_back(run_time * 1e9 / std :: max(n, int64_t(1)));
+  }
+
+  std :: sort(cost.begin(), cost.end());
+
+  bench_result res;
+  res.name = b.name;
+  res.unit = b.unit;
+  res.size = size;
+  res.threads = threads;
+  res.reps = static_cast < int32_t >(cost.size());
+  res.ns_per_op = cost[cost.size() / 2];
+  res.min_ns_per_op = cost.front();
+  res.throughput = 1e9 / res.ns_per_op;
+  res.peak_rss_kb = peak_memory();
+
+  return res;
+}
+
+
+/**
+* @brief Random graph with Nnodes nodes and Nedges edges
+*
+*/
+graph random_graph (const int32_t & Nnodes, const int32_t & Nedges)
+{
+  std :: mt19937 engine(42);
+  std :: uniform_int_distribution < int32_t > node(0, Nnodes - 1);
+
+  std :: vector < int32_t > edges(2 * Nedges);
+  std :: generate(edges.begin(), edges.end(), [&] () { return node(engine); });
+
+  return make_graph(edges.data(), Nedges);
+}
+
+template < int32_t N >
+std :: function < int64_t () > michaelis_menten_bench ()
+{
+  auto time = std :: make_shared < array < double > >(new double[N]);
+  std :: generate_n(time->get(), N, [n = 0] () mutable { return 1e-3 * n++; });
+
+  auto S  = std :: make_shared < array < double > >(new double[N]);
+  auto E  = std :: make_shared < array < double > >(new double[N]);
+  auto ES = std :: make_shared < array < double > >(new double[N]);
+  auto P  = std :: make_shared < array < double > >(new double[N]);
+
+  return [=] ()
+         {
+           MichaelisMenten < double, N >(*time, 10., 1., 0., 0., 1., 1e-2, 1., *S, *E, *ES, *P);
+           return static_cast < int64_t >(N - 1);
+         };
+}
+
+
+std :: vector < benchmark > make_benchmarks ()
+{
+  std :: vector < benchmark > benchmarks;
+
+  benchmarks.push_back({"Thomas", "row", {1000, 100000, 1000000}, false,
+                        [] (const int64_t & n)
+                        {
+                          auto a = std :: make_shared < std :: vector < float > >(n - 1, 1.f);
+                          auto b = std :: make_shared < std :: vector < float > >(n, 4.f);
+                          auto c = std :: make_shared < std :: vector < float > >(n - 1, 1.f);
+                          auto d = std :: make_shared < std :: vector < float > >(n, 1.f);
+                          auto cc = std :: make_shared < std :: vector < float > >(n - 1);
+                          auto dd = std :: make_shared < std :: vector < float > >(n);
+
+                          return std :: function < int64_t () >([=] ()
+                                                                {
+                                                                  // the forward sweep overwrites c and d
+                                                                  std :: copy(c->begin(), c->end(), cc->begin());
+                                                                  std :: copy(d->begin(), d->end(), dd->begin());
+                                                                  auto x = Thomas(b->data(), a->data(), cc->data(), dd->data(), static_cast < int32_t >(n));
+                                                                  return n;
+                                                                });
+                        }});
+
+  benchmarks.push_back({"GaussSeidel", "solve", {64, 256, 1024}, false,
+                        [] (const int64_t & n)
+                        {
+                          std :: mt19937 engine(42);
+                          std :: uniform_real_distribution < float > uniform(-1.f, 1.f);
+
+                          // diagonally dominant matrix
+                          auto A = std :: make_shared < std :: vector < float > >(n * n);
+                          auto b = std :: make_shared < std :: vector < float > >(n);
+                          std :: generate(A->begin(), A->end(), [&] () { return uniform(engine); });
+                          std :: generate(b->begin(), b->end(), [&] () { return uniform(engine); });
+                          for (int64_t i = 0; i < n; ++i)
+                            (*A)[i * n + i] = static_cast < float >(n);
+
+                          return std :: function < int64_t () >([=] ()
+                                                                {
+                                                                  auto x = GaussSeidel(A->data(), b->data(), static_cast < int32_t >(n), 1e-6f);
+                                                                  return int64_t(1);
+                                                                });
+                        }});
+
+  benchmarks.push_back({"GrassbergerProcaccia", "pair", {1000, 2000, 4000}, true,
+                        [] (const int64_t & n)
+                        {
+                          std :: array < double, 2 > x0 = {{.1, .1}};
+                          const std :: array < double, 12 > a = {{1.2, 0., -1., 0., .4, 0., 0., 1., 0., 0., 0., 0.}};
+
+                          auto orbit = std :: make_shared < std :: vector < double > >(2 * n);
+                          iterate(quadratic_map < double >(a), x0.data(), 1, 1000, n, 1, orbit->data());
+
+                          return std :: function < int64_t () >([=] ()
+                                                                {
+                                                                  GrassbergerProcaccia(orbit->data(), orbit->data() + n, static_cast < int >(n));
+                                                                  return n * (n - 1) / 2;
+                                                                });
+                        }});
+
+  benchmarks.push_back({"false_nearest_neighbours", "point", {10000, 100000}, true,
+                        [] (const int64_t & n)
+                        {
+                          // Lorenz series (y coordinate)
+                          auto y = std :: make_shared < std :: vector < double > >(n);
+                          double xi = 10., yi = 1., zi = 1.;
+                          for (int64_t i = 0; i < n; ++i)
+                          {
+                            (*y)[i] = yi;
+                            const double vx = 16. * (yi - xi);
+                            const double vy = -xi * zi + 45.92 * xi - yi;
+                            const double vz = -4. * zi + xi * yi;
+                            xi += .01 * vx;
+                            yi += .01 * vy;
+                            zi += .01 * vz;
+                          }
+
+                          return std :: function < int64_t () >([=] ()
+                                                                {
+                                                                  std :: array < double, 10 > fnn;
+                                                                  false_nearest_neighbours(y->data(), n, 10, 10, fnn.data(), 15., 2., int64_t(10));
+                                                                  return n;
+                                                                });
+                        }});
+
+  benchmarks.push_back({"average_mutual_information", "pair", {100000, 1000000}, true,
+                        [] (const int64_t & n)
+                        {
+                          // Lorenz series (x coordinate)
+                          auto x = std :: make_shared < std :: vector < double > >(n);
+                          double xi = 10., yi = 1., zi = 1.;
+                          for (int64_t i = 0; i < n; ++i)
+                          {
+                            (*x)[i] = xi;
+                            const double vx = 16. * (yi - xi);
+                            const double vy = -xi * zi + 45.92 * xi - yi;
+                            const double vz = -4. * zi + xi * yi;
+                            xi += .01 * vx;
+                            yi += .01 * vy;
+                            zi += .01 * vz;
+                          }
+
+                          return std :: function < int64_t () >([=] ()
+                                                                {
+                                                                  std :: array < double, 100 > mi;
+                                                                  average_mutual_information(x->data(), n, 100, 100, mi.data());
+                                                                  return n * 100;
+                                                                });
+                        }});
+
+  benchmarks.push_back({"levenberg_marquardt", "observation", {1000, 10000}, false,
+                        [] (const int64_t & n)
+                        {
+                          using model = michaelis_menten_model < double >;
+
+                          // noiseless product observations of the Michaelis Menten kinetic
+                          const double dt = 20. / (n - 1);
+                          const std :: array < double, 4 > y0 = {{10., 1., 0., 0.}};
+                          const std :: array < double, 3 > params = {{1., 1e-2, 1.}};
+
+                          auto obs = std :: make_shared < std :: vector < double > >(n * model :: Nvar, std :: numeric_limits < double > :: quiet_NaN());
+                          rk4_sensitivity < model >(y0.data(), params.data(), dt, 1, n,
+                                                    [&](const int64_t & k, const double * y, const double *)
+                                                    {
+                                                      (*obs)[k * model :: Nvar + 3] = y[3];
+                                                    }, false);
+
+                          return std :: function < int64_t () >([=] ()
+                                                                {
+                                                                  const std :: array < double, 3 > guess = {{.5, .1, 2.}};
+                                                                  levenberg_marquardt < model >(y0.data(), obs->data(), n, dt, 1, guess.data());
+                                                                  return n;
+                                                                });
+                        }});
+
+  benchmarks.push_back({"sobol_indices", "integration", {1000, 10000}, true,
+                        [] (const int64_t & n)
+                        {
+                          using model = michaelis_menten_model < double >;
+
+                          return std :: function < int64_t () >([=] ()
+                                                                {
+                                                                  // product of the Michaelis Menten kinetic after 500 steps
+                                                                  const std :: array < double, 4 > y0 = {{10., 1., 0., 0.}};
+                                                                  auto product = [&](const double * params)
+                                                                                 {
+                                                                                   double last = 0.;
+                                                                                   rk4_sensitivity < model >(y0.data(), params, 1e-2, 1, 501,
+                                                                                                             [&](const int64_t &, const double * y, const double *)
+                                                                                                             {
+                                                                                                               last = y[3];
+                                                                                                             }, false);
+                                                                                   return last;
+                                                                                 };
+
+                                                                  const std :: array < double, 3 > lower = {{.1, 1e-3, .1}};
+                                                                  const std :: array < double, 3 > upper = {{10., 1., 10.}};
+                                                                  std :: array < double, 3 > first, total;
+                                                                  sobol_indices(product, 3, lower.data(), upper.data(), n, first.data(), total.data());
+                                                                  return n * 5;
+                                                                });
+                        }});
+
+  benchmarks.push_back({"basins_of_attraction", "point", {65536, 262144}, true,
+                        [] (const int64_t & n)
+                        {
+                          using model = toggle_switch_model < double >;
+
+                          const int32_t side = static_cast < int32_t >(std :: sqrt(static_cast < double >(n)));
+                          auto labels = std :: make_shared < std :: vector < uint8_t > >(static_cast < int64_t >(side) * side);
+
+                          return std :: function < int64_t () >([=] ()
+                                                                {
+                                                                  const std :: array < double, 4 > params = {{2., 2., 3., 3.}};
+                                                                  const std :: array < double, 2 > lower = {{0., 0.}};
+                                                                  const std :: array < double, 2 > upper = {{3., 3.}};
+                                                                  const std :: array < int32_t, 2 > grid = {{side, side}};
+                                                                  std :: vector < double > attractors;
+                                                                  basins_of_attraction < model >(lower.data(), upper.data(), grid.data(), params.data(),
+                                                                                                 .1, 10000, 1e-4, 1e-2, labels->data(), attractors);
+                                                                  return static_cast < int64_t >(side) * side;
+                                                                });
+                        }});
+
+  benchmarks.push_back({"continuation", "point", {1}, false,
+                        [] (const int64_t &)
+                        {
+                          using model = toggle_switch_model < double >;
+
+                          return std :: function < int64_t () >([=] ()
+                                                                {
+                                                                  // S-shaped branch of the asymmetric toggle switch
+                                                                  const std :: array < double, 4 > params = {{.5, 2., 3., 3.}};
+                                                                  const std :: array < double, 2 > y0 = {{.5, 2.}};
+                                                                  const auto branch = continuation < model >(y0.data(), params.data(), 0, 0., 4.);
+                                                                  return static_cast < int64_t >(branch.size());
+                                                                });
+                        }});
+
+  benchmarks.push_back({"lyapunov_spectrum", "step", {100000, 1000000}, false,
+                        [] (const int64_t & n)
+                        {
+                          using model = lorenz_model < double >;
+
+                          return std :: function < int64_t () >([=] ()
+                                                                {
+                                                                  const std :: array < double, 3 > params = {{16., 45.92, 4.}};
+                                                                  const std :: array < double, 3 > y0 = {{10., 1., 1.}};
+                                                                  std :: array < double, 3 > spectrum;
+                                                                  lyapunov_spectrum < model >(y0.data(), params.data(), .01, 0, n, 10, spectrum.data());
+                                                                  return n;
+                                                                });
+                        }});
+
+  benchmarks.push_back({"recurrence_quantification", "pair", {10000, 30000}, true,
+                        [] (const int64_t & n)
+                        {
+                          // Lorenz series (x coordinate)
+                          auto x = std :: make_shared < std :: vector < double > >(n + 10);
+                          double xi = 10., yi = 1., zi = 1.;
+                          for (int64_t i = 0; i < n + 10; ++i)
+                          {
+                            (*x)[i] = xi;
+                            const double vx = 16. * (yi - xi);
+                            const double vy = -xi * zi + 45.92 * xi - yi;
+                            const double vz = -4. * zi + xi * yi;
+                            xi += .01 * vx;
+                            yi += .01 * vy;
+                            zi += .01 * vz;
+                          }
+
+                          return std :: function < int64_t () >([=] ()
+                                                                {
+                                                                  const delay_embedding < double > emb(x->data(), n, 5, 3);
+                                                                  recurrence_quantification(emb, 2., 2, 2, int64_t(1));
+                                                                  return n * n;
+                                                                });
+                        }});
+
+  benchmarks.push_back({"correlation_sums", "pair", {5000, 20000}, true,
+                        [] (const int64_t & n)
+                        {
+                          // Lorenz series (x coordinate)
+                          auto x = std :: make_shared < std :: vector < double > >(n);
+                          double xi = 10., yi = 1., zi = 1.;
+                          for (int64_t i = 0; i < n; ++i)
+                          {
+                            (*x)[i] = xi;
+                            const double vx = 16. * (yi - xi);
+                            const double vy = -xi * zi + 45.92 * xi - yi;
+                            const double vz = -4. * zi + xi * yi;
+                            xi += .01 * vx;
+                            yi += .01 * vy;
+                            zi += .01 * vz;
+                          }
+
+                          return std :: function < int64_t () >([=] ()
+                                                                {
+                                                                  std :: array < double, 8 * 16 > C;
+                                                                  std :: array < double, 16 > eps;
+                                                                  correlation_sums(x->data(), n, 10, 8, 16, C.data(), eps.data());
+                                                                  const int64_t Np = n - 70;
+                                                                  return Np * (Np - 1) / 2;
+                                                                });
+                        }});
+
+  benchmarks.push_back({"spatial_ssa", "event", {64, 1024}, true,
+                        [] (const int64_t & dim)
+                        {
+                          return std :: function < int64_t () >([=] ()
+                                                                {
+                                                                  // stochastic Brusselator in the Turing regime (~10^7 events)
+                                                                  const std :: vector < ssa_reaction > reactions = { {{}, {0}, 4.5}, {{0}, {1}, 7.5}, {{0}, {}, 1.}, {{0, 0, 1}, {0, 0, 0}, 1.} };
+#ifdef _OPENMP
+                                                                  spatial_ssa ssa(dim, dim, 1, 2, reactions, {2., 16.}, 10., true, 42, omp_get_max_threads());
+#else
+                                                                  spatial_ssa ssa(dim, dim, 1, 2, reactions, {2., 16.}, 10., true, 42, 1);
+#endif
+                                                                  for (int64_t v = 0; v < ssa.voxels(); ++v)
+                                                                  {
+                                                                    ssa.set(v, 0, 45);
+                                                                    ssa.set(v, 1, 16);
+                                                                  }
+                                                                  return ssa.run(5000. / (dim * dim), .01);
+                                                                });
+                        }});
+
+  benchmarks.push_back({"finite_state_projection", "state", {5, 10}, true,
+                        [] (const int64_t & omega)
+                        {
+                          return std :: function < int64_t () >([=] ()
+                                                                {
+                                                                  // Brusselator distribution at time 1 (the projection is expanded by the solver)
+                                                                  const std :: vector < ssa_reaction > reactions = { {{}, {0}, 2.}, {{0}, {1}, 5.2}, {{0}, {}, 1.}, {{0, 0, 1}, {0, 0, 0}, 1.} };
+                                                                  finite_state_projection fsp(2, reactions, static_cast < double >(omega),
+                                                                                              {static_cast < int32_t >(1.6 * omega), static_cast < int32_t >(2.8 * omega)});
+                                                                  fsp.solve(1., 1e-6);
+                                                                  return fsp.states();
+                                                                });
+                        }});
+
+  benchmarks.push_back({"exponential_propagator", "state-step", {10000, 1000000}, true,
+                        [] (const int64_t & n)
+                        {
+                          // reversible first order kinetic, 10 exact steps of a batch of initial conditions
+                          const double K[4] = {-.1, .2, .1, -.2};
+                          const auto step = std :: make_shared < exponential_propagator < float > >(K, nullptr, 2, 1.);
+                          auto Y = std :: make_shared < std :: vector < float > >(2 * n);
+                          std :: mt19937 engine(42);
+                          std :: uniform_real_distribution < float > dist(0.f, 1.f);
+                          for (int64_t i = 0; i < n; ++i)
+                          {
+                            (*Y)[i] = dist(engine);
+                            (*Y)[n + i] = 1.f - (*Y)[i];
+                          }
+                          return std :: function < int64_t () >([=] ()
+                                                                {
+                                                                  return step->apply(Y->data(), n, 10) ? 10 * n : int64_t(0);
+                                                                });
+                        }});
+
+  benchmarks.push_back({"MichaelisMenten", "step", {1000, 100000}, false,
+                        [] (const int64_t & n)
+                        {
+                          return n == 1000 ? michaelis_menten_bench < 1000 >() : michaelis_menten_bench < 100000 >();
+                        }});
+
+  benchmarks.push_back({"brusselator_rk4", "step", {1000, 100000, 1000000}, false,
+                        [] (const int64_t & n)
+                        {
+                          auto x = std :: make_shared < std :: vector < double > >(n + 1, 1.6);
+                          auto y = std :: make_shared < std :: vector < double > >(n + 1, 2.8);
+
+                          return std :: function < int64_t () >([=] ()
+                                                                {
+                                                                  brusselator_rk4(x->data(), y->data(), n, .5, 2., 1e-2);
+                                                                  return n;
+                                                                });
+                        }});
+
+  benchmarks.push_back({"BrusselatorCME", "event", {5, 30}, false,
+                        [] (const int64_t & max_time)
+                        {
+                          return std :: function < int64_t () >([=] ()
+                                                                {
+                                                                  std :: vector < double > x = {1.6};
+                                                                  std :: vector < double > y = {2.8};
+                                                                  std :: vector < double > t = {0.};
+
+                                                                  BrusselatorCME(x, y, t, 2., 5.2, 1000., static_cast < double >(max_time), 42);
+                                                                  return static_cast < int64_t >(t.size() - 1);
+                                                                });
+                        }});
+
+  benchmarks.push_back({"brusselator_diffusion", "site-update", {128, 256, 512, 2048}, true,
+                        [] (const int64_t & dim)
+                        {
+                          std :: mt19937 engine(42);
+                          std :: uniform_real_distribution < double > uniform(0., 1.);
+
+                          auto U = std :: make_shared < std :: vector < double > >(dim * dim);
+                          auto V = std :: make_shared < std :: vector < double > >(dim * dim);
+                          std :: generate(U->begin(), U->end(), [&] () { return 4.5 + .3 * uniform(engine); });
+                          std :: generate(V->begin(), V->end(), [&] () { return 1. + .3 * uniform(engine); });
+
+                          const int64_t iterations = 10;
+
+                          return std :: function < int64_t () >([=] ()
+                                                                {
+                                                                  brusselator_diffusion(U->data(), V->data(), dim, dim, .005, 4.5, 4.5, 2., 16., iterations);
+                                                                  return dim * dim * iterations;
+                                                                });
+                        }});
+
+  benchmarks.push_back({"brusselator_diffusion_mixed", "site-update", {128, 256, 512, 2048}, true,
+                        [] (const int64_t & dim)
+                        {
+                          std :: mt19937 engine(42);
+                          std :: uniform_real_distribution < float > uniform(0.f, 1.f);
+
+                          // float fields, double arithmetic
+                          auto U = std :: make_shared < std :: vector < float > >(dim * dim);
+                          auto V = std :: make_shared < std :: vector < float > >(dim * dim);
+                          std :: generate(U->begin(), U->end(), [&] () { return 4.5f + .3f * uniform(engine); });
+                          std :: generate(V->begin(), V->end(), [&] () { return 1.f + .3f * uniform(engine); });
+
+                          const int64_t iterations = 10;
+
+                          return std :: function < int64_t () >([=] ()
+                                                                {
+                                                                  brusselator_diffusion(U->data(), V->data(), dim, dim, .005, 4.5, 4.5, 2., 16., iterations);
+                                                                  return dim * dim * iterations;
+                                                                });
+                        }});
+
+  benchmarks.push_back({"reaction_diffusion_3d", "site-update", {32, 64, 128}, true,
+                        [] (const int64_t & dim)
+                        {
+                          const int64_t size = dim * dim * dim;
+
+                          // first-touch initialization with the partition of the solver
+                          auto U = std :: shared_ptr < double >(new double[size], std :: default_delete < double[] >());
+                          auto V = std :: shared_ptr < double >(new double[size], std :: default_delete < double[] >());
+                          rd_first_touch(U.get(), dim, dim, dim, [] (int64_t x, int64_t y, int64_t z) { return 4.5 + .3 * ((x * 7 + y * 13 + z * 29) % 17) / 17.; });
+                          rd_first_touch(V.get(), dim, dim, dim, [] (int64_t x, int64_t y, int64_t z) { return 1. + .3 * ((x * 11 + y * 5 + z * 23) % 19) / 19.; });
+
+                          const int64_t iterations = 10;
+
+                          return std :: function < int64_t () >([=] ()
+                                                                {
+                                                                  double * fields[2] = {U.get(), V.get()};
+                                                                  const double D[2] = {2., 16.};
+                                                                  reaction_diffusion_3d < 7 >(fields, dim, dim, dim, .005, D, brusselator_reaction < double >{4.5, 4.5}, rd_boundary :: periodic, iterations);
+                                                                  return size * iterations;
+                                                                });
+                        }});
+
+  // 2D kernels of the registered reaction models
+  for (const auto & m : rd_models())
+  {
+    const std :: string name = m.first;
+
+    benchmarks.push_back({"rd_" + name, "site-update", {128, 512}, true,
+                          [name] (const int64_t & dim)
+                          {
+                            const rd_model & model = rd_models().at(name);
+                            const int32_t Ns = static_cast < int32_t >(model.species.size());
+
+                            auto state = std :: make_shared < std :: vector < double > >(Ns * dim * dim);
+                            std :: mt19937 engine(42);
+                            std :: vector < double > c(Ns);
+
+                            for (int64_t y = 0; y < dim; ++y)
+                              for (int64_t x = 0; x < dim; ++x)
+                              {
+                                model.initial(engine, model.values.data(), x, y, 0, c.data());
+                                for (int32_t s = 0; s < Ns; ++s)
+                                  (*state)[s * dim * dim + y * dim + x] = c[s];
+                              }
+
+                            const int64_t iterations = 10;
+
+                            return std :: function < int64_t () >([=, &model] ()
+                                                                  {
+                                                                    std :: vector < double * > fields;
+                                                                    for (int32_t s = 0; s < Ns; ++s)
+                                                                      fields.push_back(state->data() + s * dim * dim);
+                                                                    model.run(fields.data(), dim, dim, 1, model.dt, model.D.data(), model.values.data(),
+                                                                              rd_boundary :: periodic, 7, iterations);
+                                                                    return dim * dim * iterations;
+                                                                  });
+                          }});
+  }
+
+  benchmarks.push_back({"kalman_filter", "step", {1000, 100000}, false,
+                        [] (const int64_t & n)
+                        {
+                          std :: mt19937 engine(123);
+                          std :: uniform_real_distribution < float > uniform(0.f, 1.f);
+
+                          auto obs = std :: make_shared < std :: vector < float > >(2 * n);
+                          for (int64_t i = 0; i < n; ++i)
+                          {
+                            const float x = static_cast < float >(i) / n;
+                            (*obs)[2 * i]     = x + .05f * uniform(engine) * x;
+                            (*obs)[2 * i + 1] = x * x + .05f * uniform(engine) * x * x;
+                          }
+
+                          return std :: function < int64_t () >([=] ()
+                                                                {
+                                                                  std :: array < float, 4 > x = {{0.f, 0.f, 0.f, 0.f}};
+                                                                  std :: array < float, 4 > motion = {{0.f, 0.f, 0.f, 0.f}};
+                                                                  std :: array < float, 16 > P = {{1e3f, 0.f, 0.f, 0.f, 0.f, 1e3f, 0.f, 0.f, 0.f, 0.f, 1e3f, 0.f, 0.f, 0.f, 0.f, 1e3f}};
+                                                                  std :: array < float, 16 > Q = {{1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f}};
+                                                                  std :: array < float, 16 > F = {{1.f, 0.f, 1.f, 0.f, 0.f, 1.f, 0.f, 1.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f}};
+                                                                  std :: array < float, 8 > H = {{1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f}};
+
+                                                                  float checksum = 0.f;
+                                                                  for (int64_t i = 0; i < n; ++i)
+                                                                    checksum += kalman_filter(x.data(), P.data(), F.data(), H.data(), motion.data(), Q.data(), 1e-2f, (*obs)[2 * i], (*obs)[2 * i + 1]).first;
+
+                                                                  // keep the loop alive
+                                                                  return checksum == checksum ? n : int64_t(0);
+                                                                });
+                        }});
+
+  benchmarks.push_back({"spring_layout", "node", {500, 2000}, false,
+                        [] (const int64_t & n)
+                        {
+                          auto g = std :: make_shared < graph >(random_graph(static_cast < int32_t >(n), static_cast < int32_t >(2 * n)));
+
+                          return std :: function < int64_t () >([=] ()
+                                                                {
+                                                                  auto pos = spring_layout(*g);
+                                                                  return static_cast < int64_t >(g->Nnodes);
+                                                                });
+                        }});
+
+  benchmarks.push_back({"multilevel_layout", "node", {500, 2000, 10000}, false,
+                        [] (const int64_t & n)
+                        {
+                          auto g = std :: make_shared < graph >(random_graph(static_cast < int32_t >(n), static_cast < int32_t >(2 * n)));
+
+                          return std :: function < int64_t () >([=] ()
+                                                                {
+                                                                  auto pos = multilevel_layout(*g);
+                                                                  return static_cast < int64_t >(g->Nnodes);
+                                                                });
+                        }});
+
+  benchmarks.push_back({"bernoulli_fixed", "site-update", {1 << 18, 1 << 22}, true,
+                        [] (const int64_t & n)
+                        {
+                          auto G = std :: make_shared < std :: vector < double > >(n, .3);
+                          auto F = std :: make_shared < fixed_lattice >(n, 4);
+                          F->from_double(G->data(), 42);
+
+                          const int64_t iterations = 100;
+
+                          return std :: function < int64_t () >([=] ()
+                                                                {
+                                                                  bernoulli(*F, iterations);
+                                                                  return n * iterations;
+                                                                });
+                        }});
+
+  benchmarks.push_back({"coupled_map_lattice", "site-update", {256, 1024}, true,
+                        [] (const int64_t & dim)
+                        {
+                          std :: mt19937 engine(42);
+                          std :: uniform_real_distribution < double > uniform(0., 1.);
+
+                          auto cml = std :: make_shared < coupled_map_lattice < logistic_map < double >, double > >(logistic_map < double >(1.), dim, dim, .3);
+                          std :: generate_n(cml->x.get(), dim * dim, [&] () { return uniform(engine); });
+
+                          const int64_t steps = 10;
+
+                          return std :: function < int64_t () >([=] ()
+                                                                {
+                                                                  cml->iterate(steps);
+                                                                  return dim * dim * steps;
+                                                                });
+                        }});
+
+  return benchmarks;
+}
+
+
+/**
+* @brief Write the results as JSON (array of records)
+*
+*/
+void dump_json (std :: ostream & os, const std :: vector < bench_result > & results)
+{
+  os << "[" << std :: endl;
+
+  for (std :: size_t i = 0; i < results.size(); ++i)
+  {
+    const bench_result & r = results[i];
+    os << "  {\"name\": \"" << r.name << "\", "
+       << "\"unit\": \"" << r.unit << "\", "
+       << "\"size\": " << r.size << ", "
+       << "\"threads\": " << r.threads << ", "
+       << "\"reps\": " << r.reps << ", "
+       << "\"ns_per_op\": " << r.ns_per_op << ", "
+       << "\"min_ns_per_op\": " << r.min_ns_per_op << ", "
+       << "\"throughput\": " << r.throughput << ", "
+       << "\"peak_rss_kb\": " << r.peak_rss_kb << "}"
+       << (i + 1 < results.size() ? "," : "") << std :: endl;
+  }
+
+  os << "]" << std :: endl;
+}
+
+/**
+* @brief Write the results as CSV (with header)
+*
+*/
+void dump_csv (std :: ostream & os, const std :: vector < bench_result > & results)
+{
+  os << "name,unit,size,threads,reps,ns_per_op,min_ns_per_op,throughput,peak_rss_kb" << std :: endl;
+
+  for (const auto & r : results)
+    os << r.name << "," << r.unit << "," << r.size << "," << r.threads << "," << r.reps << ","
+       << r.ns_per_op << "," << r.min_ns_per_op << "," << r.throughput << "," << r.peak_rss_kb
+       << std :: endl;
+}
+
+
+/**
+* @brief Command line helper
+*
+* @details Utility function for the command line user.
+*
+* @param argv Array of command line arguments.
+*
+*/
+void usage (char ** argv)
+{
+  std :: cerr << "Usage: " << argv[0] << " [--format json|csv] [--output <file>] [--filter <name>] [--threads <n,m,...>] [--min-time <sec>] [--reps <int>]"
+              << std :: endl
+              << "Default parameters:" << std :: endl
+              << "\tformat = json" << std :: endl
+              << "\toutput = stdout" << std :: endl
+              << "\tfilter = all the benchmarks" << std :: endl
+              << "\tthreads = 1 and the maximum number of threads" << std :: endl
+              << "\tmin-time = 0.5" << std :: endl
+              << "\treps = 3" << std :: endl
+              << std :: endl;
+  std :: exit(1);
+}
+
+
+int main (int argc, char ** argv)
+{
+  std :: string format = "json";
+  std :: string output = "";
+  std :: string filter = "";
+  double min_time = .5;
+  int32_t min_reps = 3;
+
+  std :: vector < int32_t > threads = {1};
+#ifdef _OPENMP
+  if (omp_get_max_threads() > 1)
+    threads.push_back(omp_get_max_threads());
+#endif
+
+  for (int32_t i = 1; i < argc; ++i)
+  {
+    const std :: string arg = argv[i];
+
+    if (i + 1 == argc)
+      usage(argv);
+
+    const std :: string value = argv[++i];
+
+    if      (arg == "--format")   format = value;
+    else if (arg == "--output")   output = value;
+    else if (arg == "--filter")   filter = value;
+    else if (arg == "--min-time") min_time = std :: stod(value);
+    else if (arg == "--reps")     min_reps = std :: stoi(value);
+    else if (arg == "--threads")
+    {
+      threads.clear();
+      std :: stringstream ss(value);
+      std :: string token;
+      while (std :: getline(ss, token, ','))
+        threads.push_back(std :: stoi(token));
+    }
+    else
+      usage(argv);
+  }
+
+  if ( (format != "json" && format != "csv") || threads.empty() )
+    usage(argv);
+
+  std :: vector < bench_result > results;
+
+  for (const auto & b : make_benchmarks())
+  {
+    if ( !filter.empty() && b.name.find(filter) == std :: string :: npos )
+      continue;
+
+    for (const auto & size : b.sizes)
+      for (const auto & nth : threads)
+      {
+        if ( !b.parallel && nth != threads.front() )
+          continue;
+
+        results.push_back(run(b, size, b.parallel ? nth : 1, min_time, min_reps));
+
+        const bench_result & r = results.back();
+        std :: cerr << std :: left << std :: setw(24) << r.name
+                    << " size: " << std :: setw(8) << r.size
+                    << " threads: " << std :: setw(3) << r.threads
+                    << " " << r.ns_per_op << " ns/" << r.unit
+                    << std :: endl;
+      }
+  }
+
+  std :: ofstream os;
+  if ( !output.empty() )
+    os.open(output);
+
+  std :: ostream & out = output.empty() ? std :: cout : os;
+
+  if (format == "json")
+    dump_json(out, results);
+  else
+    dump_csv(out, results);
+
+  PROFILE_REPORT(std :: cerr, "text");
+
+  return 0;
+}
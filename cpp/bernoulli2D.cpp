@@ -1,8 +1,21 @@
-//g++ bernoulli.cpp -O3 -std=c++11 `pkg-config opencv --cflags --libs` -o bernoulli -lpthread
+//g++ bernoulli2D.cpp ../src/bernoulli.cpp -O3 -std=c++14 -fopenmp -I../include -o bernoulli2D
+//g++ bernoulli2D.cpp ../src/bernoulli.cpp -O3 -std=c++14 -fopenmp -I../include -DOPENCV `pkg-config opencv --cflags --libs` -o bernoulli2D
 #include <iostream>
-#include <thread>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <cassert>
+#ifdef OPENCV
 #include <opencv2/opencv.hpp>
+#endif
 
+#include <bernoulli.h>
+
+
+#ifdef OPENCV
 
 void view (const std :: string & name, cv :: Mat & img, int32_t ms=1)
 {
@@ -27,29 +40,7 @@ void view (const std :: string & name, cv :: Mat & img, int32_t ms=1)
   }
 }
 
-
-void bernoulli (cv :: Mat & G,
-                const int64_t & iteration)
-{
-
-  const std :: string name = "Bernoulli Pattern";
-  cv :: namedWindow(name, cv :: WINDOW_FULLSCREEN );
-
-
-  for (int64_t t = 0; t < iteration; ++t)
-  {
-    std :: thread display = std :: thread(view, name, std :: ref(G), 10);
-
-    G = (2 * G);
-    cv :: subtract(G, 1., G, (G > 1.));
-
-    //std :: cout << "\rIter: " << t << std :: flush;
-    cv :: setWindowTitle(name, name + " (Iter: " + std :: to_string(t) + ")");
-    display.join();
-  }
-  //std :: cout << "\rIter: " << iteration << std :: endl;
-}
-
+#endif // OPENCV
 
 
 void usage (char ** argv)
@@ -99,9 +90,52 @@ void parse_args (int32_t argc, char ** argv,
 }
 
 
+/**
+* @brief Compare the double and the fixed point lattices
+*
+* @details The values with 48 significant bits are exact in both
+* representations, so the two orbits must match bit by bit (up to
+* the collapse to 0 after 48 iterations).
+*
+*/
+void check_backends ()
+{
+  const int64_t size = 4096;
+
+  std :: unique_ptr < double[] > G(new double[size]);
+  std :: unique_ptr < double[] > H(new double[size]);
+
+  std :: mt19937_64 eng(42);
+  for (int64_t i = 0; i < size; ++i)
+    G[i] = std :: ldexp(static_cast < double >(eng() >> 16), -48);
+
+  // the dyadic values which hit 1 after a doubling
+  const double dyadic[] = {0., .5, .25, .75, .375, .0625};
+  std :: copy(std :: begin(dyadic), std :: end(dyadic), G.get());
+
+  fixed_lattice F(size, 2);
+  F.from_double(G.get());
+
+  for (int32_t round = 0; round < 3; ++round)
+  {
+    bernoulli(G.get(), size, 20, 7);
+    bernoulli(F, 20);
+    F.to_double(H.get());
+
+    assert (std :: equal(G.get(), G.get() + size, H.get()));
+  }
+
+  std :: cout << "double and fixed point orbits match" << std :: endl;
+}
+
+
 int main (int argc, char ** argv)
 {
+  check_backends();
+
   const int64_t dim = 512;
+  const int64_t iterations = 100;
+  const int32_t words = 4; // 256 bits of precision
 
   double mean_x = 0.5;
   double mean_y = 0.5;
@@ -110,7 +144,7 @@ int main (int argc, char ** argv)
 
   parse_args(argc, argv, mean_x, mean_y, std_x, std_y);
 
-  cv :: Mat G(dim, dim, CV_64FC1);
+  std :: unique_ptr < double[] > G(new double[dim * dim]);
 
   for (int32_t i = 0; i < dim; ++i)
     for (int32_t j = 0; j < dim; ++j)
@@ -119,12 +153,42 @@ int main (int argc, char ** argv)
       const double y = static_cast < double >(j) / dim;
       const double gx = .5 * (x - mean_x)*(x - mean_x) / (std_x * std_x);
       const double gy = .5 * (y - mean_y)*(y - mean_y) / (std_y * std_y);
-      G.at < double >(i, j) = std :: exp(- (gx + gy));
+      G[i * dim + j] = std :: exp(- (gx + gy));
     }
 
-  view("Initial condition", G, 0);
+  fixed_lattice F(dim * dim, words);
+  F.from_double(G.get(), 42);
+
+#ifdef OPENCV
+  cv :: Mat img(dim, dim, CV_64FC1, G.get());
+  view("Initial condition", img, 0);
+#endif
+
+  auto start_time = std :: chrono :: high_resolution_clock :: now();
+  bernoulli(G.get(), dim * dim, iterations);
+  auto run_time = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+  std :: cout << "double : " << iterations << " iterations in " << run_time << " sec ("
+              << dim * dim * iterations / run_time << " site-updates/sec), "
+              << std :: count_if(G.get(), G.get() + dim * dim, [](const double & g){return g == 0. || g == 1.;})
+              << " sites collapsed to 0 or 1"
+              << std :: endl;
+
+  start_time = std :: chrono :: high_resolution_clock :: now();
+  bernoulli(F, iterations);
+  run_time = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+  F.to_double(G.get());
+
+  std :: cout << "fixed  : " << iterations << " iterations in " << run_time << " sec ("
+              << dim * dim * iterations / run_time << " site-updates/sec), "
+              << std :: count_if(G.get(), G.get() + dim * dim, [](const double & g){return g == 0. || g == 1.;})
+              << " sites collapsed to 0 or 1"
+              << std :: endl;
 
-  bernoulli(G, 100);
+#ifdef OPENCV
+  view("Bernoulli Pattern", img, 0);
+#endif
 
   return 0;
 }
@@ -0,0 +1,100 @@
+// g++ bifurcation.cpp -std=c++14 -O3 -march=native -fopenmp -I../include -o bifurcation
+
+#include <iostream>
+#include <memory>
+#include <algorithm>
+#include <numeric>
+#include <chrono>
+#include <string>
+#include <cmath>
+#include <cassert>
+#ifdef OPENCV
+#include <opencv2/opencv.hpp>
+#endif
+
+#include <bifurcation.hpp>
+
+
+int main (int argc, char ** argv)
+{
+  int64_t Nparams = 4096;
+  int64_t transient = 1000;
+  int64_t samples = 10000;
+  const int64_t bins = 1024;
+
+  if (argc > 1)
+    Nparams = std :: stoll(argv[1]);
+  if (argc > 2)
+    transient = std :: stoll(argv[2]);
+  if (argc > 3)
+    samples = std :: stoll(argv[3]);
+
+  // coefficient values (same range of py/bifurcation.py)
+  std :: unique_ptr < double[] > mu(new double[Nparams]);
+  std :: generate_n(mu.get(), Nparams, [n = 0, Nparams] () mutable { return .5 + .5 * n++ / (Nparams - 1); });
+
+  std :: unique_ptr < uint32_t[] > histogram(new uint32_t[Nparams * bins]);
+  std :: unique_ptr < double[] > lyapunov(new double[Nparams]);
+  std :: fill_n(histogram.get(), Nparams * bins, 0u);
+
+  const auto start_time = std :: chrono :: high_resolution_clock :: now();
+
+  bifurcation_sweep([](const double & m) { return logistic_map < double >(m); },
+                    mu.get(), Nparams, .5,
+                    transient, samples,
+                    0., 1., bins,
+                    histogram.get(), lyapunov.get());
+
+  const double run_time = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+  // onset of chaos as the first parameter with positive Lyapunov exponent
+  const auto chaos = std :: find_if(lyapunov.get(), lyapunov.get() + Nparams, [](const double & l) { return l > 0.; });
+
+  std :: cout << "Sweep of " << Nparams << " parameters in " << run_time << " sec ("
+              << static_cast < double >(Nparams) * (transient + samples) / run_time << " map-iterations/sec)"
+              << std :: endl;
+
+  // Feigenbaum point r = 3.5699456... of x -> r x (1 - x)
+  const double onset = 3.5699456718695445 / 4.;
+
+  assert (chaos != lyapunov.get() + Nparams);
+  std :: cout << "Onset of chaos: mu = " << mu[chaos - lyapunov.get()] << " (expected " << onset << ")" << std :: endl;
+  assert (std :: abs(mu[chaos - lyapunov.get()] - onset) < 1e-3);
+
+  // stable fixed point x = 0.6 (r = 2.5, lambda = log 0.5) and fully developed chaos (lambda = log 2)
+  {
+    const double check_mu[2] = {.625, 1.};
+    std :: unique_ptr < uint32_t[] > check_histogram(new uint32_t[2 * bins]);
+    double check_lyapunov[2];
+    std :: fill_n(check_histogram.get(), 2 * bins, 0u);
+
+    bifurcation_sweep([](const double & m) { return logistic_map < double >(m); },
+                      check_mu, 2, .3, 1000, 100000, 0., 1., bins, check_histogram.get(), check_lyapunov);
+
+    std :: cout << "Lyapunov exponent: " << check_lyapunov[0] << " (expected " << std :: log(.5) << "), "
+                << check_lyapunov[1] << " (expected " << std :: log(2.) << ")" << std :: endl;
+
+    assert (std :: abs(check_lyapunov[0] - std :: log(.5)) < 1e-6);
+    assert (std :: abs(check_lyapunov[1] - std :: log(2.)) < 1e-2);
+
+    // every sample of the fixed point is in its bin, the chaotic ones are spread over the whole interval
+    assert (check_histogram[static_cast < int64_t >(.6 * bins)] == 100000u);
+    assert (std :: accumulate(check_histogram.get() + bins, check_histogram.get() + 2 * bins, 0u) == 100000u);
+    assert (std :: count(check_histogram.get() + bins, check_histogram.get() + 2 * bins, 0u) < bins / 100);
+  }
+
+#ifdef OPENCV
+  // state on the rows, parameter on the columns (log-density)
+  cv :: Mat img(bins, Nparams, CV_32FC1);
+  for (int64_t i = 0; i < Nparams; ++i)
+    for (int64_t j = 0; j < bins; ++j)
+      img.at < float >(bins - 1 - j, i) = std :: log1p(static_cast < float >(histogram[i * bins + j]));
+
+  cv :: normalize(img, img, 0, 255, cv :: NORM_MINMAX);
+  img.convertTo(img, CV_8UC1);
+  cv :: imshow("Bifurcation diagram", 255 - img);
+  cv :: waitKey(0);
+#endif
+
+  return 0;
+}
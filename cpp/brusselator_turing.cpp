@@ -1,7 +1,29 @@
-//g++ brusselator.cpp -O3 -std=c++11 `pkg-config opencv --cflags --libs` -o brusselator -lpthread
+//g++ brusselator_turing.cpp ../src/checkpoint.cpp -O3 -std=c++14 -fopenmp -pthread -I../include -o brusselator_turing
+//g++ brusselator_turing.cpp ../src/checkpoint.cpp -O3 -std=c++14 -fopenmp -pthread -I../include -DOPENCV `pkg-config opencv --cflags --libs` -o brusselator_turing
 #include <iostream>
-#include <thread>
+#include <random>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <memory>
+#include <algorithm>
+#ifdef OPENCV
 #include <opencv2/opencv.hpp>
+#endif
+
+#include <brusselator.hpp>
+#include <checkpoint.h>
+#include <profiler.hpp>
+
+// -DMIXED_PRECISION stores the fields in float (the arithmetic is always double)
+#ifdef MIXED_PRECISION
+using field_type = float;
+#else
+using field_type = double;
+#endif
+
+
+#ifdef OPENCV
 
 /**
 * @brief OpenCV viewer
@@ -43,60 +65,7 @@ void view (const std :: string & name, cv :: Mat & img, int32_t ms=1)
   }
 }
 
-/**
-* @brief Brusselator diffusion model
-*
-* @note The visualization of the 1st morphogen
-* is performed asynchronously during the update
-* computation using std :: thread.
-*
-* @param U OpenCV Mat of the 1st morphogen
-* @param V OpenCV Mat of the 2nd morphogen
-* @param dt Interval of time
-* @param A Kinetic reaction constant
-* @param B Kinetic reaction constant
-* @param Du Diffusion coef of the 1st morphogen
-* @param Dv Diffusion coef of the 2nd morphogen
-* @param iteration Number of iterations to perform
-*
-*/
-void diffusion (cv :: Mat & U, cv :: Mat & V,
-                const double & dt,
-                const double & A, const double & B,
-                const double & Du, const double & Dv,
-                const int64_t & iteration)
-{
-
-  const std :: string name = "Turing Pattern";
-  cv :: namedWindow(name, cv :: WINDOW_FULLSCREEN );
-
-
-  for (int64_t t = 0; t < iteration; ++t)
-  {
-    std :: thread display = std :: thread(view, name, std :: ref(U), 1);
-
-    cv :: Mat lap_u;
-    cv :: Mat lap_v;
-
-    // a wrap boundary condition should be more appropriated
-    // but unfortunately OpenCV Laplacian doesn't support it :(
-    cv :: Laplacian(U, lap_u, CV_64FC1, 1, 1, 0, cv :: BORDER_REFLECT_101);
-    cv :: Laplacian(V, lap_v, CV_64FC1, 1, 1, 0, cv :: BORDER_REFLECT_101);
-
-    cv :: Mat uuv = U.mul(U.mul(V));
-
-    cv :: Mat Ut = dt * (Du * lap_u + (A - (B + 1.) * U + uuv)) + U;
-    cv :: Mat Vt = dt * (Dv * lap_v + (B * U - uuv)) + V;
-
-    U = Ut.clone();
-    V = Vt.clone();
-
-    //std :: cout << "\rTime: " << dt * t << std :: flush;
-    cv :: setWindowTitle(name, name + " (Time: " + std :: to_string(dt * t) + ")");
-    display.join();
-  }
-  //std :: cout << "\rTime: " << dt * iteration << std :: endl;
-}
+#endif // OPENCV
 
 
 /**
@@ -109,7 +78,7 @@ void diffusion (cv :: Mat & U, cv :: Mat & V,
 */
 void usage (char ** argv)
 {
-  std :: cerr << "Usage: " << argv[0] << " [A <double>] [B <double>] [Dx <double>] [Dy <double>] [dt <double>]"
+  std :: cerr << "Usage: " << argv[0] << " [A <double>] [B <double>] [Dx <double>] [Dy <double>] [dt <double>] [checkpoint <filename>]"
               << std :: endl
               << "Default parameters:" << std :: endl
               << "\tA = 4.5" << std :: endl
@@ -117,6 +86,7 @@ void usage (char ** argv)
               << "\tDx = 2.0" << std :: endl
               << "\tDy = 16.0" << std :: endl
               << "\tdt = 0.005" << std :: endl
+              << "\tcheckpoint = none (if given, the run restarts from the file)" << std :: endl
               << std :: endl;
   std :: exit(1);
 }
@@ -139,11 +109,12 @@ void usage (char ** argv)
 * @param Dx Diffusion coef of the 1st morphogen
 * @param Dy Diffusion coef of the 2nd morphogen
 * @param dt Interval of time
+* @param checkpoint Checkpoint filename
 *
 */
 void parse_args (int32_t argc, char ** argv,
                  double & A, double & B, double & Dx, double & Dy,
-                 double & dt)
+                 double & dt, std :: string & checkpoint)
 {
   switch (argc)
   {
@@ -159,22 +130,27 @@ void parse_args (int32_t argc, char ** argv,
     case 3:
     {
       B = std :: stod(argv[2]);
-      parse_args(2, argv, A, B, Dx, Dy, dt);
+      parse_args(2, argv, A, B, Dx, Dy, dt, checkpoint);
     } break;
     case 4:
     {
       Dx = std :: stod(argv[3]);
-      parse_args(3, argv, A, B, Dx, Dy, dt);
+      parse_args(3, argv, A, B, Dx, Dy, dt, checkpoint);
     } break;
     case 5:
     {
       Dy = std :: stod(argv[4]);
-      parse_args(4, argv, A, B, Dx, Dy, dt);
+      parse_args(4, argv, A, B, Dx, Dy, dt, checkpoint);
     } break;
     case 6:
     {
       dt = std :: stod(argv[5]);
-      parse_args(5, argv, A, B, Dx, Dy, dt);
+      parse_args(5, argv, A, B, Dx, Dy, dt, checkpoint);
+    } break;
+    case 7:
+    {
+      checkpoint = argv[6];
+      parse_args(6, argv, A, B, Dx, Dy, dt, checkpoint);
     } break;
   }
 }
@@ -183,27 +159,96 @@ void parse_args (int32_t argc, char ** argv,
 int main (int argc, char ** argv)
 {
   const int64_t dim = 512;
+  const int64_t iterations = 6000;
 
   double A = 4.5;
   double B = 4.5;
   double Du = 2.;
   double Dv = 16.;
   double dt = .005;
+  std :: string checkpoint;
 
-  parse_args(argc, argv, A, B, Du, Dv, dt);
+  parse_args(argc, argv, A, B, Du, Dv, dt, checkpoint);
 
-  cv :: Mat U(dim, dim, CV_64FC1);
-  cv :: Mat V(dim, dim, CV_64FC1);
+  std :: mt19937 eng(42);
+  std :: uniform_real_distribution < double > uniform(0., 1.);
 
-  cv :: randu(U, cv :: Scalar(0.), cv :: Scalar(1.));
-  cv :: randu(V, cv :: Scalar(0.), cv :: Scalar(1.));
+  std :: vector < field_type > U(dim * dim);
+  std :: vector < field_type > V(dim * dim);
 
-  U = A + .3 * U;
-  V = B/A + .3 * V;
+  std :: generate(U.begin(), U.end(), [&] () { return A + .3 * uniform(eng); });
+  std :: generate(V.begin(), V.end(), [&] () { return B / A + .3 * uniform(eng); });
 
-  view("Initial condition", U, 0);
+  int64_t first = 0;
+
+  // the fields are the whole state: a snapshot is written (in background)
+  // every checkpoint_every iterations
+  const int64_t checkpoint_every = 500;
+  std :: unique_ptr < checkpoint_writer > writer;
+
+  if ( !checkpoint.empty() )
+  {
+    checkpoint_reader snapshot(checkpoint);
+
+    if (snapshot.valid() && snapshot.read("U", U.data(), U.size() * sizeof(field_type)) && snapshot.read("V", V.data(), V.size() * sizeof(field_type)))
+    {
+      first = snapshot.iteration();
+      std :: cout << "Restarted from " << checkpoint << " at iteration " << first << std :: endl;
+    }
+
+    writer.reset(new checkpoint_writer(checkpoint));
+  }
+
+#ifdef OPENCV
+
+  const std :: string name = "Turing Pattern";
+
+  // the display interval divides checkpoint_every, so the snapshots are the same of the batch run
+  const int64_t chunk = 10;
+
+  cv :: Mat img(dim, dim, cv :: DataType < field_type > :: type, U.data());
+  view("Initial condition", img, 0);
+
+  cv :: namedWindow(name, cv :: WINDOW_FULLSCREEN );
+
+#else
+
+  const int64_t chunk = writer ? checkpoint_every : iterations;
+
+#endif // OPENCV
+
+  const auto start_time = std :: chrono :: high_resolution_clock :: now();
+
+  for (int64_t t = first; t < iterations; t += chunk)
+  {
+    const int64_t n = std :: min(chunk, iterations - t);
+
+    brusselator_diffusion(U.data(), V.data(), dim, dim, dt, A, B, Du, Dv, n);
+
+    if (writer && ((t + n) % checkpoint_every == 0 || t + n == iterations))
+    {
+      writer->begin(t + n, dt * (t + n));
+      writer->add("U", U);
+      writer->add("V", V);
+      writer->commit();
+    }
+
+#ifdef OPENCV
+    cv :: setWindowTitle(name, name + " (Time: " + std :: to_string(dt * (t + n)) + ")");
+    view(name, img, 1);
+#endif
+  }
+
+  if (writer && !writer->wait())
+    std :: cerr << "Error writing the checkpoint " << checkpoint << std :: endl;
+
+  const double run_time = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+  std :: cout << iterations - first << " iterations in " << run_time << " sec ("
+              << dim * dim * (iterations - first) / run_time << " site-updates/sec)"
+              << std :: endl;
 
-  diffusion(U, V, dt, A, B, Du, Dv, 6000);
+  PROFILE_REPORT(std :: cerr, "text");
 
   return 0;
 }
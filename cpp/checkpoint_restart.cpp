@@ -0,0 +1,137 @@
+// g++ checkpoint_restart.cpp ../src/checkpoint.cpp ../src/chemical_master_equation.cpp -O3 -std=c++14 -fopenmp -pthread -I../include -o checkpoint_restart
+
+#include <iostream>
+#include <random>
+#include <vector>
+#include <string>
+#include <limits>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <cassert>
+
+#include <brusselator.hpp>
+#include <checkpoint.h>
+#include <chemical_master_equation.h>
+
+
+/**
+* @brief Byte for byte comparison of two arrays
+*
+*/
+template < class type >
+bool same_bytes (const std :: vector < type > & a, const std :: vector < type > & b)
+{
+  return a.size() == b.size() && std :: memcmp(a.data(), b.data(), a.size() * sizeof(type)) == 0;
+}
+
+
+int main ()
+{
+  // Turing fields (as brusselator_turing.cpp): N steps against k steps,
+  // a snapshot, a restore in new buffers and the remaining N - k steps
+  {
+    const int64_t rows = 96;
+    const int64_t cols = 80;
+    const int64_t N = 400;
+    const int64_t k = 150;
+
+    const double A = 4.5;
+    const double B = 4.5;
+    const double Du = 2.;
+    const double Dv = 16.;
+    const double dt = .005;
+
+    const std :: string filename = "checkpoint_restart_turing.ckpt";
+    std :: remove(filename.c_str());
+
+    std :: mt19937 eng(42);
+    std :: uniform_real_distribution < double > uniform(0., 1.);
+
+    std :: vector < double > U(rows * cols);
+    std :: vector < double > V(rows * cols);
+
+    std :: generate(U.begin(), U.end(), [&] () { return A + .3 * uniform(eng); });
+    std :: generate(V.begin(), V.end(), [&] () { return B / A + .3 * uniform(eng); });
+
+    std :: vector < double > Uk = U;
+    std :: vector < double > Vk = V;
+
+    brusselator_diffusion(U.data(), V.data(), rows, cols, dt, A, B, Du, Dv, N);
+
+    brusselator_diffusion(Uk.data(), Vk.data(), rows, cols, dt, A, B, Du, Dv, k);
+
+    {
+      checkpoint_writer writer(filename);
+
+      writer.begin(k, dt * k);
+      writer.add("U", Uk);
+      writer.add("V", Vk);
+      writer.commit();
+
+      assert (writer.wait());
+    }
+
+    std :: vector < double > Ur(rows * cols, std :: numeric_limits < double > :: quiet_NaN());
+    std :: vector < double > Vr(rows * cols, std :: numeric_limits < double > :: quiet_NaN());
+
+    checkpoint_reader snapshot(filename);
+
+    assert (snapshot.valid() && snapshot.iteration() == k);
+    assert (snapshot.read("U", Ur) && snapshot.read("V", Vr));
+
+    brusselator_diffusion(Ur.data(), Vr.data(), rows, cols, dt, A, B, Du, Dv, N - snapshot.iteration());
+
+    assert (same_bytes(U, Ur) && same_bytes(V, Vr));
+
+    std :: cout << "Turing fields: " << N << " steps and " << k << " + restart + " << N - k << " steps are bit-exact" << std :: endl;
+
+    std :: remove(filename.c_str());
+  }
+
+  // stochastic Brusselator: an uninterrupted run against a run stopped
+  // at half time and restarted (from its last snapshot) up to the end
+  {
+    const double A = 2.;
+    const double B = 5.2;
+    const double omega = 100.;
+    const double max_time = 20.;
+    const std :: size_t seed = 42;
+    const int64_t checkpoint_every = 1000;
+
+    const std :: string filename = "checkpoint_restart_cme.ckpt";
+    std :: remove(filename.c_str());
+    std :: remove((filename + ".stream").c_str());
+
+    std :: vector < double > x = {1.6};
+    std :: vector < double > y = {2.8};
+    std :: vector < double > t = {0.};
+
+    BrusselatorCME(x, y, t, A, B, omega, max_time, seed);
+
+    std :: vector < double > xk = {1.6};
+    std :: vector < double > yk = {2.8};
+    std :: vector < double > tk = {0.};
+
+    const bool resumed = BrusselatorCME(xk, yk, tk, A, B, omega, .5 * max_time, seed, filename, checkpoint_every);
+
+    assert ( !resumed && tk.size() > static_cast < std :: size_t >(checkpoint_every) && tk.size() < t.size());
+
+    std :: vector < double > xr = {1.6};
+    std :: vector < double > yr = {2.8};
+    std :: vector < double > tr = {0.};
+
+    const bool restarted = BrusselatorCME(xr, yr, tr, A, B, omega, max_time, seed, filename, checkpoint_every);
+
+    assert (restarted);
+    assert (same_bytes(x, xr) && same_bytes(y, yr) && same_bytes(t, tr));
+
+    std :: cout << "Stochastic Brusselator: " << t.size() - 1 << " events and the run restarted at time "
+                << .5 * max_time << " are bit-exact" << std :: endl;
+
+    std :: remove(filename.c_str());
+    std :: remove((filename + ".stream").c_str());
+  }
+
+  return 0;
+}
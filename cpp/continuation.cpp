@@ -0,0 +1,145 @@
+// g++ continuation.cpp -std=c++14 -O3 -march=native -I../include -o continuation
+
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <cmath>
+#include <cassert>
+
+#include <continuation.hpp>
+#include <profiler.hpp>
+
+
+template < class model >
+void print_special_points (const std :: vector < equilibrium < model > > & branch, const char * name)
+{
+  for (const auto & e : branch)
+  {
+    if (e.kind == point_type :: regular)
+      continue;
+
+    std :: cout << "  " << (e.kind == point_type :: hopf ? "Hopf" : "Saddle-node")
+                << " at " << name << " = " << e.parameter << " : (";
+    for (int32_t i = 0; i < model :: Nvar; ++i)
+      std :: cout << e.y[i] << (i + 1 < model :: Nvar ? ", " : ")");
+    if (e.kind == point_type :: hopf)
+      std :: cout << " frequency " << e.frequency;
+    std :: cout << std :: endl;
+  }
+}
+
+
+/**
+* @brief Special points of a kind on a branch
+*
+*/
+template < class model >
+std :: vector < equilibrium < model > > special_points (const std :: vector < equilibrium < model > > & branch, const point_type & kind)
+{
+  std :: vector < equilibrium < model > > points;
+  std :: copy_if(branch.begin(), branch.end(), std :: back_inserter(points),
+                 [&](const equilibrium < model > & e) { return e.kind == kind; });
+  return points;
+}
+
+/**
+* @brief Folds of the toggle switch branch in ax (reference)
+*
+* @details On the branch y = ay / (1 + x^3) and ax = x (1 + y^3), so
+* the folds are the zeros of d ax / dx, found by bisection.
+*
+*/
+double toggle_switch_fold (double lo, double hi, const double & ay)
+{
+  auto slope = [&](const double & x)
+               {
+                 const double y = ay / (1. + x * x * x);
+                 const double dy = -3. * ay * x * x / ((1. + x * x * x) * (1. + x * x * x));
+                 return 1. + y * y * y + 3. * x * y * y * dy;
+               };
+
+  const bool rising = slope(lo) > 0.;
+
+  for (int32_t it = 0; it < 100; ++it)
+  {
+    const double mid = .5 * (lo + hi);
+    if ((slope(mid) > 0.) == rising)
+      lo = mid;
+    else
+      hi = mid;
+  }
+
+  const double x = .5 * (lo + hi);
+  const double y = ay / (1. + x * x * x);
+  return x * (1. + y * y * y);
+}
+
+
+int main ()
+{
+  // Brusselator: fixed point (A, B / A), Hopf bifurcation at B = 1 + A^2 (cpy/fast_brusselator.py)
+  {
+    using model = brusselator_model < double >;
+
+    const double A = 1.;
+    const double params[2] = {A, 1.};
+    const double y0[2] = {A, 1. / A};
+
+    const auto start_time = std :: chrono :: high_resolution_clock :: now();
+
+    const auto branch = continuation < model >(y0, params, 1, 0., 3.);
+
+    const double run_time = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+    std :: cout << "Brusselator (A = " << A << "): " << branch.size() << " points in " << run_time * 1e3 << " ms" << std :: endl;
+    print_special_points(branch, "B");
+    std :: cout << "  expected Hopf at B = " << 1. + A * A << " frequency " << A << std :: endl;
+
+    const auto hopf = special_points(branch, point_type :: hopf);
+
+    assert (hopf.size() == 1 && special_points(branch, point_type :: saddle_node).empty());
+    assert (std :: abs(hopf[0].parameter - (1. + A * A)) < 1e-6);
+    assert (std :: abs(hopf[0].frequency - A) < 1e-6);
+    assert (std :: abs(hopf[0].y[0] - A) < 1e-6 && std :: abs(hopf[0].y[1] - hopf[0].parameter / A) < 1e-6);
+  }
+
+  // Asymmetric toggle switch (py/toggle_switch.py): S-shaped branch in ax with two folds
+  {
+    using model = toggle_switch_model < double >;
+
+    const double params[4] = {.5, 2., 3., 3.};
+    const double y0[2] = {.5, 2.};
+
+    const auto start_time = std :: chrono :: high_resolution_clock :: now();
+
+    const auto branch = continuation < model >(y0, params, 0, 0., 4.);
+
+    const double run_time = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+    std :: cout << "Toggle switch (ay = 2, bx = by = 3): " << branch.size() << " points in " << run_time * 1e3 << " ms" << std :: endl;
+    print_special_points(branch, "ax");
+
+    int32_t bistable = 0;
+    for (const auto & e : branch)
+      bistable += e.unstable ? 1 : 0;
+    std :: cout << "  unstable points on the branch: " << bistable << std :: endl;
+
+    // the upper fold is the maximum of ax(x) on the branch, the lower one its minimum
+    const double upper = toggle_switch_fold(.2, 1., params[1]);
+    const double lower = toggle_switch_fold(1., 3., params[1]);
+    std :: cout << "  expected Saddle-node at ax = " << upper << " and ax = " << lower << std :: endl;
+
+    const auto folds = special_points(branch, point_type :: saddle_node);
+
+    assert (folds.size() == 2 && special_points(branch, point_type :: hopf).empty());
+    assert (std :: abs(folds[0].parameter - upper) < 1e-6);
+    assert (std :: abs(folds[1].parameter - lower) < 1e-6);
+    assert (bistable > 0);
+  }
+
+  PROFILE_REPORT(std :: cerr, "text");
+
+  return 0;
+}
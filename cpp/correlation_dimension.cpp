@@ -0,0 +1,94 @@
+// g++ correlation_dimension.cpp -std=c++14 -O3 -march=native -fopenmp -I../include -o correlation_dimension
+
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cassert>
+
+#include <grassberger_procaccia.hpp>
+#include <ode_models.hpp>
+#include <profiler.hpp>
+
+
+int main (int argc, char ** argv)
+{
+  int64_t N = 10000;
+  int32_t max_dim = 8;
+
+  if (argc > 1)
+    N = std :: stoll(argv[1]);
+  if (argc > 2)
+    max_dim = std :: stoi(argv[2]);
+
+  using model = lorenz_model < double >;
+
+  // x component of the Lorenz attractor (same parameters of py/lorentz_attractor.py)
+  const double params[3] = {16., 45.92, 4.};
+  const double y0[3] = {10., 1., 1.};
+  const int64_t transient = 1000;
+  const int32_t delay = 10;
+  const int32_t Neps = 16;
+  const int64_t theiler = 20;
+
+  std :: vector < double > x(N);
+
+  rk4_sensitivity < model >(y0, params, .01, 2, transient + N,
+                            [&](const int64_t & k, const double * y, const double *)
+                            {
+                              if (k >= transient)
+                                x[k - transient] = y[0];
+                            }, false);
+
+  std :: vector < double > C(max_dim * Neps), eps(Neps);
+
+  // check the histograms against the direct count on a short series
+  {
+    const int64_t n = 500;
+    const int64_t Np = n - (max_dim - 1) * delay;
+    correlation_sums(x.data(), n, delay, max_dim, Neps, C.data(), eps.data(), 0., theiler);
+
+    for (int32_t m = 0; m < max_dim; ++m)
+      for (int32_t k = 0; k < Neps; k += 5)
+      {
+        int64_t count = 0, pairs = 0;
+        for (int64_t i = 0; i < Np; ++i)
+          for (int64_t j = i + theiler; j < Np; ++j)
+          {
+            double d = 0.;
+            for (int32_t l = 0; l <= m; ++l)
+              d += (x[i + l * delay] - x[j + l * delay]) * (x[i + l * delay] - x[j + l * delay]);
+            count += std :: sqrt(d) < eps[k];
+            ++pairs;
+          }
+        assert (std :: abs(C[m * Neps + k] - static_cast < double >(count) / pairs) < 1e-12);
+        (void)count;
+      }
+  }
+
+  // reference: a single dimension
+  auto start_time = std :: chrono :: high_resolution_clock :: now();
+
+  correlation_sums(x.data(), N, delay, 1, Neps, C.data(), eps.data(), 0., theiler);
+
+  const double single_time = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+  start_time = std :: chrono :: high_resolution_clock :: now();
+
+  correlation_sums(x.data(), N, delay, max_dim, Neps, C.data(), eps.data(), 0., theiler);
+
+  const double run_time = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+  std :: cout << "Correlation sums of " << max_dim << " embedding dimensions (" << N << " points) in " << run_time << " sec ("
+              << run_time / single_time << "x a single dimension, separate scans would cost at least " << max_dim << "x)" << std :: endl;
+
+  for (int32_t m = 0; m < max_dim; ++m)
+  {
+    const auto fit = correlation_fit(eps.data(), C.data() + m * Neps, Neps, 3);
+    std :: cout << "  m = " << m + 1 << " : correlation dimension " << fit[0] << " +/- " << fit[1] << std :: endl;
+  }
+
+  PROFILE_REPORT(std :: cerr, "text");
+
+  return 0;
+}
@@ -0,0 +1,228 @@
+// g++ coupled_map_lattice.cpp -std=c++14 -O3 -march=native -fopenmp -I../include -o coupled_map_lattice
+
+#include <iostream>
+#include <random>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cassert>
+
+#include <iterated_maps.hpp>
+
+/**
+* @brief Site-updates per second benchmark
+*
+* @param name Label of the benchmark.
+* @param updates Number of performed site updates.
+* @param func Function to time.
+*
+*/
+template < class Func >
+void benchmark (const std :: string & name, const double & updates, Func func)
+{
+  const auto start_time = std :: chrono :: high_resolution_clock :: now();
+  func();
+  const double run_time = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+  std :: cout << name << ": " << run_time << " sec ("
+              << updates / run_time << " site-updates/sec)"
+              << std :: endl;
+}
+
+
+/**
+* @brief Compare the ensemble engine with the scalar iteration of each trajectory
+*
+* @details The ensemble size is not a multiple of the block, so the
+* last (partial) block is checked too.
+*
+*/
+template < class Map >
+void check_ensemble (const std :: string & name, const Map & map, const double & scale, std :: mt19937 & eng)
+{
+  const int64_t N = 3 * maps :: block + 17;
+  const int64_t transient = 50;
+  const int64_t samples = 4;
+  const int64_t decimation = 3;
+
+  std :: uniform_real_distribution < double > uniform(0., 1.);
+
+  std :: unique_ptr < double[] > x(new double[Map :: dim * N]);
+  std :: unique_ptr < double[] > out(new double[Map :: dim * samples * N]);
+  std :: generate_n(x.get(), Map :: dim * N, [&](){return scale * uniform(eng);});
+
+  std :: unique_ptr < double[] > x0(new double[Map :: dim * N]);
+  std :: copy_n(x.get(), Map :: dim * N, x0.get());
+
+  iterate(map, x.get(), N, transient, samples, decimation, out.get());
+
+  for (int64_t i = 0; i < N; ++i)
+  {
+    std :: array < double, Map :: dim > s;
+    for (int32_t d = 0; d < Map :: dim; ++d)
+      s[d] = x0[d * N + i];
+
+    for (int64_t t = 0; t < transient; ++t)
+      map(s);
+
+    for (int64_t k = 0; k < samples; ++k)
+    {
+      for (int64_t t = 0; k && t < decimation; ++t)
+        map(s);
+
+      for (int32_t d = 0; d < Map :: dim; ++d)
+        assert (out[(d * samples + k) * N + i] == s[d]);
+    }
+
+    for (int32_t d = 0; d < Map :: dim; ++d)
+      assert (x[d * N + i] == s[d]);
+  }
+
+  std :: cout << name << ": ensemble matches the scalar orbits" << std :: endl;
+}
+
+/**
+* @brief Compare the Jacobian of a 2D map with central differences
+*
+*/
+template < class Map >
+double jacobian_error (const Map & map, const std :: array < double, 2 > & x)
+{
+  std :: array < double, 4 > J;
+  map.jacobian(x, J);
+
+  const double h = 1e-6;
+  double error = 0.;
+
+  for (int32_t j = 0; j < 2; ++j)
+  {
+    std :: array < double, 2 > xp = x, xm = x;
+    xp[j] += h;
+    xm[j] -= h;
+    map(xp);
+    map(xm);
+
+    for (int32_t i = 0; i < 2; ++i)
+      error = std :: max(error, std :: abs((xp[i] - xm[i]) / (2. * h) - J[i * 2 + j]));
+  }
+
+  return error;
+}
+
+
+int main (int argc, char ** argv)
+{
+  int64_t N = 1 << 20;
+  int64_t iterations = 1000;
+
+  if (argc > 1)
+    N = std :: stoll(argv[1]);
+  if (argc > 2)
+    iterations = std :: stoll(argv[2]);
+
+  const int64_t transient = iterations / 2;
+  const int64_t samples = 10;
+  const int64_t decimation = (iterations - transient) / samples;
+
+  std :: mt19937 eng(123);
+  std :: uniform_real_distribution < double > uniform(0., 1.);
+
+  const std :: array < double, 12 > henon = { {1., 0., -1.4, 0., 1., 0., 0., .3, 0., 0., 0., 0.} };
+
+  check_ensemble("logistic map", logistic_map < double >(.9), 1., eng);
+  check_ensemble("Bernoulli map", bernoulli_map < double >(), 1., eng);
+  check_ensemble("standard map", standard_map < double >(1.), 1., eng);
+  check_ensemble("Henon map", quadratic_map < double >(henon), .2, eng);
+
+  {
+    std :: array < double, 1 > half = { {.5} };
+    bernoulli_map < double >()(half);
+    assert (half[0] == 0.);
+  }
+
+  // the standard map preserves the area and the Henon map contracts it by b = 0.3
+  {
+    double error = 0.;
+    for (int32_t i = 0; i < 100; ++i)
+    {
+      const std :: array < double, 2 > x = { {.1 + .8 * uniform(eng), .1 + .8 * uniform(eng)} };
+      std :: array < double, 4 > J;
+
+      standard_map < double >(1.).jacobian(x, J);
+      assert (std :: abs(J[0] * J[3] - J[1] * J[2] - 1.) < 1e-12);
+
+      quadratic_map < double >(henon).jacobian(x, J);
+      assert (std :: abs(J[0] * J[3] - J[1] * J[2] + .3) < 1e-12);
+
+      error = std :: max(error, jacobian_error(quadratic_map < double >(henon), x));
+    }
+
+    std :: cout << "Henon Jacobian: max error against central differences " << error << std :: endl;
+    assert (error < 1e-8);
+  }
+
+  // the lattice against a direct evaluation of the coupling (odd sizes, periodic boundaries)
+  {
+    const int64_t rows = 7, cols = 5;
+    const double eps = .3;
+    coupled_map_lattice < logistic_map < double >, double > lattice(logistic_map < double >(.9), rows, cols, eps);
+    std :: generate_n(lattice.x.get(), rows * cols, [&](){return uniform(eng);});
+
+    std :: vector < double > ref(rows * cols);
+    std :: vector < double > f(rows * cols);
+
+    for (int32_t t = 0; t < 10; ++t)
+    {
+      ref.assign(lattice.x.get(), lattice.x.get() + rows * cols);
+      lattice.iterate(1);
+
+      for (int64_t i = 0; i < rows * cols; ++i)
+        f[i] = 3.6 * ref[i] * (1. - ref[i]);
+
+      for (int64_t r = 0; r < rows; ++r)
+        for (int64_t c = 0; c < cols; ++c)
+          ref[r * cols + c] = (1. - eps) * f[r * cols + c] + .25 * eps * (f[((r + rows - 1) % rows) * cols + c] + f[((r + 1) % rows) * cols + c] +
+                                                                           f[r * cols + (c + cols - 1) % cols] + f[r * cols + (c + 1) % cols]);
+
+      for (int64_t i = 0; i < rows * cols; ++i)
+        assert (std :: abs(lattice.x[i] - ref[i]) < 1e-14);
+    }
+
+    std :: cout << "coupled map lattice: matches the direct coupling" << std :: endl;
+  }
+
+  // Ensemble of logistic map trajectories
+  std :: unique_ptr < double[] > x(new double[N]);
+  std :: unique_ptr < double[] > out(new double[samples * N]);
+  std :: generate_n(x.get(), N, [&](){return uniform(eng);});
+
+  benchmark("logistic map (ensemble)", static_cast < double >(N) * (transient + (samples - 1) * decimation),
+            [&](){ iterate(logistic_map < double >(.9), x.get(), N, transient, samples, decimation, out.get()); });
+
+  // Ensemble of standard map trajectories
+  std :: unique_ptr < double[] > qp(new double[2 * N]);
+  std :: generate_n(qp.get(), 2 * N, [&](){return uniform(eng);});
+
+  benchmark("standard map (ensemble)", static_cast < double >(N) * (transient + (samples - 1) * decimation),
+            [&](){ iterate(standard_map < double >(1.), qp.get(), N, transient, samples, decimation); });
+
+  // Ensemble of quadratic map trajectories
+  std :: unique_ptr < double[] > xy(new double[2 * N]);
+  std :: generate_n(xy.get(), 2 * N, [&](){return .2 * uniform(eng);});
+
+  const std :: array < double, 12 > a = { {1.2, 0., -1., 0., .4, 0., 0., 1., 0., 0., 0., 0.} };
+
+  benchmark("quadratic map (ensemble)", static_cast < double >(N) * (transient + (samples - 1) * decimation),
+            [&](){ iterate(quadratic_map < double >(a), xy.get(), N, transient, samples, decimation); });
+
+  // Coupled logistic map lattice
+  const int64_t dim = static_cast < int64_t >(std :: sqrt(N));
+  coupled_map_lattice < logistic_map < double >, double > cml(logistic_map < double >(.9), dim, dim, .3);
+  std :: generate_n(cml.x.get(), dim * dim, [&](){return uniform(eng);});
+
+  benchmark("coupled logistic map lattice", static_cast < double >(dim * dim) * iterations,
+            [&](){ cml.iterate(iterations); });
+
+  return 0;
+}
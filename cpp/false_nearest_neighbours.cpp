@@ -0,0 +1,141 @@
+// g++ false_nearest_neighbours.cpp -std=c++14 -O3 -march=native -fopenmp -I../include -o false_nearest_neighbours
+
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <memory>
+#include <vector>
+#include <numeric>
+#include <limits>
+#include <cmath>
+#include <cassert>
+
+#include <false_nearest_neighbours.hpp>
+
+
+/**
+* @brief False nearest neighbours by exhaustive search (reference)
+*
+* @details Same criteria of false_nearest_neighbours, with the
+* neighbour of every point found among all the other points.
+*
+*/
+void brute_force (const double * x, const int64_t & N, const int32_t & max_dim, const int32_t & delay,
+                  const int64_t & theiler, double * fnn)
+{
+  const int64_t M = N - static_cast < int64_t >(max_dim) * delay;
+
+  const double mean = std :: accumulate(x, x + N, 0.) / N;
+  const double sigma = std :: sqrt(std :: inner_product(x, x + N, x, 0.) / N - mean * mean);
+
+  for (int32_t k = 1; k <= max_dim; ++k)
+  {
+    int64_t n_false = 0;
+    int64_t n_valid = 0;
+
+    for (int64_t i = 0; i < M; ++i)
+    {
+      double best = std :: numeric_limits < double > :: infinity();
+      int64_t j = -1;
+
+      for (int64_t l = 0; l < M; ++l)
+      {
+        if (std :: abs(l - i) <= theiler)
+          continue;
+
+        double d2 = 0.;
+        for (int32_t d = 0; d < k; ++d)
+          d2 += (x[i + d * delay] - x[l + d * delay]) * (x[i + d * delay] - x[l + d * delay]);
+
+        if (d2 < best)
+        {
+          best = d2;
+          j = l;
+        }
+      }
+
+      if (j < 0 || best <= 0.)
+        continue;
+
+      const double next = x[i + k * delay] - x[j + k * delay];
+
+      n_false += std :: abs(next) > 15. * std :: sqrt(best) || std :: sqrt(best + next * next) > 2. * sigma;
+      ++n_valid;
+    }
+
+    fnn[k - 1] = static_cast < double >(n_false) / n_valid;
+  }
+}
+
+
+int main (int argc, char ** argv)
+{
+  int64_t N = 1000000;
+  int32_t delay = 10;
+  const int32_t max_dim = 10;
+
+  if (argc > 1)
+    N = std :: stoll(argv[1]);
+  if (argc > 2)
+    delay = std :: stoi(argv[2]);
+
+  // Lorenz system (same parameters of py/false_nearest_neighbours.py)
+  const double dt = .01;
+  const double sigma = 16.;
+  const double b = 4.;
+  const double r = 45.92;
+
+  std :: unique_ptr < double[] > y(new double[N]);
+
+  double xi = 10.;
+  double yi = 1.;
+  double zi = 1.;
+
+  for (int64_t i = 0; i < N; ++i)
+  {
+    y[i] = yi;
+
+    const double vx = sigma * (yi - xi);
+    const double vy = -xi * zi + r * xi - yi;
+    const double vz = -b * zi + xi * yi;
+
+    xi += dt * vx;
+    yi += dt * vy;
+    zi += dt * vz;
+  }
+
+  std :: unique_ptr < double[] > fnn(new double[max_dim]);
+
+  const auto start_time = std :: chrono :: high_resolution_clock :: now();
+
+  const int32_t embedding = false_nearest_neighbours(y.get(), N, max_dim, delay, fnn.get(), 15., 2., static_cast < int64_t >(delay));
+
+  const double run_time = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+  std :: cout << "False nearest neighbours of " << N << " points in " << run_time << " sec" << std :: endl;
+  for (int32_t k = 0; k < max_dim; ++k)
+    std :: cout << "dim " << k + 1 << " : " << fnn[k] * 100. << " %" << std :: endl;
+  std :: cout << "Embedding dimension: " << embedding << std :: endl;
+
+  // the Lorenz attractor is embedded in 3 dimensions
+  assert (embedding == 3);
+  assert (fnn[0] > .9 && fnn[2] < .01);
+
+  // the k-d tree search against the exhaustive one
+  {
+    const int64_t n = std :: min(N, int64_t(3000));
+    std :: unique_ptr < double[] > ref(new double[max_dim]);
+
+    false_nearest_neighbours(y.get(), n, max_dim, delay, fnn.get(), 15., 2., static_cast < int64_t >(delay));
+    brute_force(y.get(), n, max_dim, delay, static_cast < int64_t >(delay), ref.get());
+
+    for (int32_t k = 0; k < max_dim; ++k)
+      assert (fnn[k] == ref[k]);
+
+    std :: cout << "k-d tree matches the exhaustive search on " << n << " points" << std :: endl;
+  }
+
+  PROFILE_REPORT(std :: cerr, "text");
+
+  return 0;
+}
@@ -0,0 +1,123 @@
+// g++ finite_state_projection.cpp ../src/finite_state_projection.cpp ../src/chemical_master_equation.cpp ../src/checkpoint.cpp -O3 -std=c++14 -fopenmp -pthread -I../include -o finite_state_projection
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <cmath>
+#include <cassert>
+
+#include <finite_state_projection.h>
+#include <chemical_master_equation.h>
+#include <profiler.hpp>
+
+
+/**
+* @brief Mean and standard deviation of a marginal distribution
+*
+*/
+std :: pair < double, double > moments (const std :: vector < double > & m)
+{
+  double mean = 0., second = 0.;
+  for (std :: size_t n = 0; n < m.size(); ++n)
+  {
+    mean += n * m[n];
+    second += n * n * m[n];
+  }
+  return std :: make_pair(mean, std :: sqrt(second - mean * mean));
+}
+
+
+int main (int argc, char ** argv)
+{
+  double max_time = 2.;
+  int32_t Nruns = 2000;
+
+  if (argc > 1)
+    max_time = std :: stod(argv[1]);
+  if (argc > 2)
+    Nruns = std :: stoi(argv[2]);
+
+  // birth-death from an empty system: the distribution is Poisson with mean k (1 - exp(-t))
+  {
+    const std :: vector < ssa_reaction > reactions = { {{}, {0}, 20.}, {{0}, {}, 1.} };
+
+    // a small initial projection, expanded by the solver
+    finite_state_projection fsp(1, reactions, 1., {0}, {5});
+
+    const bool ok = fsp.solve(max_time, 1e-8);
+    const auto m = fsp.marginal(0);
+
+    const double lambda = 20. * (1. - std :: exp(-max_time));
+    double err = 0., pk = std :: exp(-lambda);
+    for (std :: size_t n = 0; n < m.size(); ++n)
+    {
+      err = std :: max(err, std :: abs(m[n] - pk));
+      pk *= lambda / (n + 1.);
+    }
+
+    std :: cout << "Birth-death : " << fsp.states() << " states, max error vs Poisson " << err
+                << " (projection error " << fsp.error() << ")" << std :: endl;
+
+    assert (ok && err < 1e-8);
+  }
+
+  // Brusselator (same reactions of BrusselatorCME) at low copy numbers
+  const double A = 2.;
+  const double B = 5.2;
+  const double omega = 10.;
+  const int32_t x0 = 16;
+  const int32_t y0 = 28;
+
+  const std :: vector < ssa_reaction > brusselator = { {{},        {0},       A},   // 0 -> X
+                                                       {{0},       {1},       B},   // X -> Y
+                                                       {{0},       {},        1.},  // X -> 0
+                                                       {{0, 0, 1}, {0, 0, 0}, 1.}   // 2X + Y -> 3X
+                                                     };
+
+  finite_state_projection fsp(2, brusselator, omega, {x0, y0});
+
+  auto start_time = std :: chrono :: high_resolution_clock :: now();
+
+  const bool ok = fsp.solve(max_time, 1e-6);
+
+  const double fsp_time = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+  const auto mx = moments(fsp.marginal(0));
+  const auto my = moments(fsp.marginal(1));
+
+  // the same moments from an ensemble of SSA trajectories
+  start_time = std :: chrono :: high_resolution_clock :: now();
+
+  double sx = 0., sy = 0.;
+  for (int32_t run = 0; run < Nruns; ++run)
+  {
+    std :: vector < double > x = {static_cast < double >(x0)};
+    std :: vector < double > y = {static_cast < double >(y0)};
+    std :: vector < double > t = {0.};
+
+    BrusselatorCME(x, y, t, A, B, omega, max_time, run);
+
+    // the last event is after max_time
+    sx += x[x.size() - 2];
+    sy += y[y.size() - 2];
+  }
+  sx /= Nruns;
+  sy /= Nruns;
+
+  const double ssa_time = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+  std :: cout << "Brusselator at time " << max_time << " : " << fsp.states() << " states (bounds "
+              << fsp.bounds()[0] << ", " << fsp.bounds()[1] << "), projection error " << fsp.error() << std :: endl
+              << "  FSP : <x> = " << mx.first << " +/- " << mx.second << ", <y> = " << my.first << " +/- " << my.second
+              << " in " << fsp_time << " sec" << std :: endl
+              << "  SSA : <x> = " << sx << ", <y> = " << sy << " (" << Nruns << " runs in " << ssa_time << " sec)" << std :: endl;
+
+  // agreement within the sampling error of the ensemble
+  assert (ok && std :: abs(sx - mx.first) < 5. * mx.second / std :: sqrt(Nruns)
+             && std :: abs(sy - my.first) < 5. * my.second / std :: sqrt(Nruns));
+
+  PROFILE_REPORT(std :: cerr, "text");
+
+  return 0;
+}
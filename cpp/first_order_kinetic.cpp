@@ -1,51 +1,13 @@
-// g++ fist_order_kinetic.cpp -std=c++14 -O3 -o fist_order_kinetic
+// g++ fist_order_kinetic.cpp -std=c++14 -O3 -I../include -o fist_order_kinetic
 
 #include <memory>
 #include <algorithm>
-#include <type_traits>
+#include <vector>
+#include <cmath>
 #include <cassert>
 
-template < class type >
-using is_floating_point = typename std :: enable_if < std :: is_floating_point < type > :: value > :: type *;
-
-template < class type, is_floating_point < type > = nullptr >
-using array = std :: unique_ptr < type[] >;
-
-/**
-* @brief 1st order kinetic
-*
-* @param x List of time points.
-* @param p0 Initial condition of the product.
-* @param r0 Initial condition of the reagent.
-* @param kf Constant of the forward reaction.
-* @param kb Constant of the backward reaction.
-* @param P The resulting product array.
-* @param R The resulting reagent array.
-*
-* @tparam type Data-type of arrays
-* @tparam Length of time points.
-*
-*/
-template < class type, int32_t N >
-void first_order (const array < type > & x, const type & p0, const type & r0,
-                  const type & kf, const type & kb,
-                  array < type > & P, array < type > & R
-                 )
-{
-  // determine the interval as diff
-  const type dx = x[1] - x[0]; // Note: we are assuming it is constant!!
+#include <kinetics.hpp>
 
-  // Set the initial condition
-  P[0] = p0;
-  R[0] = r0;
-
-  // Integrate the equation using the Euler method
-  for (int32_t i = 0; i < N; ++i)
-  {
-    P[i + 1] = P[i] + ( kf * R[i] - kb * P[i]) * dx;
-    R[i + 1] = R[i] + (-kf * R[i] + kb * P[i]) * dx;
-  }
-}
 
 int32_t main (/*int32_t argc, char ** argv*/)
 {
@@ -73,5 +35,43 @@ int32_t main (/*int32_t argc, char ** argv*/)
   assert (std :: all_of(resulting_total.get(), resulting_total.get() + iterations,
                         [] (const float & tot) { return std :: abs(tot - 1.) < 1e-5f; }));
 
+  // analytic solution: R(t) = R_eq + (r0 - R_eq) exp(-(kf + kb) t)
+  const float r_eq = kb * (p0 + r0) / (kf + kb);
+  auto reagent = [&] (const double & t) { return r_eq + (r0 - r_eq) * std :: exp(-(kf + kb) * t); };
+
+  // exact exponential propagator on the same grid
+  const bool exact = first_order_exponential < float, iterations >(time, p0, r0, kf, kb, resulting_product, resulting_reagent);
+  assert (exact);
+
+  for (int32_t i = 0; i <= iterations; ++i)
+  {
+    assert (std :: abs(resulting_product[i] + resulting_reagent[i] - 1.f) < 1e-6f);
+    assert (std :: abs(resulting_reagent[i] - reagent(i * dt)) < 1e-5f);
+  }
+
+  // a batch of initial conditions advanced with coarse steps (the propagator is exact for any dt)
+  const int64_t Nbatch = 100000;
+  const double K[4] = {-kb,  kf,
+                        kb, -kf};
+  const exponential_propagator < float > step(K, nullptr, 2, 1.);
+
+  std :: vector < float > Y(2 * Nbatch);
+  for (int64_t j = 0; j < Nbatch; ++j)
+  {
+    Y[j] = static_cast < float >(j) / Nbatch;  // P
+    Y[Nbatch + j] = 1.f - Y[j];                // R
+  }
+
+  const bool applied = step.apply(Y.data(), Nbatch, 10);
+  assert (applied);
+
+  for (int64_t j = 0; j < Nbatch; j += 997)
+  {
+    const float r = 1.f - static_cast < float >(j) / Nbatch;
+    const float expected = r_eq + (r - r_eq) * std :: exp(-(kf + kb) * 10.f);
+    assert (std :: abs(Y[j] + Y[Nbatch + j] - 1.f) < 1e-6f);
+    assert (std :: abs(Y[Nbatch + j] - expected) < 1e-5f);
+  }
+
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,106 @@
+// g++ fit_model.cpp -std=c++14 -O3 -march=native -fopenmp -I../include -o fit_model
+
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <string>
+#include <limits>
+#include <cmath>
+#include <cassert>
+
+#include <parameter_estimation.hpp>
+#include <profiler.hpp>
+
+
+int main (int argc, char ** argv)
+{
+  int64_t Nobs = 10000;
+
+  if (argc > 1)
+    Nobs = std :: stoll(argv[1]);
+
+  std :: mt19937 engine(123);
+  std :: normal_distribution < double > noise(0., .5);
+
+  // Decay fit (same problem of py/fit_model.py)
+  {
+    using model = decay_model < double >;
+
+    const int64_t N = 100;
+    const int32_t substeps = 10;
+    const double dt = 5. / (N - 1) / substeps;
+    const double y0 = 10.;
+    const double alpha = .5;
+
+    std :: vector < double > obs(N);
+    rk4_sensitivity < model >(&y0, &alpha, dt, substeps, N,
+                              [&](const int64_t & k, const double * y, const double *)
+                              {
+                                obs[k] = y[0] + noise(engine);
+                              }, false);
+
+    const double guess = 1.;
+    const auto fit = levenberg_marquardt < model >(&y0, obs.data(), N, dt, substeps, &guess);
+
+    std :: cout << "Decay: alpha = " << fit.params[0]
+                << " (true " << alpha << ") Fit Error: " << std :: sqrt(fit.covariance[0])
+                << " in " << fit.iterations << " iterations" << std :: endl;
+
+    assert (fit.converged && std :: abs(fit.params[0] - alpha) < 3. * std :: sqrt(fit.covariance[0]));
+  }
+
+  // Michaelis Menten fit of the product only, from multiple starts
+  {
+    using model = michaelis_menten_model < double >;
+
+    const int32_t substeps = 2;
+    const double dt = 20. / (Nobs - 1) / substeps;
+    const double y0[4] = {10., 1., 0., 0.};
+    const double params[3] = {1., 1e-2, 1.};
+
+    std :: vector < double > obs(Nobs * model :: Nvar, std :: numeric_limits < double > :: quiet_NaN());
+    rk4_sensitivity < model >(y0, params, dt, substeps, Nobs,
+                              [&](const int64_t & k, const double * y, const double *)
+                              {
+                                obs[k * model :: Nvar + 3] = y[3] + noise(engine);
+                              }, false);
+
+    const double lower[3] = {1e-2, 1e-4, 1e-2};
+    const double upper[3] = {1e2, 1., 1e2};
+    const int32_t starts = 16;
+
+    const auto start_time = std :: chrono :: high_resolution_clock :: now();
+
+    const auto fit = multistart_fit < model >(y0, obs.data(), Nobs, dt, substeps, lower, upper, starts);
+
+    const double run_time = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+    std :: cout << "Michaelis Menten (" << Nobs << " observations, " << starts << " starts) in "
+                << run_time << " sec" << std :: endl;
+
+    const char * names[3] = {"kf", "kb", "kc"};
+    for (int32_t j = 0; j < model :: Npar; ++j)
+      std :: cout << "  " << names[j] << " = " << fit.params[j]
+                  << " +/- " << std :: sqrt(fit.covariance[j * model :: Npar + j])
+                  << " (true " << params[j] << ")" << std :: endl;
+    std :: cout << "  cost = " << fit.cost << " iterations = " << fit.iterations
+                << (fit.converged ? " (converged)" : " (not converged)") << std :: endl;
+
+    // the product curve constrains kf and kc, while kb (<< kc) is loosely determined
+    assert (fit.converged);
+    assert (std :: abs(fit.params[0] - params[0]) < .05 * params[0]);
+    assert (std :: abs(fit.params[2] - params[2]) < .02 * params[2]);
+    assert (std :: abs(fit.params[1] - params[1]) < .01);
+    for (int32_t j = 0; j < model :: Npar; ++j)
+      assert (std :: abs(fit.params[j] - params[j]) < 3. * std :: sqrt(fit.covariance[j * model :: Npar + j]));
+
+    // no starts run a single one
+    const auto single = multistart_fit < model >(y0, obs.data(), Nobs, dt, substeps, lower, upper, 0);
+    assert (std :: isfinite(single.cost) && single.iterations > 0);
+  }
+
+  PROFILE_REPORT(std :: cerr, "text");
+
+  return 0;
+}
@@ -0,0 +1,127 @@
+// g++ lyapunov.cpp -std=c++14 -O3 -march=native -fopenmp -I../include -o lyapunov
+
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <random>
+#include <array>
+#include <cmath>
+#include <cassert>
+
+#include <lyapunov.hpp>
+#include <profiler.hpp>
+
+
+int main (int argc, char ** argv)
+{
+  int64_t steps = 1000000;
+  int64_t ensemble = 16;
+
+  if (argc > 1)
+    steps = std :: stoll(argv[1]);
+  if (argc > 2)
+    ensemble = std :: stoll(argv[2]);
+
+  using model = lorenz_model < double >;
+
+  // Lorenz system (same parameters of py/lorentz_attractor.py)
+  const double params[3] = {16., 45.92, 4.};
+  const double y0[3] = {10., 1., 1.};
+  const double dt = .01;
+  const int64_t transient = 10000;
+  const int32_t qr_interval = 10;
+
+  // cost of the plain integration (reference)
+  auto start_time = std :: chrono :: high_resolution_clock :: now();
+
+  double last = 0.;
+  rk4_sensitivity < model >(y0, params, dt, 1, transient + steps + 1,
+                            [&](const int64_t &, const double * y, const double *)
+                            {
+                              last = y[0];
+                            }, false);
+
+  const double plain_time = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+  std :: array < double, 3 > spectrum;
+
+  start_time = std :: chrono :: high_resolution_clock :: now();
+
+  lyapunov_spectrum < model >(y0, params, dt, transient, steps, qr_interval, spectrum.data());
+
+  const double run_time = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+  std :: cout << "Lorenz spectrum (" << steps << " steps in " << run_time << " sec, "
+              << run_time / plain_time << "x the plain integration, final x " << last << ")" << std :: endl;
+  std :: cout << "  exponents : " << spectrum[0] << " " << spectrum[1] << " " << spectrum[2]
+              << " (sum " << spectrum[0] + spectrum[1] + spectrum[2] << ", expected " << -(params[0] + 1. + params[2]) << ")" << std :: endl;
+  std :: cout << "  Kaplan-Yorke dimension : " << kaplan_yorke_dimension(spectrum.data(), 3) << std :: endl;
+
+  // the sum is the average divergence of the flow -(sigma + 1 + b), one exponent is zero
+  assert (std :: abs(spectrum[0] + spectrum[1] + spectrum[2] + params[0] + 1. + params[2]) < 1e-2 * (params[0] + 1. + params[2]));
+  assert (spectrum[0] > 1. && std :: abs(spectrum[1]) < .05 && spectrum[2] < -10.);
+  assert (kaplan_yorke_dimension(spectrum.data(), 3) > 2. && kaplan_yorke_dimension(spectrum.data(), 3) < 3.);
+
+  // ensemble of initial conditions around the attractor
+  std :: mt19937 engine(42);
+  std :: uniform_real_distribution < double > uniform(-10., 10.);
+
+  std :: vector < double > starts(ensemble * 3);
+  for (int64_t i = 0; i < ensemble; ++i)
+  {
+    starts[i * 3]     = uniform(engine);
+    starts[i * 3 + 1] = uniform(engine);
+    starts[i * 3 + 2] = 40. + uniform(engine);
+  }
+
+  std :: vector < double > spectra(ensemble * 3);
+
+  start_time = std :: chrono :: high_resolution_clock :: now();
+
+  lyapunov_ensemble < model >(starts.data(), ensemble, params, dt, transient, steps / 10, qr_interval, spectra.data());
+
+  const double ensemble_time = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+  double mean = 0.;
+  for (int64_t i = 0; i < ensemble; ++i)
+    mean += spectra[i * 3] / ensemble;
+
+  std :: cout << "Ensemble of " << ensemble << " initial conditions in " << ensemble_time << " sec: mean largest exponent " << mean << std :: endl;
+
+  assert (std :: abs(mean - spectrum[0]) < .1 * spectrum[0]);
+
+  // 2D quadratic map of GrassbergProcaccia.cpp (Henon map with a = 1.2, b = 0.4)
+  const std :: array < double, 12 > a = {{1.2, 0., -1., 0., .4, 0., 0., 1., 0., 0., 0., 0.}};
+  const std :: array < double, 2 > x0 = {{.1, .1}};
+  std :: array < double, 2 > map_spectrum;
+
+  lyapunov_spectrum_map(quadratic_map < double >(a), x0.data(), int64_t(1000), steps, 1, map_spectrum.data());
+
+  std :: cout << "Quadratic map exponents : " << map_spectrum[0] << " " << map_spectrum[1]
+              << " (sum " << map_spectrum[0] + map_spectrum[1] << ", expected log(0.4) = " << std :: log(.4) << ")" << std :: endl;
+  std :: cout << "  Kaplan-Yorke dimension : " << kaplan_yorke_dimension(map_spectrum.data(), 2) << std :: endl;
+
+  // the Jacobian determinant is constant (-b), so the sum is log|b| up to the round-off
+  assert (std :: abs(map_spectrum[0] + map_spectrum[1] - std :: log(.4)) < 1e-10);
+
+  // a QR interval < 1 is taken as 1
+  std :: array < double, 2 > check_spectrum;
+  lyapunov_spectrum_map(quadratic_map < double >(a), x0.data(), int64_t(1000), steps, 0, check_spectrum.data());
+  assert (check_spectrum == map_spectrum);
+
+  // classical Henon map (a = 1.4, b = 0.3)
+  const std :: array < double, 12 > henon = {{1., 0., -1.4, 0., 1., 0., 0., .3, 0., 0., 0., 0.}};
+  lyapunov_spectrum_map(quadratic_map < double >(henon), x0.data(), int64_t(1000), steps, 1, map_spectrum.data());
+
+  std :: cout << "Henon map exponents : " << map_spectrum[0] << " " << map_spectrum[1]
+              << " (sum " << map_spectrum[0] + map_spectrum[1] << ", expected log(0.3) = " << std :: log(.3)
+              << ", largest expected 0.419)" << std :: endl;
+
+  assert (std :: abs(map_spectrum[0] + map_spectrum[1] - std :: log(.3)) < 1e-10);
+  assert (std :: abs(map_spectrum[0] - .419) < .01);
+
+  PROFILE_REPORT(std :: cerr, "text");
+
+  return 0;
+}
@@ -4,48 +4,58 @@
 #include <iostream>
 #include <iomanip>
 #include <numeric>
+#include <chrono>
+#ifdef _OPENMP
 #include <omp.h>
+#endif
 
 int main()
 {
   std :: random_device rd;
-  std :: mt19937 eng{rd()};
-  
+  const std :: size_t seed = rd();
+
   int64_t N = 1e5, N_run = 1e4;
-  
+
   double pi = 0.;
-  double start_time, run_time;
-    
-  std :: uniform_real_distribution < double > uniform_dist {-1., 1.};
-
-  omp_set_num_threads(omp_get_max_threads());
-  
-  start_time = omp_get_wtime();
-  #pragma omp parallel
+
+  const auto start_time = std :: chrono :: high_resolution_clock :: now();
+
+#ifdef _OPENMP
+  #pragma omp parallel reduction (+ : pi)
+#endif
   {
-    #pragma omp for reduction (+ : pi)
+#ifdef _OPENMP
+    const std :: size_t tid = omp_get_thread_num();
+#else
+    const std :: size_t tid = 0;
+#endif
+
+    // each thread owns its generator (a shared engine is a data race)
+    std :: mt19937 eng{static_cast < std :: mt19937 :: result_type >(seed + tid)};
+    std :: uniform_real_distribution < double > uniform_dist {-1., 1.};
+
+#ifdef _OPENMP
+    #pragma omp for
+#endif
     for (int64_t I = 0; I < N_run; ++I)
     {
       int64_t Nhints = 0;
-            
-      #pragma omp parallel
+
+      for (int64_t i = 0; i < N; ++i)
       {
-        #pragma omp for reduction (+ : Nhints)
-        for (int64_t i = 0; i < N; ++i)
-        {
-          const double x = uniform_dist(eng);
-          const double y = uniform_dist(eng);
-          const double res = x*x + y*y;
-          Nhints += res < 1 ? 1 : 0;
-        }
+        const double x = uniform_dist(eng);
+        const double y = uniform_dist(eng);
+        const double res = x*x + y*y;
+        Nhints += res < 1 ? 1 : 0;
       }
+
       pi += 4.0 * (static_cast < double >(Nhints) / N);
     }
   }
-  
+
   pi /= N_run;
-  run_time = omp_get_wtime() - start_time;
+  const double run_time = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
   std :: cout << "pi with " << N << " steps for " << N_run << " runs is " << std :: setprecision(16) << pi << " in " << run_time << " sec" << std :: endl;
-    
+
   return 0;
-}   
+}
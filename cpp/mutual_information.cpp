@@ -0,0 +1,140 @@
+// g++ mutual_information.cpp -std=c++14 -O3 -march=native -fopenmp -I../include -o mutual_information
+
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <memory>
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+#include <mutual_information.hpp>
+#include <false_nearest_neighbours.hpp>
+
+
+/**
+* @brief Mutual information of a single lag from a direct 2D histogram (reference)
+*
+* @details The bins span the range of the whole series as in average_mutual_information.
+*
+*/
+double brute_force (const double * x, const int64_t & N, const int32_t & tau, const int32_t & bins)
+{
+  const double xmin = *std :: min_element(x, x + N);
+  const double xmax = *std :: max_element(x, x + N);
+
+  const double scale = 1. / ((xmax - xmin) / bins);
+
+  auto bin = [&](const double & v)
+             {
+               return std :: min(static_cast < int32_t >((v - xmin) * scale), bins - 1);
+             };
+
+  std :: vector < double > joint(bins * bins, 0.), row(bins, 0.), col(bins, 0.);
+
+  for (int64_t i = 0; i + tau < N; ++i)
+  {
+    joint[bin(x[i]) * bins + bin(x[i + tau])] += 1.;
+    row[bin(x[i])] += 1.;
+    col[bin(x[i + tau])] += 1.;
+  }
+
+  const double total = static_cast < double >(N - tau);
+  double info = 0.;
+
+  for (int32_t a = 0; a < bins; ++a)
+    for (int32_t b = 0; b < bins; ++b)
+      if (joint[a * bins + b] > 0.)
+        info += joint[a * bins + b] / total * std :: log(joint[a * bins + b] * total / (row[a] * col[b]));
+
+  return info;
+}
+
+
+int main (int argc, char ** argv)
+{
+  int64_t N = 10000000;
+  const int32_t max_lag = 99;
+  const int32_t bins = 100;
+  const int32_t max_dim = 10;
+
+  if (argc > 1)
+    N = std :: stoll(argv[1]);
+
+  // Lorenz system (same parameters of py/mutual_info.py)
+  const double dt = .01;
+  const double sigma = 16.;
+  const double b = 4.;
+  const double r = 45.92;
+
+  std :: unique_ptr < double[] > x(new double[N]);
+
+  double xi = 10.;
+  double yi = 1.;
+  double zi = 1.;
+
+  for (int64_t i = 0; i < N; ++i)
+  {
+    x[i] = xi;
+
+    const double vx = sigma * (yi - xi);
+    const double vy = -xi * zi + r * xi - yi;
+    const double vz = -b * zi + xi * yi;
+
+    xi += dt * vx;
+    yi += dt * vy;
+    zi += dt * vz;
+  }
+
+  std :: unique_ptr < double[] > mi(new double[max_lag]);
+
+  auto start_time = std :: chrono :: high_resolution_clock :: now();
+
+  const int32_t delay = average_mutual_information(x.get(), N, max_lag, bins, mi.get());
+
+  double run_time = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+  std :: cout << "Mutual information of " << max_lag << " lags over " << N << " samples in " << run_time << " sec ("
+              << static_cast < double >(N) * max_lag / run_time << " pairs/sec)"
+              << std :: endl;
+  std :: cout << "Optimal delay (first minimum): " << delay << " (time " << delay * dt << ")" << std :: endl;
+
+  assert (delay > 0);
+
+  // the single sweep against a direct histogram of each lag (lags not multiple
+  // of the group of 4 and more than one block of samples)
+  {
+    const int64_t n = std :: min(N, int64_t(50000));
+    const int32_t lags = 11;
+    const int32_t check_bins = 37;
+    std :: unique_ptr < double[] > check(new double[lags]);
+
+    average_mutual_information(x.get(), n, lags, check_bins, check.get());
+
+    double error = 0.;
+    for (int32_t tau = 1; tau <= lags; ++tau)
+      error = std :: max(error, std :: abs(check[tau - 1] - brute_force(x.get(), n, tau, check_bins)));
+
+    std :: cout << "Max error against the direct histograms: " << error << std :: endl;
+    assert (error < 1e-12);
+  }
+
+  // embedding dimension of the delay embedding on the first samples
+  const int64_t Nfnn = std :: min(N, int64_t(100000));
+  std :: unique_ptr < double[] > fnn(new double[max_dim]);
+
+  start_time = std :: chrono :: high_resolution_clock :: now();
+
+  const int32_t dim = false_nearest_neighbours(x.get(), Nfnn, max_dim, delay, fnn.get(), 15., 2., static_cast < int64_t >(delay));
+
+  run_time = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+  std :: cout << "Embedding dimension (FNN on " << Nfnn << " samples): " << dim << " in " << run_time << " sec" << std :: endl;
+
+  assert (dim == 3);
+
+  PROFILE_REPORT(std :: cerr, "text");
+
+  return 0;
+}
@@ -0,0 +1,201 @@
+// g++ reaction_diffusion_3d.cpp -O3 -std=c++14 -march=native -fopenmp -I../include -o reaction_diffusion_3d
+
+#include <iostream>
+#include <random>
+#include <memory>
+#include <chrono>
+#include <string>
+#include <cmath>
+#include <cassert>
+
+#include <reaction_diffusion.hpp>
+#include <brusselator.hpp>
+#include <profiler.hpp>
+
+
+/**
+* @brief Consistency of the 3D engine with the 2D Brusselator
+*
+* @details A field constant along z is a solution of the 2D model
+* (7-point stencil and Neumann boundaries, the same of
+* brusselator_diffusion), and the 27-point Laplacian must keep it
+* constant along z.
+*
+*/
+template < int32_t stencil >
+double check_2d (const int64_t & nx, const int64_t & ny, const int64_t & nz, const int64_t & iterations)
+{
+  std :: mt19937 eng(42);
+  std :: uniform_real_distribution < double > uniform(0., 1.);
+
+  std :: unique_ptr < double[] > U2(new double[nx * ny]), V2(new double[nx * ny]);
+  for (int64_t i = 0; i < nx * ny; ++i)
+  {
+    U2[i] = 4.5 + .3 * uniform(eng);
+    V2[i] = 1. + .3 * uniform(eng);
+  }
+
+  std :: unique_ptr < double[] > U(new double[nx * ny * nz]), V(new double[nx * ny * nz]);
+  rd_first_touch(U.get(), nx, ny, nz, [&] (int64_t x, int64_t y, int64_t) { return U2[y * nx + x]; });
+  rd_first_touch(V.get(), nx, ny, nz, [&] (int64_t x, int64_t y, int64_t) { return V2[y * nx + x]; });
+
+  double * fields[2] = {U.get(), V.get()};
+  const double D[2] = {2., 16.};
+
+  reaction_diffusion_3d < stencil >(fields, nx, ny, nz, .005, D, brusselator_reaction < double >{4.5, 4.5}, rd_boundary :: neumann, iterations);
+
+  if (stencil == 7)
+    brusselator_diffusion(U2.get(), V2.get(), ny, nx, .005, 4.5, 4.5, 2., 16., iterations);
+
+  double err = 0.;
+  for (int64_t z = 0; z < nz; ++z)
+    for (int64_t i = 0; i < nx * ny; ++i)
+      err = std :: max(err, std :: abs(U[z * nx * ny + i] - (stencil == 7 ? U2[i] : U[i])));
+
+  return err;
+}
+
+
+/**
+* @brief Pure diffusion (no reaction terms)
+*
+*/
+struct no_reaction
+{
+  using value_type = double;
+  static constexpr int32_t Nspecies = 1;
+
+  void operator () (const double *, double * dc) const
+  {
+    dc[0] = 0.;
+  }
+};
+
+
+/**
+* @brief Decay of a Fourier mode
+*
+* @details The separable mode cos(kx x) cos(ky y) cos(kz z) is an
+* eigenvector of both Laplacians, with k = 2 pi m / n for periodic
+* boundaries and k = pi m / (n - 1) for the Neumann ones (mirror
+* without the border). The eigenvalue is the symbol of the stencil
+*
+*   7-point  : 2 (cx + cy + cz) - 6
+*   27-point : (28 (cx + cy + cz) + 12 (cx cy + cy cz + cz cx) + 8 cx cy cz - 128) / 30
+*
+* with c = cos(k), so after n explicit Euler steps the mode is
+* scaled by (1 + D dt lambda)^n. Every site is compared, so the
+* check covers the x, y and z boundaries and the borders of the slabs.
+*
+* @return The maximum error relative to the amplitude.
+*
+*/
+template < int32_t stencil >
+double check_mode (const int64_t & nx, const int64_t & ny, const int64_t & nz, const rd_boundary & bc, const int64_t & iterations)
+{
+  const double pi = std :: acos(-1.);
+
+  auto wavenumber = [&] (const int64_t & m, const int64_t & n)
+                    {
+                      return bc == rd_boundary :: periodic ? 2. * pi * m / n : pi * m / (n - 1);
+                    };
+
+  const double kx = wavenumber(2, nx);
+  const double ky = wavenumber(3, ny);
+  const double kz = wavenumber(1, nz);
+
+  auto mode = [&] (int64_t x, int64_t y, int64_t z) { return std :: cos(kx * x) * std :: cos(ky * y) * std :: cos(kz * z); };
+
+  std :: unique_ptr < double[] > U(new double[nx * ny * nz]);
+  rd_first_touch(U.get(), nx, ny, nz, mode);
+
+  double * fields[1] = {U.get()};
+  const double D[1] = {1.};
+  const double dt = .1;
+
+  reaction_diffusion_3d < stencil >(fields, nx, ny, nz, dt, D, no_reaction{}, bc, iterations);
+
+  const double cx = std :: cos(kx), cy = std :: cos(ky), cz = std :: cos(kz);
+  const double lambda = stencil == 7 ? 2. * (cx + cy + cz) - 6.
+                                     : (28. * (cx + cy + cz) + 12. * (cx * cy + cy * cz + cz * cx) + 8. * cx * cy * cz - 128.) / 30.;
+  const double decay = std :: pow(1. + D[0] * dt * lambda, iterations);
+
+  double err = 0.;
+  for (int64_t z = 0; z < nz; ++z)
+    for (int64_t y = 0; y < ny; ++y)
+      for (int64_t x = 0; x < nx; ++x)
+        err = std :: max(err, std :: abs(U[(z * ny + y) * nx + x] - decay * mode(x, y, z)));
+
+  return err / decay;
+}
+
+
+int main (int argc, char ** argv)
+{
+  int64_t dim = 128;
+  int64_t iterations = 20;
+
+  if (argc > 1)
+    dim = std :: stoll(argv[1]);
+  if (argc > 2)
+    iterations = std :: stoll(argv[2]);
+
+  const double err7 = check_2d < 7 >(37, 29, 5, 50);
+  const double err27 = check_2d < 27 >(37, 29, 5, 50);
+
+  std :: cout << "2D consistency : 7-point " << err7 << ", 27-point " << err27 << std :: endl;
+
+  assert (err7 < 1e-12 && err27 < 1e-12);
+
+  // the rows span several slabs of reaction_diffusion_3d and a partial one,
+  // so the halo of the previous slab and the remainder are checked too
+  const int64_t nx = 1000;
+  const int64_t slab = static_cast < int64_t >(RD_BLOCK_BYTES / (3 * nx * sizeof(double))) - 2;
+  const int64_t ny = 3 * slab + slab / 2 + 1;
+
+  assert (slab > 1 && ny % slab != 0);
+
+  for (const auto & bc : {rd_boundary :: periodic, rd_boundary :: neumann})
+  {
+    const double mode7 = check_mode < 7 >(nx, ny, 7, bc, 40);
+    const double mode27 = check_mode < 27 >(nx, ny, 7, bc, 40);
+
+    std :: cout << "Fourier mode (" << (bc == rd_boundary :: periodic ? "periodic" : "neumann") << ") : 7-point " << mode7 << ", 27-point " << mode27 << std :: endl;
+
+    assert (mode7 < 1e-10 && mode27 < 1e-10);
+  }
+
+  const int64_t size = dim * dim * dim;
+
+  // uninitialized allocation: the pages are placed by the first touch
+  std :: unique_ptr < double[] > U(new double[size]), V(new double[size]);
+  double * fields[2] = {U.get(), V.get()};
+  const double D[2] = {2., 16.};
+  const brusselator_reaction < double > reaction{4.5, 4.5};
+
+  for (const auto & bc : {rd_boundary :: periodic, rd_boundary :: neumann})
+  {
+    rd_first_touch(U.get(), dim, dim, dim, [] (int64_t x, int64_t y, int64_t z) { return 4.5 + .3 * ((x * 7 + y * 13 + z * 29) % 17) / 17.; });
+    rd_first_touch(V.get(), dim, dim, dim, [] (int64_t x, int64_t y, int64_t z) { return 1. + .3 * ((x * 11 + y * 5 + z * 23) % 19) / 19.; });
+
+    auto start_time = std :: chrono :: high_resolution_clock :: now();
+
+    reaction_diffusion_3d < 7 >(fields, dim, dim, dim, .005, D, reaction, bc, iterations);
+
+    const double time7 = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+    start_time = std :: chrono :: high_resolution_clock :: now();
+
+    reaction_diffusion_3d < 27 >(fields, dim, dim, dim, .005, D, reaction, bc, iterations);
+
+    const double time27 = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+    std :: cout << iterations << " iterations on " << dim << "^3 (" << (bc == rd_boundary :: periodic ? "periodic" : "neumann") << ")" << std :: endl
+                << "  7-point  : " << time7 << " sec (" << size * iterations / time7 << " site-updates/sec)" << std :: endl
+                << "  27-point : " << time27 << " sec (" << size * iterations / time27 << " site-updates/sec)" << std :: endl;
+  }
+
+  PROFILE_REPORT(std :: cerr, "text");
+
+  return 0;
+}
@@ -0,0 +1,120 @@
+// g++ reaction_models.cpp -O3 -std=c++14 -march=native -fopenmp -I../include -o reaction_models
+
+#include <iostream>
+#include <random>
+#include <memory>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <cmath>
+
+#include <reaction_diffusion.hpp>
+#include <profiler.hpp>
+
+
+/**
+* @brief Command line helper
+*
+* @details Utility function for the command line user.
+* The available models are listed from the registry.
+*
+* @param argv Array of command line arguments.
+*
+*/
+void usage (char ** argv)
+{
+  std :: cerr << "Usage: " << argv[0] << " <model> [dim <int>] [depth <int>] [iterations <int>] [stencil <7|27>] [parameters <double>...]"
+              << std :: endl
+              << "Default parameters:" << std :: endl
+              << "\tdim = 256" << std :: endl
+              << "\tdepth = 1 (2D domain)" << std :: endl
+              << "\titerations = 5000" << std :: endl
+              << "\tstencil = 7" << std :: endl
+              << "Models:" << std :: endl;
+
+  for (const auto & m : rd_models())
+  {
+    std :: cerr << "\t" << m.first << " : " << m.second.description << " (";
+    for (std :: size_t i = 0; i < m.second.parameters.size(); ++i)
+      std :: cerr << (i ? ", " : "") << m.second.parameters[i] << " = " << m.second.values[i];
+    std :: cerr << ")" << std :: endl;
+  }
+
+  std :: cerr << std :: endl;
+  std :: exit(1);
+}
+
+
+int main (int argc, char ** argv)
+{
+  if (argc < 2 || !rd_models().count(argv[1]))
+    usage(argv);
+
+  const rd_model & model = rd_models().at(argv[1]);
+
+  const int64_t dim = argc > 2 ? std :: stoll(argv[2]) : 256;
+  const int64_t depth = argc > 3 ? std :: stoll(argv[3]) : 1;
+  const int64_t iterations = argc > 4 ? std :: stoll(argv[4]) : 5000;
+  const int32_t stencil = argc > 5 ? std :: stoi(argv[5]) : 7;
+
+  std :: vector < double > parameters = model.values;
+
+  if (argc > 6 + static_cast < int32_t >(parameters.size()))
+    usage(argv);
+
+  for (int32_t i = 6; i < argc; ++i)
+    parameters[i - 6] = std :: stod(argv[i]);
+
+  const int32_t Ns = static_cast < int32_t >(model.species.size());
+  const int64_t size = dim * dim * depth;
+
+  // random initial state (the fields are in Structure-of-Arrays format)
+  std :: vector < std :: unique_ptr < double[] > > buffers;
+  std :: vector < double * > fields;
+
+  for (int32_t s = 0; s < Ns; ++s)
+  {
+    buffers.emplace_back(new double[size]);
+    fields.push_back(buffers.back().get());
+  }
+
+  std :: mt19937 engine(42);
+  std :: vector < double > c(Ns);
+
+  for (int64_t z = 0; z < depth; ++z)
+    for (int64_t y = 0; y < dim; ++y)
+      for (int64_t x = 0; x < dim; ++x)
+      {
+        model.initial(engine, parameters.data(), x, y, z, c.data());
+        for (int32_t s = 0; s < Ns; ++s)
+          fields[s][(z * dim + y) * dim + x] = c[s];
+      }
+
+  auto start_time = std :: chrono :: high_resolution_clock :: now();
+
+  if ( !model.run(fields.data(), dim, dim, depth, model.dt, model.D.data(), parameters.data(),
+                  rd_boundary :: periodic, stencil, iterations) )
+    usage(argv);
+
+  const double elapsed = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+  std :: cout << argv[1] << " : " << iterations << " iterations on " << dim << "x" << dim << "x" << depth
+              << " (" << stencil << "-point) in " << elapsed << " sec ("
+              << size * iterations / elapsed << " site-updates/sec)" << std :: endl;
+
+  for (int32_t s = 0; s < Ns; ++s)
+  {
+    const auto range = std :: minmax_element(fields[s], fields[s] + size);
+    double mean = 0.;
+    for (int64_t i = 0; i < size; ++i)
+      mean += fields[s][i];
+    mean /= size;
+
+    std :: cout << "  " << model.species[s] << " : mean " << mean
+                << ", min " << *range.first << ", max " << *range.second << std :: endl;
+  }
+
+  PROFILE_REPORT(std :: cerr, "text");
+
+  return 0;
+}
@@ -0,0 +1,137 @@
+// g++ recurrence_quantification.cpp -std=c++14 -O3 -march=native -fopenmp -I../include -o recurrence_quantification
+
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cassert>
+
+#include <recurrence.hpp>
+#include <ode_models.hpp>
+#include <profiler.hpp>
+
+
+// Reference RQA on the dense recurrence matrix (line by line)
+rqa_measures dense_rqa (const delay_embedding < double > & emb, const double & eps,
+                        const int32_t & lmin, const int32_t & vmin, const int64_t & theiler)
+{
+  const int64_t M = emb.size;
+  std :: vector < uint8_t > R(M * M, 0);
+
+  for (int64_t i = 0; i < M; ++i)
+    for (int64_t j = 0; j < M; ++j)
+    {
+      double d = 0.;
+      for (int32_t k = 0; k < emb.dim; ++k)
+        d = std :: max(d, std :: abs(emb(i, k) - emb(j, k)));
+      R[i * M + j] = d <= eps && std :: abs(i - j) >= theiler;
+    }
+
+  int64_t recurrences = 0, diag_points = 0, diag_lines = 0, vert_points = 0, vert_lines = 0;
+
+  for (int64_t i = 0; i < M * M; ++i)
+    recurrences += R[i];
+
+  for (int64_t k = -(M - 1); k < M; ++k)
+  {
+    int64_t run = 0;
+    for (int64_t i = std :: max(int64_t(0), -k); i <= std :: min(M, M - k); ++i)
+    {
+      const bool bit = i < std :: min(M, M - k) && R[i * M + i + k];
+      if (bit)
+        ++run;
+      else
+      {
+        if (run >= lmin) { diag_points += run; ++diag_lines; }
+        run = 0;
+      }
+    }
+  }
+
+  for (int64_t j = 0; j < M; ++j)
+  {
+    int64_t run = 0;
+    for (int64_t i = 0; i <= M; ++i)
+    {
+      if (i < M && R[i * M + j])
+        ++run;
+      else
+      {
+        if (run >= vmin) { vert_points += run; ++vert_lines; }
+        run = 0;
+      }
+    }
+  }
+
+  rqa_measures rqa;
+  rqa.recurrences = recurrences;
+  rqa.recurrence_rate = 0.;
+  rqa.determinism = static_cast < double >(diag_points) / recurrences;
+  rqa.average_diagonal = static_cast < double >(diag_points) / diag_lines;
+  rqa.laminarity = static_cast < double >(vert_points) / recurrences;
+  rqa.trapping_time = static_cast < double >(vert_points) / vert_lines;
+  return rqa;
+}
+
+
+int main (int argc, char ** argv)
+{
+  int64_t N = 20000;
+  double eps = 2.;
+
+  if (argc > 1)
+    N = std :: stoll(argv[1]);
+  if (argc > 2)
+    eps = std :: stod(argv[2]);
+
+  using model = lorenz_model < double >;
+
+  // x component of the Lorenz attractor (same parameters of py/lorentz_attractor.py)
+  const double params[3] = {16., 45.92, 4.};
+  const double y0[3] = {10., 1., 1.};
+  const int64_t transient = 1000;
+  const int32_t delay = 5;
+  const int32_t dim = 3;
+
+  std :: vector < double > x(N + (dim - 1) * delay);
+
+  rk4_sensitivity < model >(y0, params, .01, 2, transient + static_cast < int64_t >(x.size()),
+                            [&](const int64_t & k, const double * y, const double *)
+                            {
+                              if (k >= transient)
+                                x[k - transient] = y[0];
+                            }, false);
+
+  // check the popcount counts against the dense matrix on a short series
+  {
+    const delay_embedding < double > small(x.data(), 600, delay, dim);
+    const rqa_measures fast = recurrence_quantification(small, eps, 2, 2, int64_t(1));
+    const rqa_measures dense = dense_rqa(small, eps, 2, 2, 1);
+
+    assert (fast.recurrences == dense.recurrences);
+    assert (std :: abs(fast.determinism - dense.determinism) < 1e-12);
+    assert (std :: abs(fast.average_diagonal - dense.average_diagonal) < 1e-12);
+    assert (std :: abs(fast.laminarity - dense.laminarity) < 1e-12);
+    assert (std :: abs(fast.trapping_time - dense.trapping_time) < 1e-12);
+    (void)fast;
+    (void)dense;
+  }
+
+  const delay_embedding < double > emb(x.data(), N, delay, dim);
+
+  auto start_time = std :: chrono :: high_resolution_clock :: now();
+
+  const rqa_measures rqa = recurrence_quantification(emb, eps, 2, 2, int64_t(1));
+
+  const double run_time = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+  std :: cout << "RQA of " << N << " embedded points (dim " << dim << ", delay " << delay << ", eps " << eps << ") in "
+              << run_time << " sec (" << N * static_cast < double >(N) / run_time * 1e-9 << " Gpairs/sec)" << std :: endl;
+  std :: cout << "  recurrence rate : " << rqa.recurrence_rate << " (" << rqa.recurrences << " points)" << std :: endl;
+  std :: cout << "  determinism     : " << rqa.determinism << " (average diagonal " << rqa.average_diagonal << ")" << std :: endl;
+  std :: cout << "  laminarity      : " << rqa.laminarity << " (trapping time " << rqa.trapping_time << ")" << std :: endl;
+
+  PROFILE_REPORT(std :: cerr, "text");
+
+  return 0;
+}
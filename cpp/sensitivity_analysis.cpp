@@ -0,0 +1,207 @@
+// g++ sensitivity_analysis.cpp -std=c++14 -O3 -march=native -fopenmp -I../include -o sensitivity_analysis
+
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <memory>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+
+#include <kinetics.hpp>
+#include <sensitivity_analysis.hpp>
+#include <profiler.hpp>
+
+
+int main (int argc, char ** argv)
+{
+  int64_t samples = 10000;
+
+  if (argc > 1)
+    samples = std :: stoll(argv[1]);
+
+  const double s0  = 10.;
+  const double e0  = 1.;
+  const double es0 = 0.;
+  const double p0  = 0.;
+
+  const double kf = 1.;
+  const double kb = 1e-2;
+  const double kc = 1.;
+
+  constexpr int32_t iterations = 501;
+  const double dt = 5. / (iterations - 1);
+
+  array < double > time(new double[iterations]);
+  std :: generate_n(time.get(), iterations, [n = 0, dt] () mutable { return dt * n++; });
+
+  array < double > S(new double[iterations]);
+  array < double > E(new double[iterations]);
+  array < double > ES(new double[iterations]);
+  array < double > P(new double[iterations]);
+  array < double > sensitivity(new double[iterations * 4 * 3]);
+
+  // Local sensitivities of the product along the trajectory
+  MichaelisMenten < double, iterations >(time, s0, e0, es0, p0,
+                                         kf, kb, kc,
+                                         S, E, ES, P, sensitivity);
+
+  const double * dP = sensitivity.get() + ((iterations - 1) * 4 + 3) * 3;
+
+  std :: cout << "P(t = 5) = " << P[iterations - 1]
+              << "  dP/dkf = " << dP[0] << "  dP/dkb = " << dP[1] << "  dP/dkc = " << dP[2] << std :: endl;
+
+  // check against a central finite difference on kc
+  {
+    const double h = 1e-5;
+    array < double > Pp(new double[iterations]);
+    array < double > Pm(new double[iterations]);
+
+    MichaelisMenten < double, iterations >(time, s0, e0, es0, p0, kf, kb, kc + h, S, E, ES, Pp);
+    MichaelisMenten < double, iterations >(time, s0, e0, es0, p0, kf, kb, kc - h, S, E, ES, Pm);
+
+    const double fd = (Pp[iterations - 1] - Pm[iterations - 1]) / (2. * h);
+    assert (std :: abs(fd - dP[2]) < 1e-6 * std :: max(1., std :: abs(fd)));
+    (void)fd;
+  }
+
+  // Brusselator sensitivities (on the limit cycle) against central finite differences on A and B
+  {
+    const double A = 1.;
+    const double B = 2.5;
+    const double x0 = 1.2;
+    const double y0 = 3.1;
+
+    array < double > x(new double[iterations]);
+    array < double > y(new double[iterations]);
+    array < double > dxy(new double[iterations * 2 * 2]);
+
+    Brusselator < double, iterations >(time, x0, y0, A, B, x, y, dxy);
+
+    const double h = 1e-6;
+    array < double > xp(new double[iterations]);
+    array < double > yp(new double[iterations]);
+    array < double > xm(new double[iterations]);
+    array < double > ym(new double[iterations]);
+
+    double error = 0.;
+
+    for (int32_t k = 0; k < 2; ++k)
+    {
+      Brusselator < double, iterations >(time, x0, y0, A + (k == 0) * h, B + (k == 1) * h, xp, yp);
+      Brusselator < double, iterations >(time, x0, y0, A - (k == 0) * h, B - (k == 1) * h, xm, ym);
+
+      for (int32_t i = 0; i < iterations; i += 50)
+      {
+        const double fdx = (xp[i] - xm[i]) / (2. * h);
+        const double fdy = (yp[i] - ym[i]) / (2. * h);
+
+        error = std :: max(error, std :: abs(fdx - dxy[(i * 2 + 0) * 2 + k]) / std :: max(1., std :: abs(fdx)));
+        error = std :: max(error, std :: abs(fdy - dxy[(i * 2 + 1) * 2 + k]) / std :: max(1., std :: abs(fdy)));
+      }
+    }
+
+    std :: cout << "Brusselator sensitivities: max error against finite differences " << error << std :: endl;
+    assert (error < 1e-6);
+  }
+
+  // Sobol indices of the Ishigami function (a = 7, b = 0.1) on [-pi, pi]^3:
+  // S = (0.3139, 0.4424, 0) and ST = (0.5576, 0.4424, 0.2437)
+  {
+    const double pi = 3.141592653589793;
+    const double lower[3] = {-pi, -pi, -pi};
+    const double upper[3] = {pi, pi, pi};
+
+    auto ishigami = [](const double * p)
+                    {
+                      const double s2 = std :: sin(p[1]);
+                      return std :: sin(p[0]) * (1. + .1 * p[2] * p[2] * p[2] * p[2]) + 7. * s2 * s2;
+                    };
+
+    // analytic values: V = a^2 / 8 + b pi^4 / 5 + b^2 pi^8 / 18 + 1 / 2
+    const double V = 49. / 8. + .1 * std :: pow(pi, 4) / 5. + .01 * std :: pow(pi, 8) / 18. + .5;
+    const double V1 = .5 * (1. + .1 * std :: pow(pi, 4) / 5.) * (1. + .1 * std :: pow(pi, 4) / 5.);
+    const double V2 = 49. / 8.;
+    const double V13 = .01 * std :: pow(pi, 8) * (1. / 18. - 1. / 50.);
+    const double S[3] = {V1 / V, V2 / V, 0.};
+    const double ST[3] = {(V1 + V13) / V, V2 / V, V13 / V};
+
+    double first[3], total[3];
+    sobol_indices(ishigami, 3, lower, upper, int64_t(1) << 18, first, total);
+
+    for (int32_t j = 0; j < 3; ++j)
+    {
+      std :: cout << "Ishigami x" << j + 1 << " : S = " << first[j] << " (expected " << S[j] << ")"
+                  << "  ST = " << total[j] << " (expected " << ST[j] << ")" << std :: endl;
+
+      assert (std :: abs(first[j] - S[j]) < 1e-2 && std :: abs(total[j] - ST[j]) < 1e-2);
+    }
+  }
+
+  // the elementary effects of a linear function are its slopes (times the width of the box)
+  {
+    const double lower[3] = {0., -1., 10.};
+    const double upper[3] = {1., 3., 12.};
+    const double slope[3] = {2., -.5, 0.};
+
+    auto linear = [&](const double * p)
+                  {
+                    return slope[0] * p[0] + slope[1] * p[1] + slope[2] * p[2];
+                  };
+
+    double mu[3], mu_star[3], sigma[3];
+    morris_screening(linear, 3, lower, upper, int64_t(1000), mu, mu_star, sigma);
+
+    for (int32_t j = 0; j < 3; ++j)
+    {
+      const double effect = slope[j] * (upper[j] - lower[j]);
+      assert (std :: abs(mu[j] - effect) < 1e-12 && std :: abs(mu_star[j] - std :: abs(effect)) < 1e-12 && sigma[j] < 1e-12);
+    }
+
+    std :: cout << "Morris screening of a linear function: exact elementary effects" << std :: endl;
+  }
+
+  // Global sensitivity of the product at t = 5 over a box of the constants
+  using model = michaelis_menten_model < double >;
+
+  const double lower[3] = {.1, 1e-3, .1};
+  const double upper[3] = {10., 1., 10.};
+  const double y0[4] = {s0, e0, es0, p0};
+
+  auto product = [&](const double * params)
+                 {
+                   double last = 0.;
+                   rk4_sensitivity < model >(y0, params, dt, 1, iterations,
+                                             [&](const int64_t &, const double * y, const double *)
+                                             {
+                                               last = y[3];
+                                             }, false);
+                   return last;
+                 };
+
+  const char * names[3] = {"kf", "kb", "kc"};
+
+  double first[3], total[3];
+
+  auto start_time = std :: chrono :: high_resolution_clock :: now();
+  sobol_indices(product, 3, lower, upper, samples, first, total);
+  double run_time = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+  std :: cout << "Sobol indices (" << samples * 5 << " integrations in " << run_time << " sec)" << std :: endl;
+  for (int32_t j = 0; j < 3; ++j)
+    std :: cout << "  " << names[j] << " : S = " << first[j] << "  ST = " << total[j] << std :: endl;
+
+  double mu[3], mu_star[3], sigma[3];
+
+  start_time = std :: chrono :: high_resolution_clock :: now();
+  morris_screening(product, 3, lower, upper, samples, mu, mu_star, sigma);
+  run_time = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+  std :: cout << "Morris screening (" << samples * 4 << " integrations in " << run_time << " sec)" << std :: endl;
+  for (int32_t j = 0; j < 3; ++j)
+    std :: cout << "  " << names[j] << " : mu = " << mu[j] << "  mu* = " << mu_star[j] << "  sigma = " << sigma[j] << std :: endl;
+
+  PROFILE_REPORT(std :: cerr, "text");
+
+  return 0;
+}
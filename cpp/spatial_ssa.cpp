@@ -0,0 +1,141 @@
+// g++ spatial_ssa.cpp ../src/spatial_ssa.cpp -O3 -std=c++14 -fopenmp -I../include -o spatial_ssa
+
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <cmath>
+#include <cassert>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <spatial_ssa.h>
+#include <profiler.hpp>
+
+
+/**
+* @brief Mean and variance of the population of a species
+*
+*/
+std :: pair < double, double > moments (const spatial_ssa & ssa, const int32_t & species)
+{
+  std :: vector < int32_t > n(ssa.voxels());
+  ssa.population(species, n.data());
+
+  double mean = 0., var = 0.;
+  for (const auto & ni : n)
+    mean += ni;
+  mean /= n.size();
+  for (const auto & ni : n)
+    var += (ni - mean) * (ni - mean);
+  var /= n.size() - 1;
+
+  return std :: make_pair(mean, var);
+}
+
+
+int main (int argc, char ** argv)
+{
+  int64_t dim = 128;
+  double max_time = .5;
+
+  if (argc > 1)
+    dim = std :: stoll(argv[1]);
+  if (argc > 2)
+    max_time = std :: stod(argv[2]);
+
+#ifdef _OPENMP
+  const int32_t Npartitions = omp_get_max_threads();
+#else
+  const int32_t Npartitions = 1;
+#endif
+
+  // birth-death with diffusion: the stationary population of every voxel is Poisson(k omega)
+  {
+    const std :: vector < ssa_reaction > reactions = { {{}, {0}, 5.}, {{0}, {}, 1.} };
+    spatial_ssa ssa(32, 32, 1, 1, reactions, {1.}, 10., true, 42, 4);
+
+    ssa.run(20., .01);
+    const auto m = moments(ssa, 0);
+
+    std :: cout << "Birth-death : mean " << m.first << " (expected 50), variance / mean " << m.second / m.first << " (expected 1)" << std :: endl;
+
+    assert (std :: abs(m.first - 50.) < 1. && std :: abs(m.second / m.first - 1.) < .1);
+  }
+
+  // pure diffusion across the slab borders conserves the molecules
+  {
+    spatial_ssa ssa(16, 16, 16, 1, {}, {1.}, 1., false, 42, 4);
+    ssa.set(0, 0, 100000);
+
+    ssa.run(5., .05);
+    const auto m = moments(ssa, 0);
+
+    std :: cout << "Diffusion : " << m.first * ssa.voxels() << " molecules (expected 100000)" << std :: endl;
+
+    assert (std :: llround(m.first * ssa.voxels()) == 100000);
+  }
+
+  // the default window of the partitions follows the diffusion (same spreading of one partition)
+  {
+    double first_slab[2];
+
+    for (int32_t i = 0; i < 2; ++i)
+    {
+      spatial_ssa ssa(16, 16, 16, 1, {}, {1.}, 1., false, 42, i ? 4 : 1);
+      ssa.set(0, 0, 100000);
+      ssa.run(5.);
+
+      std :: vector < int32_t > n(ssa.voxels());
+      ssa.population(0, n.data());
+
+      // molecules in the first 4 planes (the first of 4 slabs)
+      int64_t inside = 0;
+      for (int64_t v = 0; v < 4 * 16 * 16; ++v)
+        inside += n[v];
+      first_slab[i] = inside * 1e-5;
+    }
+
+    std :: cout << "Partitions : fraction in the first slab " << first_slab[1] << " (single partition " << first_slab[0] << ")" << std :: endl;
+
+    assert (std :: abs(first_slab[1] - first_slab[0]) < .02);
+  }
+
+  // stochastic Brusselator (same reactions of BrusselatorCME) in the Turing regime
+  const double A = 4.5;
+  const double B = 7.5;
+  const double omega = 10.;
+
+  const std :: vector < ssa_reaction > brusselator = { {{},        {0},       A},   // 0 -> X
+                                                       {{0},       {1},       B},   // X -> Y
+                                                       {{0},       {},        1.},  // X -> 0
+                                                       {{0, 0, 1}, {0, 0, 0}, 1.}   // 2X + Y -> 3X
+                                                     };
+
+  spatial_ssa ssa(dim, dim, 1, 2, brusselator, {2., 16.}, omega, true, 42, Npartitions);
+
+  for (int64_t v = 0; v < ssa.voxels(); ++v)
+  {
+    ssa.set(v, 0, static_cast < int32_t >(A * omega));
+    ssa.set(v, 1, static_cast < int32_t >(B / A * omega));
+  }
+
+  auto start_time = std :: chrono :: high_resolution_clock :: now();
+
+  const int64_t events = ssa.run(max_time, .01);
+
+  const double elapsed = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+  const auto mx = moments(ssa, 0);
+  const auto my = moments(ssa, 1);
+
+  std :: cout << "Brusselator " << dim << "x" << dim << " (" << Npartitions << " partitions) up to time " << ssa.time() << std :: endl
+              << "  " << events << " events in " << elapsed << " sec (" << events / elapsed << " events/sec)" << std :: endl
+              << "  X : mean " << mx.first << ", std " << std :: sqrt(mx.second) << " (homogeneous steady state " << A * omega << ")" << std :: endl
+              << "  Y : mean " << my.first << ", std " << std :: sqrt(my.second) << " (homogeneous steady state " << B / A * omega << ")" << std :: endl;
+
+  PROFILE_REPORT(std :: cerr, "text");
+
+  return 0;
+}
@@ -0,0 +1,120 @@
+// g++ toggle_switch.cpp -std=c++14 -O3 -march=native -fopenmp -I../include -o toggle_switch
+
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include <cmath>
+#include <cassert>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <basins.hpp>
+#include <profiler.hpp>
+
+
+int main (int argc, char ** argv)
+{
+  int32_t resolution = 1024;
+  std :: string filename = "toggle_switch_basins.pgm";
+
+  if (argc > 1)
+    resolution = std :: stoi(argv[1]);
+  if (argc > 2)
+    filename = argv[2];
+
+  using model = toggle_switch_model < double >;
+
+  // bistable regime of py/toggle_switch.py
+  const double params[4] = {2., 2., 3., 3.};
+
+  const double lower[2] = {0., 0.};
+  const double upper[2] = {3., 3.};
+  const int32_t grid[2] = {resolution, resolution};
+
+  const double dt = .1;
+  const int32_t max_steps = 10000;
+  const double tol = 1e-4;
+  const double radius = 1e-2;
+
+  const int64_t Npoints = static_cast < int64_t >(resolution) * resolution;
+
+  std :: unique_ptr < uint8_t[] > labels(new uint8_t[Npoints]);
+  std :: unique_ptr < int32_t[] > steps(new int32_t[Npoints]);
+  std :: vector < double > attractors;
+
+  const auto start_time = std :: chrono :: high_resolution_clock :: now();
+
+  const int32_t Nattractors = basins_of_attraction < model >(lower, upper, grid, params, dt, max_steps, tol, radius,
+                                                             labels.get(), attractors, steps.get());
+
+  const double run_time = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+  int64_t total_steps = 0;
+  std :: vector < int64_t > size(256, 0);
+  for (int64_t i = 0; i < Npoints; ++i)
+  {
+    ++size[labels[i]];
+    total_steps += steps[i];
+  }
+
+  std :: cout << "Basins of " << Npoints << " initial conditions in " << run_time << " sec ("
+              << Npoints / run_time << " points/sec, " << static_cast < double >(total_steps) / Npoints << " steps/point)" << std :: endl;
+
+  for (int32_t a = 0; a < Nattractors; ++a)
+    std :: cout << "Fixed point " << a << " : (" << attractors[a * 2] << ", " << attractors[a * 2 + 1] << ") basin "
+                << 100. * size[a] / Npoints << " %" << std :: endl;
+  std :: cout << "Unclassified : " << 100. * size[BASIN_UNCLASSIFIED] / Npoints << " %" << std :: endl;
+
+  // the symmetric switch has two stable fixed points and the saddle (1, 1) on the diagonal
+  assert (Nattractors == 3);
+  for (int32_t a = 0; a < Nattractors; ++a)
+  {
+    double dy[2];
+    model :: rhs(attractors.data() + a * 2, params, dy);
+    assert (std :: max(std :: abs(dy[0]), std :: abs(dy[1])) < 10. * tol);
+  }
+  assert (std :: abs(attractors[2] - 1.) < radius && std :: abs(attractors[3] - 1.) < radius);
+
+  // the map is symmetric under the exchange of the species (which swaps the stable fixed points)
+  for (int32_t i = 0; i < resolution; ++i)
+    for (int32_t j = 0; j < resolution; ++j)
+    {
+      const uint8_t a = labels[i * resolution + j];
+      const uint8_t b = labels[j * resolution + i];
+      assert (a == BASIN_UNCLASSIFIED ? b == BASIN_UNCLASSIFIED : a == Nattractors - 1 - b);
+    }
+
+  // the labels do not depend on the number of threads
+#ifdef _OPENMP
+  const int32_t thread_counts[2] = {1, 3};
+
+  for (const auto & threads : thread_counts)
+  {
+    omp_set_num_threads(threads);
+
+    std :: unique_ptr < uint8_t[] > check(new uint8_t[Npoints]);
+    std :: vector < double > check_attractors;
+
+    const int32_t Ncheck = basins_of_attraction < model >(lower, upper, grid, params, dt, max_steps, tol, radius,
+                                                          check.get(), check_attractors);
+
+    assert (Ncheck == Nattractors);
+    assert (std :: equal(labels.get(), labels.get() + Npoints, check.get()));
+
+    for (std :: size_t k = 0; k < attractors.size(); ++k)
+      assert (std :: abs(attractors[k] - check_attractors[k]) < radius);
+  }
+  std :: cout << "Same basins with 1 and 3 threads" << std :: endl;
+#endif
+
+  if (save_basins(filename, labels.get(), resolution, resolution, Nattractors))
+    std :: cout << "Basin map saved to " << filename << std :: endl;
+
+  PROFILE_REPORT(std :: cerr, "text");
+
+  return 0;
+}
@@ -0,0 +1,82 @@
+// g++ turing_precision.cpp -O3 -std=c++14 -march=native -fopenmp -I../include -o turing_precision
+
+#include <iostream>
+#include <random>
+#include <vector>
+#include <chrono>
+#include <string>
+#include <cmath>
+#include <cassert>
+
+#include <brusselator.hpp>
+#include <profiler.hpp>
+
+
+int main (int argc, char ** argv)
+{
+  int64_t dim = 1024;
+  int64_t iterations = 200;
+
+  if (argc > 1)
+    dim = std :: stoll(argv[1]);
+  if (argc > 2)
+    iterations = std :: stoll(argv[2]);
+
+  // same parameters of brusselator_turing.cpp
+  const double A = 4.5;
+  const double B = 4.5;
+  const double Du = 2.;
+  const double Dv = 16.;
+  const double dt = .005;
+
+  std :: mt19937 eng(42);
+  std :: uniform_real_distribution < double > uniform(0., 1.);
+
+  // the initial condition is representable in float, so both paths start from the same state
+  std :: vector < float > Uf(dim * dim), Vf(dim * dim);
+  std :: generate(Uf.begin(), Uf.end(), [&] () { return static_cast < float >(A + .3 * uniform(eng)); });
+  std :: generate(Vf.begin(), Vf.end(), [&] () { return static_cast < float >(B / A + .3 * uniform(eng)); });
+
+  std :: vector < double > U(Uf.begin(), Uf.end()), V(Vf.begin(), Vf.end());
+
+  auto start_time = std :: chrono :: high_resolution_clock :: now();
+
+  brusselator_diffusion(U.data(), V.data(), dim, dim, dt, A, B, Du, Dv, iterations);
+
+  const double double_time = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+  start_time = std :: chrono :: high_resolution_clock :: now();
+
+  // float fields, double arithmetic
+  brusselator_diffusion(Uf.data(), Vf.data(), dim, dim, dt, A, B, Du, Dv, iterations);
+
+  const double mixed_time = std :: chrono :: duration < double >(std :: chrono :: high_resolution_clock :: now() - start_time).count();
+
+  // accuracy of the mixed path (relative to the range of the double fields)
+  double err_u = 0., err_v = 0.;
+  const auto range_u = std :: minmax_element(U.begin(), U.end());
+  const auto range_v = std :: minmax_element(V.begin(), V.end());
+
+  for (int64_t i = 0; i < dim * dim; ++i)
+  {
+    err_u = std :: max(err_u, std :: abs(U[i] - Uf[i]));
+    err_v = std :: max(err_v, std :: abs(V[i] - Vf[i]));
+  }
+
+  err_u /= *range_u.second - *range_u.first;
+  err_v /= *range_v.second - *range_v.first;
+
+  std :: cout << iterations << " iterations on " << dim << "x" << dim << std :: endl
+              << "  double fields : " << double_time << " sec (" << dim * dim * iterations / double_time << " site-updates/sec)" << std :: endl
+              << "  float fields  : " << mixed_time << " sec (" << dim * dim * iterations / mixed_time << " site-updates/sec, "
+              << double_time / mixed_time << "x)" << std :: endl
+              << "  max relative error : U " << err_u << ", V " << err_v << std :: endl;
+
+  // accuracy regression of the mixed precision path (the float
+  // rounding is amplified by the Turing instability, ~1e-5 at 200 iterations)
+  assert (err_u < 1e-3 && err_v < 1e-3);
+
+  PROFILE_REPORT(std :: cerr, "text");
+
+  return 0;
+}
@@ -1,47 +1,11 @@
-// g++ zero_order_kinetic.cpp -std=c++14 -O3 -o zero_order_kinetic
+// g++ zero_order_kinetic.cpp -std=c++14 -O3 -I../include -o zero_order_kinetic
 
 #include <memory>
 #include <algorithm>
-#include <type_traits>
-
-template < class type >
-using is_floating_point = typename std :: enable_if < std :: is_floating_point < type > :: value > :: type *;
-
-template < class type, is_floating_point < type > = nullptr >
-using array = std :: unique_ptr < type[] >;
-
-/**
-* @brief Zero order kinetic
-*
-* @param x List of time points.
-* @param y0 Initial condition of the reactant.
-* @param alpha Constant of the reaction.
-*
-* @tparam type Data-type of arrays
-* @tparam Length of time points.
-*
-* @return The resulting product array.
-*
-*/
-template < class type, int32_t N >
-array < type > zero_order (const array < type > & x, const type & y0, const type & alpha)
-{
-  // determine the interval as diff
-  const type dx = x[1] - x[0]; // Note: we are assuming it is constant!!
-
-  // Create an empyt buffer to store our results
-  // Its length must be greater than x since we want to set
-  // the initial condition!
-  array < type > y = std :: make_unique < type[] >(N + 1);
-  // Set the initial condition
-  y[0] = y0;
+#include <cmath>
+#include <cassert>
 
-  // Integrate the equation using the Euler method
-  for (int32_t i = 0; i < N; ++i)
-    y[i + 1] = y[i] - alpha * dx;
-
-  return y;
-}
+#include <kinetics.hpp>
 
 
 int32_t main (/*int32_t argc, char ** argv*/)
@@ -57,5 +21,18 @@ int32_t main (/*int32_t argc, char ** argv*/)
 
   array < float > R = zero_order < float, iterations >(x, y0, alpha);
 
+  // the constant rate is the source term of the exact (affine) propagator
+  const double K[1] = {0.};
+  const double b[1] = {-alpha};
+  const exponential_propagator < float > step(K, b, 1, dt);
+  assert (step.valid());
+
+  float y = y0;
+  for (int32_t i = 0; i <= iterations; ++i)
+  {
+    assert (std :: abs(R[i] - y) < 1e-4f);
+    step.apply(&y, 1);
+  }
+
   return 0;
 }
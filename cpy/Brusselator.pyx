@@ -1,28 +1,369 @@
 # distutils: language = c++
 # cython: language_level=2
+# cython: boundscheck=False
+# cython: wraparound=False
 
-def integrate (double[:] x, double[:] y, double A, double B, double dt, long iterations):
+from libc.stdint cimport int64_t
+from cython cimport floating
+from cython.parallel cimport prange
 
-  cdef long i
-  cdef double kx1, kx2, kx3, kx4
-  cdef double ky1, ky2, ky3, ky4
-  cdef double xi, yi
+cdef extern from "brusselator.hpp" nogil:
 
-  for i in range(0, iterations):
+  void brusselator_rk4[T] (T * x, T * y, int64_t iterations, T A, T B, T dt)
 
-    xi = x[i]
-    yi = y[i]
+  int64_t brusselator_ssa[T] (const T * t, int64_t Nt, T * x, T * y, T x0, T y0, T A, T B, T omega, size_t seed)
 
-    kx1 = A + xi*xi * yi - B * xi - xi;
-    kx2 = kx1 + dt * .5 * kx1;
-    kx3 = kx1 + dt * .5 * kx2;
-    kx4 = kx1 + dt * kx3;
+  # fields (storage) and arithmetic (compute) precision
+  void brusselator_diffusion[S, C] (S * U, S * V, int64_t rows, int64_t cols, C dt, C A, C B, C Du, C Dv, int64_t iterations)
 
-    ky1 = B * xi - xi*xi * yi;
-    ky2 = ky1 + dt * .5 * ky1;
-    ky3 = ky1 + dt * .5 * ky2;
-    ky4 = ky1 + dt * ky3;
+cdef extern from "kinetics.hpp" nogil:
 
-    x[i + 1] = xi + dt * .16666666666666666 * (kx1 + 2. * kx2 + 2. * kx3 + kx4)
-    y[i + 1] = yi + dt * .16666666666666666 * (ky1 + 2. * ky2 + 2. * ky3 + ky4)
+  # RK4 of the ode_models (y is (iterations + 1) x Nvar, p has Npar values)
+  void first_order_rk4 "kinetic_rk4< first_order_model< double > >" (double * y, int64_t iterations, const double * p, double dt)
 
+  void michaelis_menten_rk4 "kinetic_rk4< michaelis_menten_model< double > >" (double * y, int64_t iterations, const double * p, double dt)
+
+
+def integrate (double[::1] x, double[::1] y, double A, double B, double dt, long iterations):
+  '''
+  Integrate the Brusselator kinetic with the RK4 method.
+
+  The buffers are updated in-place (no copy) and the GIL is
+  released during the integration.
+
+  Parameters
+  ----------
+    x : array-like (iterations + 1, )
+      x values with the initial condition in x[0]
+
+    y : array-like (iterations + 1, )
+      y values with the initial condition in y[0]
+
+    A : float
+      Constant of the reaction
+
+    B : float
+      Constant of the reaction
+
+    dt : float
+      Integration step
+
+    iterations : int
+      Number of integration steps
+  '''
+
+  if x.shape[0] < iterations + 1 or y.shape[0] < iterations + 1:
+    raise ValueError('x and y must store at least iterations + 1 values')
+
+  with nogil:
+    brusselator_rk4[double](&x[0], &y[0], iterations, A, B, dt)
+
+
+def integrate_batch (double[:, ::1] x, double[:, ::1] y, double[::1] A, double[::1] B, double dt, long iterations, int num_threads=0):
+  '''
+  Integrate a batch of Brusselator kinetics (one for each parameter set)
+  with the RK4 method, in parallel.
+
+  Parameters
+  ----------
+    x : array-like (batch, iterations + 1)
+      x values with the initial conditions in x[:, 0]
+
+    y : array-like (batch, iterations + 1)
+      y values with the initial conditions in y[:, 0]
+
+    A : array-like (batch, )
+      Constants of the reaction
+
+    B : array-like (batch, )
+      Constants of the reaction
+
+    dt : float
+      Integration step
+
+    iterations : int
+      Number of integration steps
+
+    num_threads : int
+      Number of threads (0 means the OpenMP default)
+  '''
+
+  cdef Py_ssize_t i
+  cdef Py_ssize_t batch = x.shape[0]
+
+  if y.shape[0] != batch or A.shape[0] != batch or B.shape[0] != batch:
+    raise ValueError('Inconsistent batch size')
+
+  if x.shape[1] < iterations + 1 or y.shape[1] < iterations + 1:
+    raise ValueError('x and y must store at least iterations + 1 values')
+
+  if num_threads <= 0:
+    for i in prange(batch, nogil=True, schedule='static'):
+      brusselator_rk4[double](&x[i, 0], &y[i, 0], iterations, A[i], B[i], dt)
+  else:
+    for i in prange(batch, nogil=True, schedule='static', num_threads=num_threads):
+      brusselator_rk4[double](&x[i, 0], &y[i, 0], iterations, A[i], B[i], dt)
+
+
+def ssa_batch (double[::1] t, double[:, ::1] x, double[:, ::1] y,
+               double[::1] x0, double[::1] y0, double[::1] A, double[::1] B,
+               double omega, long seed=123, int num_threads=0):
+  '''
+  Simulate a batch of stochastic Brusselator (Gillespie algorithm)
+  in parallel, sampling the populations on a common time grid.
+
+  Parameters
+  ----------
+    t : array-like (Nt, )
+      Increasing time points
+
+    x : array-like (batch, Nt)
+      Output x populations
+
+    y : array-like (batch, Nt)
+      Output y populations
+
+    x0, y0 : array-like (batch, )
+      Initial conditions
+
+    A, B : array-like (batch, )
+      Constants of the reaction
+
+    omega : float
+      Volume of the system
+
+    seed : int
+      Random seed (the i-th simulation uses seed + i)
+
+    num_threads : int
+      Number of threads (0 means the OpenMP default)
+
+  Returns
+  -------
+    events : int
+      Total number of simulated events
+  '''
+
+  cdef Py_ssize_t i
+  cdef Py_ssize_t batch = x.shape[0]
+  cdef int64_t Nt = t.shape[0]
+  cdef int64_t events = 0
+
+  if y.shape[0] != batch or x0.shape[0] != batch or y0.shape[0] != batch or A.shape[0] != batch or B.shape[0] != batch:
+    raise ValueError('Inconsistent batch size')
+
+  if x.shape[1] != Nt or y.shape[1] != Nt:
+    raise ValueError('x and y must store a value for each time point')
+
+  if num_threads <= 0:
+    for i in prange(batch, nogil=True, schedule='dynamic'):
+      events += brusselator_ssa[double](&t[0], Nt, &x[i, 0], &y[i, 0], x0[i], y0[i], A[i], B[i], omega, seed + i)
+  else:
+    for i in prange(batch, nogil=True, schedule='dynamic', num_threads=num_threads):
+      events += brusselator_ssa[double](&t[0], Nt, &x[i, 0], &y[i, 0], x0[i], y0[i], A[i], B[i], omega, seed + i)
+
+  return events
+
+
+def diffusion (floating[:, ::1] U, floating[:, ::1] V, double dt, double A, double B, double Du, double Dv, long iterations):
+  '''
+  Integrate the Brusselator reaction-diffusion model (Turing patterns).
+
+  The fields are updated in-place (no copy) and the GIL is
+  released during the integration. The fields can be float64
+  or float32: with float32 the Laplacian is evaluated in float
+  and the reaction terms in double (see brusselator_diffusion).
+
+  Parameters
+  ----------
+    U : array-like (rows, cols)
+      Field of the 1st morphogen (float64 or float32)
+
+    V : array-like (rows, cols)
+      Field of the 2nd morphogen (same type of U)
+
+    dt : float
+      Interval of time
+
+    A, B : float
+      Kinetic reaction constants
+
+    Du, Dv : float
+      Diffusion coefficients of the morphogens
+
+    iterations : int
+      Number of iterations to perform
+  '''
+
+  if U.shape[0] != V.shape[0] or U.shape[1] != V.shape[1]:
+    raise ValueError('U and V must have the same shape')
+
+  with nogil:
+    if floating is float:
+      brusselator_diffusion[float, double](&U[0, 0], &V[0, 0], U.shape[0], U.shape[1], dt, A, B, Du, Dv, iterations)
+    else:
+      brusselator_diffusion[double, double](&U[0, 0], &V[0, 0], U.shape[0], U.shape[1], dt, A, B, Du, Dv, iterations)
+
+
+def first_order (double[:, ::1] y, double kf, double kb, double dt, long iterations):
+  '''
+  Integrate the 1st order reversible kinetic with the RK4 method.
+
+          dP/dt =  kf R - kb P
+          dR/dt = -kf R + kb P
+
+  The buffer is updated in-place (no copy) and the GIL is
+  released during the integration.
+
+  Parameters
+  ----------
+    y : array-like (iterations + 1, 2)
+      (P, R) values with the initial condition in y[0]
+
+    kf : float
+      Constant of the forward reaction
+
+    kb : float
+      Constant of the backward reaction
+
+    dt : float
+      Integration step
+
+    iterations : int
+      Number of integration steps
+  '''
+
+  cdef double p[2]
+  p[0] = kf
+  p[1] = kb
+
+  if y.shape[0] < iterations + 1 or y.shape[1] != 2:
+    raise ValueError('y must store at least (iterations + 1, 2) values')
+
+  with nogil:
+    first_order_rk4(&y[0, 0], iterations, p, dt)
+
+
+def first_order_batch (double[:, :, ::1] y, double[:, ::1] params, double dt, long iterations, int num_threads=0):
+  '''
+  Integrate a batch of 1st order kinetics (one for each parameter set)
+  with the RK4 method, in parallel.
+
+  Parameters
+  ----------
+    y : array-like (batch, iterations + 1, 2)
+      (P, R) values with the initial conditions in y[:, 0]
+
+    params : array-like (batch, 2)
+      Constants (kf, kb) of the reactions
+
+    dt : float
+      Integration step
+
+    iterations : int
+      Number of integration steps
+
+    num_threads : int
+      Number of threads (0 means the OpenMP default)
+  '''
+
+  cdef Py_ssize_t i
+  cdef Py_ssize_t batch = y.shape[0]
+
+  if params.shape[0] != batch or params.shape[1] != 2:
+    raise ValueError('params must store (batch, 2) values')
+
+  if y.shape[1] < iterations + 1 or y.shape[2] != 2:
+    raise ValueError('y must store at least (batch, iterations + 1, 2) values')
+
+  if num_threads <= 0:
+    for i in prange(batch, nogil=True, schedule='static'):
+      first_order_rk4(&y[i, 0, 0], iterations, &params[i, 0], dt)
+  else:
+    for i in prange(batch, nogil=True, schedule='static', num_threads=num_threads):
+      first_order_rk4(&y[i, 0, 0], iterations, &params[i, 0], dt)
+
+
+def michaelis_menten (double[:, ::1] y, double kf, double kb, double kc, double dt, long iterations):
+  '''
+  Integrate the Michaelis Menten kinetic with the RK4 method.
+
+          dS/dt  = -kf S E + kb ES
+          dE/dt  = -kf S E + (kb + kc) ES
+          dES/dt =  kf S E - (kb + kc) ES
+          dP/dt  =  kc ES
+
+  The buffer is updated in-place (no copy) and the GIL is
+  released during the integration.
+
+  Parameters
+  ----------
+    y : array-like (iterations + 1, 4)
+      (S, E, ES, P) values with the initial condition in y[0]
+
+    kf : float
+      Constant of the forward reaction
+
+    kb : float
+      Constant of the backward reaction
+
+    kc : float
+      Constant of the product reaction
+
+    dt : float
+      Integration step
+
+    iterations : int
+      Number of integration steps
+  '''
+
+  cdef double p[3]
+  p[0] = kf
+  p[1] = kb
+  p[2] = kc
+
+  if y.shape[0] < iterations + 1 or y.shape[1] != 4:
+    raise ValueError('y must store at least (iterations + 1, 4) values')
+
+  with nogil:
+    michaelis_menten_rk4(&y[0, 0], iterations, p, dt)
+
+
+def michaelis_menten_batch (double[:, :, ::1] y, double[:, ::1] params, double dt, long iterations, int num_threads=0):
+  '''
+  Integrate a batch of Michaelis Menten kinetics (one for each parameter set)
+  with the RK4 method, in parallel.
+
+  Parameters
+  ----------
+    y : array-like (batch, iterations + 1, 4)
+      (S, E, ES, P) values with the initial conditions in y[:, 0]
+
+    params : array-like (batch, 3)
+      Constants (kf, kb, kc) of the reactions
+
+    dt : float
+      Integration step
+
+    iterations : int
+      Number of integration steps
+
+    num_threads : int
+      Number of threads (0 means the OpenMP default)
+  '''
+
+  cdef Py_ssize_t i
+  cdef Py_ssize_t batch = y.shape[0]
+
+  if params.shape[0] != batch or params.shape[1] != 3:
+    raise ValueError('params must store (batch, 3) values')
+
+  if y.shape[1] < iterations + 1 or y.shape[2] != 4:
+    raise ValueError('y must store at least (batch, iterations + 1, 4) values')
+
+  if num_threads <= 0:
+    for i in prange(batch, nogil=True, schedule='static'):
+      michaelis_menten_rk4(&y[i, 0, 0], iterations, &params[i, 0], dt)
+  else:
+    for i in prange(batch, nogil=True, schedule='static', num_threads=num_threads):
+      michaelis_menten_rk4(&y[i, 0, 0], iterations, &params[i, 0], dt)
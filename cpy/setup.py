@@ -37,10 +37,14 @@ class _build_ext (build_ext):
 
 ext_modules = [ Extension(name='fastBrusselator',
                           sources=['Brusselator.pyx'],
+                          include_dirs=['../include'],
                           libraries=['m'],
                           extra_compile_args = ['-g0',
                                                 '-Ofast',
+                                                '-std=c++14',
+                                                '-fopenmp',
                                                 '-Wno-unused-function'],
+                          extra_link_args = ['-fopenmp'],
                           language='c++'
                           )]
 
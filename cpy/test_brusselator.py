@@ -0,0 +1,198 @@
+# -*- coding: utf-8 -*-
+#!/usr/bin/env python
+
+# python setup.py build_ext --inplace
+# python test_brusselator.py (or pytest test_brusselator.py)
+
+import numpy as np
+import fastBrusselator as fb
+
+__package__ = "Brusselator"
+__author__  = "Nico Curti"
+__email__   = "nico.curti2@unibo.it"
+
+
+'''
+Smoke test of the fastBrusselator bindings: each call is compared with
+a NumPy reference of the same model (on the setup of fast_brusselator.py)
+and each batched call with the single one.
+'''
+
+# setup of fast_brusselator.py
+A, B = (.5, 2.)
+dt = 1e-2
+iterations = 10000
+x0, y0 = (1.6, 2.8)
+
+
+def rk4 (rhs, y, dt, iterations):
+  '''
+  Reference RK4 integration of dy/dt = rhs(y) (y[0] is the initial condition)
+  '''
+
+  for i in range(iterations):
+    k1 = rhs(y[i])
+    k2 = rhs(y[i] + .5 * dt * k1)
+    k3 = rhs(y[i] + .5 * dt * k2)
+    k4 = rhs(y[i] + dt * k3)
+    y[i + 1] = y[i] + dt / 6. * (k1 + 2. * k2 + 2. * k3 + k4)
+
+  return y
+
+
+def brusselator (A, B):
+  return lambda s : np.array([A + s[0]*s[0]*s[1] - B*s[0] - s[0], B*s[0] - s[0]*s[0]*s[1]])
+
+
+def test_integrate ():
+
+  x = np.empty(shape=(iterations + 1), dtype=float)
+  y = np.empty(shape=(iterations + 1), dtype=float)
+  x[0], y[0] = (x0, y0)
+
+  fb.integrate(x, y, A, B, dt, iterations)
+
+  ref = np.empty(shape=(iterations + 1, 2), dtype=float)
+  ref[0] = (x0, y0)
+  rk4(brusselator(A, B), ref, dt, iterations)
+
+  assert np.allclose(x, ref[:, 0], rtol=1e-9, atol=1e-12)
+  assert np.allclose(y, ref[:, 1], rtol=1e-9, atol=1e-12)
+
+  # the limit cycle (B > 1 + A^2) stays away from the fixed point (A, B / A)
+  assert np.hypot(x[-1] - A, y[-1] - B / A) > .1
+
+
+def test_integrate_batch ():
+
+  As = np.repeat([.5, 1., 1.5], 3)
+  Bs = np.tile([1., 2., 3.], 3)
+
+  x = np.empty(shape=(len(As), iterations + 1), dtype=float)
+  y = np.empty(shape=(len(As), iterations + 1), dtype=float)
+  x[:, 0], y[:, 0] = (x0, y0)
+
+  fb.integrate_batch(x, y, As, Bs, dt, iterations)
+
+  for i, (a, b) in enumerate(zip(As, Bs)):
+    xi = np.empty(shape=(iterations + 1), dtype=float)
+    yi = np.empty(shape=(iterations + 1), dtype=float)
+    xi[0], yi[0] = (x0, y0)
+
+    fb.integrate(xi, yi, a, b, dt, iterations)
+
+    assert np.array_equal(x[i], xi) and np.array_equal(y[i], yi)
+
+
+def test_ssa_batch ():
+
+  t = np.linspace(0., 5., 51)
+  batch = 4
+  omega = 100.
+
+  x = np.empty(shape=(batch, len(t)), dtype=float)
+  y = np.empty(shape=(batch, len(t)), dtype=float)
+  X0 = np.full(batch, x0 * omega)
+  Y0 = np.full(batch, y0 * omega)
+  As = np.full(batch, A)
+  Bs = np.full(batch, B)
+
+  events = fb.ssa_batch(t, x, y, X0, Y0, As, Bs, omega, seed=42)
+
+  assert events > 0
+  assert np.all(x >= 0) and np.all(y >= 0)
+  assert np.all(x[:, 0] == X0) and np.all(y[:, 0] == Y0)
+
+  # the streams depend only on the seed (not on the threads)
+  x1 = np.empty_like(x)
+  y1 = np.empty_like(y)
+  assert fb.ssa_batch(t, x1, y1, X0, Y0, As, Bs, omega, seed=42, num_threads=1) == events
+  assert np.array_equal(x, x1) and np.array_equal(y, y1)
+
+
+def test_diffusion ():
+
+  rng = np.random.default_rng(42)
+  U = 4.5 + .3 * rng.random(size=(64, 48))
+  V = 7.5 / 4.5 + .3 * rng.random(size=(64, 48))
+
+  U32 = U.astype(np.float32)
+  V32 = V.astype(np.float32)
+
+  fb.diffusion(U, V, .005, 4.5, 7.5, 2., 16., 100)
+  fb.diffusion(U32, V32, .005, 4.5, 7.5, 2., 16., 100)
+
+  # float fields (mixed precision) against double fields
+  assert np.allclose(U32, U, rtol=1e-4) and np.allclose(V32, V, rtol=1e-4)
+
+  try:
+    fb.diffusion(U, V[:-1], .005, 4.5, 7.5, 2., 16., 1)
+    assert False
+  except ValueError:
+    pass
+
+
+def test_first_order ():
+
+  kf, kb = (.3, .6)
+  p0, r0 = (0., 1.)
+
+  y = np.empty(shape=(1001, 2), dtype=float)
+  y[0] = (p0, r0)
+
+  fb.first_order(y, kf, kb, dt, 1000)
+
+  # analytic solution: R(t) = R_eq + (r0 - R_eq) exp(-(kf + kb) t)
+  t = dt * np.arange(1001)
+  r_eq = kb * (p0 + r0) / (kf + kb)
+
+  assert np.allclose(y[:, 1], r_eq + (r0 - r_eq) * np.exp(-(kf + kb) * t), atol=1e-10)
+  assert np.allclose(y.sum(axis=1), p0 + r0, atol=1e-12)
+
+  params = np.array([[kf, kb], [1., .1], [.1, 1.]])
+  Y = np.empty(shape=(len(params), 1001, 2), dtype=float)
+  Y[:, 0] = (p0, r0)
+
+  fb.first_order_batch(Y, params, dt, 1000)
+
+  assert np.array_equal(Y[0], y)
+
+
+def test_michaelis_menten ():
+
+  kf, kb, kc = (1., 1e-2, 1.)
+  s0, e0 = (10., 1.)
+
+  y = np.empty(shape=(2001, 4), dtype=float)
+  y[0] = (s0, e0, 0., 0.)
+
+  fb.michaelis_menten(y, kf, kb, kc, dt, 2000)
+
+  ref = np.empty_like(y)
+  ref[0] = y[0]
+  rk4(lambda s : np.array([-kf * s[0] * s[1] + kb * s[2],
+                           -kf * s[0] * s[1] + (kb + kc) * s[2],
+                            kf * s[0] * s[1] - (kb + kc) * s[2],
+                            kc * s[2]]), ref, dt, 2000)
+
+  assert np.allclose(y, ref, rtol=1e-9, atol=1e-12)
+
+  # conservation of the substrate and of the enzyme
+  assert np.allclose(y[:, 0] + y[:, 2] + y[:, 3], s0, atol=1e-10)
+  assert np.allclose(y[:, 1] + y[:, 2], e0, atol=1e-10)
+
+  params = np.array([[kf, kb, kc], [.5, .1, 2.]])
+  Y = np.empty(shape=(len(params), 2001, 4), dtype=float)
+  Y[:, 0] = y[0]
+
+  fb.michaelis_menten_batch(Y, params, dt, 2000, num_threads=2)
+
+  assert np.array_equal(Y[0], y)
+
+
+if __name__ == '__main__':
+
+  for name, test in sorted(globals().items()):
+    if name.startswith('test_') and callable(test):
+      test()
+      print('{} : ok'.format(name))
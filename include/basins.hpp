@@ -0,0 +1,433 @@
+#ifndef __basins_hpp__
+#define __basins_hpp__
+
+#include <array>
+#include <vector>
+#include <atomic>
+#include <fstream>
+#include <string>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <cstdint>
+
+#include <ode_models.hpp>
+#include <profiler.hpp>
+
+/**
+* @brief Label of the points which do not reach a fixed point
+*
+*/
+static constexpr uint8_t BASIN_UNCLASSIFIED = 255;
+
+
+/**
+* @brief Basins of attraction of the fixed points of a model
+*
+* @details The initial conditions are the nodes of a regular grid
+* in the box [lower, upper] (np.linspace along each axis, with the
+* first axis running fastest, so in 2D the map is an image with
+* resolution[0] columns and resolution[1] rows).
+* Each thread integrates (RK4) a batch of lanes initial conditions
+* at a time in structure-of-arrays layout, so the model RHS is
+* evaluated on all the lanes by a single (vectorizable) loop.
+* A point stops as soon as it converges (max-norm of the RHS lower
+* than tol) and its lane is refilled with the next point of the
+* thread chunk, so the batch stays full and the cost of each point
+* is its own transient.
+* The converged state is matched to the fixed points found so far
+* (within radius) or added as a new one: the list is shared by
+* the threads and it is published by an atomic counter (the
+* insertion is in a critical section, the lookup is lock-free).
+* When a fixed point is added its stability is probed by
+* displacing it by radius / 2 along all the directions; the points
+* entering the radius of a stable fixed point stop there, without
+* waiting for the convergence of the RHS.
+* At the end the fixed points are sorted lexicographically and the
+* labels are renumbered, so the map does not depend on the number
+* of threads.
+*
+* @note Only fixed points are classified: the points which do not
+* converge within max_steps (e.g. on a limit cycle) are labelled
+* BASIN_UNCLASSIFIED.
+*
+* @param lower Lower corner of the box (Nvar values).
+* @param upper Upper corner of the box (Nvar values).
+* @param resolution Number of grid nodes along each axis (Nvar values, at least 2).
+* @param p Parameters of the model (Npar values).
+* @param dt Integration step.
+* @param max_steps Maximum number of integration steps of each point.
+* @param tol Convergence threshold on the max-norm of the RHS.
+* @param radius Distance (max-norm) within which two converged states are the same fixed point.
+* @param labels Output basin map (one label per grid node, BASIN_UNCLASSIFIED for the points not converged).
+* @param attractors Output fixed points (Nvar coordinates each, in label order).
+* @param steps Optional output of the number of steps of each point (nullptr to skip).
+*
+* @tparam model Model class (see ode_models.hpp).
+*
+* @return The number of fixed points found (at most 254).
+*
+*/
+template < class model >
+int32_t basins_of_attraction (const typename model :: value_type * lower,
+                              const typename model :: value_type * upper,
+                              const int32_t * resolution,
+                              const typename model :: value_type * p,
+                              const typename model :: value_type & dt,
+                              const int32_t & max_steps,
+                              const typename model :: value_type & tol,
+                              const typename model :: value_type & radius,
+                              uint8_t * labels,
+                              std :: vector < typename model :: value_type > & attractors,
+                              int32_t * steps = nullptr)
+{
+  using type = typename model :: value_type;
+
+  constexpr int32_t Nvar = model :: Nvar;
+  constexpr int32_t lanes = 16;
+  constexpr int32_t capacity = BASIN_UNCLASSIFIED - 1;
+
+  const int64_t chunk = 4096;
+
+  int64_t Npoints = 1;
+  for (int32_t d = 0; d < Nvar; ++d)
+    Npoints *= resolution[d];
+
+  PROFILE_SCOPE("basins_of_attraction");
+  PROFILE_COUNT("basins_of_attraction", Npoints);
+
+  // shared list of the fixed points (written once, published by the counter)
+  std :: vector < std :: array < type, Nvar > > found(capacity);
+  std :: vector < uint8_t > stable(capacity, 0);
+  std :: atomic < int32_t > Nfound(0);
+
+  auto distance = [](const type * a, const type * b)
+                  {
+                    type dist = type(0.);
+                    for (int32_t d = 0; d < Nvar; ++d)
+                      dist = std :: max(dist, std :: abs(a[d] - b[d]));
+                    return dist;
+                  };
+
+  // integrate a single point until convergence (RK4)
+  auto integrate = [&](type * y)
+                   {
+                     std :: array < std :: array < type, Nvar >, 4 > k;
+                     std :: array < type, Nvar > t;
+
+                     for (int32_t n = 0; n < max_steps; ++n)
+                     {
+                       model :: rhs(y, p, k[0].data());
+
+                       type norm = type(0.);
+                       for (int32_t d = 0; d < Nvar; ++d)
+                         norm = std :: max(norm, std :: abs(k[0][d]));
+
+                       if (norm < tol)
+                         return true;
+
+                       for (int32_t s = 1; s < 4; ++s)
+                       {
+                         const type h = s < 3 ? type(.5) * dt : dt;
+                         for (int32_t d = 0; d < Nvar; ++d)
+                           t[d] = y[d] + h * k[s - 1][d];
+                         model :: rhs(t.data(), p, k[s].data());
+                       }
+
+                       for (int32_t d = 0; d < Nvar; ++d)
+                         y[d] += dt * type(1. / 6.) * (k[0][d] + type(2.) * k[1][d] + type(2.) * k[2][d] + k[3][d]);
+                     }
+
+                     return false;
+                   };
+
+  // a fixed point is stable if the points displaced by radius / 2 along
+  // the 3^Nvar - 1 directions with components in {-1, 0, 1} come back to it
+  auto probe = [&](const type * fp)
+               {
+                 int32_t combinations = 1;
+                 for (int32_t d = 0; d < Nvar; ++d)
+                   combinations *= 3;
+
+                 for (int32_t c = 0; c < combinations; ++c)
+                 {
+                   std :: array < type, Nvar > y;
+                   bool origin = true;
+
+                   for (int32_t d = 0, code = c; d < Nvar; ++d, code /= 3)
+                   {
+                     const int32_t dir = code % 3 - 1;
+                     origin = origin && dir == 0;
+                     y[d] = fp[d] + dir * type(.5) * radius;
+                   }
+
+                   if (origin)
+                     continue;
+
+                   if ( !integrate(y.data()) || !(distance(y.data(), fp) < radius) )
+                     return false;
+                 }
+
+                 return true;
+               };
+
+  auto classify = [&](const type * y)
+                  {
+                    auto match = [&](const int32_t & count)
+                                 {
+                                   for (int32_t a = 0; a < count; ++a)
+                                     if (distance(found[a].data(), y) < radius)
+                                       return a;
+                                   return -1;
+                                 };
+
+                    int32_t label = match(Nfound.load(std :: memory_order_acquire));
+
+                    if (label != -1)
+                      return static_cast < uint8_t >(label);
+
+#ifdef _OPENMP
+                    #pragma omp critical (basins_of_attraction)
+#endif
+                    {
+                      // another thread could have added the same fixed point in the meantime
+                      const int32_t count = Nfound.load(std :: memory_order_relaxed);
+                      label = match(count);
+
+                      if (label == -1 && count < capacity)
+                      {
+                        std :: copy_n(y, Nvar, found[count].begin());
+                        stable[count] = probe(y) ? 1 : 0;
+                        Nfound.store(count + 1, std :: memory_order_release);
+                        label = count;
+                      }
+                    }
+
+                    return label == -1 ? BASIN_UNCLASSIFIED : static_cast < uint8_t >(label);
+                  };
+
+  auto coordinate = [&](int64_t idx, const int32_t & d)
+                    {
+                      for (int32_t k = 0; k < d; ++k)
+                        idx /= resolution[k];
+                      const int64_t i = idx % resolution[d];
+                      return lower[d] + (upper[d] - lower[d]) * static_cast < type >(i) / (resolution[d] - 1);
+                    };
+
+  const int64_t Nchunks = (Npoints + chunk - 1) / chunk;
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic, 1)
+#endif
+  for (int64_t c = 0; c < Nchunks; ++c)
+  {
+    const int64_t end = std :: min((c + 1) * chunk, Npoints);
+    int64_t next = c * chunk;
+
+    // lane states in structure-of-arrays layout (Y[d * lanes + l])
+    std :: array < type, Nvar * lanes > Y, T, K, acc;
+    std :: array < int64_t, lanes > point;
+    std :: array < int32_t, lanes > count;
+
+    // evaluate the RHS on all the lanes
+    auto rhs = [&](const std :: array < type, Nvar * lanes > & in, std :: array < type, Nvar * lanes > & out)
+               {
+#ifdef _OPENMP
+                 #pragma omp simd
+#endif
+                 for (int32_t l = 0; l < lanes; ++l)
+                 {
+                   type y[Nvar];
+                   type dy[Nvar];
+                   for (int32_t d = 0; d < Nvar; ++d)
+                     y[d] = in[d * lanes + l];
+                   model :: rhs(y, p, dy);
+                   for (int32_t d = 0; d < Nvar; ++d)
+                     out[d * lanes + l] = dy[d];
+                 }
+               };
+
+    auto load = [&](const int32_t & l)
+                {
+                  if (next < end)
+                  {
+                    point[l] = next;
+                    for (int32_t d = 0; d < Nvar; ++d)
+                      Y[d * lanes + l] = coordinate(next, d);
+                    ++next;
+                  }
+                  else
+                  {
+                    // idle lane: park it on the first point of the chunk (finite values)
+                    point[l] = -1;
+                    for (int32_t d = 0; d < Nvar; ++d)
+                      Y[d * lanes + l] = coordinate(c * chunk, d);
+                  }
+                  count[l] = 0;
+                };
+
+    for (int32_t l = 0; l < lanes; ++l)
+      load(l);
+
+    int32_t active = static_cast < int32_t >(std :: count_if(point.begin(), point.end(), [](const int64_t & i) { return i != -1; }));
+
+    while (active)
+    {
+      rhs(Y, K);
+
+      // retire the lanes captured by a stable fixed point or converged
+      // (the RHS of the first stage is the convergence test)
+      const int32_t known = Nfound.load(std :: memory_order_acquire);
+
+      for (int32_t l = 0; l < lanes; ++l)
+      {
+        if (point[l] == -1)
+          continue;
+
+        type y[Nvar];
+        type norm = type(0.);
+        for (int32_t d = 0; d < Nvar; ++d)
+        {
+          y[d] = Y[d * lanes + l];
+          norm = std :: max(norm, std :: abs(K[d * lanes + l]));
+        }
+
+        int32_t captured = -1;
+        for (int32_t a = 0; a < known && captured == -1; ++a)
+          if (stable[a] && distance(found[a].data(), y) < radius)
+            captured = a;
+
+        const bool converged = norm < tol;
+
+        if ( captured == -1 && !converged && count[l] < max_steps && std :: isfinite(norm) )
+          continue;
+
+        labels[point[l]] = captured != -1 ? static_cast < uint8_t >(captured)
+                         : converged      ? classify(y)
+                         : BASIN_UNCLASSIFIED;
+        if (steps)
+          steps[point[l]] = count[l];
+
+        load(l);
+        active -= point[l] == -1 ? 1 : 0;
+
+        // first stage of the new point
+        type dy[Nvar];
+        for (int32_t d = 0; d < Nvar; ++d)
+          y[d] = Y[d * lanes + l];
+        model :: rhs(y, p, dy);
+        for (int32_t d = 0; d < Nvar; ++d)
+          K[d * lanes + l] = dy[d];
+
+        // a refilled point could already be converged: test it at the next step
+      }
+
+      if ( !active )
+        break;
+
+      // RK4 step of all the lanes
+      const type half = type(.5) * dt;
+
+      for (int32_t i = 0; i < Nvar * lanes; ++i)
+      {
+        acc[i] = K[i];
+        T[i] = Y[i] + half * K[i];
+      }
+
+      rhs(T, K);
+      for (int32_t i = 0; i < Nvar * lanes; ++i)
+      {
+        acc[i] += type(2.) * K[i];
+        T[i] = Y[i] + half * K[i];
+      }
+
+      rhs(T, K);
+      for (int32_t i = 0; i < Nvar * lanes; ++i)
+      {
+        acc[i] += type(2.) * K[i];
+        T[i] = Y[i] + dt * K[i];
+      }
+
+      rhs(T, K);
+      for (int32_t i = 0; i < Nvar * lanes; ++i)
+        Y[i] += dt * type(1. / 6.) * (acc[i] + K[i]);
+
+      for (int32_t l = 0; l < lanes; ++l)
+        ++count[l];
+    }
+  }
+
+  // renumber the fixed points in lexicographic order
+  const int32_t Nattractors = Nfound.load();
+
+  std :: vector < int32_t > order(Nattractors);
+  std :: iota(order.begin(), order.end(), 0);
+  std :: sort(order.begin(), order.end(),
+              [&](const int32_t & a, const int32_t & b)
+              {
+                return found[a] < found[b];
+              });
+
+  std :: array < uint8_t, 256 > relabel;
+  relabel.fill(BASIN_UNCLASSIFIED);
+  for (int32_t a = 0; a < Nattractors; ++a)
+    relabel[order[a]] = static_cast < uint8_t >(a);
+
+#ifdef _OPENMP
+  #pragma omp parallel for
+#endif
+  for (int64_t i = 0; i < Npoints; ++i)
+    labels[i] = relabel[labels[i]];
+
+  attractors.resize(Nattractors * Nvar);
+  for (int32_t a = 0; a < Nattractors; ++a)
+    std :: copy_n(found[order[a]].begin(), Nvar, attractors.begin() + a * Nvar);
+
+  return Nattractors;
+}
+
+
+/**
+* @brief Save a 2D basin map as a binary PGM image
+*
+* @details The labels are spread over the gray levels (the
+* unclassified points are black), one byte per grid node, with
+* the first row of the image at the upper end of the second axis.
+*
+* @param filename Output filename.
+* @param labels Basin map (width x height labels).
+* @param width Number of grid nodes along the first axis.
+* @param height Number of grid nodes along the second axis.
+* @param Nattractors Number of fixed points.
+*
+* @return False if the file cannot be written.
+*
+*/
+inline bool save_basins (const std :: string & filename, const uint8_t * labels,
+                         const int32_t & width, const int32_t & height,
+                         const int32_t & Nattractors)
+{
+  std :: ofstream os(filename, std :: ios :: binary);
+
+  if ( !os )
+    return false;
+
+  os << "P5\n" << width << " " << height << "\n255\n";
+
+  const int32_t levels = std :: max(Nattractors, 1);
+  std :: vector < char > row(width);
+
+  for (int32_t r = height - 1; r >= 0; --r)
+  {
+    for (int32_t c = 0; c < width; ++c)
+    {
+      const uint8_t l = labels[static_cast < int64_t >(r) * width + c];
+      row[c] = static_cast < char >(l == BASIN_UNCLASSIFIED ? 0 : 255 * (l + 1) / levels);
+    }
+    os.write(row.data(), width);
+  }
+
+  return static_cast < bool >(os);
+}
+
+#endif // __basins_hpp__
@@ -0,0 +1,130 @@
+#ifndef __bernoulli_h__
+#define __bernoulli_h__
+
+#include <memory>
+#include <algorithm>
+#include <cstdint>
+
+/**
+* @brief Bernoulli shift map on a floating point lattice
+*
+* @details The map x -> 2x mod 1 is applied in-place, k
+* iterations at a time on cache-sized blocks of sites, so every
+* pass reads and writes the lattice from main memory only once.
+* The values in [0, 1) stay in [0, 1) (e.g. 0.5 -> 0) with the
+* same rounding of the fixed point lattice, so the two versions
+* give the same orbit of the exactly representable values;
+* 1 is a fixed point.
+*
+* @note With a binary floating point representation each
+* iteration drops one bit of the mantissa, so the dynamics
+* collapses to 0 after ~53 iterations in double precision.
+* Use the fixed_lattice version for long orbits.
+*
+* @param G Lattice values in [0, 1].
+* @param size Number of lattice sites.
+* @param iteration Number of iterations to perform.
+* @param k Number of iterations per pass.
+*
+*/
+template < class type >
+void bernoulli (type * G, const int64_t & size,
+                const int64_t & iteration, const int64_t & k = 16)
+{
+  const int64_t block = 1024;
+
+  for (int64_t t = 0; t < iteration; t += k)
+  {
+    const int64_t steps = std :: min(k, iteration - t);
+
+#ifdef _OPENMP
+    #pragma omp parallel for
+#endif
+    for (int64_t b = 0; b < size; b += block)
+    {
+      type * g = G + b;
+      const int64_t n = std :: min(block, size - b);
+
+      for (int64_t s = 0; s < steps; ++s)
+      {
+#ifdef _OPENMP
+        #pragma omp simd
+#endif
+        for (int64_t i = 0; i < n; ++i)
+        {
+          const type v = g[i] * type(2.);
+          g[i] = v - ((v >= type(1.)) ? type(1.) : type(0.));
+        }
+      }
+    }
+  }
+}
+
+
+/**
+* @brief Fixed point lattice with arbitrary precision
+*
+* @details Each site stores the binary expansion of a value
+* in [0, 1) using `words` 64-bit words (the first word holds the
+* most significant bits). The words are stored as planes
+* (word-major order), so the same word of consecutive sites is
+* contiguous in memory and the shift operations vectorize.
+*
+*/
+struct fixed_lattice
+{
+  int64_t size;
+  int32_t words;
+
+  std :: unique_ptr < uint64_t[] > data;
+
+  fixed_lattice (const int64_t & size, const int32_t & words) : size(size), words(words),
+                                                                 data(new uint64_t[size * words])
+  {
+    std :: fill_n(this->data.get(), size * words, uint64_t(0));
+  }
+
+  uint64_t * plane (const int32_t & w) { return this->data.get() + w * this->size; }
+  const uint64_t * plane (const int32_t & w) const { return this->data.get() + w * this->size; }
+
+  /**
+  * @brief Set the lattice from floating point values in [0, 1]
+  *
+  * @details The double value fills the most significant word.
+  * Since the binary expansion of a double ends after 53 bits,
+  * the (unresolved) digits of the following words can be filled
+  * by a pseudo-random bit stream (seed != 0), otherwise they
+  * are set to zero and the orbit falls into 0 after 64 iterations.
+  *
+  * @note The value 1 is stored as the expansion 0.111...1
+  * (all the bits set), i.e. the fixed point of the map.
+  *
+  */
+  void from_double (const double * G, uint64_t seed = 0);
+
+  /**
+  * @brief Get the lattice as floating point values
+  *
+  * @details Only the most significant 53 bits are
+  * representable in double precision.
+  *
+  */
+  void to_double (double * G) const;
+};
+
+/**
+* @brief Exact Bernoulli shift map on a fixed point lattice
+*
+* @details Since x -> 2x mod 1 is a left shift of the binary
+* expansion (dropping the integer part), k iterations of the map
+* are a single left shift of k bits, applied in-place in one
+* pass over the lattice. The orbit is exact up to
+* 64 * words iterations.
+*
+* @param G Fixed point lattice.
+* @param iteration Number of iterations to perform.
+*
+*/
+void bernoulli (fixed_lattice & G, const int64_t & iteration);
+
+#endif // __bernoulli_h__
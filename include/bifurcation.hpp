@@ -0,0 +1,131 @@
+#ifndef __bifurcation_hpp__
+#define __bifurcation_hpp__
+
+#include <iterated_maps.hpp>
+
+#include <vector>
+
+/**
+* @brief Bifurcation diagram and Lyapunov exponent sweep
+*
+* @details Every parameter value is an independent trajectory
+* of the map (SIMD lanes over the parameters, blocks of parameters
+* across threads): each one discards its own transient and then
+* samples the attractor, accumulating the visited states in its
+* row of the (parameter x state) density histogram and the
+* log-derivative of the map for the Lyapunov exponent
+*
+*   lambda = 1/samples sum_t log|f'(x_t)|
+*
+* The log is evaluated every `log_stride` steps on the product of
+* the derivatives to keep the transcendental calls out of the
+* inner loop and the bins of `chunk` consecutive steps are
+* buffered, so the histogram is updated one row at a time.
+*
+* @param family Function (parameter) -> map functor (1D map with derivative).
+* @param params Array of parameter values.
+* @param Nparams Number of parameter values.
+* @param x0 Initial condition (the same for every parameter).
+* @param transient Number of transient iterations for each parameter.
+* @param samples Number of sampled iterations for each parameter.
+* @param xmin Lower bound of the state histogram.
+* @param xmax Upper bound of the state histogram.
+* @param bins Number of bins of the state histogram.
+* @param histogram Output density histogram of (Nparams x bins) counts (it could be nullptr).
+* @param lyapunov Output Lyapunov exponents of Nparams values (it could be nullptr).
+*
+* @tparam Family Map factory type.
+* @tparam type Data-type of the state.
+*
+*/
+template < class Family, class type >
+void bifurcation_sweep (const Family & family,
+                        const type * params, const int64_t & Nparams,
+                        const type & x0,
+                        const int64_t & transient, const int64_t & samples,
+                        const type & xmin, const type & xmax, const int64_t & bins,
+                        uint32_t * histogram, type * lyapunov)
+{
+  const int64_t log_stride = 8;
+  const int64_t chunk = 64;
+  const type scale = static_cast < type >(bins) / (xmax - xmin);
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic)
+#endif
+  for (int64_t b = 0; b < Nparams; b += maps :: block)
+  {
+    const int64_t n = std :: min(maps :: block, Nparams - b);
+    const type * p = params + b;
+
+    std :: vector < type > x(n, x0);
+    std :: vector < type > prod(n, type(1.));
+    std :: vector < type > lyap(n, type(0.));
+    std :: vector < int32_t > bin(chunk * n);
+
+    type * __restrict xb = x.data();
+    type * __restrict pb = prod.data();
+    type * __restrict lb = lyap.data();
+
+    // Transient
+    for (int64_t t = 0; t < transient; ++t)
+      for (int64_t i = 0; i < n; ++i)
+      {
+        std :: array < type, 1 > s{ {xb[i]} };
+        family(p[i])(s);
+        xb[i] = s[0];
+      }
+
+    // Sampled attractor
+    for (int64_t t0 = 0; t0 < samples; t0 += chunk)
+    {
+      const int64_t steps = std :: min(chunk, samples - t0);
+
+      for (int64_t t = 0; t < steps; ++t)
+      {
+        int32_t * __restrict ib = bin.data() + t * n;
+
+        for (int64_t i = 0; i < n; ++i)
+        {
+          const auto f = family(p[i]);
+          std :: array < type, 1 > s{ {xb[i]} };
+
+          pb[i] *= std :: abs(f.derivative(s));
+          f(s);
+          xb[i] = s[0];
+
+          // clamped in [-1, bins] (NaN included) so out of range states are skipped
+          const type pos = std :: min(static_cast < type >(bins), std :: max(type(-1.), (s[0] - xmin) * scale));
+          ib[i] = static_cast < int32_t >(pos + type(1.)) - 1;
+        }
+
+        if ( (t0 + t + 1) % log_stride == 0 || t0 + t + 1 == samples )
+          for (int64_t i = 0; i < n; ++i)
+          {
+            lb[i] += std :: log(pb[i]);
+            pb[i] = type(1.);
+          }
+      }
+
+      // histogram update row by row (each row stays in cache)
+      if (histogram)
+        for (int64_t i = 0; i < n; ++i)
+        {
+          uint32_t * row = histogram + (b + i) * bins;
+
+          for (int64_t t = 0; t < steps; ++t)
+          {
+            const int32_t k = bin[t * n + i];
+            if (k >= 0 && k < bins)
+              ++row[k];
+          }
+        }
+    }
+
+    if (lyapunov)
+      for (int64_t i = 0; i < n; ++i)
+        lyapunov[b + i] = samples ? lb[i] / samples : type(0.);
+  }
+}
+
+#endif // __bifurcation_hpp__
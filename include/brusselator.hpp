@@ -0,0 +1,288 @@
+#ifndef __brusselator_hpp__
+#define __brusselator_hpp__
+
+#include <memory>
+#include <algorithm>
+#include <random>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#include <profiler.hpp>
+
+/**
+* @brief Brusselator kernels on raw buffers
+*
+* @details The kernels work in-place on contiguous buffers
+* owned by the caller (no allocation of the results), so they
+* can be used directly on NumPy arrays by the Python bindings
+* (see cpy/Brusselator.pyx) without copies and without the GIL.
+*
+*/
+
+
+/**
+* @brief Brusselator kinetic integrated with the RK4 method
+*
+* @details dx/dt = A + x^2 y - B x - x
+*          dy/dt = B x - x^2 y
+*
+* @param x Array of (iterations + 1) values with the initial condition in x[0].
+* @param y Array of (iterations + 1) values with the initial condition in y[0].
+* @param iterations Number of integration steps.
+* @param A Constant of the reaction.
+* @param B Constant of the reaction.
+* @param dt Integration step.
+*
+* @tparam type Data-type of arrays
+*
+*/
+template < class type >
+void brusselator_rk4 (type * x, type * y, const int64_t & iterations,
+                      const type & A, const type & B, const type & dt)
+{
+  PROFILE_SCOPE("brusselator_rk4");
+  PROFILE_COUNT("brusselator_rk4", iterations);
+  PROFILE_COUNT("brusselator_rk4.rhs", 8 * iterations);
+
+  auto dx = [&](const type & x, const type & y)
+            {
+              return A + x*x*y - B*x - x;
+            };
+  auto dy = [&](const type & x, const type & y)
+            {
+              return B*x - x*x*y;
+            };
+
+  const type half = type(.5) * dt;
+
+  for (int64_t i = 0; i < iterations; ++i)
+  {
+    const type xi = x[i];
+    const type yi = y[i];
+
+    const type kx1 = dx(xi, yi);
+    const type ky1 = dy(xi, yi);
+
+    const type kx2 = dx(xi + half * kx1, yi + half * ky1);
+    const type ky2 = dy(xi + half * kx1, yi + half * ky1);
+
+    const type kx3 = dx(xi + half * kx2, yi + half * ky2);
+    const type ky3 = dy(xi + half * kx2, yi + half * ky2);
+
+    const type kx4 = dx(xi + dt * kx3, yi + dt * ky3);
+    const type ky4 = dy(xi + dt * kx3, yi + dt * ky3);
+
+    x[i + 1] = xi + dt * type(1. / 6.) * (kx1 + type(2.) * kx2 + type(2.) * kx3 + kx4);
+    y[i + 1] = yi + dt * type(1. / 6.) * (ky1 + type(2.) * ky2 + type(2.) * ky3 + ky4);
+  }
+}
+
+
+/**
+* @brief Stochastic Brusselator (Gillespie algorithm) sampled on a time grid
+*
+* @details The reactions are simulated with the SSA as in
+* BrusselatorCME (chemical_master_equation.h), but only the
+* state at the requested time points is stored, so the output
+* has a fixed size.
+*
+* @param t Array of Nt increasing time points (t[0] is the initial time).
+* @param Nt Number of time points.
+* @param x Output array of Nt values of the x population.
+* @param y Output array of Nt values of the y population.
+* @param x0 Initial condition of x.
+* @param y0 Initial condition of y.
+* @param A Constant of the reaction.
+* @param B Constant of the reaction.
+* @param omega Volume of the system.
+* @param seed Random seed.
+*
+* @return The number of simulated events.
+*
+*/
+template < class type >
+int64_t brusselator_ssa (const type * t, const int64_t & Nt,
+                         type * x, type * y,
+                         const type & x0, const type & y0,
+                         const type & A, const type & B, const type & omega,
+                         const std :: size_t & seed)
+{
+  PROFILE_SCOPE("brusselator_ssa");
+
+  std :: mt19937 mt(seed);
+  std :: uniform_real_distribution < type > uniform(type(0.), type(1.));
+
+  type ti = t[0];
+  type xi = x0;
+  type yi = y0;
+
+  int64_t events = 0;
+  int64_t k = 0;
+
+  while ( k < Nt )
+  {
+    const std :: array < type, 4 > c{ {A * omega,
+                                      A * omega + B * xi,
+                                      A * omega + B * xi + xi,
+                                      A * omega + B * xi + xi + xi * (xi - type(1.)) * yi / (omega * omega)
+                                      }
+                                    };
+
+    const type tau = -std :: log(uniform(mt)) / c[3];
+
+    // store the current state for all the grid points before the next event
+    for (; k < Nt && t[k] < ti + tau; ++k)
+    {
+      x[k] = xi;
+      y[k] = yi;
+    }
+
+    ti += tau;
+
+    const type uct = uniform(mt) * c[3];
+
+    if     (uct < c[0]) ++xi;
+    else if(uct < c[1]) {--xi; ++yi;}
+    else if(uct < c[2]) --xi;
+    else if(uct < c[3]) {++xi; --yi;}
+
+    ++events;
+  }
+
+  PROFILE_COUNT("brusselator_ssa", events);
+
+  return events;
+}
+
+
+/**
+* @brief Brusselator reaction-diffusion model
+*
+* @details Explicit Euler integration of
+*
+*   dU/dt = Du lap(U) + A - (B + 1) U + U^2 V
+*   dV/dt = Dv lap(V) + B U - U^2 V
+*
+* with the 5-point Laplacian and reflect-101 boundaries (the same
+* of cv::Laplacian with cv::BORDER_REFLECT_101). Stencil and
+* reaction terms are fused in a single pass for each row.
+*
+* The precision of the fields (storage) and of the arithmetic
+* (compute) are independent template parameters, deduced from
+* the arguments: with float fields and double constants the
+* Laplacian is evaluated in float on the loaded values, while the
+* reaction terms and the accumulation of the increment are in
+* double and the result is rounded once per step on store (only
+* the center values and the two Laplacians are converted). On one
+* core (AVX2) the float fields are 1.7-2x faster on 1024x1024 and
+* about 1.4x on 2048x2048 (see turing_precision), with a relative
+* error ~3e-5 after 200 steps.
+*
+* @note A 16-bit storage (e.g. bfloat16) is not viable: the
+* increment of a step (dt * rate) is below its resolution
+* around the steady state and the dynamics would freeze.
+*
+* @param U Field of the 1st morphogen (rows x cols), updated in-place.
+* @param V Field of the 2nd morphogen (rows x cols), updated in-place.
+* @param rows Number of rows.
+* @param cols Number of columns.
+* @param dt Interval of time.
+* @param A Kinetic reaction constant.
+* @param B Kinetic reaction constant.
+* @param Du Diffusion coef of the 1st morphogen.
+* @param Dv Diffusion coef of the 2nd morphogen.
+* @param iterations Number of iterations to perform.
+*
+* @tparam storage Data-type of the fields.
+* @tparam compute Data-type of the arithmetic.
+*
+*/
+template < class storage, class compute >
+void brusselator_diffusion (storage * U, storage * V,
+                            const int64_t & rows, const int64_t & cols,
+                            const compute & dt,
+                            const compute & A, const compute & B,
+                            const compute & Du, const compute & Dv,
+                            const int64_t & iterations)
+{
+  PROFILE_SCOPE("brusselator_diffusion");
+  PROFILE_COUNT("brusselator_diffusion", rows * cols * iterations);
+
+  std :: unique_ptr < storage[] > bufU(new storage[rows * cols]);
+  std :: unique_ptr < storage[] > bufV(new storage[rows * cols]);
+
+  storage * u = U;
+  storage * v = V;
+  storage * nu = bufU.get();
+  storage * nv = bufV.get();
+
+  auto reflect = [](const int64_t & i, const int64_t & n)
+                 {
+                   return i < 0 ? (n > 1 ? 1 : 0) : (i >= n ? (n > 1 ? n - 2 : 0) : i);
+                 };
+
+  // update of the columns [c0, c1) of a row from its neighbour rows
+  // (up, center, down): the rows are parameters, so the vectorizer
+  // does not have to track the buffers swapped at each iteration
+  auto row = [=](const storage * __restrict uu, const storage * __restrict uc, const storage * __restrict ud,
+                 const storage * __restrict vu, const storage * __restrict vc, const storage * __restrict vd,
+                 storage * __restrict ou, storage * __restrict ov,
+                 const int64_t & c0, const int64_t & c1)
+             {
+               for (int64_t c = c0; c < c1; ++c)
+               {
+                 // the boundary columns are reflected (the interior has no branches)
+                 const int64_t cl = c > 0 ? c - 1 : reflect(-1, cols);
+                 const int64_t cr = c < cols - 1 ? c + 1 : reflect(cols, cols);
+
+                 // the stencil in the storage type (no conversion of the neighbours)
+                 const storage lap_u = uu[c] + ud[c] + uc[cl] + uc[cr] - storage(4.) * uc[c];
+                 const storage lap_v = vu[c] + vd[c] + vc[cl] + vc[cr] - storage(4.) * vc[c];
+
+                 const compute u0 = static_cast < compute >(uc[c]);
+                 const compute v0 = static_cast < compute >(vc[c]);
+
+                 const compute uuv = u0 * u0 * v0;
+
+                 ou[c] = static_cast < storage >(u0 + dt * (Du * static_cast < compute >(lap_u) + A - (B + compute(1.)) * u0 + uuv));
+                 ov[c] = static_cast < storage >(v0 + dt * (Dv * static_cast < compute >(lap_v) + B * u0 - uuv));
+               }
+             };
+
+  for (int64_t t = 0; t < iterations; ++t)
+  {
+#ifdef _OPENMP
+    #pragma omp parallel for
+#endif
+    for (int64_t r = 0; r < rows; ++r)
+    {
+      const int64_t up = reflect(r - 1, rows) * cols;
+      const int64_t down = reflect(r + 1, rows) * cols;
+      const int64_t center = r * cols;
+
+      const storage * uu = u + up;
+      const storage * uc = u + center;
+      const storage * ud = u + down;
+      const storage * vu = v + up;
+      const storage * vc = v + center;
+      const storage * vd = v + down;
+
+      row(uu, uc, ud, vu, vc, vd, nu + center, nv + center, 0, 1);
+      row(uu, uc, ud, vu, vc, vd, nu + center, nv + center, 1, cols - 1);
+      row(uu, uc, ud, vu, vc, vd, nu + center, nv + center, std :: max(cols - 1, int64_t(1)), cols);
+    }
+
+    std :: swap(u, nu);
+    std :: swap(v, nv);
+  }
+
+  // the result must be stored in the caller buffers
+  if (u != U)
+  {
+    std :: copy_n(u, rows * cols, U);
+    std :: copy_n(v, rows * cols, V);
+  }
+}
+
+#endif // __brusselator_hpp__
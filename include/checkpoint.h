@@ -0,0 +1,329 @@
+#ifndef __checkpoint_h__
+#define __checkpoint_h__
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+static constexpr uint32_t CHECKPOINT_VERSION = 2;      ///< Version of the checkpoint file format
+static constexpr std :: size_t CHECKPOINT_ALIGN = 64; ///< Alignment of the sections in the file
+
+/**
+* @brief Header of a checkpoint file
+*
+* @details The file is the header, followed by the table of the
+* Nsections sections and by the payload. The sections start at
+* offsets multiple of CHECKPOINT_ALIGN (from the beginning of the
+* file), so a memory-mapped file can be used in-place. The
+* checksum (FNV-1a) covers the table and the payload. The
+* append-only stream (e.g. a trajectory) is kept in the file
+* filename + ".stream" and the header records its size at the
+* snapshot (the bytes beyond it are discarded on restart).
+*
+*/
+struct checkpoint_header
+{
+  char magic[8];      ///< "SYSDYNCK"
+  uint32_t version;   ///< CHECKPOINT_VERSION
+  uint32_t Nsections;
+  int64_t iteration;
+  double time;
+  uint64_t size;      ///< Size of the file
+  uint64_t checksum;
+  uint64_t stream;    ///< Size of the stream file at the snapshot
+  uint8_t reserved[8];
+};
+
+/**
+* @brief Named section of a checkpoint file
+*
+*/
+struct checkpoint_section
+{
+  char name[48];
+  uint64_t offset; ///< Offset from the beginning of the file
+  uint64_t size;   ///< Size in bytes
+};
+
+static_assert(sizeof(checkpoint_header) == CHECKPOINT_ALIGN, "checkpoint header must fill an aligned block");
+static_assert(sizeof(checkpoint_section) == CHECKPOINT_ALIGN, "checkpoint section must fill an aligned block");
+
+
+/**
+* @brief Asynchronous checkpoint writer
+*
+* @details A snapshot is staged by copying the state (add) in one
+* of two buffers and it is written by a background thread (commit)
+* while the computation continues on the other buffer: the caller
+* waits only if the previous snapshot is still being written when
+* the next one is committed. Each snapshot is written to a
+* temporary file, flushed to disk and renamed over the checkpoint,
+* so the file on disk is always a complete snapshot.
+*
+* The data which only grows (e.g. the trajectory of a simulation)
+* should not be copied in every snapshot: the part produced since
+* the previous snapshot is staged with append and the writer
+* thread appends it to the stream file (flushed to disk before
+* the rename of the snapshot which refers to it).
+*
+*/
+class checkpoint_writer
+{
+  struct snapshot
+  {
+    std :: vector < checkpoint_section > sections;
+    std :: vector < char > payload;
+    std :: vector < char > tail;   ///< Bytes appended to the stream
+    int64_t iteration;
+    double time;
+    uint64_t stream;               ///< Size of the stream with the tail
+  };
+
+  std :: string filename;
+  uint64_t stream_size;   ///< Size of the stream staged so far
+  uint64_t stream_start;  ///< Valid size of the stream file before the first append
+  bool stream_ready;      ///< The stream file was truncated to stream_start
+
+  snapshot buffers[2];
+  int32_t staging;  ///< Buffer filled by add
+  bool pending;     ///< The other buffer is waiting to be (or being) written
+  bool stop;
+  bool status;      ///< Result of the last write
+
+  std :: mutex mutex;
+  std :: condition_variable cv;
+  std :: thread worker;
+
+  void run ();
+
+public:
+
+  /**
+  * @brief Start the writer thread
+  *
+  * @param filename Path of the checkpoint file.
+  * @param stream Size of the stream to keep (e.g. checkpoint_reader :: stream of a
+  * restart, 0 for a new stream): the stream file is truncated at the first append.
+  *
+  */
+  checkpoint_writer (const std :: string & filename, const uint64_t & stream = 0);
+
+  /**
+  * @brief Complete the pending write and join the thread
+  *
+  */
+  ~checkpoint_writer ();
+
+  checkpoint_writer (const checkpoint_writer &) = delete;
+  checkpoint_writer & operator = (const checkpoint_writer &) = delete;
+
+  /**
+  * @brief Start a new snapshot
+  *
+  * @param iteration Iteration of the simulation.
+  * @param time Time of the simulation.
+  *
+  */
+  void begin (const int64_t & iteration, const double & time);
+
+  /**
+  * @brief Copy a block of the state in the snapshot
+  *
+  * @param name Name of the section (up to 47 characters).
+  * @param data Pointer to the data.
+  * @param bytes Size of the data.
+  *
+  */
+  void add (const std :: string & name, const void * data, const std :: size_t & bytes);
+
+  /**
+  * @brief Copy an array in the snapshot
+  *
+  */
+  template < class type >
+  void add (const std :: string & name, const std :: vector < type > & v)
+  {
+    this->add(name, v.data(), v.size() * sizeof(type));
+  }
+
+  /**
+  * @brief Copy the state of a random engine in the snapshot
+  *
+  * @details The engine is stored with its textual representation,
+  * which restores exactly the same sequence.
+  *
+  */
+  template < class Engine >
+  void add_engine (const std :: string & name, const Engine & engine)
+  {
+    std :: ostringstream os;
+    os << engine;
+    const std :: string state = os.str();
+    this->add(name, state.data(), state.size());
+  }
+
+  /**
+  * @brief Append a block to the stream with the snapshot
+  *
+  * @param data Pointer to the data.
+  * @param bytes Size of the data.
+  *
+  */
+  void append (const void * data, const std :: size_t & bytes);
+
+  /**
+  * @brief Hand the snapshot to the writer thread
+  *
+  * @details It waits only for the completion of the previous write.
+  *
+  */
+  void commit ();
+
+  /**
+  * @brief Wait the pending write
+  *
+  * @return The result of the last write.
+  *
+  */
+  bool wait ();
+};
+
+
+/**
+* @brief Memory-mapped checkpoint file
+*
+* @details The file is mapped read-only and validated (magic,
+* version, size and checksum): the sections can be used in-place
+* (section) or copied in the caller buffers (read).
+*
+*/
+class checkpoint_reader
+{
+  std :: string filename;
+  const char * data;
+  std :: size_t bytes;
+  std :: vector < char > fallback; ///< File content on the systems without mmap
+  bool mapped;
+  bool ok;
+
+  const checkpoint_header * header () const { return reinterpret_cast < const checkpoint_header * >(this->data); }
+
+public:
+
+  /**
+  * @brief Map and validate a checkpoint file
+  *
+  * @param filename Path of the checkpoint file.
+  *
+  */
+  checkpoint_reader (const std :: string & filename);
+
+  ~checkpoint_reader ();
+
+  checkpoint_reader (const checkpoint_reader &) = delete;
+  checkpoint_reader & operator = (const checkpoint_reader &) = delete;
+
+  /**
+  * @brief Check if the file exists and it is a valid checkpoint
+  *
+  */
+  bool valid () const { return this->ok; }
+
+  int64_t iteration () const { return this->ok ? this->header()->iteration : 0; }
+  double time () const { return this->ok ? this->header()->time : 0.; }
+  uint64_t stream () const { return this->ok ? this->header()->stream : 0; }
+
+  /**
+  * @brief Pointer to a section in the mapped file
+  *
+  * @param name Name of the section.
+  * @param size Size of the section in bytes.
+  *
+  * @return The pointer to the data (aligned to CHECKPOINT_ALIGN) or nullptr if the section is missing.
+  *
+  */
+  const void * section (const std :: string & name, std :: size_t & size) const;
+
+  /**
+  * @brief Copy a section
+  *
+  * @param name Name of the section.
+  * @param dst Output buffer.
+  * @param size Size of the output buffer (it must match the section size).
+  *
+  * @return False if the section is missing or the size does not match.
+  *
+  */
+  bool read (const std :: string & name, void * dst, const std :: size_t & size) const;
+
+  /**
+  * @brief Copy a section in an array (resized to the section size)
+  *
+  */
+  template < class type >
+  bool read (const std :: string & name, std :: vector < type > & v) const
+  {
+    std :: size_t size = 0;
+    const void * src = this->section(name, size);
+
+    if ( !src || size % sizeof(type) )
+      return false;
+
+    v.resize(size / sizeof(type));
+    return this->read(name, v.data(), size);
+  }
+
+  /**
+  * @brief Read the stream of the snapshot
+  *
+  * @param dst Output buffer (resized to the stream size of the snapshot).
+  *
+  * @return False if the stream file is shorter than the snapshot stream.
+  *
+  */
+  bool read_stream (std :: vector < char > & dst) const;
+
+  /**
+  * @brief Read the stream of the snapshot in an array
+  *
+  */
+  template < class type >
+  bool read_stream (std :: vector < type > & v) const
+  {
+    std :: vector < char > bytes;
+
+    if ( !this->read_stream(bytes) || bytes.size() % sizeof(type) )
+      return false;
+
+    v.resize(bytes.size() / sizeof(type));
+    if ( !bytes.empty() )
+      std :: memcpy(v.data(), bytes.data(), bytes.size());
+    return true;
+  }
+
+  /**
+  * @brief Restore the state of a random engine
+  *
+  */
+  template < class Engine >
+  bool read_engine (const std :: string & name, Engine & engine) const
+  {
+    std :: size_t size = 0;
+    const char * src = static_cast < const char * >(this->section(name, size));
+
+    if ( !src )
+      return false;
+
+    std :: istringstream is(std :: string(src, size));
+    is >> engine;
+    return !is.fail();
+  }
+};
+
+#endif // __checkpoint_h__
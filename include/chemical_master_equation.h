@@ -0,0 +1,70 @@
+#ifndef __chemical_master_equation_h__
+#define __chemical_master_equation_h__
+
+#include <vector>
+#include <string>
+#include <cstddef>
+#include <cstdint>
+
+/**
+* @brief Stochastic Brusselator (Gillespie algorithm)
+*
+* @details The reactions of the Brusselator model are simulated
+* with the Stochastic Simulation Algorithm, i.e. exact sampling
+* of the Chemical Master Equation. Every event is appended to
+* the output vectors (see brusselator_ssa in brusselator.hpp
+* for the version sampled on a fixed time grid).
+*
+* @param x Population of x with the initial condition in x[0].
+* @param y Population of y with the initial condition in y[0].
+* @param t Time of the events with the initial time in t[0].
+* @param A Constant of the reaction.
+* @param B Constant of the reaction.
+* @param omega Volume of the system.
+* @param max_time End time of the simulation.
+* @param seed Random seed.
+*
+*/
+void BrusselatorCME (std :: vector < double > & x, std :: vector < double > & y,
+                     std :: vector < double > & t,
+                     const double & A, const double & B,
+                     const double & omega, double max_time = 30.,
+                     std :: size_t seed = 123);
+
+/**
+* @brief Stochastic Brusselator (Gillespie algorithm) with checkpoints
+*
+* @details Same simulation of BrusselatorCME, with a snapshot of
+* the current state and of the random engine written every
+* checkpoint_every events (asynchronously, see checkpoint.h).
+* The events since the previous snapshot are appended to the
+* stream file (checkpoint + ".stream"), so the cost of a snapshot
+* does not depend on the length of the trajectory.
+* If the checkpoint file holds a valid snapshot the simulation
+* restarts from it (the initial conditions in x, y, t are
+* replaced by the trajectory read from the stream) and the result
+* is bit-exact with an uninterrupted run.
+*
+* @param x Population of x with the initial condition in x[0].
+* @param y Population of y with the initial condition in y[0].
+* @param t Time of the events with the initial time in t[0].
+* @param A Constant of the reaction.
+* @param B Constant of the reaction.
+* @param omega Volume of the system.
+* @param max_time End time of the simulation.
+* @param seed Random seed.
+* @param checkpoint Path of the checkpoint file.
+* @param checkpoint_every Number of events between two snapshots.
+*
+* @return True if the simulation was restarted from the checkpoint.
+*
+*/
+bool BrusselatorCME (std :: vector < double > & x, std :: vector < double > & y,
+                     std :: vector < double > & t,
+                     const double & A, const double & B,
+                     const double & omega, double max_time,
+                     std :: size_t seed,
+                     const std :: string & checkpoint,
+                     const int64_t & checkpoint_every = 1000000);
+
+#endif // __chemical_master_equation_h__
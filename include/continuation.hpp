@@ -0,0 +1,651 @@
+#ifndef __continuation_hpp__
+#define __continuation_hpp__
+
+#include <array>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <ode_models.hpp>
+#include <linear_algebra.hpp>
+#include <profiler.hpp>
+
+/**
+* @brief Eigenvalues of a real matrix
+*
+* @details The matrix is reduced to upper Hessenberg form by
+* stabilized elementary similarity transformations and the
+* eigenvalues are computed by the Francis double-shift QR
+* algorithm (elmhes + hqr of Numerical Recipes), which is
+* adequate for the small Jacobians of the kinetic models.
+*
+* @param A Matrix (n x n, row-major), destroyed.
+* @param n Size of the matrix.
+* @param wr Output array of n real parts.
+* @param wi Output array of n imaginary parts (complex pairs are consecutive).
+*
+* @tparam type Data-type of arrays
+*
+* @return False if the QR iterations do not converge.
+*
+*/
+template < class type >
+bool eigenvalues (type * A, const int32_t & n, type * wr, type * wi)
+{
+  // 1-based access, as in the reference implementation
+  auto a = [&](const int32_t & i, const int32_t & j) -> type & { return A[(i - 1) * n + (j - 1)]; };
+
+  // reduction to Hessenberg form
+  for (int32_t m = 2; m < n; ++m)
+  {
+    type x = type(0.);
+    int32_t i = m;
+
+    for (int32_t j = m; j <= n; ++j)
+      if (std :: abs(a(j, m - 1)) > std :: abs(x))
+      {
+        x = a(j, m - 1);
+        i = j;
+      }
+
+    if (i != m)
+    {
+      for (int32_t j = m - 1; j <= n; ++j)
+        std :: swap(a(i, j), a(m, j));
+      for (int32_t j = 1; j <= n; ++j)
+        std :: swap(a(j, i), a(j, m));
+    }
+
+    if (x != type(0.))
+      for (i = m + 1; i <= n; ++i)
+      {
+        type y = a(i, m - 1);
+        if (y == type(0.))
+          continue;
+
+        y /= x;
+        a(i, m - 1) = y;
+        for (int32_t j = m; j <= n; ++j)
+          a(i, j) -= y * a(m, j);
+        for (int32_t j = 1; j <= n; ++j)
+          a(j, m) += y * a(j, i);
+      }
+  }
+
+  for (int32_t i = 3; i <= n; ++i)
+    for (int32_t j = 1; j < i - 1; ++j)
+      a(i, j) = type(0.);
+
+  // shifted QR iterations
+  auto sign = [](const type & x, const type & y) { return y >= type(0.) ? std :: abs(x) : -std :: abs(x); };
+
+  type anorm = type(0.);
+  for (int32_t i = 1; i <= n; ++i)
+    for (int32_t j = std :: max(i - 1, 1); j <= n; ++j)
+      anorm += std :: abs(a(i, j));
+
+  int32_t nn = n;
+  type t = type(0.);
+  type p = type(0.), q = type(0.), r = type(0.), s, u, v, w, x, y, z;
+
+  while (nn >= 1)
+  {
+    int32_t its = 0;
+    int32_t l;
+
+    do
+    {
+      for (l = nn; l >= 2; --l)
+      {
+        s = std :: abs(a(l - 1, l - 1)) + std :: abs(a(l, l));
+        if (s == type(0.))
+          s = anorm;
+        if (static_cast < type >(std :: abs(a(l, l - 1)) + s) == s)
+        {
+          a(l, l - 1) = type(0.);
+          break;
+        }
+      }
+
+      x = a(nn, nn);
+
+      if (l == nn)
+      {
+        wr[nn - 1] = x + t;
+        wi[nn - 1] = type(0.);
+        --nn;
+      }
+      else
+      {
+        y = a(nn - 1, nn - 1);
+        w = a(nn, nn - 1) * a(nn - 1, nn);
+
+        if (l == nn - 1)
+        {
+          p = type(.5) * (y - x);
+          q = p * p + w;
+          z = std :: sqrt(std :: abs(q));
+          x += t;
+
+          if (q >= type(0.))
+          {
+            z = p + sign(z, p);
+            wr[nn - 2] = wr[nn - 1] = x + z;
+            if (z != type(0.))
+              wr[nn - 1] = x - w / z;
+            wi[nn - 2] = wi[nn - 1] = type(0.);
+          }
+          else
+          {
+            wr[nn - 2] = wr[nn - 1] = x + p;
+            wi[nn - 2] = -z;
+            wi[nn - 1] = z;
+          }
+
+          nn -= 2;
+        }
+        else
+        {
+          if (its == 30)
+            return false;
+
+          if (its == 10 || its == 20)
+          {
+            // exceptional shift
+            t += x;
+            for (int32_t i = 1; i <= nn; ++i)
+              a(i, i) -= x;
+            s = std :: abs(a(nn, nn - 1)) + std :: abs(a(nn - 1, nn - 2));
+            y = x = type(.75) * s;
+            w = type(-.4375) * s * s;
+          }
+
+          ++its;
+
+          int32_t m;
+          for (m = nn - 2; m >= l; --m)
+          {
+            z = a(m, m);
+            r = x - z;
+            s = y - z;
+            p = (r * s - w) / a(m + 1, m) + a(m, m + 1);
+            q = a(m + 1, m + 1) - z - r - s;
+            r = a(m + 2, m + 1);
+            s = std :: abs(p) + std :: abs(q) + std :: abs(r);
+            p /= s;
+            q /= s;
+            r /= s;
+
+            if (m == l)
+              break;
+
+            u = std :: abs(a(m, m - 1)) * (std :: abs(q) + std :: abs(r));
+            v = std :: abs(p) * (std :: abs(a(m - 1, m - 1)) + std :: abs(z) + std :: abs(a(m + 1, m + 1)));
+            if (static_cast < type >(u + v) == v)
+              break;
+          }
+
+          for (int32_t i = m + 2; i <= nn; ++i)
+          {
+            a(i, i - 2) = type(0.);
+            if (i != m + 2)
+              a(i, i - 3) = type(0.);
+          }
+
+          for (int32_t k = m; k <= nn - 1; ++k)
+          {
+            if (k != m)
+            {
+              p = a(k, k - 1);
+              q = a(k + 1, k - 1);
+              r = type(0.);
+              if (k != nn - 1)
+                r = a(k + 2, k - 1);
+              if ((x = std :: abs(p) + std :: abs(q) + std :: abs(r)) != type(0.))
+              {
+                p /= x;
+                q /= x;
+                r /= x;
+              }
+            }
+
+            if ((s = sign(std :: sqrt(p * p + q * q + r * r), p)) != type(0.))
+            {
+              if (k == m)
+              {
+                if (l != m)
+                  a(k, k - 1) = -a(k, k - 1);
+              }
+              else
+                a(k, k - 1) = -s * x;
+
+              p += s;
+              x = p / s;
+              y = q / s;
+              z = r / s;
+              q /= p;
+              r /= p;
+
+              for (int32_t j = k; j <= nn; ++j)
+              {
+                p = a(k, j) + q * a(k + 1, j);
+                if (k != nn - 1)
+                {
+                  p += r * a(k + 2, j);
+                  a(k + 2, j) -= p * z;
+                }
+                a(k + 1, j) -= p * y;
+                a(k, j) -= p * x;
+              }
+
+              const int32_t mmin = nn < k + 3 ? nn : k + 3;
+              for (int32_t i = l; i <= mmin; ++i)
+              {
+                p = x * a(i, k) + y * a(i, k + 1);
+                if (k != nn - 1)
+                {
+                  p += z * a(i, k + 2);
+                  a(i, k + 2) -= p * r;
+                }
+                a(i, k + 1) -= p * q;
+                a(i, k) -= p;
+              }
+            }
+          }
+        }
+      }
+    } while (nn >= 1 && l < nn - 1);
+  }
+
+  return true;
+}
+
+
+/**
+* @brief Kind of a point of an equilibrium branch
+*
+*/
+enum class point_type : int32_t
+{
+  regular = 0,     ///< Point of the branch
+  saddle_node = 1, ///< A real eigenvalue crosses zero (fold, or branch point)
+  hopf = 2         ///< A complex pair crosses the imaginary axis
+};
+
+
+/**
+* @brief Point of an equilibrium branch
+*
+* @tparam model Model class (see ode_models.hpp).
+*
+*/
+template < class model >
+struct equilibrium
+{
+  using type = typename model :: value_type;
+
+  std :: array < type, model :: Nvar > y; ///< Steady state
+  type parameter;                         ///< Value of the continuation parameter
+  int32_t unstable;                       ///< Number of eigenvalues with positive real part
+  point_type kind;
+  type frequency;                         ///< Imaginary part of the critical pair (Hopf points)
+};
+
+
+/**
+* @brief Pseudo-arclength continuation of the equilibria of a model
+*
+* @details The branch of steady states f(y, p) = 0 is followed as a
+* curve u = (y, p[index]) parametrized by its arclength: each step
+* predicts along the unit tangent t and corrects by Newton on the
+* augmented system (f(u), t . (u - u_pred)) = 0, so the folds are
+* passed without changing parameter.
+* The augmented Jacobian [Jy Jp; t^T] is factorized once per
+* step, at the last converged point: the same LU gives the tangent
+* of the next step and it is reused by the corrector iterations
+* (chord method). The Jacobian is refactorized at the predicted
+* point only if the chord iterations fail, and the step is halved if
+* also the Newton iterations fail (the step grows again when the
+* corrector converges quickly).
+* The stability of each point is given by the eigenvalues of Jy: a
+* change in the number of real (complex) unstable eigenvalues
+* between two points marks a saddle-node (Hopf) point, which is
+* located by bisection on the arclength of the test function
+* det(Jy) (the real part of the critical complex pair).
+*
+* @param y0 Initial guess of a steady state at the parameters p.
+* @param p Parameters of the model (Npar values); p[index] is the starting value.
+* @param index Index of the continuation parameter.
+* @param pmin Lower bound of the continuation parameter.
+* @param pmax Upper bound of the continuation parameter.
+* @param ds Initial arclength step (the branch is followed towards increasing parameter).
+* @param ds_max Maximum arclength step.
+* @param max_points Maximum number of points of the branch.
+* @param tol Tolerance of the Newton corrections.
+*
+* @tparam model Model class (see ode_models.hpp).
+*
+* @return The points of the branch (in arclength order), including the located bifurcation points.
+*
+*/
+template < class model >
+std :: vector < equilibrium < model > > continuation (const typename model :: value_type * y0,
+                                                      const typename model :: value_type * p,
+                                                      const int32_t & index,
+                                                      const typename model :: value_type & pmin,
+                                                      const typename model :: value_type & pmax,
+                                                      typename model :: value_type ds = 1e-2,
+                                                      const typename model :: value_type & ds_max = 1e-1,
+                                                      const int32_t & max_points = 10000,
+                                                      const typename model :: value_type & tol = 1e-10)
+{
+  using type = typename model :: value_type;
+  using vector = std :: array < type, model :: Nvar + 1 >;
+
+  constexpr int32_t Nvar = model :: Nvar;
+  constexpr int32_t Npar = model :: Npar;
+  constexpr int32_t N = Nvar + 1;
+
+  PROFILE_SCOPE("continuation");
+
+  const int32_t max_iter = 8;
+  const type ds_min = ds * type(1e-6);
+
+  std :: array < type, Npar > par;
+  std :: copy_n(p, Npar, par.begin());
+
+  std :: array < type, Nvar * Nvar > Jy;
+  std :: array < type, Nvar * Npar > Jp;
+
+  auto residual = [&](const vector & u, type * F)
+                  {
+                    par[index] = u[Nvar];
+                    model :: rhs(u.data(), par.data(), F);
+                  };
+
+  // augmented Jacobian [Jy Jp[:, index]; t^T]
+  auto augmented = [&](const vector & u, const vector & t, type * A)
+                   {
+                     par[index] = u[Nvar];
+                     model :: jacobian(u.data(), par.data(), Jy.data(), Jp.data());
+
+                     for (int32_t i = 0; i < Nvar; ++i)
+                     {
+                       for (int32_t j = 0; j < Nvar; ++j)
+                         A[i * N + j] = Jy[i * Nvar + j];
+                       A[i * N + Nvar] = Jp[i * Npar + index];
+                     }
+                     for (int32_t j = 0; j < N; ++j)
+                       A[Nvar * N + j] = t[j];
+                   };
+
+  auto norm = [](const vector & v)
+              {
+                type s = type(0.);
+                for (const auto & x : v)
+                  s += x * x;
+                return std :: sqrt(s);
+              };
+
+  // Newton (chord if LU is given, i.e. refactor = false) corrections on the augmented system
+  auto correct = [&](vector & u, const vector & u_pred, const vector & t,
+                     std :: array < type, N * N > & LU, std :: array < int32_t, N > & piv, const bool & refactor)
+                 {
+                   for (int32_t it = 0; it < max_iter; ++it)
+                   {
+                     if (refactor)
+                     {
+                       PROFILE_COUNT("continuation.factorizations", 1);
+                       augmented(u, t, LU.data());
+                       if ( !lu_factor(LU.data(), piv.data(), N) )
+                         return -1;
+                     }
+
+                     vector delta;
+                     residual(u, delta.data());
+                     type arc = type(0.);
+                     for (int32_t j = 0; j < N; ++j)
+                       arc += t[j] * (u[j] - u_pred[j]);
+                     delta[Nvar] = arc;
+
+                     lu_solve(LU.data(), piv.data(), delta.data(), N);
+
+                     type step = type(0.);
+                     type scale = type(1.);
+                     for (int32_t j = 0; j < N; ++j)
+                     {
+                       u[j] -= delta[j];
+                       step = std :: max(step, std :: abs(delta[j]));
+                       scale = std :: max(scale, std :: abs(u[j]));
+                     }
+
+                     if ( !std :: isfinite(step) )
+                       return -1;
+
+                     if (step < tol * scale)
+                       return it + 1;
+                   }
+
+                   return -1;
+                 };
+
+  // eigenvalues of Jy: number of real and complex unstable ones and test functions
+  struct spectrum
+  {
+    int32_t real_unstable;
+    int32_t complex_unstable;
+    type fold;      // det(Jy)
+    type hopf;      // real part of the complex pair closest to the imaginary axis
+    type frequency; // imaginary part of the same pair
+  };
+
+  auto analyze = [&](const vector & u)
+                 {
+                   par[index] = u[Nvar];
+                   model :: jacobian(u.data(), par.data(), Jy.data(), Jp.data());
+
+                   std :: array < type, Nvar > wr, wi;
+                   std :: array < type, Nvar * Nvar > A = Jy;
+
+                   spectrum sp = {0, 0, type(1.), std :: numeric_limits < type > :: infinity(), type(0.)};
+
+                   if ( !eigenvalues(A.data(), Nvar, wr.data(), wi.data()) )
+                     return sp;
+
+                   for (int32_t i = 0; i < Nvar; ++i)
+                   {
+                     if (wi[i] == type(0.))
+                     {
+                       sp.real_unstable += wr[i] > type(0.) ? 1 : 0;
+                       sp.fold *= wr[i];
+                     }
+                     else
+                     {
+                       sp.complex_unstable += wr[i] > type(0.) ? 1 : 0;
+                       sp.fold *= wi[i] > type(0.) ? wr[i] * wr[i] + wi[i] * wi[i] : type(1.);
+
+                       if (std :: abs(wr[i]) < std :: abs(sp.hopf))
+                       {
+                         sp.hopf = wr[i];
+                         sp.frequency = std :: abs(wi[i]);
+                       }
+                     }
+                   }
+
+                   return sp;
+                 };
+
+  std :: vector < equilibrium < model > > branch;
+
+  auto push = [&](const vector & u, const spectrum & sp, const point_type & kind)
+              {
+                equilibrium < model > e;
+                std :: copy_n(u.begin(), Nvar, e.y.begin());
+                e.parameter = u[Nvar];
+                e.unstable = sp.real_unstable + sp.complex_unstable;
+                e.kind = kind;
+                e.frequency = kind == point_type :: hopf ? sp.frequency : type(0.);
+                branch.push_back(e);
+              };
+
+  // initial steady state (Newton at fixed parameter)
+  vector u;
+  std :: copy_n(y0, Nvar, u.begin());
+  u[Nvar] = p[index];
+
+  std :: array < type, N * N > LU;
+  std :: array < int32_t, N > piv;
+
+  {
+    vector e;
+    e.fill(type(0.));
+    e[Nvar] = type(1.);
+
+    // the last row (0, ..., 0, 1) fixes the parameter
+    const vector u_fixed = u;
+    if (correct(u, u_fixed, e, LU, piv, true) < 0)
+      return branch;
+  }
+
+  // initial tangent towards increasing parameter
+  vector t;
+  t.fill(type(0.));
+  t[Nvar] = type(1.);
+
+  augmented(u, t, LU.data());
+  if ( !lu_factor(LU.data(), piv.data(), N) )
+    return branch;
+
+  {
+    vector e;
+    e.fill(type(0.));
+    e[Nvar] = type(1.);
+    lu_solve(LU.data(), piv.data(), e.data(), N);
+    const type n = norm(e);
+    for (int32_t j = 0; j < N; ++j)
+      t[j] = e[j] / n;
+  }
+
+  spectrum sp = analyze(u);
+  push(u, sp, point_type :: regular);
+
+  // locate the zero of a test function between u (s = 0) and s = ds along the tangent t
+  auto locate = [&](const vector & u0, const vector & t0, type lo, type hi, const type & f_lo,
+                    const bool & hopf, vector & found)
+                {
+                  std :: array < type, N * N > LUs;
+                  std :: array < int32_t, N > pivs;
+                  type flo = f_lo;
+
+                  // at least one bisection, so found is a corrected point even when
+                  // the step is already shorter than the tolerance (ds close to ds_min)
+                  for (int32_t it = 0; it < 60 && (it == 0 || hi - lo > tol * std :: max(type(1.), hi)); ++it)
+                  {
+                    const type s = type(.5) * (lo + hi);
+
+                    vector pred, v;
+                    for (int32_t j = 0; j < N; ++j)
+                      pred[j] = v[j] = u0[j] + s * t0[j];
+
+                    if (correct(v, pred, t0, LUs, pivs, true) < 0)
+                      return false;
+
+                    const spectrum sv = analyze(v);
+                    const type f = hopf ? sv.hopf : sv.fold;
+
+                    if ( !std :: isfinite(f) )
+                      return false;
+
+                    found = v;
+
+                    if ((f > type(0.)) == (flo > type(0.)))
+                    {
+                      lo = s;
+                      flo = f;
+                    }
+                    else
+                      hi = s;
+                  }
+
+                  return true;
+                };
+
+  while (static_cast < int32_t >(branch.size()) < max_points)
+  {
+    vector pred, v;
+    for (int32_t j = 0; j < N; ++j)
+      pred[j] = v[j] = u[j] + ds * t[j];
+
+    // chord iterations with the factorization of the last point, then Newton
+    int32_t its = correct(v, pred, t, LU, piv, false);
+
+    if (its < 0)
+    {
+      v = pred;
+      std :: array < type, N * N > LUn;
+      std :: array < int32_t, N > pivn;
+      its = correct(v, pred, t, LUn, pivn, true);
+    }
+
+    if (its < 0)
+    {
+      ds *= type(.5);
+      if (ds < ds_min)
+        break;
+      continue;
+    }
+
+    // one factorization per step: tangent at the new point (and next chord matrix)
+    PROFILE_COUNT("continuation.factorizations", 1);
+    PROFILE_COUNT("continuation", 1);
+    std :: array < type, N * N > LUv;
+    std :: array < int32_t, N > pivv;
+    augmented(v, t, LUv.data());
+    if ( !lu_factor(LUv.data(), pivv.data(), N) )
+      break;
+
+    vector tv;
+    tv.fill(type(0.));
+    tv[Nvar] = type(1.);
+    lu_solve(LUv.data(), pivv.data(), tv.data(), N);
+    const type n = norm(tv);
+    for (int32_t j = 0; j < N; ++j)
+      tv[j] /= n;
+
+    const spectrum sv = analyze(v);
+
+    // bifurcations between u and v
+    if (sv.real_unstable != sp.real_unstable && sp.fold * sv.fold <= type(0.))
+    {
+      vector b;
+      if (locate(u, t, type(0.), ds, sp.fold, false, b))
+        push(b, analyze(b), point_type :: saddle_node);
+    }
+
+    if (sv.complex_unstable != sp.complex_unstable && sp.hopf * sv.hopf < type(0.))
+    {
+      vector b;
+      if (locate(u, t, type(0.), ds, sp.hopf, true, b))
+        push(b, analyze(b), point_type :: hopf);
+    }
+
+    push(v, sv, point_type :: regular);
+
+    u = v;
+    t = tv;
+    LU = LUv;
+    piv = pivv;
+    sp = sv;
+
+    if (u[Nvar] < pmin || u[Nvar] > pmax)
+      break;
+
+    ds = its <= 3 ? std :: min(ds * type(1.5), ds_max) : its > 5 ? ds * type(.5) : ds;
+  }
+
+  return branch;
+}
+
+#endif // __continuation_hpp__
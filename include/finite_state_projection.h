@@ -0,0 +1,110 @@
+#ifndef __finite_state_projection_h__
+#define __finite_state_projection_h__
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+#include <spatial_ssa.h> // ssa_reaction
+
+/**
+* @brief Finite State Projection solver of the Chemical Master Equation
+*
+* @details The CME dp/dt = A p of a well-mixed network (mass-action
+* reactions with the propensities of ssa_reaction in a volume omega)
+* is projected on the box of the populations 0 <= n_s <= bound_s.
+* The generator A is assembled in CSR format (one row per state,
+* with the incoming rates and the total outflow on the diagonal)
+* and the probability which leaves the box is collected in one
+* absorbing sink per species, so the sum of the sinks is a bound of
+* the truncation error (Munsky-Khammash).
+*
+* The distribution is propagated with the Krylov approximation of
+* exp(t A) p (Arnoldi with adaptive sub-steps and error control, as
+* expv of Expokit), where the exponential of the small Hessenberg
+* matrix is computed by expm (matrix_exponential.hpp). The sparse
+* products and the vector operations are parallel across threads.
+* If the error of a solve exceeds the tolerance the bounds of the
+* leaking species are expanded and the step is repeated from its
+* initial distribution.
+*
+*/
+class finite_state_projection
+{
+  int32_t Nspecies, Nreactions;
+
+  std :: vector < double > rates;                                                ///< Rates scaled by the volume
+  std :: vector < std :: vector < std :: pair < int32_t, int32_t > > > reactants; ///< (species, multiplicity) of each reaction
+  std :: vector < std :: vector < int32_t > > change;                            ///< Net change of all the species of each reaction
+
+  std :: vector < int32_t > bound;   ///< Maximum population of each species
+  std :: vector < int64_t > strides; ///< Strides of the box (species 0 is the fastest)
+  int64_t Nstates;                   ///< Number of states of the box
+
+  std :: vector < int64_t > offsets; ///< CSR row pointers (Nstates + Nspecies rows)
+  std :: vector < int32_t > columns; ///< CSR column indices
+  std :: vector < double > values;   ///< CSR values
+
+  std :: vector < double > p;        ///< Probabilities of the box followed by the sinks
+  double t;
+  int32_t krylov;                    ///< Dimension of the Krylov subspace
+
+  double propensity (const int32_t & r, const int32_t * n) const;
+  void assemble ();
+  void resize (const std :: vector < int32_t > & bounds);
+  void multiply (const double * x, double * y) const;
+  bool expv (const double & dt, const double & tolerance, const double & max_error);
+
+public:
+
+  /**
+  * @brief Distribution concentrated in an initial state
+  *
+  * @param Nspecies Number of species.
+  * @param reactions Reactions of the network.
+  * @param omega Volume of the system.
+  * @param initial Initial populations (Nspecies values).
+  * @param bounds Initial bounds of the projection (empty for twice the initial state plus 10).
+  * @param krylov Dimension of the Krylov subspace.
+  *
+  */
+  finite_state_projection (const int32_t & Nspecies, const std :: vector < ssa_reaction > & reactions,
+                           const double & omega, const std :: vector < int32_t > & initial,
+                           const std :: vector < int32_t > & bounds = {}, const int32_t & krylov = 30);
+
+  /**
+  * @brief Propagate the distribution up to a final time
+  *
+  * @param max_time End time of the solve.
+  * @param tolerance Maximum probability outside the projection (total, from the initial time).
+  * @param max_states Maximum number of states of the projection.
+  *
+  * @return False if the tolerance requires more than max_states states or if the Krylov step fails (the distribution is not updated).
+  *
+  */
+  bool solve (const double & max_time, const double & tolerance = 1e-6, const int64_t & max_states = 10000000);
+
+  double time () const { return this->t; }
+  int64_t states () const { return this->Nstates; }
+  const std :: vector < int32_t > & bounds () const { return this->bound; }
+
+  /**
+  * @brief Probability outside the projection (error bound of the distribution)
+  *
+  */
+  double error () const;
+
+  /**
+  * @brief Probability of a state (zero outside the projection)
+  *
+  */
+  double probability (const std :: vector < int32_t > & state) const;
+
+  /**
+  * @brief Marginal distribution of a species (bound + 1 values)
+  *
+  */
+  std :: vector < double > marginal (const int32_t & species) const;
+};
+
+#endif // __finite_state_projection_h__
@@ -0,0 +1,30 @@
+#ifndef __gauss_seidel_h__
+#define __gauss_seidel_h__
+
+#include <memory>
+#include <cstdint>
+
+/**
+* @brief Gauss-Seidel iterative solver
+*
+* @details Solve the linear system A x = b starting from
+* x = 0. The iterations stop when no component of the solution
+* changes more than the tolerance (or after max_iter iterations).
+* The convergence is guaranteed for diagonally dominant or
+* symmetric positive definite matrices.
+*
+* @param A Coefficient matrix (N x N) in row-major order.
+* @param b Right hand side (N values).
+* @param N Number of unknowns.
+* @param tolerance Convergence threshold on the solution update.
+* @param max_iter Maximum number of iterations.
+*
+* @return The solution array.
+*
+*/
+std :: unique_ptr < float[] > GaussSeidel (const float * A, const float * b,
+                                           const int32_t & N,
+                                           const float & tolerance = 1e-8f,
+                                           const int32_t & max_iter = 10000);
+
+#endif // __gauss_seidel_h__
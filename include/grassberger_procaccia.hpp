@@ -0,0 +1,314 @@
+#ifndef __grassberger_procaccia_hpp__
+#define __grassberger_procaccia_hpp__
+
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <memory>
+#include <array>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+
+#include <profiler.hpp>
+
+#ifndef LOG2
+#define LOG2 0.69314718055994529
+#endif
+
+/**
+* @brief Correlation dimension (Grassberger-Procaccia algorithm)
+*
+* @details The correlation sum C(eps) is evaluated over the
+* pairwise distances of the 2D points for a sequence of
+* eps = max_eps * 2^-n and the correlation dimension is
+* estimated as the slope of the linear fit of log2 C(eps)
+* vs log2 eps (the first and last omit_pts values are excluded).
+*
+* @param x Array of N x coordinates.
+* @param y Array of N y coordinates.
+* @param N Number of points.
+* @param omit_pts Number of points excluded at both ends of the fit.
+*
+* @tparam T Data-type of arrays
+*
+* @return The array (slope, err slope, intercept, err intercept).
+*
+*/
+template<typename T> auto GrassbergerProcaccia(T *x, T *y, const int &N, int omit_pts = 3)
+{
+  T min_eps =  std::numeric_limits<T>::infinity(),
+    max_eps = -std::numeric_limits<T>::infinity(),
+    sx = (T)0.,
+    sy = (T)0.,
+    sxy = (T)0.,
+    sx2 = (T)0.,
+    w;
+  int eps_vec_size,
+      k1 = omit_pts,
+      k2,
+      Npairs,
+      idx;
+
+  std::array<T, 4> parameters;
+  std::unique_ptr<T[]> ED(new T[N*(N-1)/2]);
+
+#ifdef _OPENMP
+#pragma omp parallel for reduction (min: min_eps) reduction(max: max_eps) private(idx)
+#endif
+  for(int i = 0; i < N; ++i)
+    for(int j = i+1; j < N; ++j)
+    {
+      idx = (N * (N - 1) / 2) - (N - i) * ((N - i) - 1) / 2 + j - i - 1;
+      ED[idx] = std::sqrt( (x[i] - x[j])*(x[i] - x[j]) + (y[i] - y[j])*(y[i] - y[j]) );
+      min_eps = (ED[idx] < min_eps && ED[idx] != 0.f) ? ED[idx] : min_eps;
+      max_eps = (ED[idx] > max_eps && ED[idx] != 0.f) ? ED[idx] : max_eps;
+    }
+  max_eps = std::pow(2., std::ceil(std::log(max_eps) / LOG2));
+  eps_vec_size = static_cast<int>(std::floor( (std::log(max_eps/min_eps) / LOG2) )) + 1;
+  std::unique_ptr<T[]> eps_vec(new T[eps_vec_size]);
+  std::generate_n(eps_vec.get(), eps_vec_size, [n = 0, &max_eps]() mutable {return max_eps*std::pow(2., - n++);});
+  Npairs = N * (N - 1) / 2;
+
+  std::unique_ptr<T[]> C_eps(new T[eps_vec_size]);
+  std::transform(eps_vec.get(), eps_vec.get() + eps_vec_size,
+                 C_eps.get(),
+                 [&](const T &eps)
+                 {
+                  return static_cast<T>(2.)*std::count_if(ED.get(), ED.get() + Npairs,
+                                                          [&eps](const T &ed)
+                                                          {
+                                                            return (ed < eps) ? 1. : 0.;
+                                                          }) / Npairs;
+                 });
+  k2 = eps_vec_size - omit_pts;
+  // Compute correlation dimension as linear fit (slope)
+#ifdef _OPENMP
+#pragma omp parallel for reduction(+ : sx, sy, sxy, sx2)
+#endif
+  for(int i = k1; i < k2; ++i)
+  {
+    const T xp = std::log(eps_vec[i]) / LOG2;
+    const T yp = std::log(C_eps[i]) / LOG2;
+    sx  += xp;
+    sy  += yp;
+    sxy += xp * yp;
+    sx2 += xp * xp;
+  }
+  w = (k2 - k1) * sx2 - sx * sx;
+  parameters[0] = ((k2 - k1) * sxy - sx*sy) / w; //slope
+  parameters[1] = std::sqrt((k2 - k1) / w); // err slope
+  parameters[2] = (sx2 * sy - sxy*sx) / w; //intercept
+  parameters[3] = std::sqrt(sx2 / w); // err intercept
+
+  return parameters;
+}
+
+
+/**
+* @brief Binary exponent of a positive value
+*
+* @details floor(log2(x)) from the exponent bits of the double
+* representation (zero and denormals give -1023).
+*
+*/
+inline int32_t binary_exponent (const double & x)
+{
+  uint64_t bits;
+  std :: memcpy(&bits, &x, sizeof(double));
+  return static_cast < int32_t >((bits >> 52) & 0x7ff) - 1023;
+}
+
+
+/**
+* @brief Correlation sums of all the embedding dimensions in one sweep
+*
+* @details The delay vectors of dimension m = 1 .. max_dim are built
+* on the same N - (max_dim - 1) * delay points, so the distance in
+* dimension m + 1 is obtained from the one in dimension m adding
+* the last coordinate (squared Euclidean distance, or max-norm)
+* and every pair is visited once for all the dimensions. The
+* distances are binned by the binary exponent of their ratio with
+* max_eps, so the max_dim histograms are filled without searches,
+* and C_m(eps_k) is the fraction of the pairs closer than
+* eps_k = max_eps * 2^-k (as in GrassbergerProcaccia). The pairs
+* closer in time than the Theiler window are excluded and the rows
+* of pairs are distributed across the threads (each one with its
+* own histograms).
+* Only the distances are shared: the counts of a dimension cannot be
+* derived from the ones of the others, so each dimension still pays
+* the binning and the histogram increment of every pair. On the
+* Lorenz series of correlation_dimension.cpp 8 dimensions cost 5-6x
+* a single one, while separate scans of each dimension cost at least
+* 8x (and the distances of dimension m cost m times the ones of
+* dimension 1).
+*
+* @param x Scalar time series.
+* @param N Length of the series.
+* @param delay Embedding delay.
+* @param max_dim Maximum embedding dimension.
+* @param Neps Number of scales.
+* @param C Output correlation sums (max_dim x Neps, row-major).
+* @param eps Output scales (Neps values).
+* @param max_eps Largest scale (if <= 0 it is the smallest power of 2 above the largest possible distance).
+* @param theiler Theiler window (pairs with |i - j| < theiler are excluded, at least 1).
+* @param euclidean Use the Euclidean distance (default), otherwise the max-norm.
+*
+* @tparam type Data-type of the series.
+*
+*/
+template < class type >
+void correlation_sums (const type * x, const int64_t & N, const int32_t & delay, const int32_t & max_dim,
+                       const int32_t & Neps, double * C, double * eps,
+                       double max_eps = 0., int64_t theiler = 1, const bool & euclidean = true)
+{
+  const int64_t Np = N - static_cast < int64_t >(max_dim - 1) * delay;
+  theiler = std :: max(theiler, int64_t(1));
+
+  PROFILE_SCOPE("correlation_sums");
+  PROFILE_COUNT("correlation_sums", Np * (Np - 1) / 2);
+
+  if (max_eps <= 0.)
+  {
+    const auto range = std :: minmax_element(x, x + N);
+    const double width = static_cast < double >(*range.second - *range.first);
+    const double largest = euclidean ? width * std :: sqrt(static_cast < double >(max_dim)) : width;
+    max_eps = std :: pow(2., std :: ceil(std :: log2(largest > 0. ? largest : 1.)));
+
+    // the largest distance must be below max_eps
+    if (max_eps <= largest)
+      max_eps *= 2.;
+  }
+
+  for (int32_t k = 0; k < Neps; ++k)
+    eps[k] = max_eps * std :: pow(2., -k);
+
+  // squared distances are compared with max_eps^2 (a bin every 2 exponents)
+  const double scale = euclidean ? 1. / (max_eps * max_eps) : 1. / max_eps;
+  const int32_t shift = euclidean ? 1 : 0;
+
+  // one more bin per dimension for the distances above max_eps
+  const int32_t Nbins = Neps + 1;
+  std :: vector < int64_t > hist(max_dim * Nbins, 0);
+
+  constexpr int64_t block = 1024;
+
+#ifdef _OPENMP
+  #pragma omp parallel
+#endif
+  {
+    std :: vector < int64_t > local(max_dim * Nbins, 0);
+    std :: vector < double > dist(block);
+    std :: vector < int32_t > bin(max_dim * block);
+
+#ifdef _OPENMP
+    #pragma omp for schedule(dynamic, 16)
+#endif
+    for (int64_t i = 0; i < Np; ++i)
+    {
+      for (int64_t j0 = i + theiler; j0 < Np; j0 += block)
+      {
+        const int64_t n = std :: min(block, Np - j0);
+
+        std :: fill_n(dist.begin(), n, 0.);
+
+        for (int32_t m = 0; m < max_dim; ++m)
+        {
+          const double xi = static_cast < double >(x[i + m * delay]);
+          const type * xj = x + j0 + m * delay;
+
+          if (euclidean)
+            for (int64_t b = 0; b < n; ++b)
+              dist[b] += (xj[b] - xi) * (xj[b] - xi);
+          else
+            for (int64_t b = 0; b < n; ++b)
+              dist[b] = std :: max(dist[b], std :: abs(xj[b] - xi));
+
+          // dist < eps_k  <=>  exponent of (dist * scale) <= -(k << shift) - 1
+          int32_t * bm = bin.data() + m * block;
+          for (int64_t b = 0; b < n; ++b)
+          {
+            const int32_t t = -binary_exponent(dist[b] * scale) - 1;
+            bm[b] = t < 0 ? Neps : std :: min(t >> shift, Neps - 1);
+          }
+        }
+
+        // the dimensions fill independent histograms in the same loop
+        // (consecutive pairs often hit the same bin)
+        for (int64_t b = 0; b < n; ++b)
+          for (int32_t m = 0; m < max_dim; ++m)
+            ++local[m * Nbins + bin[m * block + b]];
+      }
+    }
+
+#ifdef _OPENMP
+    #pragma omp critical
+#endif
+    for (int32_t i = 0; i < max_dim * Nbins; ++i)
+      hist[i] += local[i];
+  }
+
+  // number of the pairs outside the Theiler window
+  const int64_t Nt = std :: max(Np - theiler + 1, int64_t(0));
+  const double Npairs = static_cast < double >(Nt) * (Nt - 1) / 2;
+
+  for (int32_t m = 0; m < max_dim; ++m)
+  {
+    int64_t cumulative = 0;
+    for (int32_t k = Neps - 1; k >= 0; --k)
+    {
+      cumulative += hist[m * Nbins + k];
+      C[m * Neps + k] = Npairs > 0. ? cumulative / Npairs : 0.;
+    }
+  }
+}
+
+
+/**
+* @brief Linear fit of a correlation sum
+*
+* @details Slope of log2 C(eps) vs log2 eps, as in
+* GrassbergerProcaccia (the scales with a null correlation
+* sum are skipped and omit_pts values are excluded at both ends).
+*
+* @param eps Scales.
+* @param C Correlation sums.
+* @param Neps Number of scales.
+* @param omit_pts Number of points excluded at both ends of the fit.
+*
+* @return The array (slope, err slope, intercept, err intercept).
+*
+*/
+inline std :: array < double, 4 > correlation_fit (const double * eps, const double * C, const int32_t & Neps, const int32_t & omit_pts = 3)
+{
+  int32_t valid = Neps;
+  while (valid > 0 && C[valid - 1] <= 0.)
+    --valid;
+
+  const int32_t k1 = omit_pts;
+  const int32_t k2 = valid - omit_pts;
+
+  double sx = 0., sy = 0., sxy = 0., sx2 = 0.;
+
+  for (int32_t i = k1; i < k2; ++i)
+  {
+    const double xp = std :: log2(eps[i]);
+    const double yp = std :: log2(C[i]);
+    sx  += xp;
+    sy  += yp;
+    sxy += xp * yp;
+    sx2 += xp * xp;
+  }
+
+  const double w = (k2 - k1) * sx2 - sx * sx;
+
+  std :: array < double, 4 > parameters;
+  parameters[0] = ((k2 - k1) * sxy - sx * sy) / w; // slope
+  parameters[1] = std :: sqrt((k2 - k1) / w);      // err slope
+  parameters[2] = (sx2 * sy - sxy * sx) / w;       // intercept
+  parameters[3] = std :: sqrt(sx2 / w);            // err intercept
+
+  return parameters;
+}
+
+#endif // __grassberger_procaccia_hpp__
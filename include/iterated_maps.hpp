@@ -0,0 +1,364 @@
+#ifndef __iterated_maps_hpp__
+#define __iterated_maps_hpp__
+
+#include <memory>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+/**
+* @brief Iterated maps and coupled map lattices
+*
+* @details Each map is a functor with a compile-time number of
+* state variables (dim) and a templated in-place call operator
+* on the state array, so it is fully inlined in the engine loops
+* and the same map can be evaluated on scalars of any type.
+* The 1D maps provide also the derivative f'(x), used for the
+* computation of the Lyapunov exponent.
+*
+* The state of an ensemble of N trajectories (or lattice sites)
+* is stored in Structure-of-Arrays format as dim planes of N
+* values (x[d * N + i]), so consecutive trajectories are processed
+* in SIMD lanes and the blocks of trajectories are distributed
+* across threads.
+*
+*/
+
+/**
+* @brief Logistic map x -> 4 mu x (1 - x)
+*
+*/
+template < class type >
+struct logistic_map
+{
+  static constexpr int32_t dim = 1;
+
+  type mu;
+
+  logistic_map (const type & mu) : mu(mu)
+  {
+  }
+
+  inline void operator() (std :: array < type, dim > & x) const
+  {
+    x[0] = type(4.) * this->mu * x[0] * (type(1.) - x[0]);
+  }
+
+  inline type derivative (const std :: array < type, dim > & x) const
+  {
+    return type(4.) * this->mu * (type(1.) - type(2.) * x[0]);
+  }
+};
+
+/**
+* @brief Bernoulli shift map x -> 2x mod 1
+*
+* @details The values in [0, 1) stay in [0, 1) (e.g. 0.5 -> 0),
+* as in the bernoulli lattice of bernoulli.h.
+*
+*/
+template < class type >
+struct bernoulli_map
+{
+  static constexpr int32_t dim = 1;
+
+  inline void operator() (std :: array < type, dim > & x) const
+  {
+    const type v = type(2.) * x[0];
+    x[0] = v - ((v >= type(1.)) ? type(1.) : type(0.));
+  }
+
+  inline type derivative (const std :: array < type, dim > &) const
+  {
+    return type(2.);
+  }
+};
+
+/**
+* @brief Chirikov standard map on the unit torus
+*
+* @details p -> p - k / (2 pi) sin(2 pi q) mod 1
+*          q -> q + p + 1/2 mod 1
+*
+*/
+template < class type >
+struct standard_map
+{
+  static constexpr int32_t dim = 2;
+
+  type k;
+
+  standard_map (const type & k) : k(k)
+  {
+  }
+
+  inline void operator() (std :: array < type, dim > & x) const
+  {
+    const type two_pi = type(6.283185307179586);
+
+    type p = x[1] - this->k / two_pi * std :: sin(two_pi * x[0]);
+    p -= std :: floor(p);
+    type q = x[0] + p + type(.5);
+    q -= std :: floor(q);
+
+    x[0] = q;
+    x[1] = p;
+  }
+
+  /**
+  * @brief Jacobian of the map (row-major) in the state x
+  *
+  */
+  inline void jacobian (const std :: array < type, dim > & x, std :: array < type, dim * dim > & J) const
+  {
+    const type two_pi = type(6.283185307179586);
+    const type kc = this->k * std :: cos(two_pi * x[0]);
+
+    J[0] = type(1.) - kc; J[1] = type(1.);
+    J[2] = -kc;           J[3] = type(1.);
+  }
+};
+
+/**
+* @brief General 2D iterated quadratic map
+*
+* @details x -> a0 + a1 x + a2 x^2 + a3 x y + a4 y  + a5 y^2
+*          y -> a6 + a7 x + a8 x^2 + a9 x y + a10 y + a11 y^2
+*
+*/
+template < class type >
+struct quadratic_map
+{
+  static constexpr int32_t dim = 2;
+
+  std :: array < type, 12 > a;
+
+  quadratic_map (const std :: array < type, 12 > & a) : a(a)
+  {
+  }
+
+  inline void operator() (std :: array < type, dim > & x) const
+  {
+    const type xx = x[0] * x[0];
+    const type xy = x[0] * x[1];
+    const type yy = x[1] * x[1];
+
+    const type new_x = a[0] + a[1] * x[0] + a[2] * xx + a[3] * xy + a[4]  * x[1] + a[5]  * yy;
+    const type new_y = a[6] + a[7] * x[0] + a[8] * xx + a[9] * xy + a[10] * x[1] + a[11] * yy;
+
+    x[0] = new_x;
+    x[1] = new_y;
+  }
+
+  /**
+  * @brief Jacobian of the map (row-major) in the state x
+  *
+  */
+  inline void jacobian (const std :: array < type, dim > & x, std :: array < type, dim * dim > & J) const
+  {
+    J[0] = a[1] + type(2.) * a[2] * x[0] + a[3] * x[1];
+    J[1] = a[3] * x[0] + a[4] + type(2.) * a[5] * x[1];
+    J[2] = a[7] + type(2.) * a[8] * x[0] + a[9] * x[1];
+    J[3] = a[9] * x[0] + a[10] + type(2.) * a[11] * x[1];
+  }
+};
+
+
+namespace maps
+{
+
+static constexpr int64_t block = 256; ///< Number of trajectories processed together (L1 resident)
+
+/**
+* @brief Apply the map for a given number of steps on a block of trajectories
+*
+* @param map Map functor.
+* @param x Ensemble state (dim planes of N values).
+* @param N Number of trajectories.
+* @param start Index of the first trajectory of the block.
+* @param n Number of trajectories in the block.
+* @param steps Number of iterations.
+*
+*/
+template < class Map, class type >
+inline void advance (const Map & map, type * x, const int64_t & N,
+                     const int64_t & start, const int64_t & n,
+                     const int64_t & steps)
+{
+  const Map f = map;
+
+  std :: array < type *, Map :: dim > planes;
+
+  for (int32_t d = 0; d < Map :: dim; ++d)
+    planes[d] = x + d * N + start;
+
+  const int64_t size = n;
+
+  // the loop is left to the compiler auto-vectorization since it
+  // can version the loop for the (runtime) aliasing of the planes
+  for (int64_t t = 0; t < steps; ++t)
+  {
+    for (int64_t i = 0; i < size; ++i)
+    {
+      std :: array < type, Map :: dim > s;
+
+      for (int32_t d = 0; d < Map :: dim; ++d)
+        s[d] = planes[d][i];
+
+      f(s);
+
+      for (int32_t d = 0; d < Map :: dim; ++d)
+        planes[d][i] = s[d];
+    }
+  }
+}
+
+} // end namespace maps
+
+
+/**
+* @brief Iterate an ensemble of trajectories of a map
+*
+* @details Each trajectory is evolved for `transient` steps
+* (discarded), then `samples` states are recorded every
+* `decimation` steps. The first sample is the state at the end
+* of the transient and at the end x holds the last recorded state.
+*
+* @param map Map functor.
+* @param x Initial conditions as dim planes of N values (updated in-place).
+* @param N Number of trajectories.
+* @param transient Number of transient iterations.
+* @param samples Number of recorded states.
+* @param decimation Number of iterations between two recorded states.
+* @param out Output buffer of (dim x samples x N) values, i.e.
+* out[(d * samples + s) * N + i] (it could be nullptr).
+*
+* @tparam Map Map functor type.
+* @tparam type Data-type of the state.
+*
+*/
+template < class Map, class type >
+void iterate (const Map & map, type * x, const int64_t & N,
+              const int64_t & transient, const int64_t & samples,
+              const int64_t & decimation = 1, type * out = nullptr)
+{
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(static)
+#endif
+  for (int64_t b = 0; b < N; b += maps :: block)
+  {
+    const int64_t n = std :: min(maps :: block, N - b);
+
+    maps :: advance(map, x, N, b, n, transient);
+
+    for (int64_t s = 0; s < samples; ++s)
+    {
+      if (s)
+        maps :: advance(map, x, N, b, n, decimation);
+
+      if ( !out )
+        continue;
+
+      for (int32_t d = 0; d < Map :: dim; ++d)
+        std :: copy_n(x + d * N + b, n, out + (d * samples + s) * N + b);
+    }
+  }
+}
+
+
+/**
+* @brief Coupled map lattice
+*
+* @details Diffusively coupled 2D lattice with periodic
+* boundaries of a 1D map f:
+*
+*   x_ij -> (1 - eps) f(x_ij) + eps / 4 (f(x_i-1j) + f(x_i+1j) + f(x_ij-1) + f(x_ij+1))
+*
+* The local map is first applied in-place (SIMD), then the
+* coupling is computed row by row into the second buffer and the
+* two buffers are swapped.
+*
+* @tparam Map Map functor type (with dim = 1).
+* @tparam type Data-type of the lattice.
+*
+*/
+template < class Map, class type >
+class coupled_map_lattice
+{
+  static_assert(Map :: dim == 1, "Coupled map lattice requires a 1D local map");
+
+public:
+
+  int64_t rows;
+  int64_t cols;
+
+  Map map;
+  type eps;
+
+  std :: unique_ptr < type[] > x;
+  std :: unique_ptr < type[] > buffer;
+
+  coupled_map_lattice (const Map & map, const int64_t & rows, const int64_t & cols, const type & eps) :
+                      rows(rows), cols(cols), map(map), eps(eps),
+                      x(new type[rows * cols]), buffer(new type[rows * cols])
+  {
+    std :: fill_n(this->x.get(), rows * cols, type(0.));
+  }
+
+  /**
+  * @brief Evolve the lattice
+  *
+  * @param steps Number of iterations.
+  *
+  */
+  void iterate (const int64_t & steps)
+  {
+    const int64_t size = this->rows * this->cols;
+    const type center = type(1.) - this->eps;
+    const type neigh = this->eps * type(.25);
+
+    for (int64_t t = 0; t < steps; ++t)
+    {
+      type * __restrict fx = this->x.get();
+      type * __restrict next = this->buffer.get();
+
+#ifdef _OPENMP
+      #pragma omp parallel for simd
+#endif
+      for (int64_t i = 0; i < size; ++i)
+      {
+        std :: array < type, 1 > s{ {fx[i]} };
+        this->map(s);
+        fx[i] = s[0];
+      }
+
+#ifdef _OPENMP
+      #pragma omp parallel for
+#endif
+      for (int64_t r = 0; r < this->rows; ++r)
+      {
+        const type * up   = fx + ((r + this->rows - 1) % this->rows) * this->cols;
+        const type * row  = fx + r * this->cols;
+        const type * down = fx + ((r + 1) % this->rows) * this->cols;
+        type * out = next + r * this->cols;
+
+        out[0] = center * row[0] + neigh * (up[0] + down[0] + row[this->cols - 1] + row[1 % this->cols]);
+
+#ifdef _OPENMP
+        #pragma omp simd
+#endif
+        for (int64_t c = 1; c < this->cols - 1; ++c)
+          out[c] = center * row[c] + neigh * (up[c] + down[c] + row[c - 1] + row[c + 1]);
+
+        const int64_t c = this->cols - 1;
+        if (c)
+          out[c] = center * row[c] + neigh * (up[c] + down[c] + row[c - 1] + row[0]);
+      }
+
+      std :: swap(this->x, this->buffer);
+    }
+  }
+};
+
+#endif // __iterated_maps_hpp__
@@ -0,0 +1,34 @@
+#ifndef __kalman_filter_h__
+#define __kalman_filter_h__
+
+#include <utility> // std::pair
+
+/**
+* @brief Kalman filter step for a 2D constant velocity model
+*
+* @details The state x = (x0, x1, x0_dot, x1_dot) and its
+* covariance P are updated in-place with the measurement
+* (obs_x, obs_y) and then propagated by the next state
+* function F (prediction for the next observation).
+* All the matrices are stored in row-major order.
+*
+* @param x State 4-tuple, updated in-place.
+* @param P State covariance (4 x 4), updated in-place.
+* @param F Next state function (4 x 4): x_prime = F*x.
+* @param H Measurement function (2 x 4): position = H*x.
+* @param motion External motion added to the state (4 values).
+* @param Q Motion noise (4 x 4).
+* @param R Measurement noise (variance of both coordinates).
+* @param obs_x Measured x coordinate.
+* @param obs_y Measured y coordinate.
+*
+* @return The filtered (x, y) position.
+*
+*/
+std::pair<float, float> kalman_filter(float *x, float *P,
+                                      const float *F, const float *H,
+                                      const float *motion,
+                                      const float *Q, const float &R,
+                                      const float &obs_x, const float &obs_y);
+
+#endif // __kalman_filter_h__
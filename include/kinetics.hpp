@@ -0,0 +1,425 @@
+#ifndef __kinetics_hpp__
+#define __kinetics_hpp__
+
+#include <memory>
+#include <type_traits>
+#include <cstdint>
+
+#include <brusselator.hpp>
+#include <ode_models.hpp>
+#include <matrix_exponential.hpp>
+#include <profiler.hpp>
+
+template < class type >
+using is_floating_point = typename std :: enable_if < std :: is_floating_point < type > :: value > :: type *;
+
+template < class type, is_floating_point < type > = nullptr >
+using array = std :: unique_ptr < type[] >;
+
+
+/**
+* @brief Zero order kinetic
+*
+* @param x List of time points.
+* @param y0 Initial condition of the reactant.
+* @param alpha Constant of the reaction.
+*
+* @tparam type Data-type of arrays
+* @tparam Length of time points.
+*
+* @return The resulting product array.
+*
+*/
+template < class type, int32_t N >
+array < type > zero_order (const array < type > & x, const type & y0, const type & alpha)
+{
+  PROFILE_SCOPE("zero_order");
+  PROFILE_COUNT("zero_order", N);
+
+  // determine the interval as diff
+  const type dx = x[1] - x[0]; // Note: we are assuming it is constant!!
+
+  // Create an empyt buffer to store our results
+  // Its length must be greater than x since we want to set
+  // the initial condition!
+  array < type > y = std :: make_unique < type[] >(N + 1);
+  // Set the initial condition
+  y[0] = y0;
+
+  // Integrate the equation using the Euler method
+  for (int32_t i = 0; i < N; ++i)
+    y[i + 1] = y[i] - alpha * dx;
+
+  return y;
+}
+
+
+/**
+* @brief 1st order kinetic
+*
+* @param x List of time points.
+* @param p0 Initial condition of the product.
+* @param r0 Initial condition of the reagent.
+* @param kf Constant of the forward reaction.
+* @param kb Constant of the backward reaction.
+* @param P The resulting product array.
+* @param R The resulting reagent array.
+*
+* @tparam type Data-type of arrays
+* @tparam Length of time points.
+*
+*/
+template < class type, int32_t N >
+void first_order (const array < type > & x, const type & p0, const type & r0,
+                  const type & kf, const type & kb,
+                  array < type > & P, array < type > & R
+                 )
+{
+  PROFILE_SCOPE("first_order");
+  PROFILE_COUNT("first_order", N);
+
+  // determine the interval as diff
+  const type dx = x[1] - x[0]; // Note: we are assuming it is constant!!
+
+  // Set the initial condition
+  P[0] = p0;
+  R[0] = r0;
+
+  // Integrate the equation using the Euler method
+  for (int32_t i = 0; i < N; ++i)
+  {
+    P[i + 1] = P[i] + ( kf * R[i] - kb * P[i]) * dx;
+    R[i + 1] = R[i] + (-kf * R[i] + kb * P[i]) * dx;
+  }
+}
+
+
+/**
+* @brief 1st order kinetic with the exact exponential propagator
+*
+* @details Same equations of first_order, advanced by the matrix
+* exp(dx K) of the rate matrix K (computed once, see
+* exponential_propagator) instead of the Euler steps: the result is
+* the analytic solution on the time points for any dx and P + R is
+* conserved to the rounding of the arithmetic. For many initial
+* conditions use exponential_propagator :: apply on the whole batch.
+*
+* @param x List of time points.
+* @param p0 Initial condition of the product.
+* @param r0 Initial condition of the reagent.
+* @param kf Constant of the forward reaction.
+* @param kb Constant of the backward reaction.
+* @param P The resulting product array.
+* @param R The resulting reagent array.
+*
+* @tparam type Data-type of arrays
+* @tparam Length of time points.
+*
+* @return False if the exponential of the rate matrix fails (P and R are not computed).
+*
+*/
+template < class type, int32_t N >
+bool first_order_exponential (const array < type > & x, const type & p0, const type & r0,
+                              const type & kf, const type & kb,
+                              array < type > & P, array < type > & R
+                             )
+{
+  PROFILE_SCOPE("first_order_exponential");
+  PROFILE_COUNT("first_order_exponential", N);
+
+  // determine the interval as diff
+  const type dx = x[1] - x[0]; // Note: we are assuming it is constant!!
+
+  // rate matrix of (P, R)
+  const double K[4] = {-kb,  kf,
+                        kb, -kf};
+
+  const exponential_propagator < type > step(K, nullptr, 2, dx);
+  if ( !step.valid() )
+    return false;
+
+  const double * phi = step.matrix();
+
+  // Set the initial condition
+  P[0] = p0;
+  R[0] = r0;
+
+  // the state is carried in double, so each output is the rounding of the exact value
+  double p = p0;
+  double r = r0;
+
+  for (int32_t i = 0; i < N; ++i)
+  {
+    const double pi = p;
+    p = phi[0] * pi + phi[1] * r;
+    r = phi[2] * pi + phi[3] * r;
+
+    P[i + 1] = static_cast < type >(p);
+    R[i + 1] = static_cast < type >(r);
+  }
+
+  return true;
+}
+
+
+/**
+* @brief Michaelis Menten kinetic
+*
+* @param x List of time points.
+* @param s0 Initial condition of the substrate.
+* @param e0 Initial condition of the enzyme.
+* @param es0 Initial condition of the substrate+enzyme.
+* @param p0 Initial condition of the product.
+* @param kf Constant of the forward reaction.
+* @param kb Constant of the backward reaction.
+* @param kc Constant of the product reaction.
+* @param S The resulting substrate array.
+* @param E The resulting enzyme array.
+* @param ES The resulting enzyme+substrate array.
+* @param P The resulting product array.
+*
+* @tparam type Data-type of arrays
+* @tparam Length of time points.
+*
+*/
+template < class type, int32_t N >
+void MichaelisMenten (const array < type > & x,
+                      const type & s0, const type & e0, const type & es0, const type & p0,
+                      const type & kf, const type & kb, const type &kc,
+                      array < type > & S, array < type > & E, array < type > & ES, array < type > & P
+                     )
+{
+  PROFILE_SCOPE("MichaelisMenten");
+  PROFILE_COUNT("MichaelisMenten", N - 1);
+  PROFILE_COUNT("MichaelisMenten.rhs", 16 * (N - 1));
+
+  // determine the interval as diff
+  const type dx = x[1] - x[0]; // Note: we are assuming it is constant!!
+
+  // Set the initial condition
+  S[0] = s0;
+  E[0] = e0;
+  ES[0] = es0;
+  P[0] = p0;
+
+  // set the equation functions
+  auto dS = [](const type & S, const type & E, const type & ES,
+               const type & kf, const type & kb)
+            {
+              return -kf * S * E + kb * ES;
+            };
+  auto dE = [](const type & S, const type & E, const type & ES,
+               const type & kf, const type & kb, const type & kc)
+            {
+              return -kf * S * E + kb * ES + kc * ES;
+            };
+  auto dES = [](const type & S, const type & E, const type & ES,
+                const type & kf, const type & kb, const type & kc)
+             {
+               return kf * S * E - kb * ES - kc * ES;
+             };
+  auto dP = [](const type & ES, const type & kc)
+            {
+              return kc * ES;
+            };
+
+
+  // Integrate the equation using the RK4 method
+  for (int32_t i = 0; i < N - 1; ++i)
+  {
+    const type ks1  = dx * dS( S[i], E[i], ES[i], kf, kb);
+    const type ke1  = dx * dE( S[i], E[i], ES[i], kf, kb, kc);
+    const type kes1 = dx * dES(S[i], E[i], ES[i], kf, kb, kc);
+    const type kp1  = dx * dP(ES[i], kc);
+
+    const type ks2  = dx * dS( S[i] + .5 * ks1, E[i] + .5 * ke1, ES[i] + .5 * kes1, kf, kb);
+    const type ke2  = dx * dE( S[i] + .5 * ks1, E[i] + .5 * ke1, ES[i] + .5 * kes1, kf, kb, kc);
+    const type kes2 = dx * dES(S[i] + .5 * ks1, E[i] + .5 * ke1, ES[i] + .5 * kes1, kf, kb, kc);
+    const type kp2  = dx * dP(ES[i] + .5 * kes1, kc);
+
+    const type ks3  = dx * dS( S[i] + .5 * ks2, E[i] + .5 * ke2, ES[i] + .5 * kes2, kf, kb);
+    const type ke3  = dx * dE( S[i] + .5 * ks2, E[i] + .5 * ke2, ES[i] + .5 * kes2, kf, kb, kc);
+    const type kes3 = dx * dES(S[i] + .5 * ks2, E[i] + .5 * ke2, ES[i] + .5 * kes2, kf, kb, kc);
+    const type kp3  = dx * dP(ES[i] + .5 * kes2, kc);
+
+    const type ks4  = dx * dS( S[i] + ks3, E[i] + ke3, ES[i] + kes3, kf, kb);
+    const type ke4  = dx * dE( S[i] + ks3, E[i] + ke3, ES[i] + kes3, kf, kb, kc);
+    const type kes4 = dx * dES(S[i] + ks3, E[i] + ke3, ES[i] + kes3, kf, kb, kc);
+    const type kp4  = dx * dP(ES[i] + kes3, kc);
+
+    S[i + 1]  = S[i]  + type(1. / 6.) * (ks1  + type(2.) * ks2  + type(2.) * ks3  + ks4);
+    E[i + 1]  = E[i]  + type(1. / 6.) * (ke1  + type(2.) * ke2  + type(2.) * ke3  + ke4);
+    ES[i + 1] = ES[i] + type(1. / 6.) * (kes1 + type(2.) * kes2 + type(2.) * kes3 + kes4);
+    P[i + 1]  = P[i]  + type(1. / 6.) * (kp1  + type(2.) * kp2  + type(2.) * kp3  + kp4);
+  }
+}
+
+
+/**
+* @brief Michaelis Menten kinetic with forward sensitivities
+*
+* @details The state is integrated with the RK4 method together
+* with its derivatives with respect to the constants (kf, kb, kc),
+* sharing the RHS and Jacobian evaluations of each stage
+* (see rk4_sensitivity and michaelis_menten_model).
+*
+* @param x List of time points.
+* @param s0 Initial condition of the substrate.
+* @param e0 Initial condition of the enzyme.
+* @param es0 Initial condition of the substrate+enzyme.
+* @param p0 Initial condition of the product.
+* @param kf Constant of the forward reaction.
+* @param kb Constant of the backward reaction.
+* @param kc Constant of the product reaction.
+* @param S The resulting substrate array.
+* @param E The resulting enzyme array.
+* @param ES The resulting enzyme+substrate array.
+* @param P The resulting product array.
+* @param sensitivity The resulting sensitivities (N x 4 x 3): sensitivity[(i * 4 + v) * 3 + k]
+* is the derivative of the v-th variable (S, E, ES, P) at the i-th time point with respect
+* to the k-th constant (kf, kb, kc).
+*
+* @tparam type Data-type of arrays
+* @tparam Length of time points.
+*
+*/
+template < class type, int32_t N >
+void MichaelisMenten (const array < type > & x,
+                      const type & s0, const type & e0, const type & es0, const type & p0,
+                      const type & kf, const type & kb, const type &kc,
+                      array < type > & S, array < type > & E, array < type > & ES, array < type > & P,
+                      array < type > & sensitivity
+                     )
+{
+  using model = michaelis_menten_model < type >;
+
+  // determine the interval as diff
+  const type dx = x[1] - x[0]; // Note: we are assuming it is constant!!
+
+  const type y0[model :: Nvar] = {s0, e0, es0, p0};
+  const type params[model :: Npar] = {kf, kb, kc};
+
+  rk4_sensitivity < model >(y0, params, dx, 1, N,
+                            [&](const int64_t & i, const type * y, const type * dy)
+                            {
+                              S[i] = y[0];
+                              E[i] = y[1];
+                              ES[i] = y[2];
+                              P[i] = y[3];
+                              std :: copy_n(dy, model :: Nvar * model :: Npar, sensitivity.get() + i * model :: Nvar * model :: Npar);
+                            });
+}
+
+
+/**
+* @brief Brusselator kinetic
+*
+* @param t List of time points.
+* @param x0 Initial condition of the x signal.
+* @param y0 Initial condition of the y signal.
+* @param A Constant of the reaction.
+* @param B Constant of the reaction.
+* @param x The resulting x array.
+* @param y The resulting y array.
+*
+* @tparam type Data-type of arrays
+* @tparam Length of time points.
+*
+*/
+template < class type, int32_t N >
+void Brusselator (const array < type > & t,
+                  const type & x0, const type & y0, const type & A, const type & B,
+                  array < type > & x, array < type > & y
+                  )
+{
+  // determine the interval as diff
+  const type dt = t[1] - t[0]; // Note: we are assuming it is constant!!
+
+  // Set the initial condition
+  x[0] = x0;
+  y[0] = y0;
+
+  // Integrate the equations using the RK4 method
+  brusselator_rk4(x.get(), y.get(), static_cast < int64_t >(N - 1), A, B, dt);
+}
+
+
+/**
+* @brief Brusselator kinetic with forward sensitivities
+*
+* @details The state is integrated with the RK4 method together
+* with its derivatives with respect to the constants (A, B),
+* sharing the RHS and Jacobian evaluations of each stage
+* (see rk4_sensitivity and brusselator_model).
+*
+* @param t List of time points.
+* @param x0 Initial condition of the x signal.
+* @param y0 Initial condition of the y signal.
+* @param A Constant of the reaction.
+* @param B Constant of the reaction.
+* @param x The resulting x array.
+* @param y The resulting y array.
+* @param sensitivity The resulting sensitivities (N x 2 x 2): sensitivity[(i * 2 + v) * 2 + k]
+* is the derivative of the v-th variable (x, y) at the i-th time point with respect
+* to the k-th constant (A, B).
+*
+* @tparam type Data-type of arrays
+* @tparam Length of time points.
+*
+*/
+template < class type, int32_t N >
+void Brusselator (const array < type > & t,
+                  const type & x0, const type & y0, const type & A, const type & B,
+                  array < type > & x, array < type > & y,
+                  array < type > & sensitivity
+                  )
+{
+  using model = brusselator_model < type >;
+
+  // determine the interval as diff
+  const type dt = t[1] - t[0]; // Note: we are assuming it is constant!!
+
+  const type init[model :: Nvar] = {x0, y0};
+  const type params[model :: Npar] = {A, B};
+
+  rk4_sensitivity < model >(init, params, dt, 1, N,
+                            [&](const int64_t & i, const type * state, const type * dy)
+                            {
+                              x[i] = state[0];
+                              y[i] = state[1];
+                              std :: copy_n(dy, model :: Nvar * model :: Npar, sensitivity.get() + i * model :: Nvar * model :: Npar);
+                            });
+}
+
+
+/**
+* @brief RK4 integration of a kinetic model on a raw buffer
+*
+* @details Same integration of the array versions (e.g.
+* MichaelisMenten), written in a caller-owned buffer (e.g. a NumPy
+* array, see cpy/Brusselator.pyx) without the sensitivities.
+*
+* @param y Array of (iterations + 1) x Nvar values (row-major) with the
+* initial condition in the first row.
+* @param iterations Number of integration steps.
+* @param p Parameters (Npar values).
+* @param dt Integration step.
+*
+* @tparam model Model class (see ode_models.hpp).
+*
+*/
+template < class model >
+void kinetic_rk4 (typename model :: value_type * y, const int64_t & iterations,
+                  const typename model :: value_type * p,
+                  const typename model :: value_type & dt)
+{
+  using type = typename model :: value_type;
+
+  rk4_sensitivity < model >(y, p, dt, 1, iterations + 1,
+                            [&](const int64_t & i, const type * state, const type *)
+                            {
+                              std :: copy_n(state, model :: Nvar, y + i * model :: Nvar);
+                            }, false);
+}
+
+#endif // __kinetics_hpp__
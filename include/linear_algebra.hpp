@@ -0,0 +1,81 @@
+#ifndef __linear_algebra_hpp__
+#define __linear_algebra_hpp__
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+/**
+* @brief LU decomposition with partial pivoting
+*
+* @param A Matrix (n x n, row-major), overwritten by the decomposition.
+* @param piv Output array of n pivot indices.
+* @param n Size of the matrix.
+*
+* @tparam type Data-type of arrays
+*
+* @return False if the matrix is singular.
+*
+*/
+template < class type >
+bool lu_factor (type * A, int32_t * piv, const int32_t & n)
+{
+  for (int32_t k = 0; k < n; ++k)
+  {
+    int32_t p = k;
+    for (int32_t i = k + 1; i < n; ++i)
+      if (std :: abs(A[i * n + k]) > std :: abs(A[p * n + k]))
+        p = i;
+
+    piv[k] = p;
+
+    if (A[p * n + k] == type(0.))
+      return false;
+
+    if (p != k)
+      for (int32_t j = 0; j < n; ++j)
+        std :: swap(A[k * n + j], A[p * n + j]);
+
+    for (int32_t i = k + 1; i < n; ++i)
+    {
+      const type f = A[i * n + k] / A[k * n + k];
+      A[i * n + k] = f;
+      for (int32_t j = k + 1; j < n; ++j)
+        A[i * n + j] -= f * A[k * n + j];
+    }
+  }
+
+  return true;
+}
+
+
+/**
+* @brief Solve a linear system with the LU decomposition of lu_factor
+*
+* @param LU Decomposition (n x n, row-major).
+* @param piv Pivot indices.
+* @param b Right-hand side, overwritten by the solution.
+* @param n Size of the system.
+*
+* @tparam type Data-type of arrays
+*
+*/
+template < class type >
+void lu_solve (const type * LU, const int32_t * piv, type * b, const int32_t & n)
+{
+  for (int32_t k = 0; k < n; ++k)
+  {
+    std :: swap(b[k], b[piv[k]]);
+    for (int32_t i = k + 1; i < n; ++i)
+      b[i] -= LU[i * n + k] * b[k];
+  }
+
+  for (int32_t i = n - 1; i >= 0; --i)
+  {
+    for (int32_t j = i + 1; j < n; ++j)
+      b[i] -= LU[i * n + j] * b[j];
+    b[i] /= LU[i * n + i];
+  }
+}
+
+#endif // __linear_algebra_hpp__
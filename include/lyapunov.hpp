@@ -0,0 +1,305 @@
+#ifndef __lyapunov_hpp__
+#define __lyapunov_hpp__
+
+#include <array>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include <cstdint>
+
+#include <ode_models.hpp>
+#include <iterated_maps.hpp>
+#include <profiler.hpp>
+
+/**
+* @brief Re-orthonormalize the tangent vectors
+*
+* @details Modified Gram-Schmidt QR of the columns of Q (n x n,
+* row-major): Q is replaced by the orthonormal factor and the
+* logarithms of the diagonal of R are added to sum.
+*
+* @param Q Tangent vectors as columns.
+* @param n Number of vectors (and dimension).
+* @param sum Accumulators of the log-stretching of each vector.
+*
+* @tparam type Data-type of arrays
+*
+*/
+template < class type >
+void tangent_qr (type * Q, const int32_t & n, double * sum)
+{
+  for (int32_t j = 0; j < n; ++j)
+  {
+    for (int32_t k = 0; k < j; ++k)
+    {
+      type dot = type(0.);
+      for (int32_t i = 0; i < n; ++i)
+        dot += Q[i * n + k] * Q[i * n + j];
+      for (int32_t i = 0; i < n; ++i)
+        Q[i * n + j] -= dot * Q[i * n + k];
+    }
+
+    type norm = type(0.);
+    for (int32_t i = 0; i < n; ++i)
+      norm += Q[i * n + j] * Q[i * n + j];
+    norm = std :: sqrt(norm);
+
+    sum[j] += std :: log(static_cast < double >(norm));
+
+    for (int32_t i = 0; i < n; ++i)
+      Q[i * n + j] /= norm;
+  }
+}
+
+
+/**
+* @brief Lyapunov spectrum of a flow
+*
+* @details The trajectory (RK4) is co-integrated with Nvar tangent
+* vectors, which follow the variational equations dQ/dt = Jy Q: the
+* Jacobian is evaluated once per stage on the stage state and it
+* is shared by all the tangent vectors, so a step costs Nvar + 1
+* RHS-like evaluations. The tangent vectors are re-orthonormalized
+* by a QR decomposition every qr_interval steps (the growth between
+* two decompositions must not overflow nor collapse the vectors on
+* the most unstable direction) and the exponents are the time
+* averages of the logarithms of the diagonal of R (Benettin et al. 1980).
+*
+* @param y0 Initial condition (Nvar values).
+* @param p Parameters of the model (Npar values).
+* @param dt Integration step.
+* @param transient Number of steps discarded before the average (the tangent vectors align meanwhile).
+* @param steps Number of averaged steps.
+* @param qr_interval Number of steps between two QR decompositions (values < 1 are taken as 1).
+* @param spectrum Output array of Nvar exponents (in decreasing order).
+*
+* @tparam model Model class (see ode_models.hpp).
+*
+*/
+template < class model >
+void lyapunov_spectrum (const typename model :: value_type * y0,
+                        const typename model :: value_type * p,
+                        const typename model :: value_type & dt,
+                        const int64_t & transient, const int64_t & steps,
+                        const int32_t & qr_interval,
+                        typename model :: value_type * spectrum)
+{
+  using type = typename model :: value_type;
+
+  constexpr int32_t Nvar = model :: Nvar;
+  constexpr int32_t Npar = model :: Npar;
+  constexpr int32_t NQ = Nvar * Nvar;
+
+  PROFILE_SCOPE("lyapunov_spectrum");
+  PROFILE_COUNT("lyapunov_spectrum", transient + steps);
+
+  std :: array < type, Nvar > y;
+  std :: array < type, NQ > Q;
+  std :: copy_n(y0, Nvar, y.begin());
+
+  Q.fill(type(0.));
+  for (int32_t i = 0; i < Nvar; ++i)
+    Q[i * Nvar + i] = type(1.);
+
+  std :: array < std :: array < type, Nvar >, 4 > ky;
+  std :: array < std :: array < type, NQ >, 4 > kQ;
+  std :: array < type, Nvar > ys;
+  std :: array < type, NQ > Qs;
+  std :: array < type, NQ > Jy;
+  std :: array < type, Nvar * Npar > Jp;
+
+  std :: array < double, Nvar > sum;
+  sum.fill(0.);
+
+  const int32_t interval = std :: max(qr_interval, 1);
+
+  const std :: array < type, 4 > stage = {{type(0.), type(.5) * dt, type(.5) * dt, dt}};
+
+  for (int64_t n = 0; n < transient + steps; ++n)
+  {
+    for (int32_t s = 0; s < 4; ++s)
+    {
+      for (int32_t i = 0; i < Nvar; ++i)
+        ys[i] = s ? y[i] + stage[s] * ky[s - 1][i] : y[i];
+      for (int32_t i = 0; i < NQ; ++i)
+        Qs[i] = s ? Q[i] + stage[s] * kQ[s - 1][i] : Q[i];
+
+      model :: rhs(ys.data(), p, ky[s].data());
+      model :: jacobian(ys.data(), p, Jy.data(), Jp.data());
+
+      for (int32_t i = 0; i < Nvar; ++i)
+        for (int32_t j = 0; j < Nvar; ++j)
+        {
+          type v = type(0.);
+          for (int32_t k = 0; k < Nvar; ++k)
+            v += Jy[i * Nvar + k] * Qs[k * Nvar + j];
+          kQ[s][i * Nvar + j] = v;
+        }
+    }
+
+    for (int32_t i = 0; i < Nvar; ++i)
+      y[i] += dt * type(1. / 6.) * (ky[0][i] + type(2.) * ky[1][i] + type(2.) * ky[2][i] + ky[3][i]);
+    for (int32_t i = 0; i < NQ; ++i)
+      Q[i] += dt * type(1. / 6.) * (kQ[0][i] + type(2.) * kQ[1][i] + type(2.) * kQ[2][i] + kQ[3][i]);
+
+    const bool last = n + 1 == transient + steps;
+
+    if ((n + 1) % interval == 0 || n + 1 == transient || last)
+    {
+      tangent_qr(Q.data(), Nvar, sum.data());
+
+      // the transient only aligns the tangent vectors
+      if (n + 1 == transient)
+        sum.fill(0.);
+    }
+  }
+
+  for (int32_t i = 0; i < Nvar; ++i)
+    spectrum[i] = steps ? static_cast < type >(sum[i] / (steps * static_cast < double >(dt))) : type(0.);
+
+  std :: sort(spectrum, spectrum + Nvar, std :: greater < type >());
+}
+
+
+/**
+* @brief Lyapunov spectrum of a map
+*
+* @details Same algorithm of the flow version, with the tangent
+* vectors multiplied by the Jacobian of the map at every iteration
+* (the map must provide jacobian(x, J), see quadratic_map).
+*
+* @param map Map functor.
+* @param x0 Initial condition (dim values).
+* @param transient Number of iterations discarded before the average.
+* @param steps Number of averaged iterations.
+* @param qr_interval Number of iterations between two QR decompositions (values < 1 are taken as 1).
+* @param spectrum Output array of dim exponents per iteration (in decreasing order).
+*
+* @tparam Map Map functor type.
+* @tparam type Data-type of the state.
+*
+*/
+template < class Map, class type >
+void lyapunov_spectrum_map (const Map & map, const type * x0,
+                            const int64_t & transient, const int64_t & steps,
+                            const int32_t & qr_interval, type * spectrum)
+{
+  constexpr int32_t dim = Map :: dim;
+  constexpr int32_t NQ = dim * dim;
+
+  PROFILE_SCOPE("lyapunov_spectrum_map");
+  PROFILE_COUNT("lyapunov_spectrum_map", transient + steps);
+
+  std :: array < type, dim > x;
+  std :: copy_n(x0, dim, x.begin());
+
+  std :: array < type, NQ > Q, J, JQ;
+  Q.fill(type(0.));
+  for (int32_t i = 0; i < dim; ++i)
+    Q[i * dim + i] = type(1.);
+
+  std :: array < double, dim > sum;
+  sum.fill(0.);
+
+  const int32_t interval = std :: max(qr_interval, 1);
+
+  for (int64_t n = 0; n < transient + steps; ++n)
+  {
+    map.jacobian(x, J);
+    map(x);
+
+    for (int32_t i = 0; i < dim; ++i)
+      for (int32_t j = 0; j < dim; ++j)
+      {
+        type v = type(0.);
+        for (int32_t k = 0; k < dim; ++k)
+          v += J[i * dim + k] * Q[k * dim + j];
+        JQ[i * dim + j] = v;
+      }
+    Q = JQ;
+
+    const bool last = n + 1 == transient + steps;
+
+    if ((n + 1) % interval == 0 || n + 1 == transient || last)
+    {
+      tangent_qr(Q.data(), dim, sum.data());
+
+      if (n + 1 == transient)
+        sum.fill(0.);
+    }
+  }
+
+  for (int32_t i = 0; i < dim; ++i)
+    spectrum[i] = steps ? static_cast < type >(sum[i] / steps) : type(0.);
+
+  std :: sort(spectrum, spectrum + dim, std :: greater < type >());
+}
+
+
+/**
+* @brief Lyapunov spectra of an ensemble of initial conditions
+*
+* @details Each initial condition is an independent
+* lyapunov_spectrum run, distributed across the threads.
+*
+* @param y0 Initial conditions (N x Nvar, row-major).
+* @param N Number of initial conditions.
+* @param p Parameters of the model (Npar values).
+* @param dt Integration step.
+* @param transient Number of steps discarded before the average.
+* @param steps Number of averaged steps.
+* @param qr_interval Number of steps between two QR decompositions.
+* @param spectra Output spectra (N x Nvar, row-major).
+*
+* @tparam model Model class (see ode_models.hpp).
+*
+*/
+template < class model >
+void lyapunov_ensemble (const typename model :: value_type * y0, const int64_t & N,
+                        const typename model :: value_type * p,
+                        const typename model :: value_type & dt,
+                        const int64_t & transient, const int64_t & steps,
+                        const int32_t & qr_interval,
+                        typename model :: value_type * spectra)
+{
+  constexpr int32_t Nvar = model :: Nvar;
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic, 1)
+#endif
+  for (int64_t i = 0; i < N; ++i)
+    lyapunov_spectrum < model >(y0 + i * Nvar, p, dt, transient, steps, qr_interval, spectra + i * Nvar);
+}
+
+
+/**
+* @brief Kaplan-Yorke (Lyapunov) dimension
+*
+* @details D = j + (l_1 + ... + l_j) / |l_(j+1)|, with j the largest
+* index for which the sum of the first j exponents is non-negative.
+*
+* @param spectrum Lyapunov exponents in decreasing order.
+* @param n Number of exponents.
+*
+* @tparam type Data-type of arrays
+*
+* @return The Kaplan-Yorke dimension (n if the sum of all the exponents is non-negative).
+*
+*/
+template < class type >
+type kaplan_yorke_dimension (const type * spectrum, const int32_t & n)
+{
+  type sum = type(0.);
+
+  for (int32_t j = 0; j < n; ++j)
+  {
+    if (sum + spectrum[j] < type(0.))
+      return j + sum / std :: abs(spectrum[j]);
+    sum += spectrum[j];
+  }
+
+  return static_cast < type >(n);
+}
+
+#endif // __lyapunov_hpp__
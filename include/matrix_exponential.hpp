@@ -0,0 +1,346 @@
+#ifndef __matrix_exponential_hpp__
+#define __matrix_exponential_hpp__
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <linear_algebra.hpp>
+#include <profiler.hpp>
+
+
+/**
+* @brief Product of two square matrices (row-major)
+*
+*/
+template < class type >
+void matmul (const type * A, const type * B, type * C, const int32_t & n)
+{
+  std :: fill_n(C, n * n, type(0.));
+
+  for (int32_t i = 0; i < n; ++i)
+    for (int32_t k = 0; k < n; ++k)
+    {
+      const type a = A[i * n + k];
+      for (int32_t j = 0; j < n; ++j)
+        C[i * n + j] += a * B[k * n + j];
+    }
+}
+
+
+/**
+* @brief Exponential of a dense matrix
+*
+* @details Diagonal Pade approximation of degree 6 with scaling
+* and squaring (as dgpadm of Expokit): the matrix is scaled by
+* 2^-s so that its infinity norm is below 1/2, the rational
+* approximation (V - U)^-1 (V + U) is evaluated with an LU
+* solve and squared s times. The relative error is close to the
+* machine precision for any norm of the matrix.
+*
+* @param A Matrix (n x n, row-major).
+* @param n Size of the matrix.
+* @param t Time factor (the result is exp(t A)).
+* @param E Output matrix exp(t A) (n x n, row-major).
+*
+* @tparam type Data-type of arrays
+*
+* @return False if the Pade denominator is singular.
+*
+*/
+template < class type >
+bool expm (const type * A, const int32_t & n, const type & t, type * E)
+{
+  PROFILE_SCOPE("expm");
+
+  constexpr int32_t degree = 6;
+
+  const int32_t n2 = n * n;
+
+  // infinity norm and scaling
+  type norm = type(0.);
+  for (int32_t i = 0; i < n; ++i)
+  {
+    type row = type(0.);
+    for (int32_t j = 0; j < n; ++j)
+      row += std :: abs(A[i * n + j]);
+    norm = std :: max(norm, row);
+  }
+  norm *= std :: abs(t);
+
+  int32_t s = 0;
+  if (norm > type(.5))
+    s = std :: max(0, static_cast < int32_t >(std :: log2(norm / type(.5))) + 1);
+
+  const type scale = t / std :: ldexp(type(1.), s);
+
+  std :: vector < type > X(n2), X2(n2), tmp(n2), U(n2), V(n2);
+
+  for (int32_t i = 0; i < n2; ++i)
+    X[i] = scale * A[i];
+
+  matmul(X.data(), X.data(), X2.data(), n);
+
+  // Pade coefficients c_k = c_{k-1} (p + 1 - k) / (k (2p + 1 - k))
+  type c[degree + 1];
+  c[0] = type(1.);
+  for (int32_t k = 1; k <= degree; ++k)
+    c[k] = c[k - 1] * type(degree + 1 - k) / type(k * (2 * degree + 1 - k));
+
+  // Horner scheme in X^2 for the even (V) and odd (U / X) parts
+  std :: fill(U.begin(), U.end(), type(0.));
+  std :: fill(V.begin(), V.end(), type(0.));
+  for (int32_t i = 0; i < n; ++i)
+  {
+    U[i * n + i] = c[degree - 1];
+    V[i * n + i] = c[degree];
+  }
+
+  for (int32_t k = degree - 3; k >= 1; k -= 2)
+  {
+    matmul(U.data(), X2.data(), tmp.data(), n);
+    std :: swap(U, tmp);
+    for (int32_t i = 0; i < n; ++i)
+      U[i * n + i] += c[k];
+  }
+
+  for (int32_t k = degree - 2; k >= 0; k -= 2)
+  {
+    matmul(V.data(), X2.data(), tmp.data(), n);
+    std :: swap(V, tmp);
+    for (int32_t i = 0; i < n; ++i)
+      V[i * n + i] += c[k];
+  }
+
+  matmul(X.data(), U.data(), tmp.data(), n);
+  std :: swap(U, tmp);
+
+  // E = (V - U)^-1 (V + U), column by column
+  std :: vector < type > Q(n2);
+  std :: vector < int32_t > piv(n);
+  for (int32_t i = 0; i < n2; ++i)
+    Q[i] = V[i] - U[i];
+
+  if ( !lu_factor(Q.data(), piv.data(), n) )
+    return false;
+
+  std :: vector < type > col(n);
+  for (int32_t j = 0; j < n; ++j)
+  {
+    for (int32_t i = 0; i < n; ++i)
+      col[i] = V[i * n + j] + U[i * n + j];
+    lu_solve(Q.data(), piv.data(), col.data(), n);
+    for (int32_t i = 0; i < n; ++i)
+      E[i * n + j] = col[i];
+  }
+
+  // squaring
+  for (int32_t k = 0; k < s; ++k)
+  {
+    matmul(E, E, tmp.data(), n);
+    std :: copy(tmp.begin(), tmp.end(), E);
+  }
+
+  return true;
+}
+
+
+/**
+* @brief Exact propagator of a linear (affine) system
+*
+* @details The solution of dy/dt = K y + b over an interval dt is
+*
+*   y(t + dt) = Phi y(t) + c,  Phi = exp(dt K),  c = int_0^dt exp(s K) b ds
+*
+* which is the exponential of the augmented matrix [[K, b], [0, 0]]
+* (computed once, in double precision, with expm). A step is then a
+* mat-vec, exact at any step size (e.g. the columns of Phi of a
+* closed network sum to one, so the mass is conserved to the
+* rounding of the arithmetic). The step is applied to a batch of
+* states at once, stored as n planes of Nbatch values (Y[i * Nbatch + j]),
+* so the product is vectorized along the batch and the blocks of
+* states are distributed across threads. The matrix and the states
+* of a block are kept in double precision across the steps (the
+* rounding of Phi to float would bias every step and the mass
+* would drift linearly with the number of steps).
+*
+* @tparam type Data-type of the states.
+*
+*/
+template < class type >
+class exponential_propagator
+{
+  int32_t n;
+  std :: vector < double > Phi;   ///< exp(dt K) (n x n, row-major)
+  std :: vector < double > shift; ///< Constant term of the step (n values)
+  bool ok;
+
+public:
+
+  /**
+  * @brief Precompute the propagator of a step
+  *
+  * @param K Rate matrix (n x n, row-major).
+  * @param b Constant source term (n values, nullptr for a linear system).
+  * @param n Number of variables.
+  * @param dt Interval of time.
+  *
+  */
+  exponential_propagator (const double * K, const double * b, const int32_t & n, const double & dt) : n(n), Phi(n * n), shift(n), ok(false)
+  {
+    const int32_t m = n + 1;
+    std :: vector < double > augmented(m * m, 0.), E(m * m);
+
+    for (int32_t i = 0; i < n; ++i)
+    {
+      for (int32_t j = 0; j < n; ++j)
+        augmented[i * m + j] = K[i * n + j];
+      augmented[i * m + n] = b ? b[i] : 0.;
+    }
+
+    this->ok = expm(augmented.data(), m, dt, E.data());
+
+    for (int32_t i = 0; i < n; ++i)
+    {
+      for (int32_t j = 0; j < n; ++j)
+        this->Phi[i * n + j] = E[i * m + j];
+      this->shift[i] = E[i * m + n];
+    }
+  }
+
+  /**
+  * @brief Check if the exponential was computed
+  *
+  */
+  bool valid () const { return this->ok; }
+
+  /**
+  * @brief Matrix of the step (n x n, row-major, meaningful only if valid)
+  *
+  */
+  const double * matrix () const { return this->Phi.data(); }
+
+  /**
+  * @brief Constant term of the step (n values)
+  *
+  */
+  const double * source () const { return this->shift.data(); }
+
+  /**
+  * @brief Advance a batch of states by one or more steps
+  *
+  * @param Y States (n planes of Nbatch values), updated in-place.
+  * @param Nbatch Number of states.
+  * @param steps Number of steps.
+  *
+  * @return False if the exponential was not computed (Y is unchanged).
+  *
+  */
+  bool apply (type * Y, const int64_t & Nbatch, const int64_t & steps = 1) const
+  {
+    if ( !this->ok )
+      return false;
+
+    PROFILE_SCOPE("exponential_propagator");
+    PROFILE_COUNT("exponential_propagator", Nbatch * steps);
+
+    constexpr int64_t block = 256;
+
+    const int32_t n = this->n;
+    const double * __restrict phi = this->Phi.data();
+    const double * __restrict c = this->shift.data();
+
+#ifdef _OPENMP
+    #pragma omp parallel
+#endif
+    {
+      // the states of a block stay in cache for all the steps
+      std :: vector < double > in(n * block), out(n * block);
+
+#ifdef _OPENMP
+      #pragma omp for schedule(static)
+#endif
+      for (int64_t j0 = 0; j0 < Nbatch; j0 += block)
+      {
+        const int64_t Nb = std :: min(block, Nbatch - j0);
+
+        for (int32_t i = 0; i < n; ++i)
+          std :: copy_n(Y + i * Nbatch + j0, Nb, in.data() + i * block);
+
+        for (int64_t step = 0; step < steps; ++step)
+        {
+          for (int32_t i = 0; i < n; ++i)
+          {
+            double * __restrict o = out.data() + i * block;
+
+            for (int64_t j = 0; j < Nb; ++j)
+              o[j] = c[i];
+
+            for (int32_t k = 0; k < n; ++k)
+            {
+              const double a = phi[i * n + k];
+              const double * __restrict x = in.data() + k * block;
+
+              for (int64_t j = 0; j < Nb; ++j)
+                o[j] += a * x[j];
+            }
+          }
+
+          std :: swap(in, out);
+        }
+
+        for (int32_t i = 0; i < n; ++i)
+          std :: copy_n(in.data() + i * block, Nb, Y + i * Nbatch + j0);
+      }
+    }
+
+    return true;
+  }
+};
+
+
+/**
+* @brief Exact propagator of the linearization of a kinetic model
+*
+* @details The model (see ode_models.hpp) is linearized around the
+* state y0: dy/dt ~ f(y0) + J (y - y0), i.e. K = J and
+* b = f(y0) - J y0. For a linear model (e.g. first_order_model)
+* the propagator is exact for any state.
+*
+* @param y0 State of the linearization.
+* @param params Parameters of the model.
+* @param dt Interval of time.
+*
+* @tparam model Model class (see decay_model).
+*
+* @return The propagator of a step dt.
+*
+*/
+template < class model >
+exponential_propagator < typename model :: value_type > linearized_propagator (const typename model :: value_type * y0,
+                                                                                const typename model :: value_type * params,
+                                                                                const double & dt)
+{
+  using type = typename model :: value_type;
+  constexpr int32_t n = model :: Nvar;
+
+  type f[n], Jy[n * n], Jp[n * model :: Npar];
+  model :: rhs(y0, params, f);
+  model :: jacobian(y0, params, Jy, Jp);
+
+  double K[n * n], b[n];
+  for (int32_t i = 0; i < n; ++i)
+  {
+    b[i] = f[i];
+    for (int32_t j = 0; j < n; ++j)
+    {
+      K[i * n + j] = Jy[i * n + j];
+      b[i] -= static_cast < double >(Jy[i * n + j]) * y0[j];
+    }
+  }
+
+  return exponential_propagator < type >(K, b, n, dt);
+}
+
+#endif // __matrix_exponential_hpp__
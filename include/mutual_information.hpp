@@ -0,0 +1,203 @@
+#ifndef __mutual_information_hpp__
+#define __mutual_information_hpp__
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <profiler.hpp>
+
+/**
+* @brief Quantize a series in equally spaced bins
+*
+* @details The bins span the [min, max] range of the whole
+* series (the maximum falls in the last bin).
+*
+* @param x Time series.
+* @param N Length of the series.
+* @param bins Number of bins (at most 65536).
+* @param q Output array of N bin indices.
+*
+* @tparam type Data-type of the series.
+*
+*/
+template < class type >
+void quantize (const type * x, const int64_t & N, const int32_t & bins, uint16_t * q)
+{
+  const auto range = std :: minmax_element(x, x + N);
+  const type xmin = *range.first;
+  const type width = (*range.second - xmin) / bins;
+  const type scale = width > type(0.) ? type(1.) / width : type(0.);
+  const int32_t last = bins - 1;
+
+#ifdef _OPENMP
+  #pragma omp parallel for simd
+#endif
+  for (int64_t i = 0; i < N; ++i)
+  {
+    const int32_t b = static_cast < int32_t >((x[i] - xmin) * scale);
+    q[i] = static_cast < uint16_t >(std :: min(b, last));
+  }
+}
+
+
+/**
+* @brief Average mutual information for all the lags
+*
+* @details The series is quantized once and the joint histograms
+* of (x[i], x[i + tau]) for tau = 1, ..., max_lag are filled in a
+* single sweep: the quantized series is processed in blocks small
+* enough to stay in cache, and for each block the lags are split
+* among the threads, so every thread owns the histograms of its
+* lags (no atomic updates or reductions). Each thread fills the
+* histograms of 4 consecutive lags in the same loop, which hides
+* the latency of the repeated increments of the same bin.
+* The mutual information of each lag is evaluated on its joint
+* histogram (natural logarithm, as sklearn mutual_info_score on
+* the contingency table), with the marginals given by the row and
+* column sums.
+*
+* @note The bins are computed on the range of the whole series,
+* while np.histogram2d uses the range of each lagged copy, so the
+* values differ slightly from py/mutual_info.py.
+*
+* @param x Time series.
+* @param N Length of the series.
+* @param max_lag Maximum lag.
+* @param bins Number of bins of each axis.
+* @param mi Output array of max_lag values (mi[tau - 1] is the value of lag tau).
+*
+* @tparam type Data-type of the series.
+*
+* @return The lag of the first minimum of the mutual information (0 if none).
+*
+*/
+template < class type >
+int32_t average_mutual_information (const type * x, const int64_t & N,
+                                    const int32_t & max_lag, const int32_t & bins,
+                                    type * mi)
+{
+  PROFILE_SCOPE("average_mutual_information");
+  PROFILE_COUNT("average_mutual_information", N * max_lag);
+
+  const int64_t block = 16384;
+  const int32_t lanes = 4;
+  const int32_t Ngroups = (max_lag + lanes - 1) / lanes;
+  const int64_t hsize = static_cast < int64_t >(bins) * bins;
+
+  std :: vector < uint16_t > q(N);
+  quantize(x, N, bins, q.data());
+
+  std :: vector < uint32_t > histogram(hsize * max_lag, 0u);
+
+  const uint16_t * qs = q.data();
+  uint32_t * hist = histogram.data();
+
+#ifdef _OPENMP
+  #pragma omp parallel
+#endif
+  {
+    for (int64_t start = 0; start < N - 1; start += block)
+    {
+#ifdef _OPENMP
+      #pragma omp for schedule(static)
+#endif
+      for (int32_t group = 0; group < Ngroups; ++group)
+      {
+        const int32_t tau = group * lanes + 1;
+
+        if (tau + lanes - 1 <= max_lag)
+        {
+          // consecutive samples of a smooth series hit the same bin, so
+          // the increments of a single histogram are a dependency chain:
+          // the lags of the group fill independent histograms in the same loop
+          uint32_t * h0 = hist + (tau - 1) * hsize;
+          uint32_t * h1 = h0 + hsize;
+          uint32_t * h2 = h1 + hsize;
+          uint32_t * h3 = h2 + hsize;
+
+          const int64_t stop = std :: min(start + block, N - tau - lanes + 1);
+
+          for (int64_t i = start; i < stop; ++i)
+          {
+            const int64_t row = static_cast < int64_t >(qs[i]) * bins;
+            ++h0[row + qs[i + tau]];
+            ++h1[row + qs[i + tau + 1]];
+            ++h2[row + qs[i + tau + 2]];
+            ++h3[row + qs[i + tau + 3]];
+          }
+
+          // tails of the longer lags
+          for (int32_t l = 0; l < lanes; ++l)
+          {
+            uint32_t * h = h0 + l * hsize;
+            const int64_t tail = std :: min(start + block, N - tau - l);
+
+            for (int64_t i = std :: max(stop, start); i < tail; ++i)
+              ++h[static_cast < int64_t >(qs[i]) * bins + qs[i + tau + l]];
+          }
+        }
+        else
+        {
+          for (int32_t t = tau; t <= max_lag; ++t)
+          {
+            uint32_t * h = hist + (t - 1) * hsize;
+            const int64_t stop = std :: min(start + block, N - t);
+
+            for (int64_t i = start; i < stop; ++i)
+              ++h[static_cast < int64_t >(qs[i]) * bins + qs[i + t]];
+          }
+        }
+      }
+    }
+  }
+
+  // mutual information of each lag from its contingency table
+#ifdef _OPENMP
+  #pragma omp parallel for
+#endif
+  for (int32_t tau = 1; tau <= max_lag; ++tau)
+  {
+    const uint32_t * h = hist + (tau - 1) * hsize;
+
+    std :: vector < double > row(bins, 0.);
+    std :: vector < double > col(bins, 0.);
+
+    for (int32_t a = 0; a < bins; ++a)
+    {
+      const uint32_t * ha = h + static_cast < int64_t >(a) * bins;
+
+      for (int32_t b = 0; b < bins; ++b)
+      {
+        row[a] += ha[b];
+        col[b] += ha[b];
+      }
+    }
+
+    const double total = static_cast < double >(N - tau);
+    double info = 0.;
+
+    for (int32_t a = 0; a < bins; ++a)
+    {
+      const uint32_t * ha = h + static_cast < int64_t >(a) * bins;
+
+      for (int32_t b = 0; b < bins; ++b)
+      {
+        const double n = ha[b];
+        if (n > 0.)
+          info += n / total * std :: log(n * total / (row[a] * col[b]));
+      }
+    }
+
+    mi[tau - 1] = static_cast < type >(info);
+  }
+
+  for (int32_t tau = 1; tau < max_lag; ++tau)
+    if (mi[tau] > mi[tau - 1])
+      return tau;
+
+  return 0;
+}
+
+#endif // __mutual_information_hpp__
@@ -0,0 +1,388 @@
+#ifndef __ode_models_hpp__
+#define __ode_models_hpp__
+
+#include <array>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <profiler.hpp>
+
+/**
+* @brief Kinetic models with analytic Jacobians
+*
+* @details Each model is a stateless class with the number of
+* variables (Nvar) and parameters (Npar) as compile-time constants,
+* the right-hand side of the equations and its Jacobians with
+* respect to the variables (Jy, Nvar x Nvar) and to the parameters
+* (Jp, Nvar x Npar), both row-major.
+* The equations are the same integrated by the kernels in kinetics.hpp
+* and brusselator.hpp, so the engines built on the models (fit,
+* sensitivity, continuation, ...) share a single definition.
+*
+*/
+
+
+/**
+* @brief Exponential decay (py/fit_model.py)
+*
+* @details dy/dt = -alpha y
+*
+* Parameters: (alpha)
+*
+*/
+template < class type >
+struct decay_model
+{
+  using value_type = type;
+
+  static constexpr int32_t Nvar = 1;
+  static constexpr int32_t Npar = 1;
+
+  static void rhs (const type * y, const type * p, type * dy)
+  {
+    dy[0] = -p[0] * y[0];
+  }
+
+  static void jacobian (const type * y, const type * p, type * Jy, type * Jp)
+  {
+    Jy[0] = -p[0];
+    Jp[0] = -y[0];
+  }
+};
+
+
+/**
+* @brief 1st order reversible kinetic
+*
+* @details dP/dt =  kf R - kb P
+*          dR/dt = -kf R + kb P
+*
+* Variables: (P, R), parameters: (kf, kb)
+*
+*/
+template < class type >
+struct first_order_model
+{
+  using value_type = type;
+
+  static constexpr int32_t Nvar = 2;
+  static constexpr int32_t Npar = 2;
+
+  static void rhs (const type * y, const type * p, type * dy)
+  {
+    const type flux = p[0] * y[1] - p[1] * y[0];
+    dy[0] =  flux;
+    dy[1] = -flux;
+  }
+
+  static void jacobian (const type * y, const type * p, type * Jy, type * Jp)
+  {
+    Jy[0] = -p[1]; Jy[1] =  p[0];
+    Jy[2] =  p[1]; Jy[3] = -p[0];
+
+    Jp[0] =  y[1]; Jp[1] = -y[0];
+    Jp[2] = -y[1]; Jp[3] =  y[0];
+  }
+};
+
+
+/**
+* @brief Michaelis Menten kinetic
+*
+* @details dS/dt  = -kf S E + kb ES
+*          dE/dt  = -kf S E + (kb + kc) ES
+*          dES/dt =  kf S E - (kb + kc) ES
+*          dP/dt  =  kc ES
+*
+* Variables: (S, E, ES, P), parameters: (kf, kb, kc)
+*
+*/
+template < class type >
+struct michaelis_menten_model
+{
+  using value_type = type;
+
+  static constexpr int32_t Nvar = 4;
+  static constexpr int32_t Npar = 3;
+
+  static void rhs (const type * y, const type * p, type * dy)
+  {
+    const type bind = p[0] * y[0] * y[1];
+    dy[0] = -bind + p[1] * y[2];
+    dy[1] = -bind + (p[1] + p[2]) * y[2];
+    dy[2] =  bind - (p[1] + p[2]) * y[2];
+    dy[3] =  p[2] * y[2];
+  }
+
+  static void jacobian (const type * y, const type * p, type * Jy, type * Jp)
+  {
+    const type kE = p[0] * y[1];
+    const type kS = p[0] * y[0];
+    const type kbc = p[1] + p[2];
+    const type SE = y[0] * y[1];
+
+    Jy[ 0] = -kE; Jy[ 1] = -kS; Jy[ 2] =  p[1]; Jy[ 3] = type(0.);
+    Jy[ 4] = -kE; Jy[ 5] = -kS; Jy[ 6] =  kbc;  Jy[ 7] = type(0.);
+    Jy[ 8] =  kE; Jy[ 9] =  kS; Jy[10] = -kbc;  Jy[11] = type(0.);
+    Jy[12] = type(0.); Jy[13] = type(0.); Jy[14] = p[2]; Jy[15] = type(0.);
+
+    Jp[ 0] = -SE; Jp[ 1] =  y[2]; Jp[ 2] = type(0.);
+    Jp[ 3] = -SE; Jp[ 4] =  y[2]; Jp[ 5] =  y[2];
+    Jp[ 6] =  SE; Jp[ 7] = -y[2]; Jp[ 8] = -y[2];
+    Jp[ 9] = type(0.); Jp[10] = type(0.); Jp[11] = y[2];
+  }
+};
+
+
+/**
+* @brief Brusselator kinetic
+*
+* @details dx/dt = A + x^2 y - B x - x
+*          dy/dt = B x - x^2 y
+*
+* Variables: (x, y), parameters: (A, B)
+*
+*/
+template < class type >
+struct brusselator_model
+{
+  using value_type = type;
+
+  static constexpr int32_t Nvar = 2;
+  static constexpr int32_t Npar = 2;
+
+  static void rhs (const type * y, const type * p, type * dy)
+  {
+    const type x2y = y[0] * y[0] * y[1];
+    dy[0] = p[0] + x2y - p[1] * y[0] - y[0];
+    dy[1] = p[1] * y[0] - x2y;
+  }
+
+  static void jacobian (const type * y, const type * p, type * Jy, type * Jp)
+  {
+    const type xy2 = type(2.) * y[0] * y[1];
+    const type x2 = y[0] * y[0];
+
+    Jy[0] = xy2 - p[1] - type(1.); Jy[1] =  x2;
+    Jy[2] = p[1] - xy2;            Jy[3] = -x2;
+
+    Jp[0] = type(1.); Jp[1] = -y[0];
+    Jp[2] = type(0.); Jp[3] =  y[0];
+  }
+};
+
+
+/**
+* @brief Genetic toggle switch (py/toggle_switch.py)
+*
+* @details dx/dt = ax / (1 + y^bx) - x
+*          dy/dt = ay / (1 + x^by) - y
+*
+* Variables: (x, y), parameters: (ax, ay, bx, by)
+*
+* @note The variables are concentrations, so they must be non-negative.
+*
+*/
+template < class type >
+struct toggle_switch_model
+{
+  using value_type = type;
+
+  static constexpr int32_t Nvar = 2;
+  static constexpr int32_t Npar = 4;
+
+  /**
+  * @brief Hill power x^b
+  *
+  * @details The Hill coefficients are usually small integers, which
+  * are evaluated by products (std :: pow costs tens of ns).
+  *
+  */
+  static type power (const type & x, const type & b)
+  {
+    const int32_t n = static_cast < int32_t >(b);
+
+    if (type(n) != b || n < 0 || n > 8)
+      return std :: pow(x, b);
+
+    type r = type(1.);
+    for (int32_t i = 0; i < n; ++i)
+      r *= x;
+    return r;
+  }
+
+  static void rhs (const type * y, const type * p, type * dy)
+  {
+    dy[0] = p[0] / (type(1.) + power(y[1], p[2])) - y[0];
+    dy[1] = p[1] / (type(1.) + power(y[0], p[3])) - y[1];
+  }
+
+  static void jacobian (const type * y, const type * p, type * Jy, type * Jp)
+  {
+    const type yb = power(y[1], p[2]);
+    const type xb = power(y[0], p[3]);
+    const type hx = type(1.) / (type(1.) + yb);
+    const type hy = type(1.) / (type(1.) + xb);
+
+    // d(y^b)/dy = b y^(b - 1), d(y^b)/db = y^b log(y) (both zero at y = 0)
+    const type dyb = y[1] > type(0.) ? p[2] * yb / y[1] : type(0.);
+    const type dxb = y[0] > type(0.) ? p[3] * xb / y[0] : type(0.);
+    const type lyb = y[1] > type(0.) ? yb * std :: log(y[1]) : type(0.);
+    const type lxb = y[0] > type(0.) ? xb * std :: log(y[0]) : type(0.);
+
+    Jy[0] = type(-1.);                 Jy[1] = -p[0] * dyb * hx * hx;
+    Jy[2] = -p[1] * dxb * hy * hy;     Jy[3] = type(-1.);
+
+    Jp[0] = hx;       Jp[1] = type(0.); Jp[2] = -p[0] * lyb * hx * hx; Jp[3] = type(0.);
+    Jp[4] = type(0.); Jp[5] = hy;       Jp[6] = type(0.);              Jp[7] = -p[1] * lxb * hy * hy;
+  }
+};
+
+
+/**
+* @brief Lorenz system (py/lorentz_attractor.py)
+*
+* @details dx/dt = sigma (y - x)
+*          dy/dt = -x z + r x - y
+*          dz/dt = -b z + x y
+*
+* Variables: (x, y, z), parameters: (sigma, r, b)
+*
+*/
+template < class type >
+struct lorenz_model
+{
+  using value_type = type;
+
+  static constexpr int32_t Nvar = 3;
+  static constexpr int32_t Npar = 3;
+
+  static void rhs (const type * y, const type * p, type * dy)
+  {
+    dy[0] = p[0] * (y[1] - y[0]);
+    dy[1] = -y[0] * y[2] + p[1] * y[0] - y[1];
+    dy[2] = -p[2] * y[2] + y[0] * y[1];
+  }
+
+  static void jacobian (const type * y, const type * p, type * Jy, type * Jp)
+  {
+    Jy[0] = -p[0];        Jy[1] = p[0];     Jy[2] = type(0.);
+    Jy[3] = p[1] - y[2];  Jy[4] = type(-1.); Jy[5] = -y[0];
+    Jy[6] = y[1];         Jy[7] = y[0];     Jy[8] = -p[2];
+
+    Jp[0] = y[1] - y[0]; Jp[1] = type(0.); Jp[2] = type(0.);
+    Jp[3] = type(0.);    Jp[4] = y[0];     Jp[5] = type(0.);
+    Jp[6] = type(0.);    Jp[7] = type(0.); Jp[8] = -y[2];
+  }
+};
+
+
+/**
+* @brief RK4 integration of a model and of its forward sensitivities
+*
+* @details The state is augmented with the sensitivities
+* S = dy/dp (Nvar x Npar, row-major), which follow the variational
+* equations dS/dt = Jy S + Jp, with S(0) = 0 (the initial
+* condition does not depend on the parameters). The RHS and the
+* Jacobians are evaluated once per stage and shared by the state
+* and the sensitivities.
+* The observer is called at the initial condition and after every
+* substeps integration steps, as observer(k, y, S) with k = 0, ..., Nobs - 1,
+* so the trajectory is never stored (the memory does not depend on Nobs).
+*
+* @param y0 Initial condition (Nvar values).
+* @param p Parameters (Npar values).
+* @param dt Integration step.
+* @param substeps Number of integration steps between two observations.
+* @param Nobs Number of observations.
+* @param observer Functor called at each observation.
+* @param sensitivity Switch on/off the integration of the sensitivities
+* (if false S is not updated and it stays zero).
+*
+* @tparam model Model class (see decay_model).
+* @tparam Observer Functor type.
+*
+*/
+template < class model, class Observer >
+void rk4_sensitivity (const typename model :: value_type * y0,
+                      const typename model :: value_type * p,
+                      const typename model :: value_type & dt,
+                      const int32_t & substeps, const int64_t & Nobs,
+                      Observer observer, const bool & sensitivity = true)
+{
+  using type = typename model :: value_type;
+
+  constexpr int32_t Nvar = model :: Nvar;
+  constexpr int32_t Npar = model :: Npar;
+  constexpr int32_t Nsens = Nvar * Npar;
+
+  PROFILE_SCOPE("rk4_sensitivity");
+  PROFILE_COUNT("rk4_sensitivity", Nobs > 1 ? (Nobs - 1) * substeps : 0);
+
+  std :: array < type, Nvar > y;
+  std :: array < type, Nsens > S;
+  std :: copy_n(y0, Nvar, y.begin());
+  S.fill(type(0.));
+
+  // stage derivatives and stage states
+  std :: array < std :: array < type, Nvar >, 4 > ky;
+  std :: array < std :: array < type, Nsens >, 4 > kS;
+  std :: array < type, Nvar > ys;
+  std :: array < type, Nsens > Ss;
+  std :: array < type, Nvar * Nvar > Jy;
+  std :: array < type, Nsens > Jp;
+  Ss.fill(type(0.)); // passed (and not read) also without the sensitivities
+
+  auto derivative = [&](const type * yy, const type * SS, type * dy, type * dS)
+                    {
+                      model :: rhs(yy, p, dy);
+
+                      if ( !sensitivity )
+                        return;
+
+                      model :: jacobian(yy, p, Jy.data(), Jp.data());
+
+                      for (int32_t i = 0; i < Nvar; ++i)
+                        for (int32_t j = 0; j < Npar; ++j)
+                        {
+                          type s = Jp[i * Npar + j];
+                          for (int32_t k = 0; k < Nvar; ++k)
+                            s += Jy[i * Nvar + k] * SS[k * Npar + j];
+                          dS[i * Npar + j] = s;
+                        }
+                    };
+
+  const std :: array < type, 4 > stage = {{type(0.), type(.5) * dt, type(.5) * dt, dt}};
+
+  observer(int64_t(0), y.data(), S.data());
+
+  for (int64_t n = 1; n < Nobs; ++n)
+  {
+    for (int32_t step = 0; step < substeps; ++step)
+    {
+      for (int32_t s = 0; s < 4; ++s)
+      {
+        for (int32_t i = 0; i < Nvar; ++i)
+          ys[i] = s ? y[i] + stage[s] * ky[s - 1][i] : y[i];
+
+        if (sensitivity)
+          for (int32_t i = 0; i < Nsens; ++i)
+            Ss[i] = s ? S[i] + stage[s] * kS[s - 1][i] : S[i];
+
+        derivative(ys.data(), Ss.data(), ky[s].data(), kS[s].data());
+      }
+
+      for (int32_t i = 0; i < Nvar; ++i)
+        y[i] += dt * type(1. / 6.) * (ky[0][i] + type(2.) * ky[1][i] + type(2.) * ky[2][i] + ky[3][i]);
+
+      if (sensitivity)
+        for (int32_t i = 0; i < Nsens; ++i)
+          S[i] += dt * type(1. / 6.) * (kS[0][i] + type(2.) * kS[1][i] + type(2.) * kS[2][i] + kS[3][i]);
+    }
+
+    observer(n, y.data(), S.data());
+  }
+}
+
+#endif // __ode_models_hpp__
@@ -0,0 +1,370 @@
+#ifndef __parameter_estimation_hpp__
+#define __parameter_estimation_hpp__
+
+#include <array>
+#include <vector>
+#include <random>
+#include <limits>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <ode_models.hpp>
+#include <profiler.hpp>
+
+/**
+* @brief Result of a model fit
+*
+* @tparam model Model class (see ode_models.hpp).
+*
+*/
+template < class model >
+struct fit_result
+{
+  using type = typename model :: value_type;
+
+  std :: array < type, model :: Npar > params;                     ///< Best-fit parameters
+  std :: array < type, model :: Npar * model :: Npar > covariance; ///< Covariance of the parameters (as scipy curve_fit)
+
+  type cost;          ///< Half sum of the squared residuals
+  int64_t residuals;  ///< Number of residuals (observed values)
+  int32_t iterations; ///< Number of iterations
+  bool converged;     ///< The relative decrease of the cost (or the step) dropped below the tolerance
+};
+
+
+/**
+* @brief Solve a symmetric positive definite system by Cholesky decomposition
+*
+* @param A Matrix (n x n, row-major), overwritten by the decomposition.
+* @param b Right-hand side, overwritten by the solution.
+* @param n Size of the system.
+*
+* @tparam type Data-type of arrays
+*
+* @return False if the matrix is not positive definite.
+*
+*/
+template < class type >
+bool cholesky_solve (type * A, type * b, const int32_t & n)
+{
+  for (int32_t j = 0; j < n; ++j)
+  {
+    type d = A[j * n + j];
+    for (int32_t k = 0; k < j; ++k)
+      d -= A[j * n + k] * A[j * n + k];
+
+    if ( !(d > type(0.)) )
+      return false;
+
+    d = std :: sqrt(d);
+    A[j * n + j] = d;
+
+    for (int32_t i = j + 1; i < n; ++i)
+    {
+      type s = A[i * n + j];
+      for (int32_t k = 0; k < j; ++k)
+        s -= A[i * n + k] * A[j * n + k];
+      A[i * n + j] = s / d;
+    }
+  }
+
+  // forward (L z = b) and backward (L^T x = z) substitutions
+  for (int32_t i = 0; i < n; ++i)
+  {
+    for (int32_t k = 0; k < i; ++k)
+      b[i] -= A[i * n + k] * b[k];
+    b[i] /= A[i * n + i];
+  }
+
+  for (int32_t i = n - 1; i >= 0; --i)
+  {
+    for (int32_t k = i + 1; k < n; ++k)
+      b[i] -= A[k * n + i] * b[k];
+    b[i] /= A[i * n + i];
+  }
+
+  return true;
+}
+
+
+/**
+* @brief Fit the parameters of a kinetic model by Levenberg-Marquardt
+*
+* @details The residuals are the differences between the model
+* (integrated by RK4, see rk4_sensitivity) and the observations,
+* and their gradients are given by the forward sensitivities
+* integrated with the state (no finite differences), so each
+* iteration costs a single integration (the trial point is
+* integrated with its sensitivities, which are kept if the step
+* is accepted). The normal equations
+* J^T J and J^T r are accumulated during the integration, so the
+* memory does not depend on the number of observations.
+* The fit works on the logarithm of the parameters, which keeps
+* the rate constants positive and balances parameters of different
+* orders of magnitude; the covariance is given for the parameters
+* as s^2 (J^T J)^-1 with s^2 = 2 cost / (residuals - Npar) (as scipy curve_fit).
+*
+* @param y0 Initial condition (Nvar values).
+* @param obs Observations (Nobs x Nvar, row-major): obs[k * Nvar + i] is the
+* value of the i-th variable at time k * substeps * dt; the NaN values
+* are missing observations (e.g. variables not measured).
+* @param Nobs Number of observations.
+* @param dt Integration step.
+* @param substeps Number of integration steps between two observations.
+* @param p0 Initial guess of the parameters (Npar positive values).
+* @param max_iter Maximum number of iterations.
+* @param tol Tolerance on the relative decrease of the cost and on the step.
+*
+* @tparam model Model class (see ode_models.hpp).
+*
+* @return The fit result.
+*
+*/
+template < class model >
+fit_result < model > levenberg_marquardt (const typename model :: value_type * y0,
+                                          const typename model :: value_type * obs,
+                                          const int64_t & Nobs,
+                                          const typename model :: value_type & dt,
+                                          const int32_t & substeps,
+                                          const typename model :: value_type * p0,
+                                          const int32_t & max_iter = 100,
+                                          const typename model :: value_type & tol = 1e-10)
+{
+  using type = typename model :: value_type;
+
+  constexpr int32_t Nvar = model :: Nvar;
+  constexpr int32_t Npar = model :: Npar;
+
+  PROFILE_SCOPE("levenberg_marquardt");
+
+  std :: array < type, Npar > logp;
+  std :: array < type, Npar > p;
+  std :: array < type, Npar * Npar > JtJ;
+  std :: array < type, Npar > Jtr;
+
+  // cost and normal equations in the log-parameters
+  auto evaluate = [&](const std :: array < type, Npar > & q, std :: array < type, Npar * Npar > & jtj,
+                      std :: array < type, Npar > & jtr, int64_t & count)
+                  {
+                    std :: array < type, Npar > par;
+                    for (int32_t j = 0; j < Npar; ++j)
+                      par[j] = std :: exp(q[j]);
+
+                    type cost = type(0.);
+                    count = 0;
+
+                    jtj.fill(type(0.));
+                    jtr.fill(type(0.));
+
+                    rk4_sensitivity < model >(y0, par.data(), dt, substeps, Nobs,
+                                              [&](const int64_t & k, const type * y, const type * S)
+                                              {
+                                                for (int32_t i = 0; i < Nvar; ++i)
+                                                {
+                                                  const type o = obs[k * Nvar + i];
+
+                                                  if (std :: isnan(o))
+                                                    continue;
+
+                                                  const type r = y[i] - o;
+                                                  cost += r * r;
+                                                  ++count;
+
+                                                  // d y / d log p = S * p
+                                                  std :: array < type, Npar > g;
+                                                  for (int32_t j = 0; j < Npar; ++j)
+                                                    g[j] = S[i * Npar + j] * par[j];
+
+                                                  for (int32_t a = 0; a < Npar; ++a)
+                                                  {
+                                                    jtr[a] += g[a] * r;
+                                                    for (int32_t b = 0; b < Npar; ++b)
+                                                      jtj[a * Npar + b] += g[a] * g[b];
+                                                  }
+                                                }
+                                              }, true);
+
+                    cost *= type(.5);
+                    return std :: isfinite(cost) ? cost : std :: numeric_limits < type > :: infinity();
+                  };
+
+  fit_result < model > result;
+
+  for (int32_t j = 0; j < Npar; ++j)
+    logp[j] = std :: log(p0[j]);
+
+  int64_t count = 0;
+  type cost = evaluate(logp, JtJ, Jtr, count);
+  type lambda = type(1e-3);
+
+  result.converged = false;
+  result.iterations = 0;
+
+  for (int32_t iter = 0; iter < max_iter && std :: isfinite(cost); ++iter)
+  {
+    result.iterations = iter + 1;
+
+    // damped normal equations (Marquardt scaling)
+    std :: array < type, Npar * Npar > A = JtJ;
+    std :: array < type, Npar > step;
+
+    for (int32_t j = 0; j < Npar; ++j)
+    {
+      A[j * Npar + j] += lambda * std :: max(JtJ[j * Npar + j], std :: numeric_limits < type > :: min());
+      step[j] = -Jtr[j];
+    }
+
+    if ( !cholesky_solve(A.data(), step.data(), Npar) )
+    {
+      lambda *= type(10.);
+      continue;
+    }
+
+    std :: array < type, Npar > trial;
+    type norm = type(0.);
+    for (int32_t j = 0; j < Npar; ++j)
+    {
+      trial[j] = logp[j] + step[j];
+      norm += step[j] * step[j];
+    }
+
+    std :: array < type, Npar * Npar > trial_JtJ;
+    std :: array < type, Npar > trial_Jtr;
+    int64_t trial_count = 0;
+    const type trial_cost = evaluate(trial, trial_JtJ, trial_Jtr, trial_count);
+
+    if (trial_cost < cost)
+    {
+      const type decrease = (cost - trial_cost) / std :: max(cost, std :: numeric_limits < type > :: min());
+
+      logp = trial;
+      cost = trial_cost;
+      count = trial_count;
+      JtJ = trial_JtJ;
+      Jtr = trial_Jtr;
+      lambda = std :: max(lambda * type(.1), type(1e-12));
+
+      if (decrease < tol || std :: sqrt(norm) < tol)
+      {
+        result.converged = true;
+        break;
+      }
+    }
+    else
+    {
+      lambda *= type(10.);
+
+      // the damping blew up without a descent step: the fit stalled
+      if (lambda > type(1e12))
+        break;
+    }
+  }
+
+  for (int32_t j = 0; j < Npar; ++j)
+    p[j] = std :: exp(logp[j]);
+
+  result.params = p;
+  result.cost = cost;
+  result.residuals = count;
+
+  // covariance of the log-parameters s^2 (J^T J)^-1 (column by column)
+  // and propagation to the parameters: cov(p_a, p_b) = p_a p_b cov(log p_a, log p_b)
+  const type s2 = count > Npar ? type(2.) * cost / (count - Npar) : std :: numeric_limits < type > :: infinity();
+
+  for (int32_t b = 0; b < Npar; ++b)
+  {
+    std :: array < type, Npar * Npar > A = JtJ;
+    std :: array < type, Npar > column;
+    column.fill(type(0.));
+    column[b] = type(1.);
+
+    const bool ok = cholesky_solve(A.data(), column.data(), Npar);
+
+    for (int32_t a = 0; a < Npar; ++a)
+      result.covariance[a * Npar + b] = ok ? s2 * column[a] * p[a] * p[b] : std :: numeric_limits < type > :: infinity();
+  }
+
+  return result;
+}
+
+
+/**
+* @brief Multi-start fit of a kinetic model
+*
+* @details The starting points are drawn log-uniformly in the
+* [lower, upper] box of each parameter and every start runs an
+* independent levenberg_marquardt fit. The starts are spread
+* across the threads (dynamic schedule, since the fits converge
+* in a different number of iterations) and the random generator
+* of each start is seeded by its index, so the result does not
+* depend on the number of threads.
+*
+* @param y0 Initial condition (Nvar values).
+* @param obs Observations (Nobs x Nvar, row-major, NaN for missing values).
+* @param Nobs Number of observations.
+* @param dt Integration step.
+* @param substeps Number of integration steps between two observations.
+* @param lower Lower bounds of the starting points (Npar positive values).
+* @param upper Upper bounds of the starting points (Npar positive values).
+* @param starts Number of starts (values lower than 1 run a single start).
+* @param seed Random seed.
+* @param max_iter Maximum number of iterations of each fit.
+* @param tol Tolerance of each fit.
+*
+* @tparam model Model class (see ode_models.hpp).
+*
+* @return The fit with the lowest cost.
+*
+*/
+template < class model >
+fit_result < model > multistart_fit (const typename model :: value_type * y0,
+                                     const typename model :: value_type * obs,
+                                     const int64_t & Nobs,
+                                     const typename model :: value_type & dt,
+                                     const int32_t & substeps,
+                                     const typename model :: value_type * lower,
+                                     const typename model :: value_type * upper,
+                                     const int32_t & starts,
+                                     const uint32_t & seed = 42u,
+                                     const int32_t & max_iter = 100,
+                                     const typename model :: value_type & tol = 1e-10)
+{
+  using type = typename model :: value_type;
+
+  constexpr int32_t Npar = model :: Npar;
+
+  PROFILE_SCOPE("multistart_fit");
+  const int32_t Nstarts = std :: max(starts, 1);
+
+  PROFILE_COUNT("multistart_fit", Nstarts);
+
+  std :: vector < fit_result < model > > fits(Nstarts);
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic, 1)
+#endif
+  for (int32_t s = 0; s < Nstarts; ++s)
+  {
+    std :: mt19937 engine(seed + static_cast < uint32_t >(s));
+    std :: uniform_real_distribution < type > uniform(type(0.), type(1.));
+
+    std :: array < type, Npar > p0;
+    for (int32_t j = 0; j < Npar; ++j)
+    {
+      const type lo = std :: log(lower[j]);
+      const type hi = std :: log(upper[j]);
+      p0[j] = std :: exp(lo + (hi - lo) * uniform(engine));
+    }
+
+    fits[s] = levenberg_marquardt < model >(y0, obs, Nobs, dt, substeps, p0.data(), max_iter, tol);
+  }
+
+  return *std :: min_element(fits.begin(), fits.end(),
+                             [](const fit_result < model > & a, const fit_result < model > & b)
+                             {
+                               return a.cost < b.cost;
+                             });
+}
+
+#endif // __parameter_estimation_hpp__
@@ -0,0 +1,409 @@
+#ifndef __profiler_hpp__
+#define __profiler_hpp__
+
+#include <iostream>
+#include <iomanip>
+#include <string>
+#include <deque>
+#include <mutex>
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdint>
+
+#if defined(PROFILE) && defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cstring>
+#endif
+
+/**
+* @brief Hot-path instrumentation
+*
+* @details Scoped timers, event/step counters and (optional)
+* hardware counters. All the instrumentation is accessed by the
+* PROFILE_* macros, which expand to nothing unless the PROFILE
+* macro is defined (cmake -DPROFILE=ON), so the kernels pay no
+* cost in the default build.
+*
+* Each entry is registered once (function-local static reference)
+* and updated with relaxed atomic operations, so the macros can
+* be used inside OpenMP regions. The counters should be updated
+* with the total work of a call (e.g. rows * cols stencil updates)
+* rather than once per inner iteration.
+*
+*/
+namespace profiler
+{
+
+static constexpr int32_t NUM_HW = 4; ///< Number of hardware counters
+
+/**
+* @brief Name of the hardware counters
+*
+*/
+inline const std :: array < const char *, NUM_HW > & hw_names ()
+{
+  static const std :: array < const char *, NUM_HW > names = {{"cycles", "instructions", "cache_misses", "branch_misses"}};
+  return names;
+}
+
+/**
+* @brief Instrumentation entry
+*
+* @details A timer (number of calls and total time) and a
+* counter share the same entry, so the report can show both
+* the time and the work done in a phase.
+*
+*/
+struct entry
+{
+  std :: string name;
+
+  std :: atomic < int64_t > calls;
+  std :: atomic < int64_t > ns;
+  std :: atomic < int64_t > count;
+
+  std :: array < std :: atomic < int64_t >, NUM_HW > hw;
+
+  entry (const std :: string & name) : name(name), calls(0), ns(0), count(0)
+  {
+    for (auto & h : this->hw)
+      h = 0;
+  }
+};
+
+/**
+* @brief Registry of the instrumentation entries
+*
+* @details The entries are stored in a deque, so their
+* address is stable and the macros can keep a reference to them.
+*
+*/
+class registry
+{
+  std :: deque < entry > entries;
+  std :: mutex mtx;
+
+public:
+
+  std :: atomic < bool > hardware; ///< Switch on/off the hardware counters
+
+  /**
+  * @brief Constructor
+  *
+  * @details The hardware counters are switched on by the
+  * PROFILE_HARDWARE environment variable (or PROFILE_HARDWARE(true)).
+  *
+  */
+  registry () : hardware(std :: getenv("PROFILE_HARDWARE") != nullptr)
+  {
+  }
+
+  static registry & instance ()
+  {
+    static registry reg;
+    return reg;
+  }
+
+  /**
+  * @brief Get (or create) the entry with the given name
+  *
+  */
+  entry & get (const std :: string & name)
+  {
+    std :: lock_guard < std :: mutex > lock(this->mtx);
+
+    auto it = std :: find_if(this->entries.begin(), this->entries.end(),
+                             [&](const entry & e)
+                             {
+                               return e.name == name;
+                             });
+
+    if (it != this->entries.end())
+      return *it;
+
+    this->entries.emplace_back(name);
+    return this->entries.back();
+  }
+
+  /**
+  * @brief Reset all the entries
+  *
+  */
+  void reset ()
+  {
+    std :: lock_guard < std :: mutex > lock(this->mtx);
+
+    for (auto & e : this->entries)
+    {
+      e.calls = 0;
+      e.ns = 0;
+      e.count = 0;
+      for (auto & h : e.hw)
+        h = 0;
+    }
+  }
+
+  /**
+  * @brief Dump the entries as JSON (format = "json") or as a text table
+  *
+  */
+  void report (std :: ostream & os, const std :: string & format = "text")
+  {
+    std :: lock_guard < std :: mutex > lock(this->mtx);
+
+    const bool hw = this->hardware;
+
+    if (format == "json")
+    {
+      os << "[" << std :: endl;
+
+      for (std :: size_t i = 0; i < this->entries.size(); ++i)
+      {
+        const entry & e = this->entries[i];
+
+        os << "  {\"name\": \"" << e.name << "\", "
+           << "\"calls\": " << e.calls << ", "
+           << "\"total_ns\": " << e.ns << ", "
+           << "\"count\": " << e.count;
+
+        if (hw)
+          for (int32_t h = 0; h < NUM_HW; ++h)
+            os << ", \"" << hw_names()[h] << "\": " << e.hw[h];
+
+        os << "}" << (i + 1 < this->entries.size() ? "," : "") << std :: endl;
+      }
+
+      os << "]" << std :: endl;
+      return;
+    }
+
+    os << std :: left << std :: setw(32) << "name"
+       << std :: right << std :: setw(12) << "calls"
+       << std :: setw(16) << "total [ms]"
+       << std :: setw(16) << "count"
+       << std :: setw(16) << "ns/count";
+    if (hw)
+      for (const auto & name : hw_names())
+        os << std :: setw(16) << name;
+    os << std :: endl;
+
+    for (const auto & e : this->entries)
+    {
+      const int64_t count = e.count;
+
+      os << std :: left << std :: setw(32) << e.name
+         << std :: right << std :: setw(12) << e.calls
+         << std :: setw(16) << std :: fixed << std :: setprecision(3) << e.ns * 1e-6
+         << std :: setw(16) << count
+         << std :: setw(16) << std :: setprecision(3) << (count ? static_cast < double >(e.ns) / count : 0.);
+      if (hw)
+        for (const auto & h : e.hw)
+          os << std :: setw(16) << h;
+      os << std :: defaultfloat << std :: endl;
+    }
+  }
+};
+
+
+/**
+* @brief Hardware counters of the calling thread
+*
+* @details The counters (cycles, instructions, cache misses and
+* branch misses) are opened once per thread by perf_event_open on
+* Linux, as a group which runs for the whole life of the thread,
+* so a scope only reads the group (one system call) at its
+* beginning and at its end and adds the difference.
+* If the counters are not available (e.g. restricted by
+* perf_event_paranoid or not Linux) the values stay zero.
+*
+*/
+class hw_counters
+{
+  int leader;                     ///< Group leader (-1 if not available)
+  std :: array < int, NUM_HW > fd;
+  std :: array < int32_t, NUM_HW > slot; ///< Position of each counter in the group read (-1 if not opened)
+
+public:
+
+  using values = std :: array < uint64_t, NUM_HW >;
+
+  hw_counters () : leader(-1)
+  {
+    this->fd.fill(-1);
+    this->slot.fill(-1);
+
+#if defined(PROFILE) && defined(__linux__)
+    const std :: array < uint64_t, NUM_HW > config = {{PERF_COUNT_HW_CPU_CYCLES,
+                                                       PERF_COUNT_HW_INSTRUCTIONS,
+                                                       PERF_COUNT_HW_CACHE_MISSES,
+                                                       PERF_COUNT_HW_BRANCH_MISSES}};
+
+    int32_t opened = 0;
+
+    for (int32_t h = 0; h < NUM_HW; ++h)
+    {
+      struct perf_event_attr attr;
+      std :: memset(&attr, 0, sizeof(attr));
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.size = sizeof(attr);
+      attr.config = config[h];
+      attr.read_format = PERF_FORMAT_GROUP;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+
+      // counters of the calling thread (pid 0) on any cpu
+      this->fd[h] = static_cast < int >(syscall(__NR_perf_event_open, &attr, 0, -1, this->leader, 0));
+
+      if (this->fd[h] == -1)
+        continue;
+
+      if (this->leader == -1)
+        this->leader = this->fd[h];
+      this->slot[h] = opened++;
+    }
+#endif
+  }
+
+  ~hw_counters ()
+  {
+#if defined(PROFILE) && defined(__linux__)
+    for (const auto & f : this->fd)
+      if (f != -1)
+        close(f);
+#endif
+  }
+
+  hw_counters (const hw_counters &) = delete;
+  hw_counters & operator = (const hw_counters &) = delete;
+
+  /**
+  * @brief Counters of the calling thread
+  *
+  * @details They are opened at the first call of each thread.
+  *
+  */
+  static hw_counters & thread ()
+  {
+    static thread_local hw_counters counters;
+    return counters;
+  }
+
+  /**
+  * @brief Current values of the counters
+  *
+  */
+  values read () const
+  {
+    values v;
+    v.fill(0);
+
+#if defined(PROFILE) && defined(__linux__)
+    if (this->leader == -1)
+      return v;
+
+    // PERF_FORMAT_GROUP layout: number of counters and their values
+    uint64_t group[NUM_HW + 1];
+
+    if (::read(this->leader, group, sizeof(group)) < static_cast < ssize_t >(sizeof(uint64_t)))
+      return v;
+
+    for (int32_t h = 0; h < NUM_HW; ++h)
+      if (this->slot[h] != -1 && static_cast < uint64_t >(this->slot[h]) < group[0])
+        v[h] = group[this->slot[h] + 1];
+#endif
+
+    return v;
+  }
+};
+
+
+/**
+* @brief Scoped timer
+*
+* @details The elapsed time between construction and destruction
+* is added to the entry (and the increments of the hardware
+* counters of the thread when enabled).
+*
+*/
+class scoped_timer
+{
+  entry & e;
+  std :: chrono :: steady_clock :: time_point start;
+  hw_counters * hw;
+  hw_counters :: values hw_start;
+
+public:
+
+  scoped_timer (entry & e) : e(e),
+                             start(),
+                             hw(registry :: instance().hardware ? &hw_counters :: thread() : nullptr)
+  {
+    if (this->hw)
+      this->hw_start = this->hw->read();
+
+    this->start = std :: chrono :: steady_clock :: now();
+  }
+
+  ~scoped_timer ()
+  {
+    const auto stop = std :: chrono :: steady_clock :: now();
+
+    if (this->hw)
+    {
+      const hw_counters :: values hw_stop = this->hw->read();
+
+      for (int32_t h = 0; h < NUM_HW; ++h)
+        this->e.hw[h].fetch_add(static_cast < int64_t >(hw_stop[h] - this->hw_start[h]), std :: memory_order_relaxed);
+    }
+
+    this->e.calls.fetch_add(1, std :: memory_order_relaxed);
+    this->e.ns.fetch_add(std :: chrono :: duration_cast < std :: chrono :: nanoseconds >(stop - this->start).count(), std :: memory_order_relaxed);
+  }
+};
+
+} // end namespace profiler
+
+
+#ifdef PROFILE
+
+#define PROFILE_CONCAT_IMPL(a, b) a ## b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_IMPL(a, b)
+
+/// Time the enclosing scope
+#define PROFILE_SCOPE(name) \
+  static profiler :: entry & PROFILE_CONCAT(sysdyn_profile_entry_, __LINE__) = profiler :: registry :: instance().get(name); \
+  profiler :: scoped_timer PROFILE_CONCAT(sysdyn_profile_timer_, __LINE__)(PROFILE_CONCAT(sysdyn_profile_entry_, __LINE__))
+
+/// Add n to the counter of the entry
+#define PROFILE_COUNT(name, n) \
+  do { \
+    static profiler :: entry & sysdyn_profile_counter = profiler :: registry :: instance().get(name); \
+    sysdyn_profile_counter.count.fetch_add(static_cast < int64_t >(n), std :: memory_order_relaxed); \
+  } while (0)
+
+/// Switch on/off the hardware counters in the timers
+#define PROFILE_HARDWARE(enable) profiler :: registry :: instance().hardware = (enable)
+
+/// Dump the structured report ("text" or "json")
+#define PROFILE_REPORT(os, format) profiler :: registry :: instance().report(os, format)
+
+/// Reset all the entries
+#define PROFILE_RESET() profiler :: registry :: instance().reset()
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_COUNT(name, n) do {} while (0)
+#define PROFILE_HARDWARE(enable) do {} while (0)
+#define PROFILE_REPORT(os, format) do {} while (0)
+#define PROFILE_RESET() do {} while (0)
+
+#endif // PROFILE
+
+#endif // __profiler_hpp__
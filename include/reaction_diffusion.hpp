@@ -0,0 +1,618 @@
+#ifndef __reaction_diffusion_hpp__
+#define __reaction_diffusion_hpp__
+
+#include <memory>
+#include <algorithm>
+#include <array>
+#include <vector>
+#include <map>
+#include <string>
+#include <random>
+#include <functional>
+#include <cstdint>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include <profiler.hpp>
+
+/**
+* @brief Reaction-diffusion engine
+*
+* @details The reaction terms are functors with the interface
+*
+*   using value_type;
+*   static constexpr int32_t Nspecies;
+*   void operator () (const value_type * c, value_type * dc) const;
+*
+* which evaluate the rates dc of the Nspecies concentrations c of
+* a site. The engine is a template on the functor, so the reaction
+* is inlined in the stencil loop (no virtual dispatch) and each
+* model gets its own vectorized kernel. The models can be selected
+* also at runtime by name (rd_models): the dispatch happens once per
+* call, outside of the stencil loops.
+*
+*/
+
+
+/**
+* @brief Brusselator reaction terms
+*
+* @details du/dt = A - (B + 1) u + u^2 v
+*          dv/dt = B u - u^2 v
+*
+*/
+template < class type >
+struct brusselator_reaction
+{
+  using value_type = type;
+  static constexpr int32_t Nspecies = 2;
+
+  type A;
+  type B;
+
+  void operator () (const type * c, type * dc) const
+  {
+    const type uuv = c[0] * c[0] * c[1];
+    dc[0] = this->A - (this->B + type(1.)) * c[0] + uuv;
+    dc[1] = this->B * c[0] - uuv;
+  }
+};
+
+
+/**
+* @brief Gray-Scott reaction terms
+*
+* @details du/dt = -u v^2 + F (1 - u)
+*          dv/dt =  u v^2 - (F + k) v
+*
+*/
+template < class type >
+struct gray_scott_reaction
+{
+  using value_type = type;
+  static constexpr int32_t Nspecies = 2;
+
+  type F;
+  type k;
+
+  void operator () (const type * c, type * dc) const
+  {
+    const type uvv = c[0] * c[1] * c[1];
+    dc[0] = this->F * (type(1.) - c[0]) - uvv;
+    dc[1] = uvv - (this->F + this->k) * c[1];
+  }
+};
+
+
+/**
+* @brief FitzHugh-Nagumo reaction terms
+*
+* @details du/dt = u - u^3 - v + k
+*          dv/dt = (u - v) / tau
+*
+*/
+template < class type >
+struct fitzhugh_nagumo_reaction
+{
+  using value_type = type;
+  static constexpr int32_t Nspecies = 2;
+
+  type k;
+  type tau;
+
+  void operator () (const type * c, type * dc) const
+  {
+    dc[0] = c[0] - c[0] * c[0] * c[0] - c[1] + this->k;
+    dc[1] = (c[0] - c[1]) / this->tau;
+  }
+};
+
+
+/**
+* @brief SIR reaction terms (SIR_model.ipynb)
+*
+* @details dS/dt = -beta I S
+*          dI/dt =  beta I S - alpha I
+*          dR/dt =  alpha I
+*
+*/
+template < class type >
+struct sir_reaction
+{
+  using value_type = type;
+  static constexpr int32_t Nspecies = 3;
+
+  type alpha;
+  type beta;
+
+  void operator () (const type * c, type * dc) const
+  {
+    const type infection = this->beta * c[1] * c[0];
+    const type recovery = this->alpha * c[1];
+    dc[0] = -infection;
+    dc[1] = infection - recovery;
+    dc[2] = recovery;
+  }
+};
+
+
+/**
+* @brief Boundary conditions of the reaction-diffusion engine
+*
+*/
+enum class rd_boundary
+{
+  periodic, ///< Periodic domain
+  neumann   ///< Zero flux (mirror reflection without the border, as cv::BORDER_REFLECT_101)
+};
+
+
+/**
+* @brief Neighbour index along an axis
+*
+*/
+inline int64_t rd_neighbour (const int64_t & i, const int64_t & n, const rd_boundary & bc)
+{
+  if (i >= 0 && i < n)
+    return i;
+
+  if (bc == rd_boundary :: periodic)
+    return i < 0 ? i + n : i - n;
+
+  return n > 1 ? (i < 0 ? 1 : n - 2) : 0;
+}
+
+
+static constexpr std :: size_t RD_BLOCK_BYTES = 1 << 18; ///< Working set of a slab of reaction_diffusion_3d (fits the L2 cache)
+
+
+/**
+* @brief Rows of the planes updated by the calling thread
+*
+* @details Static partition of the ny rows in contiguous ranges,
+* one for each thread of the team (the same for every plane).
+*
+* @param ny Number of rows.
+* @param y0 First row of the range.
+* @param y1 End of the range (empty if y0 == y1).
+* @param thread Index of the thread (-1 for the calling one).
+*
+*/
+inline void rd_rows (const int64_t & ny, int64_t & y0, int64_t & y1, int64_t thread = -1)
+{
+#ifdef _OPENMP
+  const int64_t nth = omp_get_num_threads();
+  if (thread < 0)
+    thread = omp_get_thread_num();
+#else
+  const int64_t nth = 1;
+  thread = 0;
+#endif
+
+  y0 = ny * thread / nth;
+  y1 = ny * (thread + 1) / nth;
+}
+
+
+/**
+* @brief First-touch initialization of a 3D field
+*
+* @details Each thread fills the rows of every plane which it
+* updates in reaction_diffusion_3d (rd_rows), so on NUMA systems
+* the memory pages of the rows are allocated on the node of the
+* thread which updates them. The field must be allocated without
+* initialization (e.g. new type[size]).
+*
+* @param field Field (nz x ny x nx, row-major).
+* @param nx Number of sites along x.
+* @param ny Number of sites along y.
+* @param nz Number of sites along z.
+* @param f Initial value f(x, y, z).
+*
+* @tparam type Data-type of the field.
+* @tparam Func Initial value function.
+*
+*/
+template < class type, class Func >
+void rd_first_touch (type * field, const int64_t & nx, const int64_t & ny, const int64_t & nz, Func f)
+{
+#ifdef _OPENMP
+  #pragma omp parallel
+#endif
+  {
+    int64_t y0, y1;
+    rd_rows(ny, y0, y1);
+
+    for (int64_t z = 0; z < nz; ++z)
+      for (int64_t y = y0; y < y1; ++y)
+      {
+        type * row = field + (z * ny + y) * nx;
+        for (int64_t x = 0; x < nx; ++x)
+          row[x] = f(x, y, z);
+      }
+  }
+}
+
+
+/**
+* @brief 3D reaction-diffusion model
+*
+* @details Explicit Euler integration of
+*
+*   dc_s/dt = D_s lap(c_s) + R_s(c)
+*
+* with the 7-point or the (isotropic) 27-point Laplacian
+*
+*   lap = (14 faces + 3 edges + corners - 128 center) / 30
+*
+* (unit grid spacing), fused with the reaction terms in a single
+* pass. The fields are updated in-place with a 2.5D blocking: each
+* thread owns a range of rows (rd_rows) which is split in slabs of
+* rows sized to fit the L2 cache (RD_BLOCK_BYTES) and each slab is
+* streamed along z, so the three planes of the stencil are read
+* from memory once per iteration. The old values still needed by
+* the stencil are kept in small buffers: the rows of the slab in
+* the planes z - 1, z (and 0 for the periodic wrap), the last row
+* of the previous slab (all the planes) and the first and last row
+* of each range (saved at the beginning of each iteration, since
+* they are overwritten by the neighbour threads). The memory is the
+* one of the fields plus 3 (x, z) planes per thread (a 512^3 grid
+* needs no full temporary copies).
+*
+* @param fields Array of Nspecies fields (nz x ny x nx, row-major), updated in-place.
+* @param nx Number of sites along x.
+* @param ny Number of sites along y.
+* @param nz Number of sites along z.
+* @param dt Interval of time.
+* @param D Diffusion coefficients (Nspecies values).
+* @param reaction Reaction terms.
+* @param bc Boundary conditions.
+* @param iterations Number of iterations to perform.
+*
+* @tparam stencil Number of points of the Laplacian (7 or 27).
+* @tparam reaction_t Reaction functor.
+*
+*/
+template < int32_t stencil, class reaction_t >
+void reaction_diffusion_3d (typename reaction_t :: value_type * const * fields,
+                            const int64_t & nx, const int64_t & ny, const int64_t & nz,
+                            const typename reaction_t :: value_type & dt,
+                            const typename reaction_t :: value_type * D,
+                            const reaction_t & reaction, const rd_boundary & bc,
+                            const int64_t & iterations)
+{
+  static_assert(stencil == 7 || stencil == 27, "the Laplacian must have 7 or 27 points");
+
+  using type = typename reaction_t :: value_type;
+  constexpr int32_t Ns = reaction_t :: Nspecies;
+
+  PROFILE_SCOPE("reaction_diffusion_3d");
+  PROFILE_COUNT("reaction_diffusion_3d", nx * ny * nz * iterations);
+
+  const int64_t plane = nx * ny;
+  const int64_t line = nz * nx; // a row in all the planes
+
+  // rows of a slab: the three planes of the stencil (and the halo rows) fit the cache
+  const int64_t block = std :: max(int64_t(1), static_cast < int64_t >(RD_BLOCK_BYTES / (3 * Ns * nx * sizeof(type))) - 2);
+
+  std :: array < type, Ns > Dt;
+  for (int32_t s = 0; s < Ns; ++s)
+    Dt[s] = D[s] * dt;
+
+  // old first and last row of the range of each thread
+  std :: unique_ptr < type[] > borders;
+
+#ifdef _OPENMP
+  #pragma omp parallel
+#endif
+  {
+    int64_t Y0, Y1;
+    rd_rows(ny, Y0, Y1);
+
+#ifdef _OPENMP
+    const int64_t thread = omp_get_thread_num();
+    const int64_t nth = omp_get_num_threads();
+#else
+    const int64_t thread = 0;
+    const int64_t nth = 1;
+#endif
+
+    // old rows of the slab in the planes 0, z - 1 and z
+    std :: unique_ptr < type[] > ring(new type[3 * Ns * block * nx]);
+    // old last row of the previous slab
+    std :: unique_ptr < type[] > halo(new type[Ns * line]);
+
+#ifdef _OPENMP
+    #pragma omp single
+#endif
+    borders.reset(new type[2 * nth * Ns * line]);
+
+    auto border = [&](const int64_t & t, const int32_t & which, const int32_t & s) -> type *
+                  {
+                    return borders.get() + ((2 * t + which) * Ns + s) * line;
+                  };
+
+    // saved old row outside the slab and its halo (the first or the last one of a range)
+    auto border_row = [&](const int64_t & r, const int32_t & s) -> const type *
+                      {
+                        int64_t t = 0, y0 = 0, y1 = 0;
+                        for (rd_rows(ny, y0, y1, t); r >= y1; rd_rows(ny, y0, y1, ++t));
+                        return border(t, r == y0 ? 0 : 1, s);
+                      };
+
+    for (int64_t t = 0; t < iterations; ++t)
+    {
+      if (Y1 > Y0)
+        for (int32_t s = 0; s < Ns; ++s)
+          for (int64_t z = 0; z < nz; ++z)
+          {
+            std :: copy_n(fields[s] + z * plane + Y0 * nx, nx, border(thread, 0, s) + z * nx);
+            std :: copy_n(fields[s] + z * plane + (Y1 - 1) * nx, nx, border(thread, 1, s) + z * nx);
+          }
+
+#ifdef _OPENMP
+      #pragma omp barrier
+#endif
+
+      for (int64_t y0 = Y0; y0 < Y1; y0 += block)
+      {
+        const int64_t y1 = std :: min(y0 + block, Y1);
+        const int64_t rows_size = (y1 - y0) * nx;
+
+        // slot of the ring which holds the old rows of a plane (the plane 0 is kept for the wrap)
+        auto slot = [&](const int64_t & k, const int32_t & s) -> type *
+                    {
+                      return ring.get() + ((k ? 1 + (k & 1) : 0) * Ns + s) * block * nx;
+                    };
+
+        for (int64_t z = 0; z < nz; ++z)
+        {
+          for (int32_t s = 0; s < Ns; ++s)
+            std :: copy_n(fields[s] + z * plane + y0 * nx, rows_size, slot(z, s));
+
+          const int64_t k[3] = {rd_neighbour(z - 1, nz, bc), z, rd_neighbour(z + 1, nz, bc)};
+
+          // old rows of the slab in the planes of the stencil: [species][plane (z-1, z, z+1)]
+          std :: array < std :: array < const type *, 3 >, Ns > slab_rows;
+
+          for (int32_t s = 0; s < Ns; ++s)
+            for (int32_t i = 0; i < 3; ++i)
+              slab_rows[s][i] = k[i] > z ? fields[s] + k[i] * plane + y0 * nx : slot(k[i], s);
+
+          // old values of the row r in the plane i of the stencil
+          auto old_row = [&](const int32_t & i, const int64_t & r, const int32_t & s) -> const type *
+                         {
+                           if (r >= y0 && r < y1)
+                             return slab_rows[s][i] + (r - y0) * nx;
+                           if (r >= y1 && r < Y1)
+                             return fields[s] + k[i] * plane + r * nx;
+                           if (r == y0 - 1 && r >= Y0)
+                             return halo.get() + s * line + k[i] * nx;
+                           return border_row(r, s) + k[i] * nx;
+                         };
+
+          for (int64_t y = y0; y < y1; ++y)
+          {
+            const int64_t yd = rd_neighbour(y - 1, ny, bc);
+            const int64_t yu = rd_neighbour(y + 1, ny, bc);
+
+            // rows of the stencil: [plane (z-1, z, z+1)][row (y-1, y, y+1)]
+            std :: array < std :: array < std :: array < const type *, 3 >, 3 >, Ns > rows;
+            std :: array < type *, Ns > out;
+
+            for (int32_t s = 0; s < Ns; ++s)
+            {
+              for (int32_t i = 0; i < 3; ++i)
+              {
+                rows[s][i][0] = old_row(i, yd, s);
+                rows[s][i][1] = slab_rows[s][i] + (y - y0) * nx;
+                rows[s][i][2] = old_row(i, yu, s);
+              }
+              out[s] = fields[s] + z * plane + y * nx;
+            }
+
+            auto site = [&](const int64_t & x, const int64_t & xl, const int64_t & xr)
+                        {
+                          type c[Ns], dc[Ns], lap[Ns];
+
+                          for (int32_t s = 0; s < Ns; ++s)
+                          {
+                            const auto & r = rows[s];
+                            c[s] = r[1][1][x];
+
+                            if (stencil == 7)
+                              lap[s] = r[0][1][x] + r[2][1][x] + r[1][0][x] + r[1][2][x] + r[1][1][xl] + r[1][1][xr] - type(6.) * c[s];
+                            else
+                            {
+                              type faces = r[0][1][x] + r[2][1][x] + r[1][0][x] + r[1][2][x] + r[1][1][xl] + r[1][1][xr];
+                              type edges = r[0][0][x] + r[0][2][x] + r[2][0][x] + r[2][2][x]
+                                         + r[0][1][xl] + r[0][1][xr] + r[2][1][xl] + r[2][1][xr]
+                                         + r[1][0][xl] + r[1][0][xr] + r[1][2][xl] + r[1][2][xr];
+                              type corners = r[0][0][xl] + r[0][0][xr] + r[0][2][xl] + r[0][2][xr]
+                                           + r[2][0][xl] + r[2][0][xr] + r[2][2][xl] + r[2][2][xr];
+                              lap[s] = (type(14.) * faces + type(3.) * edges + corners - type(128.) * c[s]) * type(1. / 30.);
+                            }
+                          }
+
+                          reaction(c, dc);
+
+                          for (int32_t s = 0; s < Ns; ++s)
+                            out[s][x] = c[s] + Dt[s] * lap[s] + dt * dc[s];
+                        };
+
+            site(0, rd_neighbour(-1, nx, bc), rd_neighbour(1, nx, bc));
+
+            // the row of the plane z is read from the ring (the output is a different buffer)
+#ifdef _OPENMP
+            #pragma omp simd
+#endif
+            for (int64_t x = 1; x < nx - 1; ++x)
+              site(x, x - 1, x + 1);
+
+            if (nx > 1)
+              site(nx - 1, nx - 2, rd_neighbour(nx, nx, bc));
+          }
+
+          // the old last row of the plane z - 1 is no longer read by this slab
+          // (the planes 0 and nz - 1 are read by the periodic wrap)
+          if (z >= 2)
+            for (int32_t s = 0; s < Ns; ++s)
+              std :: copy_n(slot(z - 1, s) + (y1 - 1 - y0) * nx, nx, halo.get() + s * line + (z - 1) * nx);
+        }
+
+        for (int32_t s = 0; s < Ns; ++s)
+        {
+          std :: copy_n(slot(0, s) + (y1 - 1 - y0) * nx, nx, halo.get() + s * line);
+          std :: copy_n(slot(nz - 1, s) + (y1 - 1 - y0) * nx, nx, halo.get() + s * line + (nz - 1) * nx);
+        }
+      }
+
+      // the borders are read until the end of the iteration
+#ifdef _OPENMP
+      #pragma omp barrier
+#endif
+    }
+  }
+}
+
+
+/**
+* @brief Reaction-diffusion model with the stencil chosen at runtime
+*
+* @details It dispatches to the 7 or 27-point kernel of
+* reaction_diffusion_3d. A 2D domain is a single plane (nz = 1):
+* with both boundaries the 7-point stencil is the 5-point one of
+* brusselator_diffusion, while the 27-point one gives a 9-point
+* isotropic Laplacian.
+*
+* @param stencil Number of points of the Laplacian (7 or 27).
+*
+* @return False if the stencil is not supported.
+*
+*/
+template < class reaction_t >
+bool rd_integrate (typename reaction_t :: value_type * const * fields,
+                   const int64_t & nx, const int64_t & ny, const int64_t & nz,
+                   const typename reaction_t :: value_type & dt,
+                   const typename reaction_t :: value_type * D,
+                   const reaction_t & reaction, const rd_boundary & bc,
+                   const int32_t & stencil, const int64_t & iterations)
+{
+  switch (stencil)
+  {
+    case 7:  reaction_diffusion_3d < 7 >(fields, nx, ny, nz, dt, D, reaction, bc, iterations); return true;
+    case 27: reaction_diffusion_3d < 27 >(fields, nx, ny, nz, dt, D, reaction, bc, iterations); return true;
+    default: return false;
+  }
+}
+
+
+/**
+* @brief Entry of the registry of the reaction models
+*
+* @details The defaults give a Turing (or travelling wave) pattern
+* from the initial condition on a grid with unit spacing, within the
+* stability limit of the explicit scheme (D dt < 1/6 in 3D).
+*
+*/
+struct rd_model
+{
+  using run_t = std :: function < bool (double * const * fields, const int64_t & nx, const int64_t & ny, const int64_t & nz,
+                                        const double & dt, const double * D, const double * parameters,
+                                        const rd_boundary & bc, const int32_t & stencil, const int64_t & iterations) >;
+
+  using init_t = std :: function < void (std :: mt19937 & engine, const double * parameters,
+                                         const int64_t & x, const int64_t & y, const int64_t & z, double * c) >;
+
+  std :: string description;
+  std :: vector < std :: string > species;    ///< Names of the species (Nspecies)
+  std :: vector < std :: string > parameters; ///< Names of the parameters
+  std :: vector < double > values;            ///< Default parameters
+  std :: vector < double > D;                 ///< Default diffusion coefficients
+  double dt;                                  ///< Default interval of time
+  init_t initial;                             ///< Random initial state of the site (x, y, z)
+  run_t run;                                  ///< Integrator (rd_integrate with the model functor)
+};
+
+
+/**
+* @brief Registry of the reaction models by name
+*
+* @details Each entry wraps the kernel instantiated on the functor of
+* the model (double precision): the parameters are unpacked once per
+* call, so the inner loops are the same of a direct call of the
+* template engine.
+*
+* @return The map name -> model (brusselator, gray_scott, fitzhugh_nagumo, sir).
+*
+*/
+inline const std :: map < std :: string, rd_model > & rd_models ()
+{
+  static const std :: map < std :: string, rd_model > models = {
+
+    // Turing instability for (1 + A sqrt(Du / Dv))^2 < B < 1 + A^2
+    {"brusselator", {"Brusselator", {"U", "V"}, {"A", "B"}, {4.5, 7.5}, {2., 16.}, .005,
+                     [] (std :: mt19937 & engine, const double * p, const int64_t &, const int64_t &, const int64_t &, double * c)
+                     {
+                       // perturbation of the homogeneous steady state (A, B / A)
+                       std :: uniform_real_distribution < double > uniform(0., 1.);
+                       c[0] = p[0] + .3 * uniform(engine);
+                       c[1] = p[1] / p[0] + .3 * uniform(engine);
+                     },
+                     [] (double * const * f, const int64_t & nx, const int64_t & ny, const int64_t & nz, const double & dt,
+                         const double * D, const double * p, const rd_boundary & bc, const int32_t & stencil, const int64_t & iterations)
+                     {
+                       return rd_integrate(f, nx, ny, nz, dt, D, brusselator_reaction < double >{p[0], p[1]}, bc, stencil, iterations);
+                     }}},
+
+    {"gray_scott", {"Gray-Scott", {"U", "V"}, {"F", "k"}, {.035, .065}, {.2, .1}, .5,
+                    [] (std :: mt19937 & engine, const double *, const int64_t & x, const int64_t & y, const int64_t & z, double * c)
+                    {
+                      // seeds of V (blocks of 8 sites, single sites decay) in a uniform U = 1
+                      std :: uniform_real_distribution < double > uniform(0., .05);
+                      const uint64_t block = static_cast < uint64_t >((x / 8) * 73856093 ^ (y / 8) * 19349663 ^ (z / 8) * 83492791);
+                      const bool seed = block % 7 == 0;
+                      c[0] = (seed ? .5 : 1.) - uniform(engine);
+                      c[1] = (seed ? .25 : 0.) + uniform(engine);
+                    },
+                    [] (double * const * f, const int64_t & nx, const int64_t & ny, const int64_t & nz, const double & dt,
+                        const double * D, const double * p, const rd_boundary & bc, const int32_t & stencil, const int64_t & iterations)
+                    {
+                      return rd_integrate(f, nx, ny, nz, dt, D, gray_scott_reaction < double >{p[0], p[1]}, bc, stencil, iterations);
+                    }}},
+
+    {"fitzhugh_nagumo", {"FitzHugh-Nagumo", {"u", "v"}, {"k", "tau"}, {-.005, .1}, {.7, 125.}, .001,
+                         [] (std :: mt19937 & engine, const double *, const int64_t &, const int64_t &, const int64_t &, double * c)
+                         {
+                           std :: uniform_real_distribution < double > uniform(-1., 1.);
+                           c[0] = uniform(engine);
+                           c[1] = uniform(engine);
+                         },
+                         [] (double * const * f, const int64_t & nx, const int64_t & ny, const int64_t & nz, const double & dt,
+                             const double * D, const double * p, const rd_boundary & bc, const int32_t & stencil, const int64_t & iterations)
+                         {
+                           return rd_integrate(f, nx, ny, nz, dt, D, fitzhugh_nagumo_reaction < double >{p[0], p[1]}, bc, stencil, iterations);
+                         }}},
+
+    {"sir", {"SIR epidemic (SIR_model.ipynb)", {"S", "I", "R"}, {"alpha", "beta"}, {1., 10.}, {0., 12., 0.}, .005,
+             [] (std :: mt19937 & engine, const double *, const int64_t &, const int64_t &, const int64_t &, double * c)
+             {
+               // 1% of infected sites
+               std :: uniform_real_distribution < double > uniform(0., 1.);
+               c[1] = uniform(engine) < .01 ? 1. : 0.;
+               c[0] = 1. - c[1];
+               c[2] = 0.;
+             },
+             [] (double * const * f, const int64_t & nx, const int64_t & ny, const int64_t & nz, const double & dt,
+                 const double * D, const double * p, const rd_boundary & bc, const int32_t & stencil, const int64_t & iterations)
+             {
+               return rd_integrate(f, nx, ny, nz, dt, D, sir_reaction < double >{p[0], p[1]}, bc, stencil, iterations);
+             }}},
+  };
+
+  return models;
+}
+
+#endif // __reaction_diffusion_hpp__
@@ -0,0 +1,275 @@
+#ifndef __recurrence_hpp__
+#define __recurrence_hpp__
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+#include <false_nearest_neighbours.hpp>
+#include <profiler.hpp>
+
+/**
+* @brief Number of set bits of a 64-bit word
+*
+*/
+inline int64_t popcount64 (const uint64_t & x)
+{
+#ifdef _MSC_VER
+  return static_cast < int64_t >(__popcnt64(x));
+#else
+  return __builtin_popcountll(x);
+#endif
+}
+
+
+/**
+* @brief Recurrence quantification measures
+*
+*/
+struct rqa_measures
+{
+  int64_t recurrences;     ///< Number of recurrence points (outside the Theiler window)
+  double recurrence_rate;  ///< RR: fraction of recurrence points
+  double determinism;      ///< DET: fraction of the recurrence points on diagonal lines (length >= lmin)
+  double average_diagonal; ///< L: average length of the diagonal lines (length >= lmin)
+  double laminarity;       ///< LAM: fraction of the recurrence points on vertical lines (length >= vmin)
+  double trapping_time;    ///< TT: average length of the vertical lines (length >= vmin)
+};
+
+
+/**
+* @brief Thresholded recurrence row of an embedded point
+*
+* @details The bit j of the row (bit j % 64 of the word j / 64) is
+* set if the distance (max-norm, or Euclidean) between the points
+* i and j is at most eps and |i - j| >= theiler. The distances are
+* computed in blocks of 64 contiguous points, one coordinate at a
+* time (so the loops vectorize), and packed in a word.
+*
+* @param emb Delay embedding.
+* @param i Index of the point.
+* @param eps Recurrence threshold.
+* @param theiler Theiler window (1 excludes the line of identity).
+* @param euclidean Use the Euclidean distance (default max-norm).
+* @param dist Work buffer of 64 values.
+* @param row Output row of (emb.size + 63) / 64 words.
+*
+* @tparam type Data-type of the series.
+*
+*/
+template < class type >
+void recurrence_row (const delay_embedding < type > & emb, const int64_t & i, const type & eps,
+                     const int64_t & theiler, const bool & euclidean,
+                     type * dist, uint64_t * row)
+{
+  const int64_t M = emb.size;
+  const int64_t words = (M + 63) / 64;
+  const type threshold = euclidean ? eps * eps : eps;
+
+  for (int64_t w = 0; w < words; ++w)
+  {
+    const int64_t base = w * 64;
+
+    // the columns beyond the last point of a partial word are never recurrent
+    if (base + 64 > M)
+      std :: fill_n(dist, 64, threshold + type(1.));
+
+    const int64_t n = std :: min(int64_t(64), M - base);
+
+    for (int32_t d = 0; d < emb.dim; ++d)
+    {
+      const type xi = emb(i, d);
+      const type * xd = emb.x + base + d * emb.delay;
+
+      if (euclidean)
+      {
+        if (d == 0)
+          for (int64_t b = 0; b < n; ++b)
+            dist[b] = (xd[b] - xi) * (xd[b] - xi);
+        else
+          for (int64_t b = 0; b < n; ++b)
+            dist[b] += (xd[b] - xi) * (xd[b] - xi);
+      }
+      else
+      {
+        if (d == 0)
+          for (int64_t b = 0; b < n; ++b)
+            dist[b] = std :: abs(xd[b] - xi);
+        else
+          for (int64_t b = 0; b < n; ++b)
+            dist[b] = std :: max(dist[b], std :: abs(xd[b] - xi));
+      }
+    }
+
+    uint64_t bits = 0;
+    for (int32_t b = 0; b < 64; ++b)
+      bits |= static_cast < uint64_t >(dist[b] <= threshold) << b;
+    row[w] = bits;
+  }
+
+  // Theiler window around the line of identity
+  const int64_t lo = std :: max(int64_t(0), i - theiler + 1);
+  const int64_t hi = std :: min(M, i + theiler);
+  for (int64_t j = lo; j < hi; ++j)
+    row[j / 64] &= ~(uint64_t(1) << (j % 64));
+}
+
+
+/**
+* @brief Recurrence quantification analysis
+*
+* @details The recurrence matrix is never stored: each thread
+* computes the thresholded rows of its range of points (bit-packed,
+* see recurrence_row) and keeps only the last lmin + 1 rows.
+* The line statistics are obtained by popcounts of AND-ed shifted
+* rows, without tracking the single lines: the number of positions
+* where l consecutive points of a diagonal are recurrent is
+*
+*   A_l = sum_i popcount(R_i & (R_i+1 >> 1) & ... & (R_i+l-1 >> l-1))
+*
+* and for the lines of length L >= l it counts sum (L - l + 1), so
+* the points on the lines of length >= lmin are
+* lmin A_lmin - (lmin - 1) A_lmin+1 and the number of these lines
+* is A_lmin - A_lmin+1. Since the matrix is symmetric, the vertical
+* lines of the columns are the horizontal lines of the rows, which
+* are counted in the same way on each row shifted by itself.
+* The rows are full (each distance is evaluated twice), so the
+* work is split in contiguous ranges of rows across the threads
+* (lmin rows are recomputed at the end of each range).
+*
+* @note The maximum line lengths and the line entropy need the
+* single lines and they are not computed.
+*
+* @param emb Delay embedding.
+* @param eps Recurrence threshold.
+* @param lmin Minimum length of the diagonal lines (< 64).
+* @param vmin Minimum length of the vertical lines (< 64).
+* @param theiler Theiler window (1 excludes the line of identity).
+* @param euclidean Use the Euclidean distance (default max-norm).
+*
+* @tparam type Data-type of the series.
+*
+* @return The RQA measures.
+*
+*/
+template < class type >
+rqa_measures recurrence_quantification (const delay_embedding < type > & emb, const type & eps,
+                                        const int32_t & lmin = 2, const int32_t & vmin = 2,
+                                        const int64_t & theiler = 1, const bool & euclidean = false)
+{
+  const int64_t M = emb.size;
+  const int64_t words = (M + 63) / 64;
+  const int32_t window = lmin + 1;
+
+  PROFILE_SCOPE("recurrence_quantification");
+  PROFILE_COUNT("recurrence_quantification", M * M);
+
+  int64_t recurrences = 0;
+  int64_t diag_lmin = 0, diag_next = 0;
+  int64_t vert_vmin = 0, vert_next = 0;
+
+  const int64_t chunk = 256;
+  const int64_t Nchunks = (M + chunk - 1) / chunk;
+
+  // funnel shift of a row by s bits towards the lower columns
+  // (the row has a trailing zero word)
+  auto shifted = [](const uint64_t * row, const int64_t & w, const int32_t & s)
+                 {
+                   return s ? (row[w] >> s) | (row[w + 1] << (64 - s)) : row[w];
+                 };
+
+#ifdef _OPENMP
+  #pragma omp parallel reduction (+ : recurrences, diag_lmin, diag_next, vert_vmin, vert_next)
+#endif
+  {
+    std :: vector < type > dist(64);
+    std :: vector < uint64_t > ring(window * (words + 1), 0);
+    std :: vector < uint64_t > acc(words);
+
+    auto slot = [&](const int64_t & r) { return ring.data() + (r % window) * (words + 1); };
+
+#ifdef _OPENMP
+    #pragma omp for schedule(dynamic, 1)
+#endif
+    for (int64_t c = 0; c < Nchunks; ++c)
+    {
+      const int64_t start = c * chunk;
+      const int64_t end = std :: min(start + chunk, M);
+
+      for (int64_t r = start; r < end + lmin; ++r)
+      {
+        uint64_t * row = slot(r);
+
+        if (r < M)
+          recurrence_row(emb, r, eps, theiler, euclidean, dist.data(), row);
+        else
+          std :: fill_n(row, words, uint64_t(0));
+        row[words] = 0;
+
+        const int64_t i = r - lmin;
+        if (i < start)
+          continue;
+
+        // row i with the following lmin rows in the ring
+        const uint64_t * Ri = slot(i);
+
+        // diagonal lines
+        for (int64_t w = 0; w < words; ++w)
+          acc[w] = Ri[w];
+
+        for (int32_t t = 1; t < lmin; ++t)
+        {
+          const uint64_t * Rt = slot(i + t);
+          for (int64_t w = 0; w < words; ++w)
+            acc[w] &= shifted(Rt, w, t);
+        }
+
+        const uint64_t * Rl = slot(i + lmin);
+        for (int64_t w = 0; w < words; ++w)
+        {
+          recurrences += popcount64(Ri[w]);
+          diag_lmin += popcount64(acc[w]);
+          diag_next += popcount64(acc[w] & shifted(Rl, w, lmin));
+        }
+
+        // vertical lines (horizontal lines of the row, by symmetry)
+        for (int64_t w = 0; w < words; ++w)
+        {
+          uint64_t v = Ri[w];
+          for (int32_t t = 1; t < vmin; ++t)
+            v &= shifted(Ri, w, t);
+
+          vert_vmin += popcount64(v);
+          vert_next += popcount64(v & shifted(Ri, w, vmin));
+        }
+      }
+    }
+  }
+
+  rqa_measures rqa;
+
+  // entries outside the Theiler window
+  const int64_t band = std :: min(theiler, M);
+  const int64_t excluded = band > 0 ? M + 2 * ((band - 1) * M - (band - 1) * band / 2) : 0;
+  const double entries = static_cast < double >(M * M - excluded);
+
+  const int64_t diag_points = lmin * diag_lmin - (lmin - 1) * diag_next;
+  const int64_t diag_lines = diag_lmin - diag_next;
+  const int64_t vert_points = vmin * vert_vmin - (vmin - 1) * vert_next;
+  const int64_t vert_lines = vert_vmin - vert_next;
+
+  rqa.recurrences = recurrences;
+  rqa.recurrence_rate = entries > 0. ? recurrences / entries : 0.;
+  rqa.determinism = recurrences ? static_cast < double >(diag_points) / recurrences : 0.;
+  rqa.average_diagonal = diag_lines ? static_cast < double >(diag_points) / diag_lines : 0.;
+  rqa.laminarity = recurrences ? static_cast < double >(vert_points) / recurrences : 0.;
+  rqa.trapping_time = vert_lines ? static_cast < double >(vert_points) / vert_lines : 0.;
+
+  return rqa;
+}
+
+#endif // __recurrence_hpp__
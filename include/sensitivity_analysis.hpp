@@ -0,0 +1,257 @@
+#ifndef __sensitivity_analysis_hpp__
+#define __sensitivity_analysis_hpp__
+
+#include <vector>
+#include <random>
+#include <numeric>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include <profiler.hpp>
+
+/**
+* @brief Global sensitivity analysis drivers
+*
+* @details The drivers sample the parameter box [lower, upper],
+* evaluate the model output f(p) (a functor returning a scalar,
+* e.g. the product concentration at the final time of a
+* MichaelisMenten integration) on the perturbed ensemble and
+* reduce the results to sensitivity indices.
+* The ensemble is generated serially batch by batch (so the
+* result does not depend on the number of threads) and the
+* evaluations of each batch run in parallel; only the outputs of
+* the current batch are stored.
+* The functor is called concurrently by the threads, so it must
+* be thread-safe (no shared mutable state).
+*
+*/
+
+
+/**
+* @brief Sobol sensitivity indices (Saltelli/Jansen estimators)
+*
+* @details Two independent samples A and B of the parameters are
+* drawn uniformly in the box, and for each parameter i the matrix
+* AB_i is A with the i-th column taken from B. The first order
+* and total indices are estimated as
+*   S_i  = mean(f(B) (f(AB_i) - f(A))) / V      (Saltelli 2010)
+*   ST_i = mean((f(A) - f(AB_i))^2) / (2 V)    (Jansen 1999)
+* with V the variance of the outputs of A and B, so the cost is
+* samples * (Npar + 2) model evaluations.
+*
+* @param f Model output as function of the parameters (const type * p -> type).
+* @param Npar Number of parameters.
+* @param lower Lower bounds of the parameters.
+* @param upper Upper bounds of the parameters.
+* @param samples Number of base samples.
+* @param first Output array of Npar first order indices.
+* @param total Output array of Npar total indices.
+* @param seed Random seed.
+* @param batch Number of base samples evaluated in each parallel batch.
+*
+* @tparam type Data-type of the parameters.
+* @tparam Function Functor type.
+*
+*/
+template < class type, class Function >
+void sobol_indices (Function f, const int32_t & Npar,
+                    const type * lower, const type * upper,
+                    const int64_t & samples,
+                    type * first, type * total,
+                    const uint32_t & seed = 42u, const int64_t & batch = 1024)
+{
+  PROFILE_SCOPE("sobol_indices");
+  PROFILE_COUNT("sobol_indices", samples * (Npar + 2));
+
+  const int32_t cols = Npar + 2; // f(A), f(B), f(AB_1), ..., f(AB_Npar)
+
+  std :: mt19937 engine(seed);
+  std :: uniform_real_distribution < type > uniform(type(0.), type(1.));
+
+  std :: vector < type > A(batch * Npar);
+  std :: vector < type > B(batch * Npar);
+  std :: vector < type > out(batch * cols);
+
+  // accumulators (in double precision, the sums run over the whole ensemble)
+  double sum = 0.;
+  double sum2 = 0.;
+  std :: vector < double > num_first(Npar, 0.);
+  std :: vector < double > num_total(Npar, 0.);
+
+  for (int64_t start = 0; start < samples; start += batch)
+  {
+    const int64_t rows = std :: min(batch, samples - start);
+
+    for (int64_t r = 0; r < rows; ++r)
+      for (int32_t j = 0; j < Npar; ++j)
+      {
+        A[r * Npar + j] = lower[j] + (upper[j] - lower[j]) * uniform(engine);
+        B[r * Npar + j] = lower[j] + (upper[j] - lower[j]) * uniform(engine);
+      }
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (int64_t e = 0; e < rows * cols; ++e)
+    {
+      const int64_t r = e / cols;
+      const int32_t c = static_cast < int32_t >(e % cols);
+
+      std :: vector < type > p(A.begin() + r * Npar, A.begin() + (r + 1) * Npar);
+
+      if (c == 1)
+        std :: copy_n(B.begin() + r * Npar, Npar, p.begin());
+      else if (c > 1)
+        p[c - 2] = B[r * Npar + c - 2];
+
+      out[e] = f(p.data());
+    }
+
+    for (int64_t r = 0; r < rows; ++r)
+    {
+      const double fA = out[r * cols];
+      const double fB = out[r * cols + 1];
+
+      sum += fA + fB;
+      sum2 += fA * fA + fB * fB;
+
+      for (int32_t j = 0; j < Npar; ++j)
+      {
+        const double fAB = out[r * cols + 2 + j];
+        num_first[j] += fB * (fAB - fA);
+        num_total[j] += (fA - fAB) * (fA - fAB);
+      }
+    }
+  }
+
+  const double mean = sum / (2. * samples);
+  const double var = sum2 / (2. * samples) - mean * mean;
+
+  for (int32_t j = 0; j < Npar; ++j)
+  {
+    first[j] = var > 0. ? static_cast < type >(num_first[j] / samples / var) : type(0.);
+    total[j] = var > 0. ? static_cast < type >(.5 * num_total[j] / samples / var) : type(0.);
+  }
+}
+
+
+/**
+* @brief Morris screening (elementary effects)
+*
+* @details Each trajectory starts from a random point of a grid
+* with levels values per parameter (in the unit box) and moves one
+* parameter at a time, in random order, by delta = levels / (2 (levels - 1)),
+* so it costs Npar + 1 model evaluations. The elementary effect of
+* the i-th parameter is (f(p + delta e_i) - f(p)) / delta (unit box
+* coordinates) and the statistics over the trajectories are the
+* mean (mu), the mean of the absolute values (mu*, Campolongo 2007)
+* and the standard deviation (sigma).
+* The trajectories of each batch run in parallel.
+*
+* @param f Model output as function of the parameters (const type * p -> type).
+* @param Npar Number of parameters.
+* @param lower Lower bounds of the parameters.
+* @param upper Upper bounds of the parameters.
+* @param trajectories Number of trajectories.
+* @param mu Output array of Npar mean elementary effects.
+* @param mu_star Output array of Npar mean absolute elementary effects.
+* @param sigma Output array of Npar standard deviations of the elementary effects.
+* @param levels Number of grid levels (even).
+* @param seed Random seed.
+* @param batch Number of trajectories evaluated in each parallel batch.
+*
+* @tparam type Data-type of the parameters.
+* @tparam Function Functor type.
+*
+*/
+template < class type, class Function >
+void morris_screening (Function f, const int32_t & Npar,
+                       const type * lower, const type * upper,
+                       const int64_t & trajectories,
+                       type * mu, type * mu_star, type * sigma,
+                       const int32_t & levels = 4,
+                       const uint32_t & seed = 42u, const int64_t & batch = 1024)
+{
+  PROFILE_SCOPE("morris_screening");
+  PROFILE_COUNT("morris_screening", trajectories * (Npar + 1));
+
+  const type delta = type(levels) / (type(2.) * (levels - 1));
+  // the base point is drawn among the levels which leave room for the +delta step
+  const int32_t base_levels = levels / 2;
+
+  std :: mt19937 engine(seed);
+  std :: uniform_int_distribution < int32_t > level(0, base_levels - 1);
+
+  std :: vector < type > base(batch * Npar);
+  std :: vector < int32_t > order(batch * Npar);
+  std :: vector < type > effects(batch * Npar);
+
+  std :: vector < double > sum(Npar, 0.);
+  std :: vector < double > sum_abs(Npar, 0.);
+  std :: vector < double > sum2(Npar, 0.);
+
+  for (int64_t start = 0; start < trajectories; start += batch)
+  {
+    const int64_t rows = std :: min(batch, trajectories - start);
+
+    for (int64_t r = 0; r < rows; ++r)
+    {
+      int32_t * perm = order.data() + r * Npar;
+      std :: iota(perm, perm + Npar, 0);
+      std :: shuffle(perm, perm + Npar, engine);
+
+      for (int32_t j = 0; j < Npar; ++j)
+        base[r * Npar + j] = type(level(engine)) / (levels - 1);
+    }
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (int64_t r = 0; r < rows; ++r)
+    {
+      std :: vector < type > u(base.begin() + r * Npar, base.begin() + (r + 1) * Npar);
+      std :: vector < type > p(Npar);
+
+      auto evaluate = [&]()
+                      {
+                        for (int32_t j = 0; j < Npar; ++j)
+                          p[j] = lower[j] + (upper[j] - lower[j]) * u[j];
+                        return f(p.data());
+                      };
+
+      type previous = evaluate();
+
+      for (int32_t k = 0; k < Npar; ++k)
+      {
+        const int32_t j = order[r * Npar + k];
+        u[j] += delta;
+
+        const type current = evaluate();
+        effects[r * Npar + j] = (current - previous) / delta;
+        previous = current;
+      }
+    }
+
+    for (int64_t r = 0; r < rows; ++r)
+      for (int32_t j = 0; j < Npar; ++j)
+      {
+        const double ee = effects[r * Npar + j];
+        sum[j] += ee;
+        sum_abs[j] += std :: abs(ee);
+        sum2[j] += ee * ee;
+      }
+  }
+
+  for (int32_t j = 0; j < Npar; ++j)
+  {
+    const double m = sum[j] / trajectories;
+    const double var = trajectories > 1 ? (sum2[j] - trajectories * m * m) / (trajectories - 1) : 0.;
+
+    mu[j] = static_cast < type >(m);
+    mu_star[j] = static_cast < type >(sum_abs[j] / trajectories);
+    sigma[j] = static_cast < type >(std :: sqrt(std :: max(var, 0.)));
+  }
+}
+
+#endif // __sensitivity_analysis_hpp__
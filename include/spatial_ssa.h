@@ -0,0 +1,171 @@
+#ifndef __spatial_ssa_h__
+#define __spatial_ssa_h__
+
+#include <vector>
+#include <random>
+#include <cstddef>
+#include <cstdint>
+
+/**
+* @brief Mass-action reaction of the spatial SSA
+*
+* @details The propensity in a voxel of volume omega is
+*
+*   a = rate * omega^(1 - order) * prod_s n_s (n_s - 1) ... (n_s - m_s + 1)
+*
+* where m_s is the multiplicity of the species s in the reactants
+* and order = sum_s m_s (the same convention of BrusselatorCME,
+* e.g. 2X + Y -> 3X has propensity rate x (x - 1) y / omega^2).
+*
+*/
+struct ssa_reaction
+{
+  std :: vector < int32_t > reactants; ///< Species consumed (repeated for each molecule)
+  std :: vector < int32_t > products;  ///< Species produced (repeated for each molecule)
+  double rate;                         ///< Macroscopic rate constant
+};
+
+
+/**
+* @brief Spatial stochastic simulation (reaction-diffusion master equation)
+*
+* @details The domain is a nx x ny x nz lattice of voxels (nz = 1
+* for a 2D domain) and each molecule jumps to each neighbour voxel
+* with rate D_s (the diffusion coefficient over the squared voxel
+* size). The events are sampled with the Next Subvolume Method:
+* every voxel holds the propensities of its reactions (updated
+* only for the reactions which depend on the changed species) and
+* of its diffusion jumps, and the time of its next event is kept
+* in an indexed 4-ary heap, so each event costs O(log Nvoxels).
+* The time of the voxel which receives a molecule is rescaled by
+* the ratio of the propensities (Gibson-Bruck) instead of drawn
+* again.
+*
+* For the parallel simulation the lattice is split in slabs along
+* the slowest axis (Npartitions contiguous blocks of voxels), each
+* one with its own heap and random engine, advanced independently
+* over windows of time. The molecules which jump across a slab
+* border are delivered at the end of the window, so the coupling
+* between the slabs lags at most one window (which must be small
+* compared to the diffusion time of a voxel). With one partition
+* the simulation is exact for any window. The result depends only
+* on the seed and on the number of partitions, not on the number
+* of threads.
+*
+*/
+class spatial_ssa
+{
+  /**
+  * @brief Slab of the lattice with its own event queue
+  *
+  */
+  struct partition
+  {
+    struct entry
+    {
+      double time;                       ///< Time of the next event
+      int32_t voxel;                     ///< Local index of the voxel
+    };
+
+    int64_t begin;                       ///< First voxel
+    int64_t end;                         ///< Last voxel (excluded)
+
+    std :: vector < entry > heap;        ///< Indexed 4-ary heap of the next events of the voxels
+    std :: vector < int32_t > position;  ///< Position of each (local) voxel in the heap
+
+    std :: mt19937_64 engine;
+
+    std :: vector < std :: vector < std :: pair < int64_t, int32_t > > > outbox; ///< Molecules (voxel, species) sent to each partition
+    int64_t events;
+  };
+
+  int64_t nx, ny, nz, Nvoxels;
+  int32_t Nspecies, Nreactions;
+  bool periodic;
+  double omega;
+  double t;
+
+  std :: vector < double > D;
+  std :: vector < double > rates;                           ///< Rates scaled by the volume
+  std :: vector < std :: vector < std :: pair < int32_t, int32_t > > > reactants; ///< (species, multiplicity) of each reaction
+  std :: vector < std :: vector < std :: pair < int32_t, int32_t > > > change;    ///< (species, net change) of each reaction
+  std :: vector < std :: vector < int32_t > > depends;      ///< Reactions to update after a change of each species
+
+  std :: vector < int32_t > state;                          ///< Populations (voxel-major, state[v * Nspecies + s])
+  std :: vector < double > propensity;                      ///< Reaction propensities (propensity[v * Nreactions + r])
+  std :: vector < double > total;                           ///< Total propensity of each voxel
+  std :: vector < uint8_t > degree;                         ///< Number of neighbours of each voxel
+
+  std :: vector < partition > partitions;
+  bool dirty;
+
+  int32_t neighbours (const int64_t & v, int64_t * nb) const;
+  double reaction_propensity (const int64_t & v, const int32_t & r) const;
+  void update_total (const int64_t & v);
+  void update_reactions (const int64_t & v, const int32_t & species);
+  void schedule (partition & p, const int64_t & v, const double & now);
+  void reschedule (partition & p, const int64_t & v, const double & now, const double & previous);
+  void sift (partition & p, int32_t i);
+  void initialize ();
+  void advance (partition & p, const double & until);
+
+public:
+
+  /**
+  * @brief Empty lattice
+  *
+  * @param nx Number of voxels along x.
+  * @param ny Number of voxels along y.
+  * @param nz Number of voxels along z (1 for a 2D lattice).
+  * @param Nspecies Number of species.
+  * @param reactions Reactions of every voxel.
+  * @param D Jump rate of each species to each neighbour voxel.
+  * @param omega Volume of a voxel.
+  * @param periodic Periodic (true) or reflecting (false) boundaries.
+  * @param seed Random seed.
+  * @param Npartitions Number of slabs (at most the extent of the slowest axis).
+  *
+  */
+  spatial_ssa (const int64_t & nx, const int64_t & ny, const int64_t & nz,
+               const int32_t & Nspecies, const std :: vector < ssa_reaction > & reactions,
+               const std :: vector < double > & D, const double & omega,
+               const bool & periodic = true, const std :: size_t & seed = 123,
+               const int32_t & Npartitions = 1);
+
+  /**
+  * @brief Number of molecules of a species in a voxel
+  *
+  */
+  int32_t get (const int64_t & voxel, const int32_t & species) const { return this->state[voxel * this->Nspecies + species]; }
+
+  /**
+  * @brief Set the number of molecules of a species in a voxel
+  *
+  * @details The propensities are updated at the next call of run.
+  *
+  */
+  void set (const int64_t & voxel, const int32_t & species, const int32_t & n);
+
+  /**
+  * @brief Copy the population of a species (nz x ny x nx, row-major)
+  *
+  */
+  void population (const int32_t & species, int32_t * out) const;
+
+  double time () const { return this->t; }
+  int64_t voxels () const { return this->Nvoxels; }
+
+  /**
+  * @brief Simulate up to a final time
+  *
+  * @param max_time End time of the simulation.
+  * @param window Interval of synchronization of the partitions (if <= 0, a single window
+  * with one partition and a tenth of the fastest jump time 1 / max(D) otherwise).
+  *
+  * @return The number of events (reactions and jumps).
+  *
+  */
+  int64_t run (const double & max_time, const double & window = 0.);
+};
+
+#endif // __spatial_ssa_h__
@@ -0,0 +1,283 @@
+#ifndef __spring_layout_h__
+#define __spring_layout_h__
+
+#include <vector>
+#include <array>
+#include <memory>
+#include <functional>
+#include <algorithm>
+#include <string>
+#include <cstdint>
+
+static constexpr int32_t LAYOUT_DIM = 2; ///< Number of dimensions of the layout
+
+/**
+* @brief Aligned buffer of floating point values
+*
+* @details The buffer is over-allocated and the data pointer
+* is moved forward up to the first address multiple of the
+* alignment value (cache line), so that the force loops can
+* use aligned vector loads.
+*
+*/
+struct aligned_array
+{
+  static constexpr std :: size_t alignment = 64;
+
+  std :: unique_ptr < float[] > buffer;
+  float * data;
+
+  aligned_array () : buffer(nullptr), data(nullptr)
+  {
+  }
+
+  aligned_array (const int32_t & size) : buffer(new float[size + alignment / sizeof(float)])
+  {
+    void * ptr = this->buffer.get();
+    std :: size_t space = (size + alignment / sizeof(float)) * sizeof(float);
+    this->data = static_cast < float * >(std :: align(alignment, size * sizeof(float), ptr, space));
+    std :: fill_n(this->data, size, 0.f);
+  }
+
+  float & operator[] (const int32_t & i) { return this->data[i]; }
+  const float & operator[] (const int32_t & i) const { return this->data[i]; }
+};
+
+/**
+* @brief Graph ingestion structure
+*
+* @details The input edge list is remapped to dense node
+* indices (so the node IDs can be arbitrary and non-contiguous),
+* self-loops and duplicated edges are removed and the nodes
+* are relabelled according to a Reverse Cuthill-McKee ordering,
+* so that connected nodes are close in memory.
+* The adjacency is stored in CSR format and the undirected
+* edges are stored once as sorted COO (src < dst).
+*
+*/
+struct graph
+{
+  int32_t Nnodes;
+  int32_t Nedges;
+
+  std :: vector < int32_t > labels;    // dense index -> original node ID
+  std :: vector < int32_t > offsets;   // CSR row pointers
+  std :: vector < int32_t > adjacency; // CSR column indices
+  std :: vector < int32_t > src;       // sorted COO source
+  std :: vector < int32_t > dst;       // sorted COO destination
+};
+
+/**
+* @brief Node storage in Structure-of-Arrays format
+*
+* @details Positions and forces are stored in separate aligned
+* arrays, one for each dimension.
+*
+*/
+struct nodes
+{
+  int32_t Nnodes;
+
+  std :: array < aligned_array, LAYOUT_DIM > pos;
+  std :: array < aligned_array, LAYOUT_DIM > force;
+
+  nodes (const int32_t & Nnodes) : Nnodes(Nnodes)
+  {
+    for (int32_t d = 0; d < LAYOUT_DIM; ++d)
+    {
+      this->pos[d] = aligned_array(Nnodes);
+      this->force[d] = aligned_array(Nnodes);
+    }
+  }
+};
+
+/**
+* @brief Function called at the end of each layout iteration
+*
+* @details It receives the current graph level, the node
+* positions and the iteration number (e.g. for visualization).
+*
+*/
+using layout_callback = std :: function < void (const graph &, const nodes &, const int32_t &) >;
+
+
+/**
+* @brief Build the CSR adjacency of a dense edge list
+*
+* @param Nnodes Number of nodes.
+* @param src Source of each undirected edge.
+* @param dst Destination of each undirected edge.
+* @param offsets The resulting CSR row pointers.
+* @param adjacency The resulting CSR column indices.
+*
+*/
+void build_csr (const int32_t & Nnodes,
+                const std :: vector < int32_t > & src, const std :: vector < int32_t > & dst,
+                std :: vector < int32_t > & offsets, std :: vector < int32_t > & adjacency);
+
+/**
+* @brief Reverse Cuthill-McKee ordering
+*
+* @details Each connected component is visited in BFS order
+* starting from its minimum degree node and the neighbours are
+* enqueued by increasing degree. The final order is reversed.
+*
+* @param g Graph in CSR format.
+*
+* @return The permutation as old index -> new index.
+*
+*/
+std :: vector < int32_t > reverse_cuthill_mckee (const graph & g);
+
+/**
+* @brief Set the edges of a dense graph
+*
+* @details The edges are sorted, the duplicated ones are
+* removed and the CSR adjacency is rebuilt.
+*
+* @param g Graph with a valid number of nodes.
+* @param coo Undirected edges as (min, max) dense index pairs.
+*
+*/
+void set_edges (graph & g, std :: vector < std :: pair < int32_t, int32_t > > & coo);
+
+/**
+* @brief Graph ingestion
+*
+* @param edges Array of (Nedges x 2) node IDs.
+* @param Nedges Number of edges.
+* @param reorder Switch on/off the RCM locality reordering.
+*
+* @return The dense graph.
+*
+*/
+graph make_graph (const int32_t * edges, const int32_t & Nedges, bool reorder = true);
+
+/**
+* @brief Graph coarsening by edge matching
+*
+* @details Each unmatched node is collapsed together with its
+* unmatched neighbour of minimum degree (nodes without free
+* neighbours are kept alone). The coarse edges are the
+* projection of the fine ones without self-loops.
+*
+* @param g Fine graph.
+* @param parent The resulting fine index -> coarse index map.
+*
+* @return The coarse graph.
+*
+*/
+graph coarsen (const graph & g, std :: vector < int32_t > & parent);
+
+/**
+* @brief Force-directed relaxation of a single graph level
+*
+* @details The Coulomb and Hooke forces are applied and the
+* nodes are moved by the (clamped) resultant force until the
+* mean displacement per node drops below the tolerance or
+* the maximum number of iterations is reached.
+*
+* @param g Graph.
+* @param nd Node positions (used as initial condition).
+* @param iterations Maximum number of iterations.
+* @param force_strength Natural spring length.
+* @param damping Damping of the resultant force.
+* @param max_velocity Maximum displacement per iteration.
+* @param max_distance Cut-off distance of the forces.
+* @param tolerance Threshold of the mean displacement (as fraction of
+* max_velocity) for the early stop.
+* @param callback Function called after each iteration (it could be nullptr).
+*
+* @return The number of performed iterations.
+*
+*/
+int32_t relax (const graph & g, nodes & nd,
+               const int32_t & iterations,
+               const float & force_strength, const float & damping,
+               const float & max_velocity, const float & max_distance,
+               const float & tolerance, const layout_callback & callback = nullptr);
+
+/**
+* @brief Copy the node positions in a (Nnodes x LAYOUT_DIM) row-major buffer
+*
+* @details The node positions follow the order of g.labels.
+*
+*/
+std :: vector < float > positions (const nodes & nd);
+
+/**
+* @brief Spring layout
+*
+* @details Single level force-directed layout starting from
+* all the nodes in the origin.
+*
+* @return The node positions as (Nnodes x LAYOUT_DIM) row-major buffer.
+*
+*/
+std :: vector < float > spring_layout (const graph & g,
+                                       int iterations = 1000,
+                                       float force_strength = 5.f,
+                                       float damping = .01f,
+                                       float max_velocity = 2.f,
+                                       float max_distance = 50.f,
+                                       float tolerance = 5e-2f,
+                                       const layout_callback & callback = nullptr);
+
+/**
+* @brief Multilevel spring layout
+*
+* @details The graph is recursively coarsened by edge matching
+* (FM^3 style) up to min_nodes nodes (or until the matching
+* stops reducing the graph). The coarsest level is laid out
+* first and each level is interpolated down to the finer one,
+* placing the nodes around the position of their coarse parent,
+* and refined by the force-directed relaxation.
+* Since every level starts from an (almost) untangled layout
+* the convergence-based early stop is reached in few iterations.
+*
+* @return The node positions as (Nnodes x LAYOUT_DIM) row-major buffer.
+*
+*/
+std :: vector < float > multilevel_layout (const graph & g,
+                                           int32_t min_nodes = 16,
+                                           int iterations = 1000,
+                                           float force_strength = 5.f,
+                                           float damping = .01f,
+                                           float max_velocity = 2.f,
+                                           float max_distance = 50.f,
+                                           float tolerance = 5e-2f,
+                                           const layout_callback & callback = nullptr);
+
+/**
+* @brief Multilevel spring layout with checkpoint
+*
+* @details Same layout of multilevel_layout, with a snapshot of
+* the current level (index, performed iterations and node
+* positions) written every checkpoint_every iterations and at the
+* end of each level (asynchronously, see checkpoint.h).
+* The coarsening is deterministic, so if the checkpoint file holds
+* a valid snapshot of the same graph (checked by a hash of the CSR
+* adjacency) the layout restarts from its level (the forces
+* are recomputed at each iteration, so the positions are the whole
+* state) and the result is bit-exact with an uninterrupted run.
+*
+* @param g Graph.
+* @param checkpoint Checkpoint file.
+* @param checkpoint_every Number of iterations between two snapshots.
+*
+* @return The node positions as (Nnodes x LAYOUT_DIM) row-major buffer.
+*
+*/
+std :: vector < float > multilevel_layout (const graph & g,
+                                           const std :: string & checkpoint,
+                                           const int32_t & checkpoint_every,
+                                           int32_t min_nodes = 16,
+                                           int iterations = 1000,
+                                           float force_strength = 5.f,
+                                           float damping = .01f,
+                                           float max_velocity = 2.f,
+                                           float max_distance = 50.f,
+                                           float tolerance = 5e-2f,
+                                           const layout_callback & callback = nullptr);
+
+#endif // __spring_layout_h__
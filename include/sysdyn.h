@@ -0,0 +1,41 @@
+#ifndef __sysdyn_h__
+#define __sysdyn_h__
+
+/**
+* @brief SysDyn core library
+*
+* @details Umbrella header of the numerical kernels (no
+* dependency on OpenCV). The template kernels are header-only
+* (.hpp), while the others are compiled in the sysdyn library (.h).
+*
+*/
+
+#include <thomas.h>
+#include <gauss_seidel.h>
+#include <kalman_filter.h>
+#include <bernoulli.h>
+#include <spring_layout.h>
+#include <chemical_master_equation.h>
+#include <checkpoint.h>
+#include <spatial_ssa.h>
+#include <finite_state_projection.h>
+
+#include <kinetics.hpp>
+#include <brusselator.hpp>
+#include <reaction_diffusion.hpp>
+#include <iterated_maps.hpp>
+#include <bifurcation.hpp>
+#include <grassberger_procaccia.hpp>
+#include <false_nearest_neighbours.hpp>
+#include <mutual_information.hpp>
+#include <ode_models.hpp>
+#include <parameter_estimation.hpp>
+#include <sensitivity_analysis.hpp>
+#include <basins.hpp>
+#include <linear_algebra.hpp>
+#include <continuation.hpp>
+#include <matrix_exponential.hpp>
+#include <lyapunov.hpp>
+#include <recurrence.hpp>
+
+#endif // __sysdyn_h__
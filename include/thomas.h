@@ -0,0 +1,28 @@
+#ifndef __thomas_h__
+#define __thomas_h__
+
+#include <memory>
+#include <cstdint>
+
+/**
+* @brief Thomas algorithm for tridiagonal systems
+*
+* @details Solve the system A x = d where A is a tridiagonal
+* matrix given by its lower (a), main (b) and upper (c) diagonals.
+* The forward sweep is performed in-place on c and d.
+*
+* @param b Main diagonal (nb values).
+* @param a Lower diagonal (nb - 1 values). If nullptr the values of
+* the upper diagonal are used (symmetric matrix).
+* @param c Upper diagonal (nb - 1 values), overwritten.
+* @param d Right hand side (nb values), overwritten.
+* @param nb Number of unknowns.
+*
+* @return The solution array.
+*
+*/
+std :: unique_ptr < float[] > Thomas (const float * b, const float * a,
+                                      float * c, float * d,
+                                      const int32_t & nb);
+
+#endif // __thomas_h__
@@ -0,0 +1,93 @@
+#include <bernoulli.h>
+
+#include <cmath>
+
+void fixed_lattice :: from_double (const double * G, uint64_t seed)
+{
+  uint64_t * hi = this->plane(0);
+
+  for (int32_t w = 1; w < this->words; ++w)
+  {
+    uint64_t * low = this->plane(w);
+
+    for (int64_t i = 0; i < this->size; ++i)
+    {
+      if ( !seed )
+      {
+        low[i] = 0;
+        continue;
+      }
+
+      // splitmix64 stream
+      uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+      z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+      z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+      low[i] = z ^ (z >> 31);
+    }
+  }
+
+  for (int64_t i = 0; i < this->size; ++i)
+  {
+    if (G[i] >= 1.)
+    {
+      for (int32_t w = 0; w < this->words; ++w)
+        this->plane(w)[i] = ~uint64_t(0);
+      continue;
+    }
+
+    // 2^64 * g is exact in double (53 significant bits)
+    hi[i] = G[i] > 0. ? static_cast < uint64_t >(std :: ldexp(G[i], 64)) : uint64_t(0);
+  }
+}
+
+void fixed_lattice :: to_double (double * G) const
+{
+  const uint64_t * hi = this->plane(0);
+
+  for (int64_t i = 0; i < this->size; ++i)
+    G[i] = std :: ldexp(static_cast < double >(hi[i] >> 11), -53);
+}
+
+void bernoulli (fixed_lattice & G, const int64_t & iteration)
+{
+  const int64_t word_shift = iteration / 64;
+  const int32_t bit_shift = static_cast < int32_t >(iteration % 64);
+
+  for (int32_t w = 0; w < G.words; ++w)
+  {
+    uint64_t * dst = G.plane(w);
+
+    const int64_t src_w = w + word_shift;
+
+    if (src_w >= G.words)
+    {
+      std :: fill_n(dst, G.size, uint64_t(0));
+      continue;
+    }
+
+    const uint64_t * src = G.plane(static_cast < int32_t >(src_w));
+    const uint64_t * low = src_w + 1 < G.words ? G.plane(static_cast < int32_t >(src_w + 1)) : nullptr;
+
+    if ( !bit_shift )
+    {
+      if (src != dst)
+        std :: copy_n(src, G.size, dst);
+    }
+    else if ( !low )
+    {
+#ifdef _OPENMP
+      #pragma omp parallel for simd
+#endif
+      for (int64_t i = 0; i < G.size; ++i)
+        dst[i] = src[i] << bit_shift;
+    }
+    else
+    {
+#ifdef _OPENMP
+      #pragma omp parallel for simd
+#endif
+      for (int64_t i = 0; i < G.size; ++i)
+        dst[i] = (src[i] << bit_shift) | (low[i] >> (64 - bit_shift));
+    }
+  }
+}
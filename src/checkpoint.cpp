@@ -0,0 +1,419 @@
+#include <checkpoint.h>
+#include <profiler.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CHECKPOINT_POSIX
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+
+namespace
+{
+
+const char CHECKPOINT_MAGIC[8] = {'S', 'Y', 'S', 'D', 'Y', 'N', 'C', 'K'};
+
+uint64_t fnv1a (const char * data, const std :: size_t & bytes, uint64_t hash = 14695981039346656037ull)
+{
+  for (std :: size_t i = 0; i < bytes; ++i)
+  {
+    hash ^= static_cast < uint8_t >(data[i]);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+std :: size_t aligned (const std :: size_t & n)
+{
+  return (n + CHECKPOINT_ALIGN - 1) / CHECKPOINT_ALIGN * CHECKPOINT_ALIGN;
+}
+
+#ifdef CHECKPOINT_POSIX
+
+/**
+* @brief Write a whole buffer to a file descriptor
+*
+*/
+bool write_all (const int & fd, const char * ptr, std :: size_t left)
+{
+  while (left > 0)
+  {
+    const ssize_t written = ::write(fd, ptr, left);
+    if (written <= 0)
+      return false;
+    ptr += written;
+    left -= static_cast < std :: size_t >(written);
+  }
+  return true;
+}
+
+#endif // CHECKPOINT_POSIX
+
+/**
+* @brief Write a buffer and flush it to disk
+*
+*/
+bool write_file (const std :: string & filename, const std :: vector < const char * > & blocks,
+                 const std :: vector < std :: size_t > & sizes)
+{
+#ifdef CHECKPOINT_POSIX
+
+  const int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+  if (fd < 0)
+    return false;
+
+  bool ok = true;
+
+  for (std :: size_t b = 0; b < blocks.size() && ok; ++b)
+    ok = write_all(fd, blocks[b], sizes[b]);
+
+  ok = ok && ::fsync(fd) == 0;
+  ok = ::close(fd) == 0 && ok;
+
+  return ok;
+
+#else
+
+  std :: ofstream os(filename, std :: ios :: binary | std :: ios :: trunc);
+
+  for (std :: size_t b = 0; b < blocks.size() && os; ++b)
+    os.write(blocks[b], sizes[b]);
+
+  os.flush();
+  return static_cast < bool >(os);
+
+#endif // CHECKPOINT_POSIX
+}
+
+/**
+* @brief Append a buffer to a file and flush it to disk
+*
+* @details If truncate is true the file is first cut (or extended)
+* to size bytes, i.e. the valid part of the stream.
+*
+*/
+bool append_file (const std :: string & filename, const char * data, const std :: size_t & bytes,
+                  const bool & truncate, const uint64_t & size)
+{
+#ifdef CHECKPOINT_POSIX
+
+  const int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT, 0644);
+
+  if (fd < 0)
+    return false;
+
+  bool ok = !truncate || ::ftruncate(fd, static_cast < off_t >(size)) == 0;
+  ok = ok && ::lseek(fd, 0, SEEK_END) >= 0;
+  ok = ok && write_all(fd, data, bytes);
+  ok = ok && ::fsync(fd) == 0;
+  ok = ::close(fd) == 0 && ok;
+
+  return ok;
+
+#else
+
+  if (truncate)
+  {
+    std :: vector < char > keep(static_cast < std :: size_t >(size), 0);
+    {
+      std :: ifstream is(filename, std :: ios :: binary);
+      is.read(keep.data(), keep.size());
+    }
+    std :: ofstream os(filename, std :: ios :: binary | std :: ios :: trunc);
+    os.write(keep.data(), keep.size());
+    if ( !os )
+      return false;
+  }
+
+  std :: ofstream os(filename, std :: ios :: binary | std :: ios :: app);
+  os.write(data, bytes);
+  os.flush();
+  return static_cast < bool >(os);
+
+#endif // CHECKPOINT_POSIX
+}
+
+} // end namespace
+
+
+checkpoint_writer :: checkpoint_writer (const std :: string & filename, const uint64_t & stream) : filename(filename),
+                                                                                                  stream_size(stream), stream_start(stream),
+                                                                                                  stream_ready(false), staging(0),
+                                                                                                  pending(false), stop(false), status(true)
+{
+  this->worker = std :: thread(&checkpoint_writer :: run, this);
+}
+
+checkpoint_writer :: ~checkpoint_writer ()
+{
+  {
+    std :: unique_lock < std :: mutex > lock(this->mutex);
+    this->cv.wait(lock, [this] { return !this->pending; });
+    this->stop = true;
+  }
+  this->cv.notify_all();
+  this->worker.join();
+}
+
+void checkpoint_writer :: begin (const int64_t & iteration, const double & time)
+{
+  snapshot & s = this->buffers[this->staging];
+
+  s.sections.clear();
+  s.payload.clear();
+  s.tail.clear();
+  s.iteration = iteration;
+  s.time = time;
+  s.stream = this->stream_size;
+}
+
+void checkpoint_writer :: add (const std :: string & name, const void * data, const std :: size_t & bytes)
+{
+  PROFILE_SCOPE("checkpoint.add");
+
+  snapshot & s = this->buffers[this->staging];
+
+  checkpoint_section section;
+  std :: memset(&section, 0, sizeof(section));
+  std :: strncpy(section.name, name.c_str(), sizeof(section.name) - 1);
+
+  // offsets relative to the payload (fixed in the writer thread)
+  const std :: size_t offset = aligned(s.payload.size());
+  section.offset = offset;
+  section.size = bytes;
+
+  s.payload.resize(offset + aligned(bytes), 0);
+  if (bytes)
+    std :: memcpy(s.payload.data() + offset, data, bytes);
+
+  s.sections.push_back(section);
+}
+
+void checkpoint_writer :: append (const void * data, const std :: size_t & bytes)
+{
+  PROFILE_SCOPE("checkpoint.append");
+
+  snapshot & s = this->buffers[this->staging];
+
+  const char * ptr = static_cast < const char * >(data);
+  s.tail.insert(s.tail.end(), ptr, ptr + bytes);
+
+  this->stream_size += bytes;
+  s.stream = this->stream_size;
+}
+
+void checkpoint_writer :: commit ()
+{
+  PROFILE_SCOPE("checkpoint.commit");
+
+  {
+    std :: unique_lock < std :: mutex > lock(this->mutex);
+    this->cv.wait(lock, [this] { return !this->pending; });
+
+    this->pending = true;
+    this->staging ^= 1;
+  }
+  this->cv.notify_all();
+}
+
+bool checkpoint_writer :: wait ()
+{
+  std :: unique_lock < std :: mutex > lock(this->mutex);
+  this->cv.wait(lock, [this] { return !this->pending; });
+  return this->status;
+}
+
+void checkpoint_writer :: run ()
+{
+  while (true)
+  {
+    int32_t index;
+
+    {
+      std :: unique_lock < std :: mutex > lock(this->mutex);
+      this->cv.wait(lock, [this] { return this->pending || this->stop; });
+
+      if ( !this->pending )
+        return;
+
+      // the committed buffer is the one not staged
+      index = this->staging ^ 1;
+    }
+
+    snapshot & s = this->buffers[index];
+
+    const std :: size_t table = sizeof(checkpoint_section) * s.sections.size();
+    const std :: size_t start = sizeof(checkpoint_header) + table;
+
+    for (auto & section : s.sections)
+      section.offset += start;
+
+    checkpoint_header header;
+    std :: memset(&header, 0, sizeof(header));
+    std :: memcpy(header.magic, CHECKPOINT_MAGIC, sizeof(header.magic));
+    header.version = CHECKPOINT_VERSION;
+    header.Nsections = static_cast < uint32_t >(s.sections.size());
+    header.iteration = s.iteration;
+    header.time = s.time;
+    header.size = start + s.payload.size();
+    header.checksum = fnv1a(s.payload.data(), s.payload.size(),
+                            fnv1a(reinterpret_cast < const char * >(s.sections.data()), table));
+    header.stream = s.stream;
+
+    bool ok = true;
+
+    // the stream is on disk before the snapshot which refers to it
+    if ( !s.tail.empty() )
+    {
+      ok = append_file(this->filename + ".stream", s.tail.data(), s.tail.size(), !this->stream_ready, this->stream_start);
+      // a failed first write truncates the stream again at the next snapshot
+      this->stream_ready = this->stream_ready || ok;
+    }
+
+    // the rename replaces the previous snapshot only with a complete file
+    const std :: string tmp = this->filename + ".tmp";
+
+    ok = ok && write_file(tmp, {reinterpret_cast < const char * >(&header),
+                               reinterpret_cast < const char * >(s.sections.data()),
+                               s.payload.data()},
+                              {sizeof(header), table, s.payload.size()});
+
+    ok = ok && std :: rename(tmp.c_str(), this->filename.c_str()) == 0;
+
+    {
+      std :: lock_guard < std :: mutex > lock(this->mutex);
+      this->status = ok;
+      this->pending = false;
+    }
+    this->cv.notify_all();
+  }
+}
+
+
+checkpoint_reader :: checkpoint_reader (const std :: string & filename) : filename(filename), data(nullptr), bytes(0), fallback(),
+                                                                          mapped(false), ok(false)
+{
+#ifdef CHECKPOINT_POSIX
+
+  const int fd = ::open(filename.c_str(), O_RDONLY);
+
+  if (fd < 0)
+    return;
+
+  struct stat info;
+  if (::fstat(fd, &info) == 0 && info.st_size >= static_cast < off_t >(sizeof(checkpoint_header)))
+  {
+    void * ptr = ::mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (ptr != MAP_FAILED)
+    {
+      this->data = static_cast < const char * >(ptr);
+      this->bytes = static_cast < std :: size_t >(info.st_size);
+      this->mapped = true;
+    }
+  }
+  ::close(fd);
+
+#else
+
+  std :: ifstream is(filename, std :: ios :: binary | std :: ios :: ate);
+
+  if ( !is )
+    return;
+
+  this->fallback.resize(static_cast < std :: size_t >(is.tellg()));
+  is.seekg(0);
+  is.read(this->fallback.data(), this->fallback.size());
+  this->data = this->fallback.data();
+  this->bytes = this->fallback.size();
+
+#endif // CHECKPOINT_POSIX
+
+  if ( !this->data || this->bytes < sizeof(checkpoint_header) )
+    return;
+
+  const checkpoint_header * h = this->header();
+
+  if (std :: memcmp(h->magic, CHECKPOINT_MAGIC, sizeof(h->magic)) || h->version != CHECKPOINT_VERSION || h->size != this->bytes)
+    return;
+
+  const std :: size_t table = sizeof(checkpoint_section) * h->Nsections;
+  const std :: size_t start = sizeof(checkpoint_header) + table;
+
+  if (start > this->bytes)
+    return;
+
+  const uint64_t checksum = fnv1a(this->data + start, this->bytes - start,
+                                  fnv1a(this->data + sizeof(checkpoint_header), table));
+  if (checksum != h->checksum)
+    return;
+
+  const checkpoint_section * sections = reinterpret_cast < const checkpoint_section * >(this->data + sizeof(checkpoint_header));
+
+  for (uint32_t i = 0; i < h->Nsections; ++i)
+    if (sections[i].offset < start || sections[i].offset + sections[i].size > this->bytes)
+      return;
+
+  this->ok = true;
+}
+
+checkpoint_reader :: ~checkpoint_reader ()
+{
+#ifdef CHECKPOINT_POSIX
+  if (this->mapped)
+    ::munmap(const_cast < char * >(this->data), this->bytes);
+#endif
+}
+
+const void * checkpoint_reader :: section (const std :: string & name, std :: size_t & size) const
+{
+  if ( !this->ok )
+    return nullptr;
+
+  const checkpoint_header * h = this->header();
+  const checkpoint_section * sections = reinterpret_cast < const checkpoint_section * >(this->data + sizeof(checkpoint_header));
+
+  for (uint32_t i = 0; i < h->Nsections; ++i)
+    if (std :: strncmp(sections[i].name, name.c_str(), sizeof(sections[i].name)) == 0)
+    {
+      size = static_cast < std :: size_t >(sections[i].size);
+      return this->data + sections[i].offset;
+    }
+
+  return nullptr;
+}
+
+bool checkpoint_reader :: read (const std :: string & name, void * dst, const std :: size_t & size) const
+{
+  std :: size_t found = 0;
+  const void * src = this->section(name, found);
+
+  if ( !src || found != size )
+    return false;
+
+  std :: memcpy(dst, src, size);
+  return true;
+}
+
+bool checkpoint_reader :: read_stream (std :: vector < char > & dst) const
+{
+  if ( !this->ok )
+    return false;
+
+  dst.resize(static_cast < std :: size_t >(this->stream()));
+
+  if (dst.empty())
+    return true;
+
+  std :: ifstream is(this->filename + ".stream", std :: ios :: binary);
+  is.read(dst.data(), dst.size());
+
+  return static_cast < std :: size_t >(is.gcount()) == dst.size();
+}
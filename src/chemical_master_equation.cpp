@@ -0,0 +1,173 @@
+#include <chemical_master_equation.h>
+#include <checkpoint.h>
+#include <profiler.hpp>
+
+#include <random>
+#include <algorithm>
+#include <array>
+#include <memory>
+#include <cmath>
+
+namespace
+{
+
+/**
+* @brief Snapshot of the resumable state
+*
+* @details The snapshot holds the current state and the engine,
+* while the events since the previous snapshot (from streamed)
+* are appended to the stream as (x, y, t) records, so the cost
+* of a snapshot does not grow with the trajectory.
+*
+*/
+void snapshot (checkpoint_writer & writer,
+               const std :: vector < double > & x, const std :: vector < double > & y,
+               const std :: vector < double > & t, const std :: mt19937 & mt,
+               std :: size_t & streamed, std :: vector < double > & records)
+{
+  const std :: size_t n = t.size();
+
+  records.resize(3 * (n - streamed));
+  for (std :: size_t i = streamed; i < n; ++i)
+  {
+    records[3 * (i - streamed)    ] = x[i];
+    records[3 * (i - streamed) + 1] = y[i];
+    records[3 * (i - streamed) + 2] = t[i];
+  }
+  streamed = n;
+
+  const double state[3] = {x.back(), y.back(), t.back()};
+
+  writer.begin(static_cast < int64_t >(n) - 1, t.back());
+  writer.add("state", state, sizeof(state));
+  writer.add_engine("engine", mt);
+  writer.append(records.data(), records.size() * sizeof(double));
+  writer.commit();
+}
+
+void simulate (std :: vector < double > & x, std :: vector < double > & y,
+               std :: vector < double > & t,
+               const double & A, const double & B,
+               const double & omega, const double & max_time,
+               double ti, double xi, double yi,
+               std :: mt19937 & mt,
+               checkpoint_writer * writer, const int64_t & checkpoint_every,
+               std :: size_t streamed)
+{
+  std :: uniform_real_distribution < double > uniform(0., 1.);
+  std :: vector < double > records;
+
+  int64_t events = 0;
+
+  while (ti <= max_time)
+  {
+    std :: array < double, 4 > c{ {A * omega,
+                                   A * omega + B * xi,
+                                   A * omega + B * xi + xi,
+                                   A * omega + B * xi + xi + xi * (xi - 1.) * yi / (omega * omega)
+                                   }
+                                 };
+
+    const double rng1 = uniform(mt);
+    const double rng2 = uniform(mt);
+    const double tau = -std :: log(rng1) / c[3];
+    const double uct = rng2 * c.back();
+
+    ti += tau;
+
+    if     (uct < c[0]) ++xi;
+    else if(uct < c[1]) {--xi; ++yi;}
+    else if(uct < c[2]) --xi;
+    else if(uct < c[3]) {++xi; --yi;}
+
+    x.push_back(xi);
+    y.push_back(yi);
+    t.push_back(ti);
+
+    ++events;
+
+    if (writer && events % checkpoint_every == 0)
+      snapshot(*writer, x, y, t, mt, streamed, records);
+  }
+
+  // the final state (a restart of a completed run returns immediately)
+  if (writer)
+    snapshot(*writer, x, y, t, mt, streamed, records);
+
+  PROFILE_COUNT("BrusselatorCME", events);
+}
+
+} // end namespace
+
+
+void BrusselatorCME (std :: vector < double > & x, std :: vector < double > & y,
+                     std :: vector < double > & t,
+                     const double & A, const double & B,
+                     const double & omega, double max_time,
+                     std :: size_t seed)
+{
+  PROFILE_SCOPE("BrusselatorCME");
+
+  std :: mt19937 mt(seed);
+
+  simulate(x, y, t, A, B, omega, max_time, t[0], x[0], y[0], mt, nullptr, 0, 0);
+}
+
+
+bool BrusselatorCME (std :: vector < double > & x, std :: vector < double > & y,
+                     std :: vector < double > & t,
+                     const double & A, const double & B,
+                     const double & omega, double max_time,
+                     std :: size_t seed,
+                     const std :: string & checkpoint,
+                     const int64_t & checkpoint_every)
+{
+  PROFILE_SCOPE("BrusselatorCME");
+
+  std :: mt19937 mt(seed);
+
+  bool restarted = false;
+  uint64_t stream = 0;
+
+  {
+    checkpoint_reader snapshot(checkpoint);
+
+    if (snapshot.valid())
+    {
+      double state[3];
+      std :: vector < double > records;
+      std :: mt19937 smt;
+
+      // the trajectory is the stream up to the snapshot (initial condition included)
+      if (snapshot.read("state", state, sizeof(state)) && snapshot.read_engine("engine", smt) &&
+          snapshot.read_stream(records) &&
+          records.size() == 3 * static_cast < std :: size_t >(snapshot.iteration() + 1) &&
+          records[records.size() - 1] == state[2])
+      {
+        const std :: size_t n = records.size() / 3;
+        x.resize(n);
+        y.resize(n);
+        t.resize(n);
+        for (std :: size_t i = 0; i < n; ++i)
+        {
+          x[i] = records[3 * i];
+          y[i] = records[3 * i + 1];
+          t[i] = records[3 * i + 2];
+        }
+        mt = smt;
+        stream = snapshot.stream();
+        restarted = true;
+      }
+    }
+  }
+
+  std :: unique_ptr < checkpoint_writer > writer(new checkpoint_writer(checkpoint, stream));
+
+  // a restart continues from the last event of the snapshot (already in the stream)
+  simulate(x, y, t, A, B, omega, max_time, t.back(), x.back(), y.back(), mt,
+           writer.get(), std :: max(checkpoint_every, int64_t(1)), restarted ? t.size() : 0);
+
+  writer->wait();
+
+  return restarted;
+}
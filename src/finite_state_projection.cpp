@@ -0,0 +1,606 @@
+#include <finite_state_projection.h>
+#include <matrix_exponential.hpp>
+#include <profiler.hpp>
+
+#include <algorithm>
+#include <numeric>
+#include <limits>
+#include <cmath>
+
+
+namespace
+{
+
+double dot (const double * x, const double * y, const int64_t & N)
+{
+  double sum = 0.;
+
+#ifdef _OPENMP
+  #pragma omp parallel for reduction(+ : sum)
+#endif
+  for (int64_t i = 0; i < N; ++i)
+    sum += x[i] * y[i];
+
+  return sum;
+}
+
+void axpy (const double & a, const double * x, double * y, const int64_t & N)
+{
+#ifdef _OPENMP
+  #pragma omp parallel for
+#endif
+  for (int64_t i = 0; i < N; ++i)
+    y[i] += a * x[i];
+}
+
+void scale (const double & a, double * x, const int64_t & N)
+{
+#ifdef _OPENMP
+  #pragma omp parallel for
+#endif
+  for (int64_t i = 0; i < N; ++i)
+    x[i] *= a;
+}
+
+/**
+* @brief Round a step size to two significant digits (as Expokit)
+*
+*/
+double round_step (const double & tau)
+{
+  const double s = std :: pow(10., std :: floor(std :: log10(tau)) - 1.);
+  return std :: ceil(tau / s) * s;
+}
+
+} // end namespace
+
+
+finite_state_projection :: finite_state_projection (const int32_t & Nspecies, const std :: vector < ssa_reaction > & reactions,
+                                                    const double & omega, const std :: vector < int32_t > & initial,
+                                                    const std :: vector < int32_t > & bounds, const int32_t & krylov) :
+                                                    Nspecies(Nspecies), Nreactions(static_cast < int32_t >(reactions.size())),
+                                                    Nstates(0), t(0.), krylov(std :: max(krylov, 2))
+{
+  for (const auto & reaction : reactions)
+  {
+    std :: vector < int32_t > multiplicity(Nspecies, 0);
+    std :: vector < int32_t > net(Nspecies, 0);
+
+    for (const auto & s : reaction.reactants)
+    {
+      ++multiplicity[s];
+      --net[s];
+    }
+    for (const auto & s : reaction.products)
+      ++net[s];
+
+    std :: vector < std :: pair < int32_t, int32_t > > in;
+    for (int32_t s = 0; s < Nspecies; ++s)
+      if (multiplicity[s])
+        in.emplace_back(s, multiplicity[s]);
+
+    this->reactants.push_back(in);
+    this->change.push_back(net);
+    this->rates.push_back(reaction.rate * std :: pow(omega, 1. - static_cast < double >(reaction.reactants.size())));
+  }
+
+  std :: vector < int32_t > box(Nspecies);
+  for (int32_t s = 0; s < Nspecies; ++s)
+    box[s] = bounds.empty() ? 2 * initial[s] + 10 : std :: max(bounds[s], initial[s]);
+
+  // empty box (no sinks yet) and delta distribution in the initial state
+  this->bound.assign(Nspecies, 0);
+  this->strides.assign(Nspecies, 1);
+  this->Nstates = 1;
+  this->p.assign(1 + Nspecies, 0.);
+
+  int64_t index = 0;
+  this->resize(box);
+
+  for (int32_t s = 0; s < Nspecies; ++s)
+    index += initial[s] * this->strides[s];
+
+  this->p[index] = 1.;
+}
+
+
+double finite_state_projection :: propensity (const int32_t & r, const int32_t * n) const
+{
+  double a = this->rates[r];
+
+  for (const auto & reactant : this->reactants[r])
+    for (int32_t k = 0; k < reactant.second; ++k)
+      a *= static_cast < double >(std :: max(n[reactant.first] - k, 0));
+
+  return a;
+}
+
+
+void finite_state_projection :: resize (const std :: vector < int32_t > & bounds)
+{
+  PROFILE_SCOPE("finite_state_projection.resize");
+
+  std :: vector < int64_t > new_strides(this->Nspecies);
+  int64_t size = 1;
+
+  for (int32_t s = 0; s < this->Nspecies; ++s)
+  {
+    new_strides[s] = size;
+    size *= bounds[s] + 1;
+  }
+
+  // copy the probabilities of the old box (and the sinks) in the new one
+  std :: vector < double > q(size + this->Nspecies, 0.);
+
+#ifdef _OPENMP
+  #pragma omp parallel for
+#endif
+  for (int64_t i = 0; i < this->Nstates; ++i)
+  {
+    int64_t j = 0;
+    int64_t rest = i;
+
+    for (int32_t s = 0; s < this->Nspecies; ++s)
+    {
+      const int64_t n = rest % (this->bound[s] + 1);
+      rest /= this->bound[s] + 1;
+      j += n * new_strides[s];
+    }
+
+    q[j] = this->p[i];
+  }
+
+  for (int32_t s = 0; s < this->Nspecies; ++s)
+    q[size + s] = this->p[this->Nstates + s];
+
+  this->p.swap(q);
+  this->bound = bounds;
+  this->strides = new_strides;
+  this->Nstates = size;
+
+  this->assemble();
+}
+
+
+void finite_state_projection :: assemble ()
+{
+  PROFILE_SCOPE("finite_state_projection.assemble");
+
+  const int64_t N = this->Nstates;
+  const int32_t Ns = this->Nspecies;
+  const int32_t Nr = this->Nreactions;
+
+  // state of an index, and the (source, sink) index of a reaction
+  auto decode = [&] (int64_t i, int32_t * n)
+                {
+                  for (int32_t s = 0; s < Ns; ++s)
+                  {
+                    n[s] = static_cast < int32_t >(i % (this->bound[s] + 1));
+                    i /= this->bound[s] + 1;
+                  }
+                };
+
+  // species whose bound is exceeded by the reaction r from n (-1 if inside the box)
+  auto exit = [&] (const int32_t & r, const int32_t * n)
+              {
+                for (int32_t s = 0; s < Ns; ++s)
+                  if (n[s] + this->change[r][s] > this->bound[s])
+                    return s;
+                return -1;
+              };
+
+  // incoming rate of the reaction r to the state n (the source must be inside the box)
+  auto incoming = [&] (const int32_t & r, const int32_t * n, int32_t * src)
+                  {
+                    for (int32_t s = 0; s < Ns; ++s)
+                    {
+                      src[s] = n[s] - this->change[r][s];
+                      if (src[s] < 0 || src[s] > this->bound[s])
+                        return 0.;
+                    }
+                    return this->propensity(r, src);
+                  };
+
+  this->offsets.assign(N + Ns + 1, 0);
+
+  // number of entries of the rows of the box
+#ifdef _OPENMP
+  #pragma omp parallel
+#endif
+  {
+    std :: vector < int32_t > n(Ns), src(Ns);
+
+#ifdef _OPENMP
+    #pragma omp for
+#endif
+    for (int64_t i = 0; i < N; ++i)
+    {
+      decode(i, n.data());
+
+      int64_t count = 1;
+      for (int32_t r = 0; r < Nr; ++r)
+        if (incoming(r, n.data(), src.data()) > 0.)
+          ++count;
+
+      this->offsets[i + 1] = count;
+    }
+  }
+
+  // rows of the sinks: outflow of the states across the bound of each species
+  std :: vector < std :: vector < std :: pair < int32_t, double > > > sinks(Ns);
+  {
+    std :: vector < int32_t > n(Ns);
+
+    for (int64_t i = 0; i < N; ++i)
+    {
+      decode(i, n.data());
+
+      for (int32_t r = 0; r < Nr; ++r)
+      {
+        const int32_t s = exit(r, n.data());
+        if (s < 0)
+          continue;
+
+        const double a = this->propensity(r, n.data());
+        if (a > 0.)
+          sinks[s].emplace_back(static_cast < int32_t >(i), a);
+      }
+    }
+  }
+
+  for (int32_t s = 0; s < Ns; ++s)
+    this->offsets[N + s + 1] = static_cast < int64_t >(sinks[s].size());
+
+  std :: partial_sum(this->offsets.begin(), this->offsets.end(), this->offsets.begin());
+
+  this->columns.resize(this->offsets.back());
+  this->values.resize(this->offsets.back());
+
+#ifdef _OPENMP
+  #pragma omp parallel
+#endif
+  {
+    std :: vector < int32_t > n(Ns), src(Ns);
+
+#ifdef _OPENMP
+    #pragma omp for
+#endif
+    for (int64_t i = 0; i < N; ++i)
+    {
+      decode(i, n.data());
+
+      int64_t k = this->offsets[i];
+
+      // diagonal: total outflow (inside the box and towards the sinks)
+      double out = 0.;
+      for (int32_t r = 0; r < Nr; ++r)
+        out += this->propensity(r, n.data());
+
+      this->columns[k] = static_cast < int32_t >(i);
+      this->values[k++] = -out;
+
+      for (int32_t r = 0; r < Nr; ++r)
+      {
+        const double a = incoming(r, n.data(), src.data());
+        if (a > 0.)
+        {
+          int64_t j = 0;
+          for (int32_t s = 0; s < Ns; ++s)
+            j += src[s] * this->strides[s];
+
+          this->columns[k] = static_cast < int32_t >(j);
+          this->values[k++] = a;
+        }
+      }
+    }
+  }
+
+  for (int32_t s = 0; s < Ns; ++s)
+  {
+    int64_t k = this->offsets[N + s];
+    for (const auto & entry : sinks[s])
+    {
+      this->columns[k] = entry.first;
+      this->values[k++] = entry.second;
+    }
+  }
+}
+
+
+void finite_state_projection :: multiply (const double * x, double * y) const
+{
+  const int64_t rows = this->Nstates + this->Nspecies;
+
+#ifdef _OPENMP
+  #pragma omp parallel for schedule(dynamic, 4096)
+#endif
+  for (int64_t i = 0; i < rows; ++i)
+  {
+    double sum = 0.;
+    for (int64_t k = this->offsets[i]; k < this->offsets[i + 1]; ++k)
+      sum += this->values[k] * x[this->columns[k]];
+    y[i] = sum;
+  }
+}
+
+
+bool finite_state_projection :: expv (const double & T, const double & tolerance, const double & max_error)
+{
+  PROFILE_SCOPE("finite_state_projection.expv");
+
+  const int64_t N = static_cast < int64_t >(this->p.size());
+  const int32_t m = static_cast < int32_t >(std :: min(static_cast < int64_t >(this->krylov), N - 1));
+
+  if (m < 1)
+    return true;
+
+  constexpr double btol = 1e-7;  // happy breakdown
+  constexpr double gamma = .9;
+  constexpr double delta = 1.2;
+  constexpr int32_t max_reject = 10;
+
+  // infinity norm of the generator
+  double anorm = 0.;
+  for (int64_t i = 0; i < N; ++i)
+  {
+    double row = 0.;
+    for (int64_t k = this->offsets[i]; k < this->offsets[i + 1]; ++k)
+      row += std :: abs(this->values[k]);
+    anorm = std :: max(anorm, row);
+  }
+
+  std :: vector < double > & w = this->p;
+  double beta = std :: sqrt(dot(w.data(), w.data(), N));
+
+  if (anorm == 0. || beta == 0.)
+    return true;
+
+  std :: vector < double > V((m + 1) * N), Av(N);
+  std :: vector < double > H((m + 2) * (m + 2));
+
+  const double fact = std :: pow((m + 1.) / std :: exp(1.), m + 1.) * std :: sqrt(2. * std :: acos(-1.) * (m + 1.));
+  double tau = round_step((1. / anorm) * std :: pow((fact * tolerance) / (4. * beta * anorm), 1. / m));
+
+  double tk = 0.;
+  int64_t steps = 0;
+
+  while (tk < T)
+  {
+    tau = std :: min(T - tk, tau);
+
+    // Arnoldi
+    std :: fill(H.begin(), H.end(), 0.);
+
+    double * v0 = V.data();
+#ifdef _OPENMP
+    #pragma omp parallel for
+#endif
+    for (int64_t i = 0; i < N; ++i)
+      v0[i] = w[i] / beta;
+
+    int32_t mb = m;
+    bool breakdown = false;
+
+    for (int32_t j = 0; j < m; ++j)
+    {
+      double * next = V.data() + (j + 1) * N;
+      this->multiply(V.data() + j * N, next);
+
+      for (int32_t i = 0; i <= j; ++i)
+      {
+        const double h = dot(V.data() + i * N, next, N);
+        H[i * (m + 2) + j] = h;
+        axpy(-h, V.data() + i * N, next, N);
+      }
+
+      const double s = std :: sqrt(dot(next, next, N));
+
+      if (s < btol)
+      {
+        breakdown = true;
+        mb = j + 1;
+        tau = T - tk;
+        break;
+      }
+
+      H[(j + 1) * (m + 2) + j] = s;
+      scale(1. / s, next, N);
+    }
+
+    double avnorm = 0.;
+    int32_t mx = mb;
+
+    if ( !breakdown )
+    {
+      H[(m + 1) * (m + 2) + m] = 1.;
+      this->multiply(V.data() + m * N, Av.data());
+      avnorm = std :: sqrt(dot(Av.data(), Av.data(), N));
+      mx = m + 2;
+    }
+
+    // exponential of the (augmented) Hessenberg matrix with error control
+    std :: vector < double > Hm(mx * mx), Fm(mx * mx);
+    for (int32_t i = 0; i < mx; ++i)
+      for (int32_t j = 0; j < mx; ++j)
+        Hm[i * mx + j] = H[i * (m + 2) + j];
+
+    double err_loc = btol;
+    double xm = 1. / m;
+    int32_t reject = 0;
+
+    while (true)
+    {
+      if ( !expm(Hm.data(), mx, tau, Fm.data()) )
+        return false;
+
+      if (breakdown)
+        break;
+
+      const double p1 = std :: abs(Fm[m * mx]) * beta;
+      const double p2 = std :: abs(Fm[(m + 1) * mx]) * beta * avnorm;
+
+      if (p1 > 10. * p2)
+      {
+        err_loc = p2;
+        xm = 1. / m;
+      }
+      else if (p1 > p2)
+      {
+        err_loc = p1 * p2 / (p1 - p2);
+        xm = 1. / m;
+      }
+      else
+      {
+        err_loc = p1;
+        xm = 1. / std :: max(m - 1, 1);
+      }
+
+      if (err_loc <= delta * tau * tolerance)
+        break;
+
+      if (++reject > max_reject)
+        return false;
+
+      tau = round_step(gamma * tau * std :: pow(tau * tolerance / err_loc, xm));
+    }
+
+    // w = beta V F e_1 (the basis vectors of the step)
+    const int32_t Nv = breakdown ? mb : m + 1;
+
+#ifdef _OPENMP
+    #pragma omp parallel for
+#endif
+    for (int64_t i = 0; i < N; ++i)
+    {
+      double sum = 0.;
+      for (int32_t k = 0; k < Nv; ++k)
+        sum += Fm[k * mx] * V[k * N + i];
+      w[i] = beta * sum;
+    }
+
+    beta = std :: sqrt(dot(w.data(), w.data(), N));
+    tk += tau;
+    ++steps;
+
+    // the projection is already too small: stop early (the solve expands it and starts again)
+    if (beta == 0. || this->error() > max_error)
+      break;
+
+    tau = round_step(gamma * tau * std :: pow(tau * tolerance / std :: max(err_loc, 1e-300), xm));
+  }
+
+  PROFILE_COUNT("finite_state_projection.expv", steps);
+
+  return true;
+}
+
+
+bool finite_state_projection :: solve (const double & max_time, const double & tolerance, const int64_t & max_states)
+{
+  PROFILE_SCOPE("finite_state_projection.solve");
+
+  if (max_time <= this->t)
+    return true;
+
+  const double dt = max_time - this->t;
+
+  // Krylov tolerance per unit time, small compared to the projection error
+  const double krylov_tolerance = .1 * tolerance / std :: max(dt, 1.);
+
+  // initial distribution of the step and its box
+  const std :: vector < double > initial = this->p;
+  const std :: vector < int32_t > initial_bound = this->bound;
+  const std :: vector < int64_t > initial_strides = this->strides;
+  const int64_t initial_states = this->Nstates;
+
+  // restart the step from its initial distribution
+  auto restore = [&]()
+                 {
+                   this->p = initial;
+                   this->bound = initial_bound;
+                   this->strides = initial_strides;
+                   this->Nstates = initial_states;
+                 };
+
+  while (true)
+  {
+    std :: vector < double > before(this->p.end() - this->Nspecies, this->p.end());
+
+    // a failed step leaves the distribution (and the box) of its beginning
+    if ( !this->expv(dt, krylov_tolerance, tolerance) )
+    {
+      restore();
+      this->assemble();
+      return false;
+    }
+
+    if (this->error() <= tolerance)
+    {
+      this->t = max_time;
+      return true;
+    }
+
+    // expand the species which lost more probability
+    double worst = 0.;
+    std :: vector < double > leak(this->Nspecies);
+    for (int32_t s = 0; s < this->Nspecies; ++s)
+    {
+      leak[s] = this->p[this->Nstates + s] - before[s];
+      worst = std :: max(worst, leak[s]);
+    }
+
+    std :: vector < int32_t > bounds = this->bound;
+    int64_t size = 1;
+    for (int32_t s = 0; s < this->Nspecies; ++s)
+    {
+      if (leak[s] >= .1 * worst)
+        bounds[s] += std :: max(bounds[s] / 2, 10);
+      size *= bounds[s] + 1;
+    }
+
+    restore();
+
+    if (size > max_states || size > std :: numeric_limits < int32_t > :: max())
+    {
+      this->assemble();
+      return false;
+    }
+
+    this->resize(bounds);
+  }
+}
+
+
+double finite_state_projection :: error () const
+{
+  double sum = 0.;
+  for (int32_t s = 0; s < this->Nspecies; ++s)
+    sum += this->p[this->Nstates + s];
+  return sum;
+}
+
+
+double finite_state_projection :: probability (const std :: vector < int32_t > & state) const
+{
+  int64_t index = 0;
+
+  for (int32_t s = 0; s < this->Nspecies; ++s)
+  {
+    if (state[s] < 0 || state[s] > this->bound[s])
+      return 0.;
+    index += state[s] * this->strides[s];
+  }
+
+  return this->p[index];
+}
+
+
+std :: vector < double > finite_state_projection :: marginal (const int32_t & species) const
+{
+  std :: vector < double > m(this->bound[species] + 1, 0.);
+
+  for (int64_t i = 0; i < this->Nstates; ++i)
+    m[(i / this->strides[species]) % (this->bound[species] + 1)] += this->p[i];
+
+  return m;
+}
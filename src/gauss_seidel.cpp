@@ -0,0 +1,42 @@
+#include <gauss_seidel.h>
+#include <profiler.hpp>
+
+#include <numeric>
+#include <algorithm>
+#include <cmath>
+
+std :: unique_ptr < float[] > GaussSeidel (const float * A, const float * b,
+                                           const int32_t & N,
+                                           const float & tolerance,
+                                           const int32_t & max_iter)
+{
+  PROFILE_SCOPE("GaussSeidel");
+
+  std :: unique_ptr < float[] > x(new float[N]);
+  std :: fill_n(x.get(), N, 0.f);
+
+  for (int32_t it = 0; it < max_iter; ++it)
+  {
+    PROFILE_COUNT("GaussSeidel", 1);
+
+    int32_t cnt = 0;
+
+    for (int32_t i = 0; i < N; ++i)
+    {
+      const float * Ai = A + i * N;
+
+      // the first i components are already updated (in-place sweep)
+      const float diff = std :: inner_product(Ai, Ai + i, x.get(), 0.f) +
+                         std :: inner_product(Ai + i + 1, Ai + N, x.get() + i + 1, 0.f);
+      const float xi = (b[i] - diff) / Ai[i];
+
+      cnt += (std :: fabs(xi - x[i]) > tolerance) ? 1 : 0;
+      x[i] = xi;
+    }
+
+    if ( ! cnt )
+      break;
+  }
+
+  return x;
+}
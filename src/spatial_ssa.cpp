@@ -0,0 +1,432 @@
+#include <spatial_ssa.h>
+#include <profiler.hpp>
+
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+
+spatial_ssa :: spatial_ssa (const int64_t & nx, const int64_t & ny, const int64_t & nz,
+                            const int32_t & Nspecies, const std :: vector < ssa_reaction > & reactions,
+                            const std :: vector < double > & D, const double & omega,
+                            const bool & periodic, const std :: size_t & seed,
+                            const int32_t & Npartitions) : nx(nx), ny(ny), nz(nz), Nvoxels(nx * ny * nz),
+                                                           Nspecies(Nspecies), Nreactions(static_cast < int32_t >(reactions.size())),
+                                                           periodic(periodic), omega(omega), t(0.), D(D), dirty(true)
+{
+  this->depends.resize(Nspecies);
+
+  for (int32_t r = 0; r < this->Nreactions; ++r)
+  {
+    const ssa_reaction & reaction = reactions[r];
+
+    std :: vector < int32_t > net(Nspecies, 0);
+    std :: vector < int32_t > multiplicity(Nspecies, 0);
+
+    for (const auto & s : reaction.reactants)
+    {
+      ++multiplicity[s];
+      --net[s];
+    }
+    for (const auto & s : reaction.products)
+      ++net[s];
+
+    std :: vector < std :: pair < int32_t, int32_t > > in, delta;
+
+    for (int32_t s = 0; s < Nspecies; ++s)
+    {
+      if (multiplicity[s])
+      {
+        in.emplace_back(s, multiplicity[s]);
+        this->depends[s].push_back(r);
+      }
+      if (net[s])
+        delta.emplace_back(s, net[s]);
+    }
+
+    this->reactants.push_back(in);
+    this->change.push_back(delta);
+    this->rates.push_back(reaction.rate * std :: pow(omega, 1. - static_cast < double >(reaction.reactants.size())));
+  }
+
+  this->state.assign(this->Nvoxels * Nspecies, 0);
+  this->propensity.assign(this->Nvoxels * this->Nreactions, 0.);
+  this->total.assign(this->Nvoxels, 0.);
+  this->degree.resize(this->Nvoxels);
+
+  int64_t nb[6];
+  for (int64_t v = 0; v < this->Nvoxels; ++v)
+    this->degree[v] = static_cast < uint8_t >(this->neighbours(v, nb));
+
+  // slabs along the slowest axis (contiguous blocks of voxels)
+  const int64_t extent = nz > 1 ? nz : (ny > 1 ? ny : nx);
+  const int64_t stride = this->Nvoxels / extent;
+  const int32_t P = static_cast < int32_t >(std :: max(int64_t(1), std :: min(static_cast < int64_t >(Npartitions), extent)));
+
+  std :: seed_seq sequence{static_cast < uint64_t >(seed)};
+  std :: vector < uint32_t > seeds(P);
+  sequence.generate(seeds.begin(), seeds.end());
+
+  this->partitions.resize(P);
+
+  for (int32_t i = 0; i < P; ++i)
+  {
+    partition & p = this->partitions[i];
+
+    p.begin = (i * extent / P) * stride;
+    p.end = ((i + 1) * extent / P) * stride;
+    p.engine.seed(seeds[i]);
+    p.outbox.resize(P);
+    p.events = 0;
+
+    const int64_t size = p.end - p.begin;
+    p.heap.resize(size);
+    p.position.resize(size);
+  }
+}
+
+
+void spatial_ssa :: set (const int64_t & voxel, const int32_t & species, const int32_t & n)
+{
+  this->state[voxel * this->Nspecies + species] = n;
+  this->dirty = true;
+}
+
+
+void spatial_ssa :: population (const int32_t & species, int32_t * out) const
+{
+  for (int64_t v = 0; v < this->Nvoxels; ++v)
+    out[v] = this->state[v * this->Nspecies + species];
+}
+
+
+int32_t spatial_ssa :: neighbours (const int64_t & v, int64_t * nb) const
+{
+  const int64_t x = v % this->nx;
+  const int64_t y = (v / this->nx) % this->ny;
+  const int64_t z = v / (this->nx * this->ny);
+
+  const int64_t coords[3] = {x, y, z};
+  const int64_t extents[3] = {this->nx, this->ny, this->nz};
+  const int64_t strides[3] = {1, this->nx, this->nx * this->ny};
+
+  int32_t n = 0;
+
+  for (int32_t axis = 0; axis < 3; ++axis)
+  {
+    const int64_t c = coords[axis];
+    const int64_t L = extents[axis];
+    const int64_t step = strides[axis];
+
+    if (L == 1)
+      continue;
+
+    if (c > 0)
+      nb[n++] = v - step;
+    else if (this->periodic)
+      nb[n++] = v + (L - 1) * step;
+
+    if (c < L - 1)
+      nb[n++] = v + step;
+    else if (this->periodic)
+      nb[n++] = v - (L - 1) * step;
+  }
+
+  return n;
+}
+
+
+double spatial_ssa :: reaction_propensity (const int64_t & v, const int32_t & r) const
+{
+  double a = this->rates[r];
+  const int32_t * n = this->state.data() + v * this->Nspecies;
+
+  // falling factorial (zero if there are not enough molecules)
+  for (const auto & reactant : this->reactants[r])
+    for (int32_t k = 0; k < reactant.second; ++k)
+      a *= static_cast < double >(std :: max(n[reactant.first] - k, 0));
+
+  return a;
+}
+
+
+void spatial_ssa :: update_reactions (const int64_t & v, const int32_t & species)
+{
+  for (const auto & r : this->depends[species])
+    this->propensity[v * this->Nreactions + r] = this->reaction_propensity(v, r);
+}
+
+
+void spatial_ssa :: update_total (const int64_t & v)
+{
+  const double * a = this->propensity.data() + v * this->Nreactions;
+  const int32_t * n = this->state.data() + v * this->Nspecies;
+
+  double sum = 0.;
+
+  for (int32_t r = 0; r < this->Nreactions; ++r)
+    sum += a[r];
+
+  for (int32_t s = 0; s < this->Nspecies; ++s)
+    sum += this->D[s] * n[s] * this->degree[v];
+
+  this->total[v] = sum;
+}
+
+
+void spatial_ssa :: sift (partition & p, int32_t i)
+{
+  // the keys are stored in the heap, so the comparisons do not jump across the lattice
+  const int32_t size = static_cast < int32_t >(p.heap.size());
+  const partition :: entry item = p.heap[i];
+
+  // up
+  while (i > 0)
+  {
+    const int32_t parent = (i - 1) / 4;
+    if (p.heap[parent].time <= item.time)
+      break;
+    p.heap[i] = p.heap[parent];
+    p.position[p.heap[i].voxel] = i;
+    i = parent;
+  }
+
+  // down
+  while (true)
+  {
+    const int32_t first = 4 * i + 1;
+    if (first >= size)
+      break;
+
+    // smallest of the (up to) four adjacent children
+    int32_t child = first;
+    const int32_t last = std :: min(first + 4, size);
+    for (int32_t c = first + 1; c < last; ++c)
+      if (p.heap[c].time < p.heap[child].time)
+        child = c;
+
+    if (item.time <= p.heap[child].time)
+      break;
+    p.heap[i] = p.heap[child];
+    p.position[p.heap[i].voxel] = i;
+    i = child;
+  }
+
+  p.heap[i] = item;
+  p.position[item.voxel] = i;
+}
+
+
+void spatial_ssa :: schedule (partition & p, const int64_t & v, const double & now)
+{
+  const int32_t i = p.position[v - p.begin];
+  const double a = this->total[v];
+
+  if (a > 0.)
+  {
+    std :: uniform_real_distribution < double > uniform(0., 1.);
+    p.heap[i].time = now - std :: log(1. - uniform(p.engine)) / a;
+  }
+  else
+    p.heap[i].time = std :: numeric_limits < double > :: infinity();
+
+  this->sift(p, i);
+}
+
+
+void spatial_ssa :: reschedule (partition & p, const int64_t & v, const double & now, const double & previous)
+{
+  const int32_t i = p.position[v - p.begin];
+  const double a = this->total[v];
+
+  // the waiting time not yet elapsed is still exponential (with the new rate after the rescaling)
+  if (previous > 0. && a > 0.)
+  {
+    p.heap[i].time = now + (p.heap[i].time - now) * (previous / a);
+    this->sift(p, i);
+  }
+  else
+    this->schedule(p, v, now);
+}
+
+
+void spatial_ssa :: initialize ()
+{
+  for (int64_t v = 0; v < this->Nvoxels; ++v)
+  {
+    for (int32_t r = 0; r < this->Nreactions; ++r)
+      this->propensity[v * this->Nreactions + r] = this->reaction_propensity(v, r);
+    this->update_total(v);
+  }
+
+  for (auto & p : this->partitions)
+  {
+    std :: uniform_real_distribution < double > uniform(0., 1.);
+
+    const int32_t size = static_cast < int32_t >(p.end - p.begin);
+
+    for (int32_t i = 0; i < size; ++i)
+    {
+      const double a = this->total[p.begin + i];
+      p.heap[i].time = a > 0. ? this->t - std :: log(1. - uniform(p.engine)) / a : std :: numeric_limits < double > :: infinity();
+      p.heap[i].voxel = i;
+      p.position[i] = i;
+    }
+
+    for (int32_t i = (size - 2) / 4; i >= 0; --i)
+      this->sift(p, i);
+  }
+
+  this->dirty = false;
+}
+
+
+void spatial_ssa :: advance (partition & p, const double & until)
+{
+  std :: uniform_real_distribution < double > uniform(0., 1.);
+
+  // owner partition of a voxel (the slabs are contiguous ranges)
+  auto owner = [this] (const int64_t & v)
+               {
+                 const auto it = std :: upper_bound(this->partitions.begin(), this->partitions.end(), v,
+                                                    [] (const int64_t & voxel, const partition & q) { return voxel < q.begin; });
+                 return static_cast < int32_t >(it - this->partitions.begin()) - 1;
+               };
+
+  int64_t nb[6];
+
+  while ( !p.heap.empty() )
+  {
+    const int32_t local = p.heap[0].voxel;
+    const double now = p.heap[0].time;
+
+    if (now > until)
+      break;
+
+    const int64_t v = p.begin + local;
+    int32_t * n = this->state.data() + v * this->Nspecies;
+    const double * a = this->propensity.data() + v * this->Nreactions;
+
+    double u = uniform(p.engine) * this->total[v];
+
+    int32_t r = 0;
+    for (; r < this->Nreactions; ++r)
+    {
+      if (u < a[r])
+        break;
+      u -= a[r];
+    }
+
+    if (r < this->Nreactions)
+    {
+      for (const auto & delta : this->change[r])
+        n[delta.first] += delta.second;
+      for (const auto & delta : this->change[r])
+        this->update_reactions(v, delta.first);
+    }
+    else
+    {
+      // jump of a molecule of species s to one of the neighbours
+      for (int32_t s = 0; s < this->Nspecies; ++s)
+      {
+        const double rate = this->D[s] * n[s];
+        const double as = rate * this->degree[v];
+
+        if (u < as)
+        {
+          const int32_t deg = this->neighbours(v, nb);
+          const int64_t w = nb[std :: min(static_cast < int32_t >(u / rate), deg - 1)];
+
+          --n[s];
+          this->update_reactions(v, s);
+
+          if (w >= p.begin && w < p.end)
+          {
+            const double previous = this->total[w];
+            ++this->state[w * this->Nspecies + s];
+            this->update_reactions(w, s);
+            this->update_total(w);
+            this->reschedule(p, w, now, previous);
+          }
+          else
+            p.outbox[owner(w)].emplace_back(w, s);
+
+          break;
+        }
+        u -= as;
+      }
+    }
+
+    // (a rounding overflow of u leaves the state unchanged and only draws a new time)
+    this->update_total(v);
+    this->schedule(p, v, now);
+
+    ++p.events;
+  }
+}
+
+
+int64_t spatial_ssa :: run (const double & max_time, const double & window)
+{
+  PROFILE_SCOPE("spatial_ssa.run");
+
+  if (this->dirty)
+    this->initialize();
+
+  int64_t events = 0;
+  for (const auto & p : this->partitions)
+    events -= p.events;
+
+  const int32_t P = static_cast < int32_t >(this->partitions.size());
+
+  // a single window would hold all the jumps across the slabs until the end
+  double step = window > 0. ? window : max_time - this->t;
+  if (window <= 0. && P > 1)
+  {
+    const double max_D = this->D.empty() ? 0. : *std :: max_element(this->D.begin(), this->D.end());
+    if (max_D > 0.)
+      step = .1 / max_D;
+  }
+
+  while (this->t < max_time)
+  {
+    const double until = std :: min(this->t + step, max_time);
+
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (int32_t i = 0; i < P; ++i)
+      this->advance(this->partitions[i], until);
+
+    // delivery of the molecules across the slab borders (in order of source partition)
+#ifdef _OPENMP
+    #pragma omp parallel for schedule(dynamic, 1)
+#endif
+    for (int32_t i = 0; i < P; ++i)
+    {
+      partition & p = this->partitions[i];
+
+      for (auto & q : this->partitions)
+      {
+        for (const auto & molecule : q.outbox[i])
+        {
+          const double previous = this->total[molecule.first];
+          ++this->state[molecule.first * this->Nspecies + molecule.second];
+          this->update_reactions(molecule.first, molecule.second);
+          this->update_total(molecule.first);
+          this->reschedule(p, molecule.first, until, previous);
+        }
+        q.outbox[i].clear();
+      }
+    }
+
+    this->t = until;
+  }
+
+  for (const auto & p : this->partitions)
+    events += p.events;
+
+  PROFILE_COUNT("spatial_ssa.run", events);
+
+  return events;
+}
@@ -0,0 +1,651 @@
+#include <spring_layout.h>
+#include <checkpoint.h>
+#include <profiler.hpp>
+
+#include <unordered_map>
+#include <deque>
+#include <numeric>
+#include <cmath>
+
+static constexpr int32_t SEED = 42;
+
+void build_csr (const int32_t & Nnodes,
+                const std :: vector < int32_t > & src, const std :: vector < int32_t > & dst,
+                std :: vector < int32_t > & offsets, std :: vector < int32_t > & adjacency)
+{
+  offsets.assign(Nnodes + 1, 0);
+  adjacency.resize(2 * src.size());
+
+  for (std :: size_t e = 0; e < src.size(); ++e)
+  {
+    ++offsets[src[e] + 1];
+    ++offsets[dst[e] + 1];
+  }
+
+  std :: partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+  std :: vector < int32_t > fill(offsets.begin(), offsets.end() - 1);
+
+  for (std :: size_t e = 0; e < src.size(); ++e)
+  {
+    adjacency[fill[src[e]]++] = dst[e];
+    adjacency[fill[dst[e]]++] = src[e];
+  }
+
+  for (int32_t n = 0; n < Nnodes; ++n)
+    std :: sort(adjacency.begin() + offsets[n], adjacency.begin() + offsets[n + 1]);
+}
+
+std :: vector < int32_t > reverse_cuthill_mckee (const graph & g)
+{
+  std :: vector < int32_t > order;
+  order.reserve(g.Nnodes);
+
+  std :: vector < bool > visited(g.Nnodes, false);
+
+  auto degree = [&](const int32_t & n)
+                {
+                  return g.offsets[n + 1] - g.offsets[n];
+                };
+
+  std :: vector < int32_t > by_degree(g.Nnodes);
+  std :: iota(by_degree.begin(), by_degree.end(), 0);
+  std :: stable_sort(by_degree.begin(), by_degree.end(),
+                     [&](const int32_t & a, const int32_t & b)
+                     {
+                       return degree(a) < degree(b);
+                     });
+
+  std :: vector < int32_t > neighbours;
+
+  for (const auto & root : by_degree)
+  {
+    if (visited[root])
+      continue;
+
+    std :: deque < int32_t > queue(1, root);
+    visited[root] = true;
+
+    while ( !queue.empty() )
+    {
+      const int32_t n = queue.front();
+      queue.pop_front();
+      order.push_back(n);
+
+      neighbours.clear();
+
+      for (int32_t j = g.offsets[n]; j < g.offsets[n + 1]; ++j)
+        if ( !visited[g.adjacency[j]] )
+        {
+          visited[g.adjacency[j]] = true;
+          neighbours.push_back(g.adjacency[j]);
+        }
+
+      std :: stable_sort(neighbours.begin(), neighbours.end(),
+                         [&](const int32_t & a, const int32_t & b)
+                         {
+                           return degree(a) < degree(b);
+                         });
+
+      queue.insert(queue.end(), neighbours.begin(), neighbours.end());
+    }
+  }
+
+  std :: vector < int32_t > perm(g.Nnodes);
+  for (int32_t i = 0; i < g.Nnodes; ++i)
+    perm[order[g.Nnodes - 1 - i]] = i;
+
+  return perm;
+}
+
+void set_edges (graph & g, std :: vector < std :: pair < int32_t, int32_t > > & coo)
+{
+  std :: sort(coo.begin(), coo.end());
+  coo.erase(std :: unique(coo.begin(), coo.end()), coo.end());
+
+  g.Nedges = static_cast < int32_t >(coo.size());
+  g.src.resize(g.Nedges);
+  g.dst.resize(g.Nedges);
+
+  for (int32_t e = 0; e < g.Nedges; ++e)
+  {
+    g.src[e] = coo[e].first;
+    g.dst[e] = coo[e].second;
+  }
+
+  build_csr(g.Nnodes, g.src, g.dst, g.offsets, g.adjacency);
+}
+
+graph make_graph (const int32_t * edges, const int32_t & Nedges, bool reorder)
+{
+  graph g;
+
+  // Remap the (arbitrary) node IDs to dense indices
+  std :: unordered_map < int32_t, int32_t > index;
+
+  for (int32_t i = 0; i < 2 * Nedges; ++i)
+    if ( index.emplace(edges[i], static_cast < int32_t >(g.labels.size())).second )
+      g.labels.push_back(edges[i]);
+
+  g.Nnodes = static_cast < int32_t >(g.labels.size());
+
+  // Undirected edges without self-loops and duplicates
+  std :: vector < std :: pair < int32_t, int32_t > > coo;
+  coo.reserve(Nedges);
+
+  for (int32_t e = 0; e < Nedges; ++e)
+  {
+    const int32_t u = index[edges[2 * e]];
+    const int32_t v = index[edges[2 * e + 1]];
+
+    if (u != v)
+      coo.emplace_back(std :: min(u, v), std :: max(u, v));
+  }
+
+  set_edges(g, coo);
+
+  if ( !reorder )
+    return g;
+
+  // Relabel the nodes according to the RCM permutation
+  const std :: vector < int32_t > perm = reverse_cuthill_mckee(g);
+
+  std :: vector < int32_t > labels(g.Nnodes);
+  for (int32_t n = 0; n < g.Nnodes; ++n)
+    labels[perm[n]] = g.labels[n];
+  g.labels.swap(labels);
+
+  for (auto & edge : coo)
+  {
+    const int32_t u = perm[edge.first];
+    const int32_t v = perm[edge.second];
+    edge = std :: make_pair(std :: min(u, v), std :: max(u, v));
+  }
+
+  set_edges(g, coo);
+
+  return g;
+}
+
+graph coarsen (const graph & g, std :: vector < int32_t > & parent)
+{
+  PROFILE_SCOPE("coarsen");
+
+  graph coarse;
+
+  parent.assign(g.Nnodes, -1);
+  int32_t Ncoarse = 0;
+
+  for (int32_t n = 0; n < g.Nnodes; ++n)
+  {
+    if (parent[n] != -1)
+      continue;
+
+    int32_t mate = -1;
+    int32_t mate_degree = g.Nnodes;
+
+    for (int32_t j = g.offsets[n]; j < g.offsets[n + 1]; ++j)
+    {
+      const int32_t m = g.adjacency[j];
+      const int32_t degree = g.offsets[m + 1] - g.offsets[m];
+
+      if (parent[m] == -1 && m != n && degree < mate_degree)
+      {
+        mate = m;
+        mate_degree = degree;
+      }
+    }
+
+    parent[n] = Ncoarse;
+    if (mate != -1)
+      parent[mate] = Ncoarse;
+
+    ++Ncoarse;
+  }
+
+  coarse.Nnodes = Ncoarse;
+  coarse.labels.resize(Ncoarse);
+  std :: iota(coarse.labels.begin(), coarse.labels.end(), 0);
+
+  std :: vector < std :: pair < int32_t, int32_t > > coo;
+  coo.reserve(g.Nedges);
+
+  for (int32_t e = 0; e < g.Nedges; ++e)
+  {
+    const int32_t u = parent[g.src[e]];
+    const int32_t v = parent[g.dst[e]];
+
+    if (u != v)
+      coo.emplace_back(std :: min(u, v), std :: max(u, v));
+  }
+
+  set_edges(coarse, coo);
+
+  return coarse;
+}
+
+
+/**
+* @brief Jitter for overlapping nodes
+*
+* @details If the deltas are too small, pseudo-random values
+* in [0.1, 0.2) are used to keep things moving.
+* The values are obtained by an integer hash of the node pair
+* (instead of a global random engine) so the force loops can
+* be vectorized and the layout is reproducible.
+*
+*/
+static inline float jitter (const int32_t & n1, const int32_t & n2, const int32_t & d)
+{
+  uint32_t h = static_cast < uint32_t >(n1) * 0x9E3779B1u ^ static_cast < uint32_t >(n2) * 0x85EBCA77u ^ static_cast < uint32_t >(d + SEED) * 0xC2B2AE3Du;
+  h ^= h >> 15;
+  h *= 0x2C1B3C6Du;
+  h ^= h >> 12;
+  return .1f + .1f * static_cast < float >(h >> 8) * (1.f / 16777216.f);
+}
+
+
+static struct
+{
+  // Add in Coulomb-esque node-node repulsive forces
+  void operator()(nodes & nd,
+                  const float & k,
+                  const float & r)
+  {
+    float * __restrict x = nd.pos[0].data;
+    float * __restrict y = nd.pos[1].data;
+    float * __restrict fx = nd.force[0].data;
+    float * __restrict fy = nd.force[1].data;
+
+    const float k2 = k * k;
+    const float r2 = r * r;
+
+    for (int32_t n1 = 0; n1 < nd.Nnodes; ++n1)
+    {
+      const float x1 = x[n1];
+      const float y1 = y[n1];
+      float fx1 = 0.f;
+      float fy1 = 0.f;
+
+#ifdef _OPENMP
+      #pragma omp simd reduction (+ : fx1, fy1)
+#endif
+      for (int32_t n2 = 0; n2 < n1; ++n2)
+      {
+        float dx = x[n2] - x1;
+        float dy = y[n2] - y1;
+        float distance = dx * dx + dy * dy;
+
+        if (distance < .1f)
+        {
+          dx = jitter(n1, n2, 0);
+          dy = jitter(n1, n2, 1);
+          distance = dx * dx + dy * dy;
+        }
+
+        const float force = (distance < r2) ? k2 / distance : 0.f;
+        fx1 -= force * dx;
+        fy1 -= force * dy;
+        fx[n2] += force * dx;
+        fy[n2] += force * dy;
+      }
+
+      fx[n1] += fx1;
+      fy[n1] += fy1;
+    }
+  }
+
+} Coulomb;
+
+static struct
+{
+  // And Hooke-esque edge spring forces
+  void operator()(const graph & g,
+                  nodes & nd,
+                  const float & k,
+                  const float & r)
+  {
+    float * __restrict x = nd.pos[0].data;
+    float * __restrict y = nd.pos[1].data;
+    float * __restrict fx = nd.force[0].data;
+    float * __restrict fy = nd.force[1].data;
+
+    for (int32_t e = 0; e < g.Nedges; ++e)
+    {
+      const int32_t n1 = g.src[e];
+      const int32_t n2 = g.dst[e];
+
+      float dx = x[n2] - x[n1];
+      float dy = y[n2] - y[n1];
+      float distance = dx * dx + dy * dy;
+
+      if (distance < .1f)
+      {
+        dx = jitter(n1, n2, 0);
+        dy = jitter(n1, n2, 1);
+        distance = dx * dx + dy * dy;
+      }
+
+      // Truncate distance so as to not have crazy springiness
+      distance = std :: min(distance, r);
+
+      // Calculate Hooke force and update nodes
+      const float force = (distance - k * k) / (distance * distance * k);
+      fx[n1] += force * dx;
+      fy[n1] += force * dy;
+      fx[n2] -= force * dx;
+      fy[n2] -= force * dy;
+    }
+  }
+
+} Hooke;
+
+
+/**
+* @brief Function called at the end of each relaxation step
+*
+* @details It receives the node positions, the iteration number
+* and whether the relaxation of the level is finished.
+*
+*/
+using relax_callback = std :: function < void (const nodes &, const int32_t &, const bool &) >;
+
+/**
+* @brief Force-directed relaxation from a given iteration
+*
+* @details Same relaxation of relax, starting from the first-th
+* iteration (e.g. after a restart).
+*
+*/
+static int32_t relax_from (const graph & g, nodes & nd,
+                           const int32_t & first, const int32_t & iterations,
+                           const float & force_strength, const float & damping,
+                           const float & max_velocity, const float & max_distance,
+                           const float & tolerance, const layout_callback & callback,
+                           const relax_callback & step_callback)
+{
+  PROFILE_SCOPE("relax");
+
+  int32_t i = first;
+
+  while ( i < iterations )
+  {
+    {
+      PROFILE_SCOPE("relax.coulomb");
+      Coulomb(nd, force_strength, max_distance);
+    }
+    {
+      PROFILE_SCOPE("relax.hooke");
+      Hooke(g, nd, force_strength, max_distance);
+    }
+
+    // Move by resultant force
+    float displacement = 0.f;
+
+    for (int32_t d = 0; d < LAYOUT_DIM; ++d)
+    {
+      float * __restrict p = nd.pos[d].data;
+      float * __restrict f = nd.force[d].data;
+
+      for (int32_t n = 0; n < g.Nnodes; ++n)
+      {
+        const float step = std :: max(-max_velocity, std :: min(damping * f[n], max_velocity));
+        p[n] += step;
+        f[n] = 0.f;
+        displacement += std :: abs(step);
+      }
+    }
+    ++i;
+
+    if (callback)
+      callback(g, nd, i);
+
+    const bool converged = displacement < tolerance * max_velocity * g.Nnodes;
+
+    if (step_callback)
+      step_callback(nd, i, converged || i == iterations);
+
+    if (converged)
+      break;
+  }
+
+  PROFILE_COUNT("relax", i - first);
+
+  return i;
+}
+
+int32_t relax (const graph & g, nodes & nd,
+               const int32_t & iterations,
+               const float & force_strength, const float & damping,
+               const float & max_velocity, const float & max_distance,
+               const float & tolerance, const layout_callback & callback)
+{
+  return relax_from(g, nd, 0, iterations, force_strength, damping, max_velocity, max_distance, tolerance, callback, nullptr);
+}
+
+std :: vector < float > positions (const nodes & nd)
+{
+  std :: vector < float > pos(nd.Nnodes * LAYOUT_DIM);
+
+  for (int32_t n = 0; n < nd.Nnodes; ++n)
+    for (int32_t d = 0; d < LAYOUT_DIM; ++d)
+      pos[n * LAYOUT_DIM + d] = nd.pos[d][n];
+
+  return pos;
+}
+
+
+std :: vector < float > spring_layout (const graph & g,
+                                       int iterations,
+                                       float force_strength,
+                                       float damping,
+                                       float max_velocity,
+                                       float max_distance,
+                                       float tolerance,
+                                       const layout_callback & callback)
+{
+  PROFILE_SCOPE("spring_layout");
+
+  nodes nd(g.Nnodes);
+
+  relax(g, nd, iterations, force_strength, damping, max_velocity, max_distance, tolerance, callback);
+
+  return positions(nd);
+}
+
+
+/**
+* @brief Hash (FNV-1a) of the CSR adjacency of a graph
+*
+* @details It identifies the graph (and the coarsening threshold,
+* which sets the levels) of a checkpoint, so a restart file of a
+* different graph is rejected.
+*
+*/
+static uint64_t graph_hash (const graph & g, const int32_t & min_nodes)
+{
+  uint64_t hash = 14695981039346656037ull;
+
+  auto update = [&](const int32_t * data, const std :: size_t & size)
+                {
+                  const uint8_t * bytes = reinterpret_cast < const uint8_t * >(data);
+                  for (std :: size_t i = 0; i < size * sizeof(int32_t); ++i)
+                  {
+                    hash ^= bytes[i];
+                    hash *= 1099511628211ull;
+                  }
+                };
+
+  const int32_t sizes[2] = {g.Nnodes, min_nodes};
+  update(sizes, 2);
+  update(g.offsets.data(), g.offsets.size());
+  update(g.adjacency.data(), g.adjacency.size());
+
+  return hash;
+}
+
+
+/**
+* @brief Multilevel spring layout (optionally resumable)
+*
+* @details The levels are numbered from the input graph (0) to the
+* coarsest one. If writer is not nullptr a snapshot of the level
+* is written every checkpoint_every iterations and at its end; if
+* restart holds a valid snapshot of the same graph the layout
+* starts from it.
+*
+*/
+static std :: vector < float > multilevel (const graph & g,
+                                           const int32_t & min_nodes,
+                                           const int32_t & iterations,
+                                           const float & force_strength,
+                                           const float & damping,
+                                           const float & max_velocity,
+                                           const float & max_distance,
+                                           const float & tolerance,
+                                           const layout_callback & callback,
+                                           checkpoint_writer * writer,
+                                           const int32_t & checkpoint_every,
+                                           const checkpoint_reader * restart)
+{
+  PROFILE_SCOPE("multilevel_layout");
+
+  std :: vector < graph > levels;
+  std :: vector < std :: vector < int32_t > > parents;
+
+  const graph * current = &g;
+
+  while ( current->Nnodes > min_nodes )
+  {
+    std :: vector < int32_t > parent;
+    graph coarse = coarsen(*current, parent);
+
+    // Stop if the matching does not reduce the graph
+    if (coarse.Nnodes > static_cast < int32_t >(.9f * current->Nnodes))
+      break;
+
+    levels.push_back(std :: move(coarse));
+    parents.push_back(std :: move(parent));
+    current = &levels.back();
+  }
+
+  auto level_graph = [&](const int32_t & l) -> const graph &
+                     {
+                       return l ? levels[l - 1] : g;
+                     };
+
+  // state of the layout: level, performed iterations and end of the level
+  int32_t level = static_cast < int32_t >(levels.size());
+  int32_t first = 0;
+  bool finished = false;
+
+  std :: unique_ptr < nodes > nd(new nodes(current->Nnodes));
+
+  const uint64_t hash = graph_hash(g, min_nodes);
+
+  int32_t state[3];
+  uint64_t saved_hash = 0;
+
+  if (restart && restart->valid() &&
+      restart->read("graph", &saved_hash, sizeof(saved_hash)) && saved_hash == hash &&
+      restart->read("level", state, sizeof(state)) && state[0] >= 0 && state[0] <= level)
+  {
+    std :: unique_ptr < nodes > saved(new nodes(level_graph(state[0]).Nnodes));
+
+    bool ok = true;
+    for (int32_t d = 0; d < LAYOUT_DIM; ++d)
+      ok = ok && restart->read("pos" + std :: to_string(d), saved->pos[d].data, saved->Nnodes * sizeof(float));
+
+    if (ok)
+    {
+      level = state[0];
+      first = state[1];
+      finished = state[2];
+      nd = std :: move(saved);
+    }
+  }
+
+  relax_callback snapshot = nullptr;
+
+  if (writer)
+    snapshot = [&](const nodes & pos, const int32_t & i, const bool & end)
+               {
+                 if ( !end && i % checkpoint_every )
+                   return;
+
+                 const int32_t current_state[3] = {level, i, end};
+
+                 writer->begin(i, 0.);
+                 writer->add("graph", &hash, sizeof(hash));
+                 writer->add("level", current_state, sizeof(current_state));
+                 for (int32_t d = 0; d < LAYOUT_DIM; ++d)
+                   writer->add("pos" + std :: to_string(d), pos.pos[d].data, pos.Nnodes * sizeof(float));
+                 writer->commit();
+               };
+
+  while ( true )
+  {
+    if ( !finished )
+      relax_from(level_graph(level), *nd, first, iterations, force_strength, damping, max_velocity, max_distance, tolerance, callback, snapshot);
+
+    if (level == 0)
+      break;
+
+    const graph & fine = level_graph(level - 1);
+    const std :: vector < int32_t > & parent = parents[level - 1];
+
+    std :: unique_ptr < nodes > fine_nd(new nodes(fine.Nnodes));
+
+    // Interpolate the coarse positions: the coarse layout is expanded
+    // to keep the node density constant and the matched nodes are
+    // spread around their parent position
+    const float scale = std :: sqrt(static_cast < float >(fine.Nnodes) / nd->Nnodes);
+
+    for (int32_t n = 0; n < fine.Nnodes; ++n)
+      for (int32_t d = 0; d < LAYOUT_DIM; ++d)
+        fine_nd->pos[d][n] = scale * nd->pos[d][parent[n]] + 4.f * force_strength * (jitter(n, level - 1, d) - .15f);
+
+    nd = std :: move(fine_nd);
+
+    --level;
+    first = 0;
+    finished = false;
+  }
+
+  return positions(*nd);
+}
+
+
+std :: vector < float > multilevel_layout (const graph & g,
+                                           int32_t min_nodes,
+                                           int iterations,
+                                           float force_strength,
+                                           float damping,
+                                           float max_velocity,
+                                           float max_distance,
+                                           float tolerance,
+                                           const layout_callback & callback)
+{
+  return multilevel(g, min_nodes, iterations, force_strength, damping, max_velocity, max_distance, tolerance, callback,
+                    nullptr, 0, nullptr);
+}
+
+
+std :: vector < float > multilevel_layout (const graph & g,
+                                           const std :: string & checkpoint,
+                                           const int32_t & checkpoint_every,
+                                           int32_t min_nodes,
+                                           int iterations,
+                                           float force_strength,
+                                           float damping,
+                                           float max_velocity,
+                                           float max_distance,
+                                           float tolerance,
+                                           const layout_callback & callback)
+{
+  const checkpoint_reader restart(checkpoint);
+  checkpoint_writer writer(checkpoint);
+
+  return multilevel(g, min_nodes, iterations, force_strength, damping, max_velocity, max_distance, tolerance, callback,
+                    &writer, std :: max(checkpoint_every, 1), &restart);
+}
@@ -0,0 +1,32 @@
+#include <thomas.h>
+
+std :: unique_ptr < float[] > Thomas (const float * b, const float * a,
+                                      float * c, float * d,
+                                      const int32_t & nb)
+{
+  int32_t i = 0;
+  std :: unique_ptr < float[] > x(new float[nb]);
+
+  float tmp = c[i];
+
+  c[i] /= b[i];
+  d[i] /= b[i];
+
+  for (i = 1; i < nb - 1; ++i)
+  {
+    const float scale = a ? a[i - 1] : tmp;
+    const float id = 1.f / (b[i] - scale * c[i-1]);
+    d[i] = (d[i] - scale * d[i-1]) * id;
+    tmp = c[i];
+    c[i] *= id;
+  }
+
+  tmp = a ? a[i - 1] : tmp;
+  d[i] = (d[i] - tmp * d[i-1]) / (b[i] - tmp * c[i-1]);
+  x[nb - 1] = d[i];
+
+  for (i = nb-2; i != -1; --i)
+    x[i] = d[i] - c[i] * x[i+1];
+
+  return x;
+}